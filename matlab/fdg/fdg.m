@@ -121,7 +121,12 @@ end
 if (progress)
   disp ('Preparing the blood...');
 end;
-[ts_new, plasma_new] = getFDGplasma (ts_plasma, plasma, EndFTimes);
+if (exist ('fdgrates') == 3)
+  ts_new = ts_plasma(:);            % fdgrates merges in the frame times itself
+  plasma_new = plasma(:);
+else
+  [ts_new, plasma_new] = getFDGplasma (ts_plasma, plasma, EndFTimes);
+end
 
 
 %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
@@ -0,0 +1,53 @@
+function err = fit_fdg (args, Cp_even, ts_even, A, fstart, flengths)
+
+% FIT_FDG  residual of the three-rate-constant FDG model
+%
+%     err = fit_fdg (args, Cp_even, ts_even, A, fstart, flengths)
+%
+% Computes the sum of squared differences between the frame data A
+% and the frame integrals of the FDG model (with k4 = 0)
+%
+%     K1/(k2+k3) * (k3 * conv (Cp(t), 1) + k2 * conv (Cp(t), exp(-(k2+k3)*t)))
+%
+% where args = [K1 k2 k3], and Cp_even is the plasma activity sampled
+% at the evenly spaced times ts_even.  Frames that ts_even does not
+% span contribute zero to the model.
+%
+% This is meant to be minimised by nfmins, which recognises the name
+% and evaluates the model in C rather than calling this M-file.
+
+% $Id$
+% $Name:  $
+
+% ----------------------------- MNI Header -----------------------------------
+% @NAME       : fit_fdg
+% @INPUT      : 
+% @OUTPUT     : 
+% @RETURNS    : 
+% @DESCRIPTION: 
+% @METHOD     : 
+% @GLOBALS    : 
+% @CALLS      : 
+% @CREATED    : 2026/10/16
+% @MODIFIED   : 
+% ---------------------------------------------------------------------------- */
+
+if (length(args) ~= 3), error ('Wrong number of fit parameters'), end;
+
+spacing = ts_even(2) - ts_even(1);
+n = length(ts_even);
+k23 = args(2) + args(3);
+
+c1 = nconv (Cp_even, ones(size(ts_even)), spacing);
+c1 = c1 (1:n);
+if (k23 == 0)
+   c = args(1) * c1;
+else
+   c2 = nconv (Cp_even, exp(-k23*ts_even), spacing);
+   c = args(1) / k23 * (args(3) * c1 + args(2) * c2 (1:n));
+end
+
+integral = nframeint (ts_even, c, fstart, flengths);
+integral (find (isnan (integral))) = 0;
+
+err = sum ((A - integral(1:length(A))).^2);
@@ -63,6 +63,18 @@ elseif nargin~=11
 end;
 
 
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+% If the fdgrates CMEX is available, it does the whole job (for
+% every slice) in one go.
+
+if (exist ('fdgrates') == 3)
+  [K1_image, K_image, CMRglc_image] = fdgrates ...
+      (handlefield (handle, 'Filename'), slices-1, ts_Ca, Ca, eft, ...
+       c_Time, glucose, v0, wtf, MMC, progress);
+  return;
+end
+
+
 %%%%%%%%%%%%%%%%%%%%%%%%
 % Extract the parameters
 
@@ -0,0 +1,149 @@
+function maxdiff = test_fdgrates (parent, tol)
+
+% TEST_FDGRATES  check the fdgrates CMEX against solveFDG's M-file code
+%
+%     maxdiff = test_fdgrates (parent [, tol])
+%
+% Makes a two-slice synthetic FDG study with the frame timing (and
+% image size) of the dynamic MINC file parent.  Each pixel holds the
+% frame averages of the three-rate-constant FDG model for its own K1,
+% k2 and k3, driven by a synthetic plasma curve.  fdg is then run on
+% the phantom twice: once as usual (so that solveFDG hands the whole
+% job to fdgrates), and once with fdgrates hidden, so that solveFDG
+% does it in MATLAB.
+%
+% Returns the largest relative difference between the two in K1, K
+% and CMRglc; it is an error if that is more than tol (default 1e-6),
+% or if one gives a non-finite value where the other doesn't.
+
+% $Id$
+% $Name:  $
+
+% ----------------------------- MNI Header -----------------------------------
+% @NAME       : test_fdgrates
+% @INPUT      : parent - a dynamic MINC file, for the frame times
+%               tol - (optional) the largest relative difference allowed
+% @OUTPUT     :
+% @RETURNS    : maxdiff - the largest relative difference found
+% @DESCRIPTION:
+% @METHOD     : fdgrates is hidden by putting an M-file of the same
+%               name at the front of the path, so exist ('fdgrates')
+%               no longer returns 3.
+% @GLOBALS    :
+% @CALLS      : newimage, putimages, fdg, nconv, nframeint, tempfilename
+% @CREATED    : 2026/10/16
+% @MODIFIED   :
+% ---------------------------------------------------------------------------- */
+
+error (nargchk (1, 2, nargin));
+if (nargin < 2), tol = 1e-6; end
+
+if (exist ('fdgrates') ~= 3)
+   error ('The fdgrates CMEX is not on the path');
+end
+
+glucose = 5.5;
+
+% The frame timing, in minutes
+
+p = openimage (parent);
+fstart = getimageinfo (p, 'FrameTimes') / 60;
+flengths = getimageinfo (p, 'FrameLengths') / 60;
+closeimage (p);
+if (isempty (fstart))
+   error ([parent ' is not dynamic']);
+end
+NumFrames = length (fstart);
+eft = fstart + flengths;
+
+% A synthetic plasma curve: a bolus on a slowly rising baseline,
+% sampled every 0.05 minutes (the sample times don't line up with
+% the frames, so both paths have to resample)
+
+ts_plasma = (0:0.05:max(eft)+1)';
+plasma = 800 * ts_plasma .* exp (-ts_plasma / 0.6) + ...
+         60 * (1 - exp (-ts_plasma / 5));
+
+% Rate constants vary along each row (one set per column), and K1 is
+% scaled down the columns, so that each image has a spread of values
+
+newfile = [tempfilename '.mnc'];
+h = newimage (newfile, [NumFrames 2], parent);
+width = getimageinfo (h, 'ImageWidth');
+height = getimageinfo (h, 'ImageHeight');
+
+k2 = linspace (0.08, 0.4, width);
+k3 = linspace (0.15, 0.03, width);
+K1scale = linspace (0.5, 1.5, height)';
+
+spacing = ts_plasma(2) - ts_plasma(1);
+n = length (ts_plasma);
+c1 = nconv (plasma, ones (n, 1), spacing);
+A = zeros (NumFrames, width);
+for i = 1:width
+   k23 = k2(i) + k3(i);
+   c2 = nconv (plasma, exp (-k23 * ts_plasma), spacing);
+   c = 0.1 / k23 * (k3(i) * c1(1:n) + k2(i) * c2(1:n));
+   A(:,i) = nframeint (ts_plasma, c, fstart, flengths);
+end
+
+for slice = 1:2
+   images = zeros (width*height, NumFrames);
+   for f = 1:NumFrames
+      images(:,f) = reshape (K1scale * (A(f,:) * (0.8 + 0.4*slice)), ...
+                             width*height, 1);
+   end
+   putimages (h, images, slice, 1:NumFrames);
+end
+closeimage (h);
+
+% First with fdgrates, then without
+
+[K1c, Kc, CMRc] = fdg (newfile, [1 2], glucose, 0, ts_plasma, plasma);
+
+hidedir = tempfilename;
+mkdir (hidedir);
+fid = fopen (fullfile (hidedir, 'fdgrates.m'), 'w');
+fprintf (fid, 'function varargout = fdgrates (varargin)\n');
+fprintf (fid, 'error (''hidden by test_fdgrates'');\n');
+fclose (fid);
+addpath (hidedir);
+clear fdgrates
+
+try
+   [K1m, Km, CMRm] = fdg (newfile, [1 2], glucose, 0, ts_plasma, plasma);
+catch
+   K1m = [];
+end
+
+rmpath (hidedir);
+delete (fullfile (hidedir, 'fdgrates.m'));
+rmdir (hidedir);
+clear fdgrates
+miflushcache;
+delete (newfile);
+
+if (isempty (K1m))
+   error (['solveFDG failed without fdgrates: ' lasterr]);
+end
+
+maxdiff = max ([reldiff(K1c, K1m), reldiff(Kc, Km), reldiff(CMRc, CMRm)]);
+fprintf ('test_fdgrates: largest relative difference %g\n', maxdiff);
+if (maxdiff > tol)
+   error (sprintf ('fdgrates and solveFDG differ by %g (tolerance %g)', ...
+                   maxdiff, tol));
+end
+
+
+
+function d = reldiff (a, b)
+
+% RELDIFF  largest relative difference between a and b (Inf if they
+% are not non-finite in the same places)
+
+if (any (size (a) ~= size (b)) | any (xor (isfinite (a(:)), isfinite (b(:)))))
+   d = Inf;
+   return;
+end
+ok = find (isfinite (a));
+d = max ([abs (a(ok) - b(ok)) ./ max (abs (b(ok)), eps); 0]);
@@ -17,20 +17,24 @@
 %   mireadvar     - Read a hyperslab from any NetCDF variable.
 %   micreate      - Create a new MINC file from scratch.
 %   miwriteimages - Write images to a MINC file (used by putimages).
+%   miputimages   - Write images from memory (used by miwriteimages).
 %   miinquire     - Get netCDF variable, dimension, or attribute information.
+%   miflushcache  - Close files held open by the CMEX readers.
 %
-%     Note: these seven functions should not generally be called by 
+%     Note: these eight functions should not generally be called by 
 %     general purpose image analysis applications.  Use the high-
 %     level functions instead.
 %
 % General utility functions (numeric)
 %   deriv         - Calculate the derivative of a numerical function.
 %   lookup        - Fast CMEX function for linear interpolation.
-%   nconv         - Convolution of two vectors with not necessarily unit spacing.
+%   nconv         - Fast CMEX convolution of two vectors with not necessarily unit spacing.
 %   nfmins        - Minimize a function of several variables.
 %   nframeint     - Fast CMEX integration across frames.
 %   ntrapz        - Fast CMEX function for trapezoidal integration.
 %   rescale       - Multiply a matrix by a scalar.
+%   test_nconv    - Checks the nconv CMEX against nconv.m's filter method.
+%   bench_putimages - Times miputimages against the standalone miwriteimages.
 %   
 % General utility functions (image processing)
 %   getmask       - Returns a mask that is the same size as the passed image.
@@ -40,6 +44,7 @@
 %   hotmetal      - Generate the RGB numbers for a hotmetal colourmap.
 %   maketac       - Generate a time-activity curve from a set of data.
 %   smooth        - Perform a simple spatial smoothing on an image.
+%   slabapply     - Apply a function to a study a few image rows at a time.
 %   spectral      - Generate the RGB numbers for a spectral colourmap.
 %   
 % General utility (image volume geometry, tag and transform files)
@@ -58,6 +63,15 @@
 %   rcbf1         - Performs a single compartment rCBF analysis.
 %   rcbf2         - Performs a full two compartment rCBF analysis, with
 %                   blood dispersion and delay correction.
+%   rcbf          - Fast CMEX two compartment rCBF analysis of many
+%                   slices at once (used by rcbf2).
+%
+% FDG analysis functions
+%   fdg           - Compute K1, K and CMRglc images from an FDG study.
+%   fdgrates      - Fast CMEX FDG analysis of many slices at once (used
+%                   by solveFDG).
+%   test_fdgrates - Checks fdgrates against solveFDG's M-file code on a
+%                   synthetic study.
 %
 % Rat Data Analysis
 %   ratbrain      - Analyze rat data.
@@ -0,0 +1,110 @@
+function rates = bench_putimages (numframes, imsize)
+
+% BENCH_PUTIMAGES  time miputimages against the standalone miwriteimages
+%
+%     rates = bench_putimages ([numframes [, imsize]])
+%
+% Creates a scratch MINC file of numframes (default 2000) single-slice
+% frames of imsize by imsize (default 128) pixels, and writes the same
+% images into it twice: once straight from memory with the miputimages
+% CMEX, and once the way miwriteimages.m does without it -- write them
+% to a temporary file, and copy that into the MINC file with the
+% standalone miwriteimages.  Each time, the frames are read back with
+% mireadimages and checked.
+%
+% Returns [cmex standalone], the rates of the two in megabytes (of
+% doubles) per second, and prints them.  The default numframes is more
+% than the 1024 images miputimages used to be able to write at once.
+
+% $Id$
+% $Name:  $
+
+% ----------------------------- MNI Header -----------------------------------
+% @NAME       : bench_putimages
+% @INPUT      : numframes - (optional) number of frames to write
+%               imsize    - (optional) height and width of each image
+% @OUTPUT     :
+% @RETURNS    : rates - [cmex standalone] write rates, in MB/s
+% @DESCRIPTION:
+% @METHOD     : Only the write itself is timed, not creating the file or
+%               checking it; the scratch files are deleted afterwards.
+% @GLOBALS    :
+% @CALLS      : newimage, closeimage, miputimages, miwriteimages (the
+%               executable), mireadimages, miflushcache, tempfilename
+% @CREATED    : 2026/10/16
+% @MODIFIED   :
+% ---------------------------------------------------------------------------- */
+
+error (nargchk (0, 2, nargin));
+if (nargin < 1), numframes = 2000; end
+if (nargin < 2), imsize = 128; end
+
+if (exist ('miputimages') ~= 3)
+   error ('The miputimages CMEX is not on the path');
+end
+
+mincfile = [tempfilename '.mnc'];
+handle = newimage (mincfile, [numframes 1 imsize imsize]);
+closeimage (handle);
+
+images = rand (imsize*imsize, numframes) * 100;
+frames = 0:(numframes-1);
+megabytes = prod (size (images)) * 8 / 2^20;
+
+% The CMEX, straight from memory
+
+t0 = clock;
+miputimages (mincfile, images, 0, frames);
+miflushcache (mincfile);
+cmextime = etime (clock, t0);
+check (mincfile, images, frames, 'miputimages');
+
+% The standalone program, via a temporary file
+
+rawfile = tempfilename;
+framelist = sprintf ('%d,', frames);
+framelist = framelist(1:(length(framelist)-1));
+
+t0 = clock;
+outfile = fopen (rawfile, 'w');
+if (outfile == -1)
+   delete (mincfile);
+   error (['Could not open temporary file ' rawfile ' for writing']);
+end
+fwrite (outfile, images, 'double');
+fclose (outfile);
+result = unix (sprintf ('miwriteimages "%s" 0 %s %s', ...
+                        mincfile, framelist, rawfile));
+miflushcache (mincfile);
+shelltime = etime (clock, t0);
+
+delete (rawfile);
+if (result ~= 0)
+   delete (mincfile);
+   error ('The standalone miwriteimages failed');
+end
+check (mincfile, images, frames, 'miwriteimages');
+delete (mincfile);
+
+rates = megabytes ./ max ([cmextime shelltime], eps);
+fprintf ('bench_putimages: %d frames of %dx%d (%.1f MB)\n', ...
+         numframes, imsize, imsize, megabytes);
+fprintf ('  miputimages (CMEX):         %8.3f s  %8.1f MB/s\n', ...
+         cmextime, rates(1));
+fprintf ('  miwriteimages (standalone): %8.3f s  %8.1f MB/s\n', ...
+         shelltime, rates(2));
+
+
+
+function check (mincfile, images, frames, what)
+
+% CHECK  read the frames back and make sure they are (to within the
+% precision of the file's storage type) what was written
+
+back = mireadimages (mincfile, 0, frames);
+scale = max (abs (images(:)));
+if (any (size (back) ~= size (images)) | ...
+    max (abs (back(:) - images(:))) > scale * 1e-2)
+   delete (mincfile);
+   error (sprintf ('Images read back differ from those written (%s)', what));
+end
@@ -1,7 +1,7 @@
-function msg = check_sf (handle, slices, frames)
+function msg = check_sf (handle, slices, frames, one_list)
 %  CHECK_SF  determine the validity of slice and frame lists (internal use)
 %
-%      msg = check_sf (handle, slices, frames)
+%      msg = check_sf (handle, slices, frames [, one_list])
 %
 %  examines the lists of slices and frames, compares them to the 
 %  properties of the MINC file specified by handle, and generates
@@ -11,7 +11,8 @@ function msg = check_sf (handle, slices, frames)
 %
 %  The specific conditions that cause an error message are:
 %
-%     - both slices and frames have multiple values
+%     - both slices and frames have multiple values, if one_list is
+%       given and non-zero (putimages can only write one list at a time)
 %     - the file has no time dimension, but a frame list was given
 %     - the file has a time dimension, but no frame list was given
 %     - the file has no slice dimension, but a slice list was given
@@ -33,8 +34,11 @@ dim_sizes = handlefield(handle, 'DimSizes');
 num_frames = dim_sizes(1);
 num_slices = dim_sizes(2);
 
-if (length(slices) > 1) & (length(frames) > 1)
-   msg = 'Cannot specify both multiple slices and multiple frames';
+if (nargin > 3)
+   if (one_list & (length(slices) > 1) & (length(frames) > 1))
+      msg = 'Cannot specify both multiple slices and multiple frames';
+      return;
+   end
 end
 
 if (num_frames == 0)
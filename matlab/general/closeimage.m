@@ -7,7 +7,8 @@ function closeimage (handles)
 % Closes one or more image data sets.  If the associated MINC was a
 % compressed file (and therefore uncompressed by openimage), then the
 % temporary file and directory used for the uncompressed data are
-% deleted.
+% deleted.  The file is also dropped from the open-file caches of the
+% CMEX readers (see miflushcache).
 
 % $Id: closeimage.m,v 1.12 2004-10-06 15:04:13 bert Exp $
 % $Name:  $
@@ -16,6 +17,10 @@ for handle = handles
    Flags = handlefield(handle, 'Flags');
    Filename = handlefield(handle, 'Filename');
    
+   if (~isempty (Filename))
+      miflushcache (Filename);
+   end
+
    if (size(Flags) == [1 2])		% was it actually a compressed file?
       if (Flags(2))                     % then nuke the temp directory
 	 slashes = find (Filename == '/');
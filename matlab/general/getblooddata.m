@@ -57,6 +57,8 @@ function [activity, mid_times] = getblooddata (study)
 %@CREATED    : June 1993, Greg Ward & Mark Wolforth
 %@MODIFIED   : 6 July 1993, Greg Ward: greater flexibility wrt. handling
 %              both MINC and BNC files
+%              16 October 2026: read all the variables with one call
+%              to mireadvar
 %@VERSION    : $Id: getblooddata.m,v 1.8 2000-04-10 16:00:50 neelin Exp $
 %              $Name:  $
 %-----------------------------------------------------------------------------
@@ -111,8 +113,15 @@ else                        % study is a number, so use it
     ans = mireadvar (filename, 'blood_analysis');
     if isempty (ans)
 
-        % Now we wish to strip off the .mnc and tack on .bnc
+        % Now we wish to strip off the .mnc (and .gz, if the study is
+        % being read compressed) and tack on .bnc
     
+        len = length (filename);
+        if (len > 3)
+           if (strcmp (filename((len-2):len), '.gz'))
+              filename = filename(1:(len-3));
+           end
+        end
         dot = find(filename=='.');      % location of . in filename
         if isempty(dot)                 % no extension found (not too likely!)
             filename = [filename '.bnc'];
@@ -131,10 +140,8 @@ end
 % contains blood analysis data.  (Assuming all BNC files contain these
 % variables)
 
-activity = mireadvar (filename, 'corrected_activity');
-start_times = mireadvar (filename, 'sample_start');
-stop_times = mireadvar (filename, 'sample_stop');
-lengths = mireadvar (filename, 'sample_length');
+[activity, start_times, stop_times, lengths] = mireadvar (filename, ...
+   {'corrected_activity', 'sample_start', 'sample_stop', 'sample_length'});
 
 if (~isempty (stop_times))
    mid_times = (start_times + stop_times) / 2;
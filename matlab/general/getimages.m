@@ -1,15 +1,17 @@
-function images = getimages (handle, slices, frames, old_matrix, start_row, num_rows)
+function [images, scale, offset] = getimages (handle, slices, frames, old_matrix, start_row, num_rows, precision, prefetch, next_slices)
 %GETIMAGES  Retrieve whole or partial images from an open MINC file.
 %
 %  images = getimages (handle [, slices [, frames [, old_matrix ...
-%                      [, start_row [, num_rows]]]]])
+%                      [, start_row [, num_rows]]]]] [, precision])
+%  [images, scale, offset] = getimages (...)
+%  images = getimages (..., 'prefetch', next_slices)
 %
 %  reads whole or partial images from the MINC file specified by
-%  handle.  Either slices or frames can be a vector (to specify a
-%  set of several images), but at least one of them must be a scalar
-%  -- it is not possible to read images from both different slices and
-%  different frames at the same time.  (Multiple calls to getimages
-%  will be needed for this.)  If the file is non-dynamic (no time
+%  handle.  Either or both of slices and frames can be a vector (to
+%  specify a set of several images).  If both are vectors, every
+%  frame of every slice is read, with the frames of the first slice
+%  in the first length(frames) columns, followed by those of the
+%  second slice, and so on.  If the file is non-dynamic (no time
 %  dimension), then the frames argument can be omitted or empty;
 %  likewise, if there is no slice dimension, the slices argument can
 %  be omitted or empty.  (But note that slices must be given if any
@@ -43,6 +45,30 @@ function images = getimages (handle, slices, frames, old_matrix, start_row, num_
 %  This will get around MATLAB's tendency to unnecessarily allocate
 %  new blocks of memory and leave old blocks unused.
 %
+%  A more effective way to save memory is to give 'single' as the
+%  last argument: the images are then returned in single precision,
+%  which halves the size of the matrix.  'raw' returns the values as
+%  stored in the file (eg. uint8 or int16), along with the scale and
+%  offset that convert each column to real values -- see MIREADIMAGES
+%  for details.
+%
+%  When reading a volume slice by slice, the disk would normally sit
+%  idle while each slice is being processed.  Giving 'prefetch' and
+%  the slices that will be read next as the last two arguments asks
+%  the operating system to start reading ahead in the background, so
+%  that the next call doesn't have to wait for the disk:
+%
+%  for slice = 1:numslices
+%     img = getimages (handle, slice, 1:numframes, ...
+%                      'prefetch', slice+1:min(slice+1,numslices));
+%     (process img)
+%  end
+%
+%  (An empty next_slices, as on the last slice, means there's nothing
+%  more to read.)  The hint only has an effect with the CMEX version
+%  of mireadimages, on systems that support it; it never changes the
+%  images returned.
+%
 %  EXAMPLES (assuming handle = openimage ('some_minc_file');)
 %
 %   To read in the first frame of the first slice:
@@ -51,6 +77,11 @@ function images = getimages (handle, slices, frames, old_matrix, start_row, num_
 %     first_10 = getimages (handle, 1, 1:10);
 %   To read in the first 10 slices of a non-dynamic (i.e. no frames) file:
 %     first_10 = getimages (handle, 1:10);
+%   To read in all 21 frames of all 15 slices of a dynamic file:
+%     everything = getimages (handle, 1:15, 1:21);
+%     frame3_slice7 = everything (:, (7-1)*21 + 3);
+%   To do the same in half the memory:
+%     everything = getimages (handle, 1:15, 1:21, 'single');
 %   
 %  Note that there is currently no way to write partial images -- this 
 %  feature is provided in the hopes of cutting down memory usage due
@@ -69,6 +100,8 @@ function images = getimages (handle, slices, frames, old_matrix, start_row, num_
 %              old_matrix - previously used block of memory to be recycled
 %              start_row - image row to start reading at
 %              num_rows - number of rows to read
+%              precision - 'double', 'single' or 'raw'
+%              'prefetch', next_slices - slices (1-based) to be read next
 %@OUTPUT     : 
 %@RETURNS    : images - matrix whose columns contain entire images
 %              layed out linearly.
@@ -97,6 +130,7 @@ function images = getimages (handle, slices, frames, old_matrix, start_row, num_
 %@MODIFIED   : 6 July 1993, Greg Ward: 
 %             30 May 1994, Greg Ward: added start_row and num_rows, 
 %                          completely rewrote help section
+%             16 October 2026: added the 'prefetch' hint
 %@VERSION    : $Id: getimages.m,v 1.15 2000-04-10 16:00:51 neelin Exp $
 %              $Name:  $
 %-----------------------------------------------------------------------------
@@ -104,15 +138,43 @@ function images = getimages (handle, slices, frames, old_matrix, start_row, num_
 
 % Check for valid number of arguments
 
-if (nargin < 1) | (nargin > 6)
+if (nargin < 1) | (nargin > 9)
    error ('Incorrect number of arguments.');
 end
 
-if (nargin < 2)
+% A trailing 'prefetch', next_slices pair comes off the end of the
+% argument list first; then, if the last argument is a string, it's
+% the precision.  Take both off before looking at the others.
+
+args = {handle};
+if (nargin >= 2), args{2} = slices; end
+if (nargin >= 3), args{3} = frames; end
+if (nargin >= 4), args{4} = old_matrix; end
+if (nargin >= 5), args{5} = start_row; end
+if (nargin >= 6), args{6} = num_rows; end
+if (nargin >= 7), args{7} = precision; end
+if (nargin >= 8), args{8} = prefetch; end
+if (nargin >= 9), args{9} = next_slices; end
+prefetch = {};
+nargs = nargin;
+if (nargs > 2) & isstr (args{nargs-1})
+   if (strcmp (args{nargs-1}, 'prefetch'))
+      prefetch = {'prefetch', args{nargs}-1};
+      nargs = nargs - 2;
+   end
+end
+
+precision = {};
+if (nargs > 1) & isstr (args{nargs})
+   precision = args(nargs);
+   nargs = nargs - 1;
+end
+
+if (nargs < 2)
    slices = [];         % no slices vector given, so make it empty
 end
 
-if (nargin < 3)         % no frames vector given, so make it empty
+if (nargs < 3)         % no frames vector given, so make it empty
    frames = [];
 end
 
@@ -146,14 +208,17 @@ end
 % Now read the images!  (remembering to make slices and frames zero-based for
 % mireadimages).
 
-if (nargin < 4)
-    images = mireadimages (filename, slices-1, frames-1);
-elseif (nargin < 5)
-    images = mireadimages (filename, slices-1, frames-1, old_matrix);
-elseif (nargin < 6)
-    images = mireadimages (filename, slices-1, frames-1, old_matrix, ...
-                           start_row-1);
-elseif (nargin < 7)
-    images = mireadimages (filename, slices-1, frames-1, old_matrix, ...
-                           start_row-1, num_rows);
+miargs = {filename, slices-1, frames-1};
+if (nargs >= 4), miargs{4} = old_matrix; end
+if (nargs >= 5), miargs{5} = start_row-1; end
+if (nargs >= 6), miargs{6} = num_rows; end
+miargs = [miargs precision];
+if (exist ('mireadimages') == 3)
+   miargs = [miargs prefetch];
+end
+
+if (nargout > 1)
+    [images, scale, offset] = mireadimages (miargs{:});
+else
+    images = mireadimages (miargs{:});
 end
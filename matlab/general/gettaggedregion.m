@@ -102,12 +102,16 @@ if (progress), fprintf ('reading slices: '), end;
 
 values = zeros (num_tags, num_frames);
 
-for sl = unique_slices
+num_slices = length (unique_slices);
+for isl = 1:num_slices
+   sl = unique_slices(isl);
    if (progress), fprintf ('%d..', sl), end;
 
-   % Read the current slice from disk
+   % Read the current slice from disk, and let the next one be read
+   % ahead while we work on this one
 
-   img = getimages (volume, sl, frames);
+   img = getimages (volume, sl, frames, ...
+                    'prefetch', unique_slices(isl+1:min(isl+1,num_slices)));
    
    % Find which tag points are in that slice
    
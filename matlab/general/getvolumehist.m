@@ -69,7 +69,7 @@ no = zeros (1,length(xo));
 fprintf ('Procesing %d slices', slices);
 
 for i=1:slices
-  MRI = getimages(handle,i);
+  MRI = getimages(handle,i,[],'prefetch',i+1:min(i+1,slices));
   [n,x] = hist(MRI,xo);
   no = no+n;
   fprintf ('.');
@@ -0,0 +1,45 @@
+function [hits, misses] = miflushcache (filename)
+% MIFLUSHCACHE  close MINC files held open by the CMEX readers
+%
+%   miflushcache
+%   miflushcache (filename)
+%   [hits, misses] = miflushcache (...)
+%
+%  The CMEX programs mireadimages, mireadvar, miinquire, rcbf,
+%  fdgrates, and slabapply keep the files they read open between
+%  calls, so that (eg.) reading a volume one slice at a time doesn't
+%  mean opening the file and parsing its header once per slice.  A
+%  cached file is reopened automatically if its modification time or
+%  size changes, but since the modification time only has a one-second
+%  resolution, anything that writes to a MINC file should call
+%  miflushcache with the name of that file.
+%  (putimages, miwriteatt, newimage, and closeimage all do this.)
+%
+%  With no arguments, every cached file is closed.  If output arguments
+%  are given, the total number of opens that were satisfied from the
+%  caches (hits) and that had to go to the file (misses) is returned.
+%  Each CMEX program has its own cache, so these are summed over all
+%  of them.
+
+% $Id$
+% $Name:  $
+
+hits = 0;
+misses = 0;
+readers = {'mireadimages', 'mireadvar', 'miinquire', 'rcbf', 'fdgrates', ...
+           'slabapply'};
+
+for i = 1:length(readers)
+   if (exist (readers{i}) == 3)
+      if (nargout > 0)
+         [h, m] = feval (readers{i}, '-cachestats');
+         hits = hits + h;
+         misses = misses + m;
+      end
+      if (nargin > 0)
+         feval (readers{i}, '-flush', filename);
+      else
+         feval (readers{i}, '-flush');
+      end
+   end
+end
@@ -1,8 +1,10 @@
-function images = mireadimages(minc_file, slices, frames, old_matrix, start_row, num_rows);
+function [images, scale, offset] = mireadimages(minc_file, slices, frames, old_matrix, start_row, num_rows, precision);
 %MIREADIMAGES  Read images from specified slice(s)/frame(s) of a MINC file.
 %
 %  images = mireadimages ('minc_file' [, slices [, frames ...
-%                         [, old_matrix [, start_row [, num_rows]]]]])
+%                         [, old_matrix [, start_row [, num_rows]]]]] ...
+%                         [, precision])
+%  [images, scale, offset] = mireadimages (...)
 %
 %  opens the given MINC file, and attempts to read whole or partial
 %  images from the slices and frames specified in the slices and
@@ -49,8 +51,27 @@ function images = mireadimages(minc_file, slices, frames, old_matrix, start_row,
 %  For most dynamic analyses, it will also be necessary to extract
 %  the frame timing data.  This can be done using MIREADVAR.
 %
-%  Currently, only one of the vectors slices or frames can contain multiple
-%  elements.
+%  Both slices and frames may contain multiple elements, in which case
+%  every frame of every slice is read: column (i-1)*length(frames)+j
+%  of the result holds frame frames(j) of slice slices(i).
+%
+%  If the last argument is a string, it selects the precision of the
+%  result.  'double' (the default) returns real (physical) values as
+%  doubles.  'single' returns the same values as a single-precision
+%  matrix, which takes half the memory.  'raw' returns the values
+%  exactly as they are stored in the file (eg. uint8 or int16 for
+%  byte or short data), with no scaling and no mapping of out-of-range
+%  values to NaN.  To get the real values, use the optional scale and
+%  offset outputs: these are row vectors with one element per column
+%  of images, such that
+%
+%  >> real = double (images(:,i)) * scale(i) + offset(i);
+%
+%  In 'double' and 'single' mode, scale and offset are just 1 and 0.
+%  'raw' is only available in the CMEX version of mireadimages.
+%
+%  The CMEX version of mireadimages keeps the file open between calls;
+%  mireadimages ('-flush') closes it again.  See MIFLUSHCACHE.
 
 % $Id: mireadimages.m,v 1.7 2005-08-24 22:27:00 bert Exp $
 % $Name:  $
@@ -62,12 +83,32 @@ if (nargin < 1)
   error('Too few arguments');
 end
 
+% Peel off a trailing precision argument (see above)
+args = {minc_file};
+if (nargin >= 2), args{2} = slices; end
+if (nargin >= 3), args{3} = frames; end
+if (nargin >= 4), args{4} = old_matrix; end
+if (nargin >= 5), args{5} = start_row; end
+if (nargin >= 6), args{6} = num_rows; end
+if (nargin >= 7), args{7} = precision; end
+precision = 'double';
+nargs = nargin;
+if (nargs > 1) & isstr (args{nargs})
+  precision = args{nargs};
+  nargs = nargs - 1;
+  if (strcmp (precision, 'raw'))
+    error ('Raw precision is only supported by the CMEX version of mireadimages');
+  elseif (~strcmp (precision, 'single') & ~strcmp (precision, 'double'))
+    error (['Unknown precision: ' precision]);
+  end
+end
+
 % Make sure that all input arguments are set
-if (nargin < 6), num_rows=[];end
-if (nargin < 5), start_row=[];end
+if (nargs < 6), num_rows=[];end
+if (nargs < 5), start_row=[];end
 old_matrix = [];
-if (nargin < 3), frames=[];end
-if (nargin < 2), slices=[];end
+if (nargs < 3), frames=[];end
+if (nargs < 2), slices=[];end
 
 % Check that slices and frames are set
 if (isempty(slices)), slices = 0; end
@@ -215,26 +256,36 @@ for islice=1:nslcrange
       error('Error opening temp file to read image data');
     end
     
-    % Loop over slices and frames
-    for jslice=1:slcrange(islice,2)
-      
-      for jframe=1:frmrange(iframe,2)
-
-        % Read the data back in
-        thisimage = fread(fid, imgsize, 'double');
-        if (length(thisimage) ~= imgsize)
-          fclose(fid);
-          delete(tempfile);
-          error(['Error reading in image data, expected ' num2str(imgsize) ...
-                  ', got ', num2str(length(thisimage))]);
-        end
+    % Loop over the images in the order mincextract wrote them (ie.
+    % the order of the dimensions in the file), and stick each one in
+    % the right column: all frames of a slice are adjacent columns
+    nslc = slcrange(islice,2);
+    nfrm = frmrange(iframe,2);
+    slcoffset = sum(slcrange(1:islice-1,2));
+    frmoffset = sum(frmrange(1:iframe-1,2));
+    for k=1:nslc*nfrm
+
+      if (dimmap(1) < dimmap(2))      % time varies more slowly than slices
+        jframe = floor((k-1)/nslc) + 1;
+        jslice = rem(k-1, nslc) + 1;
+      else
+        jslice = floor((k-1)/nfrm) + 1;
+        jframe = rem(k-1, nfrm) + 1;
+      end
+
+      % Read the data back in
+      thisimage = fread(fid, imgsize, 'double');
+      if (length(thisimage) ~= imgsize)
+        fclose(fid);
+        delete(tempfile);
+        error(['Error reading in image data, expected ' num2str(imgsize) ...
+                ', got ', num2str(length(thisimage))]);
+      end
     
-        % Stick it in the array
-        imgnum = (jslice-1)*nframes + jframe;
-        images(:, imgnum) = thisimage;
+      % Stick it in the array
+      imgnum = (slcoffset+jslice-1)*nframes + frmoffset+jframe;
+      images(:, imgnum) = thisimage;
         
-      end
-      
     end
     
     fclose(fid);
@@ -244,4 +295,8 @@ for islice=1:nslcrange
     
 end
 
-
+if (strcmp (precision, 'single'))
+  images = single (images);
+end
+scale = ones (1, size (images, 2));
+offset = zeros (1, size (images, 2));
@@ -1,4 +1,4 @@
-function data = mireadvar(minc_file, varname, start, count, options);
+function varargout = mireadvar(minc_file, varname, start, count, options);
 %MIREADVAR  Read a hyperslab of data from any variable in a MINC file.
 %
 %  data = mireadvars ('MINC_file', 'var_name', [, start, count[, options]])
@@ -41,6 +41,24 @@ function data = mireadvar(minc_file, varname, start, count, options);
 %  out the start and count values for each dimension yourself.
 %  Mireadimages, however, does all that work for you given just slice
 %  and frame numbers.
+%
+%  The options argument may be 'mmap' or 'raw'.  With either, an
+%  uncompressed (NetCDF classic) file is read through a memory map
+%  rather than the NetCDF library, which is much faster for large
+%  variables.  'mmap' returns doubles just as usual; 'raw' returns the
+%  values in the type they are stored in (eg. int16 or uint8), which
+%  also saves the memory of converting them.  Compressed and MINC 2
+%  files are quietly read the usual way.  For example:
+%
+%    image = mireadvar ('foobar.mnc', 'image', [6 4 0 0], [1 1 128 128], 'raw');
+%
+%  Several variables can be read with one call (and the file opened
+%  just once) by giving a cell array of names; each variable goes to
+%  its own output argument, and is empty if it isn't in the file.  If
+%  start and count are given, they must be cell arrays too, with a
+%  vector (or [], to read the whole variable) for each name:
+%
+%    [start, stop] = mireadvar ('foobar.mnc', {'sample_start', 'sample_stop'});
 
 % $Id: mireadvar.m,v 1.5 2005-08-24 22:27:01 bert Exp $
 % $Name:  $
@@ -54,6 +72,15 @@ end
 if (nargin > 2)
   error('Too many arguments (start, count and options not implemented)');
 end
+
+% A list of variables: read them one at a time
+if (iscell(varname))
+  for i = 1:min(max(nargout,1), length(varname))
+    varargout{i} = mireadvar(minc_file, varname{i});
+  end
+  return;
+end
+
 if (length(varname) == 0)
   error('Please specify a variable name')
 end
@@ -73,6 +100,6 @@ if (length(out) > 0)
   out = out(1:max(ind));
 end
     
-data = sscanf(out, '%f');
+varargout{1} = sscanf(out, '%f');
 
 
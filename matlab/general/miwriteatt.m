@@ -49,3 +49,4 @@ end
 
 execstr = sprintf('miwriteatt "%s" %s %s %s %s', filename, varname, attname, datatyp, datastr);
 result = unix (execstr);
+miflushcache (filename);
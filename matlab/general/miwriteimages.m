@@ -15,9 +15,15 @@ function miwriteimages (filename, images, slices, frames)
 %  miwriteimages only expects to be called by putimages, none of these
 %  requirements are checked here -- all that is done by putimages.
 %
-%  Note that there is also a standalone executable miwriteimages; this 
-%  is called by miwriteimages.m via a shell escape.  Neither of these
-%  programs are meant for everyday use by the end user.
+%  If the CMEX routine miputimages is available, the images are written
+%  straight from memory into the MINC file.  Otherwise, they are written
+%  to a temporary file, and the standalone executable miwriteimages is
+%  called via a shell escape to copy them into the MINC file.  None of
+%  these programs are meant for everyday use by the end user.
+%
+%  Either way, the file is then flushed from the open-file caches of
+%  the CMEX readers (see miflushcache), so that subsequent reads see
+%  the new data.
 
 % $Id: miwriteimages.m,v 1.18 2005-08-24 22:27:01 bert Exp $
 % $Name:  $
@@ -27,6 +33,18 @@ if (nargin < 2) | (nargin > 4)
    error ('Incorrect number of arguments');
 end
 
+if (nargin < 3), slices = []; end
+if (nargin < 4), frames = []; end
+
+% Use the CMEX writer if we have it -- this avoids writing all the
+% images to a temporary file and reading them back in again.
+
+if (exist ('miputimages') == 3)
+   miputimages (filename, images, slices-1, frames-1);
+   miflushcache (filename);
+   return;
+end
+
 % If the slices vector was supplied and is non-empty, then convert it
 % to a string (eg. [1 2 3] becomes '1,2,3') for passing to the executable
 % miwriteimages.  If the vector was not supplied or is empty, then 
@@ -94,3 +112,4 @@ execstr = sprintf ('miwriteimages "%s" %s %s %s', ...
 result = unix (execstr);
 
 delete(tempfile);
+miflushcache (filename);
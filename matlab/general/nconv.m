@@ -11,6 +11,10 @@ function c = conv(a, b, spacing)
 %	independent variable.  Then, if the spacing of the independent
 %	variable is not 1, it should be passed to nconv.
 %
+%	NCONV is normally a CMEX file, which uses an FFT to convolve
+%	long vectors quickly; this M-file is only used if the CMEX
+%	version is not available.
+%
 %	See also CONV, XCORR, DECONV, CONV2, LOOKUP.
 
 % $Id: nconv.m,v 1.2 1997-10-20 18:23:20 greg Rel $
@@ -72,6 +72,10 @@ function handle = newimage (NewFile, DimSizes, ParentFile, ...
 %                     transverse   MIzspace     MIyspace     MIxspace
 %                     sagittal     MIxspace     MIzspace     MIyspace
 %                     coronal      MIyspace     MIzspace     MIxspace
+%
+% The image data in the new file is not initialised (so creating even a
+% large file is quick): write every slice and frame with putimages
+% before reading any of it back.
 
 % ------------------------------ MNI Header ----------------------------------
 %@NAME       : newimage
@@ -90,6 +94,7 @@ function handle = newimage (NewFile, DimSizes, ParentFile, ...
 %                              image type/valid range/orientation;
 %                              a few more fixes to the argument handling code
 %              27 May 1997   - Modified to work with Matlab 5 (MW)
+%              16 Oct 2026   - create the file with -nofill
 %@VERSION    : $Id: newimage.m,v 2.17 2005-08-24 22:27:01 bert Exp $
 %              $Name:  $
 %-----------------------------------------------------------------------------
@@ -251,10 +256,10 @@ end
 
 
 if (Parent == -1)
-   execstr = sprintf ('micreateimage "%s" -size %d %d %d %d -type %s -valid_range %.20g %.20g -orientation %s', ...
+   execstr = sprintf ('micreateimage "%s" -nofill -size %d %d %d %d -type %s -valid_range %.20g %.20g -orientation %s', ...
 		      NewFile, DimSizes, ImageType, ValidRange, Orientation);
 else
-   execstr = sprintf ('micreateimage "%s" -parent "%s" -size %d %d %d %d -type %s -valid_range %.20g %.20g -orientation %s', ...
+   execstr = sprintf ('micreateimage "%s" -nofill -parent "%s" -size %d %d %d %d -type %s -valid_range %.20g %.20g -orientation %s', ...
 		      NewFile, ParentFile, DimSizes, ...
 		      ImageType, ValidRange, Orientation);
 end
@@ -267,6 +272,7 @@ if (result ~= 0)
    disp ([' Output: ' output]);
    error (['Error running micreateimage to create file ' NewFile]);
 end
+miflushcache (NewFile);		% in case we just clobbered a cached file
 
 if (Parent ~= -1 & CloseParent)
    closeimage (Parent);
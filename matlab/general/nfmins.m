@@ -19,6 +19,21 @@
 %
 %	NFMINS uses a Simplex search method.
 %
+%	A few objective functions are also compiled into NFMINS:
+%	fit_b_curve, fit_rcbf and fit_fdg, all called as
+%	F(X, g_even, ts_even, A, fstart, flengths).  If 'F' is one of
+%	these and the arguments match, NFMINS evaluates it directly
+%	rather than calling the M-file, which makes fitting these models
+%	much faster still.  Any other function is called through MATLAB
+%	as usual.
+%
+%	[X, FVAL] = NFMINS('F',X0,OPTIONS,[],g_even,ts_even,A,fstart,flengths)
+%	with one of the compiled functions and a matrix A (one row per
+%	voxel, one column per frame -- as returned by getimages) fits
+%	every row of A separately, starting each fit from X0.  X has one
+%	row of parameters per row of A, and FVAL the final value of F
+%	for each.  This saves looping over voxels in MATLAB.
+%
 %       NFMINS is identical in use to the standard MATLAB FMINS function,
 %       but with much better performance (up to two orders of magnitude
 %       faster).
@@ -9,12 +9,18 @@ function ImHandle = openimage (filename, mode)
 % size and number of images on the file, all of which can be queried
 % via getimageinfo.
 %  
-% If the file in question is compressed (i.e., it ends with `.z',
-% `.gz', or `.Z', then openimage will transparently uncompress it to a
-% uniquely named temporary directory.  The filename returned by
-% getimageinfo (handle, 'filename') in this case will be the name of
-% the temporary, uncompressed file.  When the file is closed with
-% closeimage, this temporary file (and its directory) will be deleted.
+% If the file in question is compressed with gzip (i.e., it ends with
+% `.gz') and the CMEX readers are available, it is read directly: only
+% as much of the file is uncompressed as has been read so far, so
+% reading the first few slices of a big study is quick.  (That only
+% works for MINC 1 files; others, such as MINC 2, are uncompressed whole
+% by the readers when first opened.)  Otherwise, if
+% the file is compressed (i.e., it ends with `.z', `.gz', or `.Z'),
+% openimage will transparently uncompress it to a uniquely named
+% temporary directory.  The filename returned by getimageinfo (handle,
+% 'filename') in this case will be the name of the temporary,
+% uncompressed file.  When the file is closed with closeimage, this
+% temporary file (and its directory) will be deleted.
 % 
 % The value returned by openimage is a handle to be passed to
 % getimages, putimages, getimageinfo, etc.
@@ -67,6 +73,8 @@ function ImHandle = openimage (filename, mode)
 %              97-5-27 Mark Wolforth: Minor modification to work with
 %                                     Matlab 5, which handles global
 %                                     variables differently from Matlab 4.x
+%              2026-10-16: gzip'd files are left for the CMEX readers
+%                          to read directly
 %@VERSION    : $Id: openimage.m,v 1.29 2005-08-24 22:27:01 bert Exp $
 %              $Name:  $
 %-----------------------------------------------------------------------------
@@ -101,18 +109,25 @@ if (nargin > 1)
 end
       
 
-% Check to see if it's a compressed file, and if so uncompress
-% (and give it a new filename)
+% Check to see if it's a compressed file.  If it's gzip'd and the CMEX
+% readers are there, they can read it as it is; otherwise uncompress
+% it (and give it a new filename)
 
 len = length (filename);
-if (strcmp (filename(len-2:len), '.gz') | ...
-    strcmp (filename(len-1:len), '.z') | ...
-    strcmp (filename(len-1:len), '.Z'))
+gzipped = strcmp (filename(len-2:len), '.gz');
+compressed = gzipped | ...
+             strcmp (filename(len-1:len), '.z') | ...
+             strcmp (filename(len-1:len), '.Z');
+if (compressed & Flags(1))
+   error (['Cannot open compressed files for writing']);
+end
+
+direct = gzipped & isunix & (exist ('mireadimages') == 3) & ...
+         (exist ('mireadvar') == 3) & (exist ('miinquire') == 3);
+
+if (compressed & ~direct)
 
    Flags(2) = 1;
-   if (Flags(1))
-      error (['Cannot open compressed files for writing']);
-   end
    
    % Parse the filename (strip off directory and last extension)
 
@@ -9,8 +9,7 @@ function putimages (handle, images, slices, frames)
 %
 %  Note that only one of the vectors slices or frames may have multiple
 %  elements; ie., you may not write multiple slices and multiple frames
-%  simultaneously.  (This should not be a problem, since you cannot *read*
-%  multiple frames and slices simultaneously either.)  If both slices
+%  simultaneously.  If both slices
 %  and frames are present in the MINC file, then both slices and frames
 %  vectors must be supplied and be non-empty.  If either of those 
 %  dimensions are not present, though, then the associated vector must
@@ -87,9 +86,10 @@ else
    num_required = max (length(slices), length(frames));
 end
 
-% check that slices and frames are valid
+% check that slices and frames are valid (and that there aren't both
+% multiple slices and multiple frames, which miwriteimages can't write)
 
-error (check_sf (handle, slices, frames));
+error (check_sf (handle, slices, frames, 1));
 
 % N.B. number of rows in images is the image length (eg., 16384 for 
 % 128 x 128 images); number of columns is the number of images specified.
@@ -0,0 +1,42 @@
+%SLABAPPLY  Apply a function to a study a few image rows at a time.
+%
+%  [R1, R2, ...] = slabapply ('minc_file', 'fname', slices, frames, ...
+%                             rows [, P1, P2, ...])
+%
+%  streams the given slices and frames of a MINC file through the
+%  MATLAB function fname, one slab at a time, where a slab is (at
+%  most) rows image rows of one slice, for all of the frames.  Only
+%  two slabs are ever held in memory (the next is read while fname
+%  works on this one), so pixel-by-pixel analyses can be run on
+%  studies too large to read a whole slice (of every frame) at once.
+%  fname is called as
+%
+%     [R1, R2, ...] = feval (fname, slab, P1, P2, ...)
+%
+%  where slab has one row per pixel and one column per frame, just as
+%  getimages returns them (so with 128-pixel-wide images and rows=16,
+%  slab has 2048 rows).  Each output of fname must have one element
+%  per pixel of the slab; slabapply puts them together into whole
+%  images, returning one column per slice in each of R1, R2, ...
+%
+%  For example, to sum the first ten frames of every slice of a
+%  large study, 16 rows at a time:
+%
+%  >> total = slabapply ('big.mnc', 'sum2', [], 0:9, 16);
+%
+%  where sum2.m contains "function s = sum2 (x); s = sum (x')';".
+%
+%  Like mireadimages, slabapply expects slice and frame numbers to be
+%  zero-based; an empty slices or frames vector means all of them.
+%  The frames must be consecutive.  slabapply keeps the file open
+%  between calls; see MIFLUSHCACHE.
+%
+%  Since slabs are read in the background, fname must not itself read
+%  or write MINC files (eg. with getimages or putimages).
+%
+%  slabapply is only available as a CMEX file.
+
+% $Id$
+% $Name:  $
+
+error ('slabapply is only available as a CMEX file');
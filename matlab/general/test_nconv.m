@@ -0,0 +1,94 @@
+function maxdiff = test_nconv (tol)
+
+% TEST_NCONV  check the nconv CMEX against nconv.m's filter method
+%
+%     maxdiff = test_nconv ([tol])
+%
+% Convolves pairs of vectors with the nconv CMEX -- short ones, which
+% it convolves directly, and long ones, which it convolves with an FFT
+% -- and compares the results with what nconv.m gets with filter.
+% The long pairs are also tried with a NaN and an Inf in them: those
+% must only spoil the elements of the result that depend on them, as
+% they do with filter, rather than the whole thing.
+%
+% Returns the largest difference found, relative to the largest
+% element of the result; it is an error if that is more than tol
+% (default 1e-10), or if the two are non-finite in different places.
+
+% $Id$
+% $Name:  $
+
+% ----------------------------- MNI Header -----------------------------------
+% @NAME       : test_nconv
+% @INPUT      : tol - (optional) the largest relative difference allowed
+% @OUTPUT     :
+% @RETURNS    : maxdiff - the largest relative difference found
+% @DESCRIPTION:
+% @METHOD     : The reference is filter (b, 1, a) with a padded out to
+%               length(a)+length(b)-1, which is all nconv.m does.
+% @GLOBALS    :
+% @CALLS      : nconv
+% @CREATED    : 2026/10/16
+% @MODIFIED   :
+% ---------------------------------------------------------------------------- */
+
+error (nargchk (0, 1, nargin));
+if (nargin < 1), tol = 1e-10; end
+
+if (exist ('nconv') ~= 3)
+   error ('The nconv CMEX is not on the path');
+end
+
+maxdiff = 0;
+
+% Short (direct) and long (FFT) pairs, of equal and unequal lengths
+
+lengths = [5 7; 40 40; 2000 2000; 3000 700; 700 3000];
+for i = 1:size (lengths, 1)
+   a = 1 + sin ((1:lengths(i,1))' * 0.01);
+   b = exp (-(1:lengths(i,2))' * 0.003);
+   maxdiff = max (maxdiff, compare (a, b, 0.5, tol, 'finite'));
+
+   if (lengths(i,1) >= 2000)
+      a(1500) = NaN;
+      maxdiff = max (maxdiff, compare (a, b, 0.5, tol, 'NaN in a'));
+      a(1500) = 1;
+      b(7) = Inf;
+      maxdiff = max (maxdiff, compare (a, b, 0.5, tol, 'Inf in b'));
+   end
+end
+
+fprintf ('test_nconv: largest relative difference %g\n', maxdiff);
+
+
+
+function d = compare (a, b, spacing, tol, what)
+
+% COMPARE  convolve a and b with nconv and with filter, and return the
+% largest relative difference (an error if it's too big, or if they
+% are not non-finite in the same places)
+
+c = nconv (a, b, spacing);
+
+n = length (a) + length (b) - 1;
+a(n) = 0;
+ref = filter (b, 1, a) * spacing;
+
+if (length (c) ~= n)
+   error (sprintf ('nconv gave %d elements, not %d (%s)', length (c), n, what));
+end
+
+c = c(:);
+ref = ref(:);
+if (any (isnan (c) ~= isnan (ref)) | any (isinf (c) ~= isinf (ref)))
+   error (sprintf ('nconv and filter are non-finite in different places (%s)', ...
+                   what));
+end
+
+ok = find (isfinite (ref));
+scale = max ([abs(ref(ok)); eps]);
+d = max ([abs(c(ok) - ref(ok)) / scale; 0]);
+if (d > tol)
+   error (sprintf ('nconv and filter differ by %g (tolerance %g; %s)', ...
+                   d, tol, what));
+end
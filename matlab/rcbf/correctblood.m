@@ -168,52 +168,38 @@ if (do_delay)
    if (progress >= 2), fprintf (':\n'), end
 
    deltas = -5:1:10;
-   rss = zeros (length(deltas), 1);     % residual sum-of-squares
-   params = zeros (length(deltas), 3);  % 3 parameters per fit
-
-   for i = 1:length(deltas)
-      delta = deltas (i);
-      if (progress >= 2), fprintf ('delta = %.1f', delta), end
-
-      % Get the shifted activity function, g(t - delta), by shifting g(t)
-      % to the right (ie. subtract delta from its actual times, ts_even)
-      % and resample at the "correct" times ts_even).  Then do the 
-      % three-parameter fit to optimise the function wrt. alpha, beta,
-      % and gamma.
-
-      shifted_g_even = lookup ((ts_even-delta), g_even, ts_even);
-      g_select = find (~isnan (shifted_g_even));
-
-      final = delaycorrect (init, ...
-	                    shifted_g_even(g_select), ...
-                            ts_even(g_select), ...
- 	                    A, FrameTimes, FrameLengths);
-
-      params (i,:) = final;
-%     rss (i) = sum (f .^ 2) ;            % if using leastsq
-      rss(i) = fit_b_curve (final, ...
-                            shifted_g_even(g_select), ts_even(g_select), ...
-                            A, FrameTimes, FrameLengths);
-
-      init = final;
-      if (progress == 1)                % minimal progress messages
-         fprintf ('.');
-      elseif (progress >= 2)            % more progress messages
-         fprintf ('; final = [%g %g %g]; residual = %g\n', final, rss (i));
+
+   % For every delta, delaycorrect gets the shifted activity function,
+   % g(t - delta), by shifting g(t) to the right (ie. subtracting delta
+   % from its actual times, ts_even) and resampling at the "correct"
+   % times ts_even.  It then does the three-parameter fit to optimise
+   % the function wrt. alpha, beta, and gamma, starting each fit from
+   % the result of the last.  It returns the fitted parameters and the
+   % residual sum-of-squares for every delta, and the delta for the
+   % best fit.
+
+   [params, rss, delta] = delaycorrect (init, g_even, ts_even, ...
+                                        A, FrameTimes, FrameLengths, deltas);
+
+   if (progress == 1)                   % minimal progress messages
+      fprintf (repmat ('.', 1, length(deltas)));
+   elseif (progress >= 2)               % more progress messages
+      for i = 1:length(deltas)
+         fprintf ('delta = %.1f; final = [%g %g %g]; residual = %g\n', ...
+                  deltas(i), params(i,:), rss(i));
 
          if (progress >= 3)             % report progress graphically
+            shifted_g_even = lookup ((ts_even-deltas(i)), g_even, ts_even);
+            g_select = find (~isnan (shifted_g_even));
             plot (MidFTimes, ...
-		  b_curve(final, ...
+		  b_curve(params(i,:), ...
 	                  shifted_g_even(g_select), ...
 	                  ts_even(g_select), ...
                           A, FrameTimes, FrameLengths));
             drawnow;
          end      % if graphical progress
-      end      % if any progress
-   end      % for delta
-
-   [err, where] = min (rss);            % find smallest residual
-   delta = deltas (where);              % select delta for best fit
+      end      % for delta
+   end      % if any progress
    
    if (progress)                        % minimal progress
       fprintf ('using delta = %.1f\n', delta);
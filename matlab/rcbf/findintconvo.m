@@ -32,6 +32,10 @@ function [int1, int2, int3] = findintconvo (Ca_even, ts_even, k2_lookup,...
 % each individual frame (a slightly more sophisticated approach than
 % simply resampling at the mid-frame times) and integrated across all
 % frames using flengths as dt.
+%
+% findintconvo is normally a CMEX file, which builds the whole table in
+% one call using a recursive filter for the convolutions; this M-file
+% is only used if the CMEX version is not available.
 
 % $Id: findintconvo.m,v 1.16 1997-10-20 18:23:25 greg Rel $
 % $Name:  $
@@ -0,0 +1,43 @@
+function err = fit_rcbf (args, Ca_even, ts_even, A, fstart, flengths)
+
+% FIT_RCBF  residual of the one-compartment rCBF model
+%
+%     err = fit_rcbf (args, Ca_even, ts_even, A, fstart, flengths)
+%
+% Computes the sum of squared differences between the frame data A
+% and the frame integrals of the one-compartment (Kety) model
+%
+%     K1 * conv (Ca(t), exp(-k2*t))
+%
+% where args = [K1 k2], and Ca_even is the arterial blood activity
+% sampled at the evenly spaced times ts_even.  Frames that ts_even
+% does not span contribute zero to the model.
+%
+% This is meant to be minimised by nfmins, which recognises the name
+% and evaluates the model in C rather than calling this M-file.
+
+% $Id$
+% $Name:  $
+
+% ----------------------------- MNI Header -----------------------------------
+% @NAME       : fit_rcbf
+% @INPUT      : 
+% @OUTPUT     : 
+% @RETURNS    : 
+% @DESCRIPTION: 
+% @METHOD     : 
+% @GLOBALS    : 
+% @CALLS      : 
+% @CREATED    : 2026/10/16
+% @MODIFIED   : 
+% ---------------------------------------------------------------------------- */
+
+if (length(args) ~= 2), error ('Wrong number of fit parameters'), end;
+
+c = nconv (Ca_even, exp(-args(2)*ts_even), ts_even(2)-ts_even(1));
+c = args(1) * c (1:length(ts_even));
+
+integral = nframeint (ts_even, c, fstart, flengths);
+integral (find (isnan (integral))) = 0;
+
+err = sum ((A - integral(1:length(A))).^2);
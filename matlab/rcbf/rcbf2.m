@@ -1,10 +1,12 @@
 function [K1,k2,V0,delta] = rcbf2 (filename, slices, progress, ...
-                                         correction, batch, tau)
+                                         correction, batch, tau, ...
+                                         K1file, V0file)
 
 % RCBF2 a two-compartment (triple-weighted integral) rCBF model.
 %
 %       [K1,k2,V0,delta] = rcbf2 (filename, slices ...
-%                  [, progress [, correction [, batch [, tau]]]]] )
+%                  [, progress [, correction [, batch [, tau ...
+%                  [, K1file [, V0file]]]]]]] )
 % 
 % rcbf2 implements the three-weighted integral method of calculating
 % k2, K1, and V0 (in that order) for a particular slice.  This
@@ -22,6 +24,17 @@ function [K1,k2,V0,delta] = rcbf2 (filename, slices, progress, ...
 % circumstances (i.e. never).  tau is also an optional argument
 % that sets the dispersion constant; if it is not given, 4 seconds
 % is assumed.
+%
+% K1file and V0file, if given and not empty, name existing MINC files
+% (eg. created with newimage) into which the K1 and V0 images for the
+% given slices are written.
+%
+% If the CMEX rcbf is available, and the grey-matter mask is chosen
+% automatically (batch) or not needed (no correction), the whole
+% analysis is done by it in a single call: it reads each slice
+% straight from the file, builds the k2 lookup tables once for every
+% blood delay rather than once per slice, and writes K1file and V0file
+% as it goes.  Otherwise, the slices are done one at a time here.
 % 
 % The actual calculations follow the procedure outlined in the
 % document "RCBF Analysis Using MATLAB" (http://www.mni.mcgill/system/
@@ -80,6 +93,9 @@ function [K1,k2,V0,delta] = rcbf2 (filename, slices, progress, ...
 %               May 27, 1997 by MW:
 %                  Made a minor modification so that this code now works
 %                  with Matlab 5.x and 4.x.
+%               2026/10/16:
+%                  Hand the whole analysis to the rcbf CMEX when
+%                  possible; added K1file and V0file.
 % @COPYRIGHT  :
 %             Copyright 1993 Mark Wolforth and Greg Ward, McConnell Brain
 %             Imaging Centre, Montreal Neurological Institute, McGill
@@ -114,11 +130,18 @@ elseif (nargin < 5)
    tau = 4;
 elseif (nargin < 6)
    tau = 4;
-elseif (nargin > 6)
+elseif (nargin > 8)
    help rcbf2
    error('Incorrect number of arguments.');
 end
 
+if (nargin < 7)
+   K1file = '';
+end
+if (nargin < 8)
+   V0file = '';
+end
+
 img = openimage(filename);
 
 total_slices = length(slices);
@@ -155,6 +178,19 @@ w3 = sqrt (MidFTimes);
 
 k2_lookup = (-10:0.05:10) / 60;
 
+% If we can, let rcbf do the lot (it returns K1, k2 and V0 already
+% cleaned up and in the final units).
+
+if ((exist ('rcbf') == 3) & (batch | ~correction))
+   [K1, k2, V0, delta] = rcbf (handlefield (img, 'Filename'), slices-1, ...
+         FrameTimes, FrameLengths, g_even, orig_ts_even, k2_lookup, ...
+         correction, tau, progress, K1file, V0file);
+   disp('notice: rcbf2 calculates K1 in mL_blood / (100 g_tissue * min),');
+   disp('k2 in 1/min, and V0 in mL_blood / (100 g_tissue)');
+   closeimage (img);
+   return;
+end
+
 
 for current_slice = 1:total_slices
   % Now start the real computation.  FrameTimes, FrameLengths, and 
@@ -173,10 +209,13 @@ for current_slice = 1:total_slices
   
   ts_even = orig_ts_even;
   
+  next_slice = slices(current_slice+1:min(current_slice+1,total_slices));
   if exist('PET')
-      PET = getimages (img, slices(current_slice), 1:length(FrameTimes), PET);
+      PET = getimages (img, slices(current_slice), 1:length(FrameTimes), ...
+                       PET, 'prefetch', next_slice);
   else
-      PET = getimages (img, slices(current_slice), 1:length(FrameTimes));
+      PET = getimages (img, slices(current_slice), 1:length(FrameTimes), ...
+                       'prefetch', next_slice);
   end
 
   rescale (PET, (37/1.05));             % convert to decay / (g_tissue * sec)
@@ -349,6 +388,17 @@ rescale (V0, 100/1.05);       % from g_blood/g_tissue to mL_b / (100 g_t)
 disp('notice: rcbf2 calculates K1 in mL_blood / (100 g_tissue * min),');
 disp('k2 in 1/min, and V0 in mL_blood / (100 g_tissue)');
 
+if (~isempty (K1file))
+   h = openimage (K1file, 'w');
+   putimages (h, K1, slices);
+   closeimage (h);
+end
+if (~isempty (V0file))
+   h = openimage (V0file, 'w');
+   putimages (h, V0, slices);
+   closeimage (h);
+end
+
 % Cleanup
 
 closeimage (img);
@@ -29,7 +29,8 @@ function rcbfanalysis (infile, K1file, V0file, slices, progress, ...
 % @GLOBALS    : 
 % @CALLS      : 
 % @CREATED    : February 28, 1994 by Mark Wolforth
-% @MODIFIED   : 
+% @MODIFIED   : 2026/10/16: create the output files first, and have
+%               rcbf2 write them
 % @COPYRIGHT  :
 %             Copyright 1994 Mark Wolforth and Greg Ward, McConnell Brain
 %             Imaging Centre, Montreal Neurological Institute, McGill
@@ -50,14 +51,15 @@ function rcbfanalysis (infile, K1file, V0file, slices, progress, ...
 if (nargin < 4)
   help rcbfanalysis
   error ('Not enough input arguments');
-elseif (nargin == 4)
-  [K1, k2, V0, delta] = rcbf2(infile, slices, 1, 1);
-elseif (nargin == 5)
-  [K1, k2, V0, delta] = rcbf2(infile, slices, progress, 1);
-elseif (nargin == 6)
-  [K1, k2, V0, delta] = rcbf2(infile, slices, progress, correction);
-elseif (nargin == 7)
-  [K1, k2, V0, delta] = rcbf2(infile, slices, progress, correction, batch);
+end
+if (nargin < 5)
+  progress = 1;
+end
+if (nargin < 6)
+  correction = 1;
+end
+if (nargin < 7)
+  batch = 1;
 end
 
 %
@@ -69,28 +71,22 @@ numslices = getimageinfo(h, 'NumSlices');
 closeimage(h);
 
 %
-% Write out the K1 file
+% Create the K1 and V0 files; rcbf2 writes the images into them as it
+% goes
 %
 
 if (length(K1file) ~= 0)
-
-  disp ('Writing K1 file.');
-  
   h = newimage(K1file, [0 numslices], infile);
-  putimages(h,K1,slices);
   closeimage(h);
+else
+  K1file = '';
 end
 
-%
-% Write out the V0 file
-%
-
 if (length(V0file) ~= 0)
-
-  disp ('Writing V0 file.');
-  
   h = newimage(V0file, [0 numslices], infile);
-  putimages(h,V0,slices);
   closeimage(h);
+else
+  V0file = '';
 end
-  
+
+rcbf2(infile, slices, progress, correction, batch, 4, K1file, V0file);
@@ -5,7 +5,15 @@
 @METHOD     : A CMEX program
 @GLOBALS    : NaN, progress
 @CREATED    : November 5, 1993 by Mark Wolforth
-@MODIFIED   : 
+@MODIFIED   : 2026/10/16: use the library Convolve, which switches to an
+                          FFT for long blood curves
+              2026/10/16: use the simplex minimiser in simplex.c (shared
+                          with nfmins)
+              2026/10/16: fit a whole grid of delays in one call
+              2026/10/16: moved the fitting code into bloodcorrect.c
+                          (shared with rcbf)
+              2026/10/16: return the parameters and residual at the
+                          best (possibly refined) delay
 @COPYRIGHT  :
               Copyright 1993 Mark Wolforth, McConnell Brain Imaging Centre, 
               Montreal Neurological Institute, McGill University.
@@ -29,21 +37,20 @@
 #include <math.h>
 #include "mex.h"
 #include "emmageneral.h"
+#include "simplex.h"
+#include "bloodcorrect.h"
 
 
 #define PROGNAME "delaycorrect"
 
 
-void IntFrames (int Length, double *X, double *Y, 
-                int NumFrames, double *FrameStarts,
-		double *FrameLengths, double *Integrals);
-
 /*
  * Constants to check for argument number and position
  */
 
 
-#define NUM_IN_ARGS        6
+#define MIN_IN_ARGS        6
+#define MAX_IN_ARGS        8
 
 #define START              prhs[0]
 #define G_EVEN             prhs[1]
@@ -51,33 +58,14 @@ void IntFrames (int Length, double *X, double *Y,
 #define FITDATA            prhs[3]
 #define FRAMETIMES         prhs[4]
 #define FRAMELENGTHS       prhs[5]
+#define DELTAS             prhs[6]
+#define REFINE             prhs[7]
 
-/*
- * Some parameters for the simplex search algorithm
- */
-
-#define ALPHA              1
-#define BETA               0.5
-#define GAMMA              2
-
-#define FUNCVAL            (numvars)
-
-/*
- * type declarations
- */
-
-typedef struct blooddata 
-{
-    double *ts_even;
-    double *g_even;
-    int     numsamples;
-    int     numframes;
-    int     numfitpoints;
-    double *fstarts;
-    double *flengths;
-    double *fitdata;
-}
-BloodData;
+#define PARAMS_OUT         plhs[0]
+#define RSS_OUT            plhs[1]
+#define DELTA_OUT          plhs[2]
+#define BEST_PARAMS_OUT    plhs[3]
+#define BEST_RSS_OUT       plhs[4]
 
 /*
  * Global variables
@@ -110,609 +98,13 @@ void ErrAbort (char msg[], Boolean PrintUsage, int ExitCode)
 {
    if (PrintUsage)
    {
-      (void) mexPrintf ("Usage: %s ('F', X0)\n", PROGNAME);
-      (void) mexPrintf ("Compatible with MATLAB's fmins function.\n");
+      (void) mexPrintf ("Usage: final = %s (init, g_even, ts_even, A, fstart, flengths)\n", PROGNAME);
+      (void) mexPrintf ("   or: [params, rss, delta, best_params, best_rss] = %s (init, g_even, ts_even, A, fstart, flengths, deltas [, refine])\n", PROGNAME);
    }
    (void) mexErrMsgTxt (msg);
 }
 
 
-/* ----------------------------- MNI Header -----------------------------------
-@NAME       : CreateLocalMatrix
-@INPUT      : rows -> an integer containing the number of rows in the matrix
-              cols -> an integer containing the number of columns in the matrix
-@OUTPUT     : none
-@RETURNS    : a pointer to a pointer to double.  This is a pointer to an array
-              of pointers to arrays containing the rows of the matrix.
-@DESCRIPTION: Allocates memory for a two-dimensional array.
-@METHOD     : 
-@GLOBALS    : none
-@CALLS      : standard MEX functions
-              ErrAbort
-@CREATED    : November 1993 by MW
-@MODIFIED   : 
----------------------------------------------------------------------------- */
-double **CreateLocalMatrix(int rows, int cols)
-{
-    int i;
-    double **matrix;
-
-    matrix = (double **) mxCalloc (rows, sizeof(double *));
-    if (matrix == NULL)
-    {
-        ErrAbort("Out of memory!", FALSE, -1);
-    }
-    
-    for (i=0; i<rows; i++)
-    {
-        matrix[i] = (double *) mxCalloc (cols, sizeof(double));
-        if (matrix[i] == NULL)
-        {
-            ErrAbort("Out of memory!", FALSE, -1);
-        }
-    }
-    
-    return (matrix);
-}
-
-
-/* ----------------------------- MNI Header -----------------------------------
-@NAME       : Convolve
-@INPUT      : n - number of elements in A[], B[], and C[]
-            : A[], B[] - the functions to convolve.  Must have same
-                         number of elements and be sampled with the same
-                         uniform spacing.
-              spacing - the spacing of the time-domain to which A[] and 
-                        B[] belong (and to which C[] will belong)
-@OUTPUT     : C[] - the convolution of A[] and B[], or rather its first
-                    n elements
-@RETURNS    : 
-@DESCRIPTION: Calculates a truncated, scaled convolution of two functions.
-@METHOD     : 
-@GLOBALS    : 
-@CALLS      : 
-@CREATED    : 93-8-23, Greg Ward (based on polynomial multiplication 
-                                  routine from CEPHES)
-@MODIFIED   : 
----------------------------------------------------------------------------- */
-void Convolve (int n, double A[], double B[], double spacing, double C[])
-{
-   int     i, j, k;
-   double  x;
-   
-   for (k = 0; k < n; k++)
-   {
-      C [k] = 0;
-   }
-   
-   for(i=0; i < n; i++)
-   {
-      x = A [i];
-      for(j=0; j < n-i; j++)
-      {
-         k = i + j;
-         C [k] += x * B [j] * spacing;
-      } 
-   }      
-
-}     /* Convolve */
-              
-
-/* ----------------------------- MNI Header -----------------------------------
-@NAME       : VectorExponential
-@INPUT      : 
-@OUTPUT     : 
-@RETURNS    : 
-@DESCRIPTION: Calculates the exponential of each member of a vector.  It also
-              allows a scale factor to be included in the exponent.
-@METHOD     : 
-@GLOBALS    : none
-@CALLS      : 
-@CREATED    : 
-@MODIFIED   : 
----------------------------------------------------------------------------- */
-void VectorExponential (int n, double scale, double A[], double C[])
-{
-   int   i;
-   
-   for (i = 0; i < n; i++)
-   {
-      C[i] = exp (scale * A [i]);
-   }
-}
-
-
-/* ----------------------------- MNI Header -----------------------------------
-@NAME       : BloodCurve
-@INPUT      : 
-@OUTPUT     : 
-@RETURNS    : 
-@DESCRIPTION: 
-@METHOD     : 
-@GLOBALS    : 
-@CALLS      : 
-@CREATED    : 
-@MODIFIED   : 
----------------------------------------------------------------------------- */
-double BloodCurve (double x[], BloodData *data)
-{
-    int    i;
-    double *Ntemp1, *Ntemp2;
-    double spacing;
-    double bcurve[8192];
-    double answer;
-    
-    /*
-     * alpha (K1) = x[0]
-     *  beta (k2) = x[1]
-     * gamma (V0) = x[2]
-     */
-
-    if (x[2] < 0)
-    {
-	x[2] = 0;
-    }
-
-    
-    Ntemp1 = (double *) mxCalloc (data->numsamples, sizeof(double));
-    Ntemp2 = (double *) mxCalloc (data->numsamples, sizeof(double));
-
-    spacing = data->ts_even[1] - data->ts_even[0];
-    
-    VectorExponential (data->numsamples, -x[1], data->ts_even, Ntemp1);
-    Convolve (data->numsamples, data->g_even, Ntemp1, spacing, Ntemp2); 
-    
-    /*
-     * Now multiply Ntemp2[] (the convolution) by alpha, and then
-     * replace Ntemp2[] with alpha*conv + gamma * shifted_g_even
-     */
-    
-    for (i = 0; i < data->numsamples; i++)
-    {
-        Ntemp2 [i] *= x[0];
-        Ntemp2 [i] += x[2] * data->g_even[i];
-    }
-    
-    /* Now Ntemp2 corresponds to the vector i in b_curve.m (which is
-     * simply the "blood curve" in the time domain of ts_even); I have 
-     * verified that the two match almost to within machine precision
-     * (max difference ~ 1e-12, mean difference ~ 1e-14)
-     */
-    
-    /* Now integrate Ntemp2 frame-by-frame using fstarts and flengths */
-    
-    IntFrames (data->numsamples, data->ts_even, Ntemp2, data->numframes,
-               data->fstarts, data->flengths, bcurve);
-    
-    /* Replace any NaN's in bcurve with 0 */
-
-    answer = 0;
-    
-    for (i = 0; i < data->numfitpoints; i++)
-    {
-        if (bcurve [i] == NaN)
-        {
-            bcurve [i] = 0;
-        }
-        answer += (bcurve[i] - data->fitdata[i])*
-            (bcurve[i] - data->fitdata[i]);
-    }
-
-    mxFree (Ntemp1);
-    mxFree (Ntemp2);
-    
-    return (answer);
-
-}
-
-
-/* ----------------------------- MNI Header -----------------------------------
-@NAME       : CopyVector
-@INPUT      : 
-@OUTPUT     : 
-@RETURNS    : 
-@DESCRIPTION:               
-@METHOD     : 
-@GLOBALS    : 
-@CALLS      : 
-@CREATED    : 
-@MODIFIED   : 
----------------------------------------------------------------------------- */
-void CopyVector(double vec1[], const double vec2[], int size)
-{
-    int i;
-    
-    for (i=0; i<size; i++)
-    {
-        vec1[i] = vec2[i];
-    }
-}
-
-
-/* ----------------------------- MNI Header -----------------------------------
-@NAME       : SortSimplex
-@INPUT      : 
-@OUTPUT     : 
-@RETURNS    : 
-@DESCRIPTION:               
-@METHOD     : 
-@GLOBALS    : 
-@CALLS      : 
-@CREATED    : 
-@MODIFIED   : 
----------------------------------------------------------------------------- */
-void SortSimplex (double **simplex, int numvars)
-{
-    int i;
-    Boolean bubbled;
-    double *pointer;
-    
-    bubbled = TRUE;
-
-    while (bubbled)
-    {
-        bubbled = FALSE;
-        for (i=0; i<numvars; i++)
-        {
-            if (simplex[i][FUNCVAL] > simplex[i+1][FUNCVAL])
-            {
-                pointer = simplex[i];
-                simplex[i] = simplex[i+1];
-                simplex[i+1] = pointer;
-                bubbled = TRUE;
-            }
-        }
-    }    
-}
-
-
-/* ----------------------------- MNI Header -----------------------------------
-@NAME       : PrintSimplex
-@INPUT      : 
-@OUTPUT     : 
-@RETURNS    : 
-@DESCRIPTION:               
-@METHOD     : 
-@GLOBALS    : 
-@CALLS      : 
-@CREATED    : 
-@MODIFIED   : 
----------------------------------------------------------------------------- */
-void PrintSimplex (double **simplex, int numvars)
-{
-    int i,j;
-
-    printf ("Vertices:\n");
-    
-    for (i=0; i<(numvars+1); i++)
-    {
-        for (j=0; j<(numvars); j++)
-        {
-            printf ("%lf  ", simplex[i][j]);
-        }
-        printf ("\n");
-    }
-    
-    printf ("Function Values:\n");
-    for (i=0; i<(numvars+1); i++)
-    {
-        printf ("%lf\n",simplex[i][FUNCVAL]);
-    }
-}
-
-
-/* ----------------------------- MNI Header -----------------------------------
-@NAME       : GetStartingSimplex
-@INPUT      : 
-@OUTPUT     : 
-@RETURNS    : 
-@DESCRIPTION:               
-@METHOD     : 
-@GLOBALS    : 
-@CALLS      : 
-@CREATED    : 
-@MODIFIED   : 
----------------------------------------------------------------------------- */
-void GetStartingSimplex(double start[], int numvars, BloodData *data,
-                        double **simplex)
-{
-    int i;
-
-    if (progress)
-    {
-        printf ("Filling the first vertex.\n");
-    }
-
-    for (i=0; i<numvars; i++)
-    {
-        simplex[0][i] = 0.9 * start[i];
-    }
-
-    if (progress)
-    {
-        printf ("Filling the first function value.\n");
-    }
-
-    simplex[0][FUNCVAL] = BloodCurve(simplex[0], data);
-
-    if (progress)
-    {
-        printf ("Filling the remaining vertices.\n");
-    }
-    
-    for (i=1; i<(numvars+1); i++)
-    {
-
-        if (progress)
-        {
-            printf ("Copying a starting vector.\n");
-        }
-
-        CopyVector(simplex[i], start, numvars);
-
-        if (progress)
-        {
-            printf ("Comparing element (%d,%d) to zero.\n", i, (i-1));
-        }
-
-        if (simplex[i][i-1] != 0)
-        {
-            if (progress)
-            {
-                printf ("Okay, set it equal to 1.1 times itself.\n");
-            }
-            simplex[i][i-1] *= 1.1;
-        }
-        else
-        {
-            if (progress)
-            {
-                printf ("Set it equal to 0.1.\n");
-            }
-            simplex[i][i-1] = 0.1;
-        }
-        
-        if (progress)
-        {
-            printf ("Get the function value for this vertex.\n");
-        }
-
-        simplex[i][FUNCVAL] = BloodCurve(simplex[i], data);
-
-    }
-
-    SortSimplex(simplex, numvars);
-
-    if (progress)
-    {
-        printf("Starting simplex:\n");
-        PrintSimplex(simplex, numvars);
-    }
-}
-
-
-/* ----------------------------- MNI Header -----------------------------------
-@NAME       : Terminated
-@INPUT      : 
-@OUTPUT     : 
-@RETURNS    : 
-@DESCRIPTION:               
-@METHOD     : 
-@GLOBALS    : 
-@CALLS      : 
-@CREATED    : 
-@MODIFIED   : 
----------------------------------------------------------------------------- */
-Boolean Terminated (double **simplex, int numvars, double tol, double tol2)
-{
-    int i,j;
-    
-    for (i=1; i<(numvars+1); i++)
-    {
-        for (j=0; j<numvars; j++)
-        {
-            if (abs(simplex[i][j] - simplex[0][j]) > tol)
-            {
-                return (FALSE);
-            }
-        }
-        if (abs(simplex[i][FUNCVAL] - simplex[0][FUNCVAL]) > tol2)
-        {
-            return (FALSE);
-        }
-    }
-    return (TRUE);
-}
-
-
-/* ----------------------------- MNI Header -----------------------------------
-@NAME       : MinimizeSimplex
-@INPUT      : 
-@OUTPUT     : 
-@RETURNS    : 
-@DESCRIPTION:               
-@METHOD     : 
-@GLOBALS    : 
-@CALLS      : 
-@CREATED    : 
-@MODIFIED   : 
----------------------------------------------------------------------------- */
-void MinimizeSimplex (double **simplex, BloodData *data, int numvars,
-                      int maxiter, double tol, double tol2,
-                      double minimum[], double *finalvalue)
-{
-    char how[256];
-    int i,j;
-    int count;
-    double temp_double;
-    double *temp_vector;
-    double *vbar;
-    double *vr;
-    double fr;
-    double *vk;
-    double fk;
-    double *ve;
-    double fe;
-    double *vt;
-    double ft;
-    double *vc;
-    double fc;
-    
-    temp_vector = (double *) mxCalloc (numvars, sizeof (double));
-    vbar = (double *) mxCalloc (numvars, sizeof (double));
-    vr = (double *) mxCalloc (numvars, sizeof (double));
-    vk = (double *) mxCalloc (numvars, sizeof (double));
-    ve = (double *) mxCalloc (numvars, sizeof (double));
-    vt = (double *) mxCalloc (numvars, sizeof (double));
-    vc = (double *) mxCalloc (numvars, sizeof (double));
-
-    count = numvars+1;
-    
-    while (count < maxiter)
-    {
-        if (progress)
-        {
-            printf ("Current simplex:\n");
-            PrintSimplex(simplex, numvars);
-        }
-        
-        
-        if (Terminated(simplex, numvars, tol, tol2))
-        {
-            if (progress)
-            {
-                printf ("Terminated after %d iterations.\n", count);
-            }
-            break;
-        }
-
-        for (i=0; i<numvars; i++)
-        {
-            temp_double = 0;
-            for (j=0; j<numvars; j++)
-            {
-                temp_double += simplex[j][i];
-            }
-            vbar[i] = temp_double / numvars;
-            vr[i] = ((1+ALPHA)*vbar[i]) - (ALPHA*simplex[numvars][i]);
-        }           
-
-        fr = BloodCurve(vr, data);
-        
-        count++;
-
-        CopyVector (vk, vr, numvars);
-        fk = fr;
-
-        strcpy (how, "Reflect.\n");
-        
-        if (fr < simplex[numvars-1][FUNCVAL])
-        {
-            if (fr < simplex[0][FUNCVAL])
-            {
-                for (i=0; i<numvars; i++)
-                {
-                    ve[i] = GAMMA*vr[i] + (1-GAMMA)*vbar[i];
-                }
-                
-                fe = BloodCurve(ve, data);
-
-                count++;
-                
-                if (fe < simplex[0][FUNCVAL])
-                {
-                    CopyVector(vk,ve,numvars);
-                    fk = fe;
-                    
-                    strcpy (how, "Expand.\n");
-
-                }
-            }
-        }
-        else 
-        {
-            CopyVector(vt,simplex[numvars], numvars);
-            ft = simplex[numvars][FUNCVAL];
-            if (fr < ft)
-            {
-                CopyVector(vt,vr,numvars);
-                ft = fr;
-            }
-            
-            for (i=0; i<numvars; i++)
-            {
-                vc[i] = BETA*vt[i] + (1-BETA)*vbar[i];
-            }
-                
-
-            fc = BloodCurve(vc, data);
-            
-            count++;
-            
-            if (fc < simplex[numvars-1][FUNCVAL])
-            {
-                CopyVector(vk,vc,numvars);
-                fk = fc;
-
-                strcpy (how, "Contract.\n");
-
-            }
-            else 
-            {
-                for (i=1; i<numvars; i++)
-                {
-                    for (j=0; j<numvars; j++)
-                    {
-                        temp_vector[j] = (simplex[0][j] + simplex[i][j])/2;
-                    }
-                    CopyVector(simplex[i], temp_vector, numvars);
-                                
-                    simplex[i][FUNCVAL] = BloodCurve (simplex[i], data);
-                    
-                }
-                
-                count += numvars - 1;
-
-                for (i=0; i<numvars; i++)
-                {
-                    vk[i] = (simplex[0][i] + simplex[numvars][i])/2;
-                }
-                
-                fk = BloodCurve (vk, data);
-
-                strcpy (how,"Shrink\n");
-                
-                count++;
-                
-            }
-        }
-        
-        for (i=0; i<numvars; i++)
-        {
-            simplex[numvars][i] = vk[i];
-        }
-        simplex[numvars][FUNCVAL] = fk;
-        
-        SortSimplex (simplex, numvars);
-
-        if (progress)
-        {
-            printf ("\n-----------------------\nIteration: %s", how);
-        }
-        
-    }
-    if ((count >= maxiter) && progress)
-    {
-        printf ("Maximum number of iterations exceeded!\n");
-    }   
-
-    CopyVector (minimum, simplex[0], numvars);
-    *finalvalue = simplex[0][FUNCVAL];
-
-}
-
-    
-
 /* ----------------------------- MNI Header -----------------------------------
 @NAME       : mexFunction
 @INPUT      : nlhs, nrhs - number of output/input arguments (from MATLAB)
@@ -736,11 +128,17 @@ void mexFunction(int    nlhs,
     double tol;
     double tol2;
     double *start;
-    double **simplex;
+    Simplex simplex;
     double *minimum;
     double finalvalue;
     BloodData data;
     double *return_argument;
+    int numdeltas;
+    Boolean refine;
+    double *rss;
+    double best_delta;
+    double *best_params;
+    double best_rss;
     double x=0;
 
     NaN = x/x;
@@ -748,15 +146,15 @@ void mexFunction(int    nlhs,
 
     /* First make sure a valid number of arguments was given. */
 
-    if (nrhs != NUM_IN_ARGS)
+    if ((nrhs < MIN_IN_ARGS) || (nrhs > MAX_IN_ARGS))
     {
         ErrAbort ("Incorrect number of arguments.", TRUE, -1);
     }
 
     progress = FALSE;
-    maxiter = 600;
-    tol = 1;
-    tol2 = 1;
+    maxiter = DELAY_MAXITER;
+    tol = DELAY_TOLERANCE;
+    tol2 = DELAY_TOLERANCE;
 
     numvars = max(mxGetM(START),mxGetN(START));
     start = mxGetPr(START);
@@ -770,20 +168,69 @@ void mexFunction(int    nlhs,
     data.fstarts = mxGetPr(FRAMETIMES);
     data.flengths = mxGetPr(FRAMELENGTHS);
     data.fitdata = mxGetPr(FITDATA);
+    data.work = NULL;
+
+    /*
+     * Given a grid of delays, fit them all and return the lot
+     */
+
+    if (nrhs > 6)
+    {
+        numdeltas = mxGetM(DELTAS) * mxGetN(DELTAS);
+        refine = (nrhs > 7) && (mxGetScalar (REFINE) != 0);
+
+        PARAMS_OUT = mxCreateDoubleMatrix (numdeltas, numvars, mxREAL);
+        if (nlhs > 1)
+        {
+            RSS_OUT = mxCreateDoubleMatrix (numdeltas, 1, mxREAL);
+            rss = mxGetPr (RSS_OUT);
+        }
+        else
+        {
+            rss = (double *) mxCalloc (max(numdeltas,1), sizeof (double));
+        }
+
+        if (nlhs > 3)
+        {
+            BEST_PARAMS_OUT = mxCreateDoubleMatrix (1, numvars, mxREAL);
+            best_params = mxGetPr (BEST_PARAMS_OUT);
+        }
+        else
+        {
+            best_params = (double *) mxCalloc (numvars, sizeof (double));
+        }
+
+        FitDeltaGrid (&data, numvars, start, numdeltas, mxGetPr (DELTAS),
+                      refine, mxGetPr (PARAMS_OUT), rss, &best_delta,
+                      best_params, &best_rss);
+
+        if (nlhs > 2)
+        {
+            DELTA_OUT = mxCreateDoubleMatrix (1, 1, mxREAL);
+            *(mxGetPr (DELTA_OUT)) = best_delta;
+        }
+        if (nlhs > 4)
+        {
+            BEST_RSS_OUT = mxCreateDoubleMatrix (1, 1, mxREAL);
+            *(mxGetPr (BEST_RSS_OUT)) = best_rss;
+        }
+        return;
+    }
 
     /*
      * Now we need a starting simplex close to the initial
      * point given by the user.
      */
 
-    simplex = CreateLocalMatrix (numvars+1, numvars+1);
+    data.work = (double *) mxCalloc (2*data.numsamples, sizeof (double));
+    CreateSimplex (&simplex, numvars, BloodCurve, &data, progress);
 
     if (progress)
     {
         printf ("Getting the starting simplex.\n");
     }
 
-    GetStartingSimplex (start, numvars, &data, simplex);
+    StartSimplex (&simplex, start);
 
     if (progress)
     {
@@ -791,12 +238,11 @@ void mexFunction(int    nlhs,
     }
 
     minimum = (double *) mxCalloc (numvars, sizeof (double));
-    MinimizeSimplex (simplex, &data, numvars, maxiter,
-                     tol, tol2, minimum, &finalvalue);
+    MinimizeSimplex (&simplex, maxiter, tol, tol2, minimum, &finalvalue);
 
     plhs[0] = mxCreateDoubleMatrix(1, numvars, mxREAL);
     return_argument = mxGetPr (plhs[0]);
 
-    CopyVector (return_argument, minimum, numvars);
+    memcpy (return_argument, minimum, numvars * sizeof (double));
 
 }     /* mexFunction */
@@ -0,0 +1,811 @@
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : fdgrates (CMEX)
+@INPUT      : filename - the dynamic FDG study (MINC)
+              slices - zero-based slice numbers to analyse
+              ts_Ca - blood sample times (minutes, increasing)
+              Ca - blood activity (nCi/ml)
+              eft - end-frame times (minutes)
+              c_Time - circulation (analysis) time in minutes
+              glucose - plasma glucose concentration (umol/ml)
+              v0 - assumed value of v0
+              wtf - choice of weighting functions, [n11 n12 n21 n22]
+              MMC - [tau phi Kt Vd]
+              progress - (optional) whether to print progress messages
+@OUTPUT     : K1, K, CMRglc - the parametric images, one column per
+                       slice
+@RETURNS    :
+@DESCRIPTION: The whole of solveFDG.m, for every slice in one call:
+              resamples the blood data, builds the weighted integrals
+              of the plasma curve, reads each slice's frames straight
+              from the file, and computes K1, K and CMRglc for every
+              pixel by weighted integration.
+
+              ts_Ca may be either the output of getFDGplasma or the raw
+              blood sample times: the end-frame times are merged into
+              the resampled time scale here, so getFDGplasma need not
+              be called first.
+@METHOD     : See solveFDG.m.  Everything that depends only on the
+              blood curve (the once- and twice-integrated plasma, its
+              convolution with exp(-b*t) for each b, and the p1, p2,
+              Q13b and Q22b coefficients) is computed once; after that
+              each pixel needs just four weighted frame integrals and a
+              search over b.  Slices are done one after the other, but
+              the pixels of each slice are shared among threads when
+              built with OpenMP (see SliceFDG).
+@GLOBALS    : NaN, ErrMsg
+@CALLS      : CacheOpenImage, CacheInflate, Lookup1, Monotonic
+@CREATED    : 2026/10/16, from solveFDG.m
+@MODIFIED   : 2026/10/16: compute each slice's pixels in parallel
+@VERSION    : $Id$
+              $Name:  $
+---------------------------------------------------------------------------- */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+#include <errno.h>
+#include "mex.h"
+#include "minc.h"
+#include "mierrors.h"
+#include "mexutils.h"         /* N.B. must link in mexutils.o */
+#include "mincutil.h"
+#include "emmaproto.h"
+
+#define PROGNAME "fdgrates"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+/*
+ * Constants to check for argument number and position
+ */
+
+#define MIN_IN_ARGS        10
+#define MAX_IN_ARGS        11
+
+#define MINC_FILENAME      prhs[0]
+#define SLICES             prhs[1]
+#define TS_CA              prhs[2]
+#define CA                 prhs[3]
+#define EFT                prhs[4]
+#define C_TIME             prhs[5]
+#define GLUCOSE            prhs[6]
+#define V0_ARG             prhs[7]
+#define WTF                prhs[8]
+#define MMC                prhs[9]
+#define PROGRESS           prhs[10]
+
+#define K1_OUT             plhs[0]
+#define K_OUT              plhs[1]
+#define CMRGLC_OUT         plhs[2]
+
+#define NUM_FUNCTIONS      10   /* weighting functions to choose from */
+#define NUM_WEIGHTS        4    /* ... of which we use this many */
+#define TIME_STEP          0.5  /* blood resampling interval (minutes) */
+#define B_FIRST            0.1  /* the b's searched: B_FIRST to */
+#define B_STEP             0.01 /* B_LAST in steps of B_STEP */
+#define NUM_B              191  /* (B_LAST = 2.0) */
+
+/*
+ * Everything that depends only on the blood curve and frame timing
+ */
+
+typedef struct
+{
+   double  *W [NUM_WEIGHTS];    /* chosen weighting functions times dt */
+   double   p1;                 /* p1(2); p1(1) is 1 */
+   double   Offset;             /* v0*sq1(Wt(1:2))*p1 */
+   double   b [NUM_B];
+   double   p2 [NUM_B];         /* p2(2,:); p2(1,:) is 1 */
+   double   Q13b [NUM_B];
+   double   Q22b [NUM_B];
+} FDGCoeffs;
+
+double   NaN;                    /* NaN in native C format */
+char    *ErrMsg;                 /* set as close to the occurence of the
+                                    error as possible; displayed by whatever
+                                    code exits */
+
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : ErrAbort
+@INPUT      : msg - character to string to print just before aborting
+              PrintUsage - whether or not to print a usage summary before
+                aborting
+              ExitCode - one of the standard codes from mierrors.h -- NOTE!
+                this parameter is NOT currently used, but I've included it for
+                consistency with other functions named ErrAbort in other
+                programs
+@OUTPUT     : none - function does not return!!!
+@RETURNS    :
+@DESCRIPTION: Optionally prints a usage summary, and calls mexErrMsgTxt with
+              the supplied msg, which ABORTS the mex-file!!!
+@METHOD     :
+@GLOBALS    : requires PROGNAME macro
+@CALLS      : standard mex functions
+@CREATED    : 2026/10/16 (copied from mireadimages.c)
+@MODIFIED   :
+---------------------------------------------------------------------------- */
+void ErrAbort (char msg[], Boolean PrintUsage, int ExitCode)
+{
+   if (PrintUsage)
+   {
+      (void) mexPrintf ("Usage: [K1, K, CMRglc] = %s (filename, slices, ...\n", PROGNAME);
+      (void) mexPrintf ("          ts_Ca, Ca, eft, c_Time, glucose, v0, wtf, MMC [, progress])\n");
+   }
+   (void) mexErrMsgTxt (msg);
+}
+
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : CheckVector
+@INPUT      : Vector - MATLAB Matrix passed in by the caller
+              Name - what to call it in error messages
+              Length - required number of elements, or -1 for any
+@OUTPUT     :
+@RETURNS    : the number of elements in Vector
+              does not return if Vector is not a real vector of the
+              required length
+@DESCRIPTION:
+@METHOD     :
+@GLOBALS    : ErrMsg
+@CALLS      : ErrAbort
+@CREATED    : 2026/10/16 (copied from findintconvo.c)
+@MODIFIED   :
+---------------------------------------------------------------------------- */
+int CheckVector (const mxArray *Vector, char *Name, int Length)
+{
+   int     NumElements;
+
+   NumElements = mxGetM (Vector) * mxGetN (Vector);
+   if (!mxIsDouble (Vector) || mxIsComplex (Vector) ||
+       (min (mxGetM (Vector), mxGetN (Vector)) > 1))
+   {
+      sprintf (ErrMsg, "%s must be a real vector", Name);
+      ErrAbort (ErrMsg, TRUE, ERR_ARGS);
+   }
+   if ((Length >= 0) && (NumElements != Length))
+   {
+      sprintf (ErrMsg, "%s must have %d elements", Name, Length);
+      ErrAbort (ErrMsg, TRUE, ERR_ARGS);
+   }
+   return (NumElements);
+}
+
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : ReadFrames
+@INPUT      : Image - the study, with a double ICV attached
+              Slice - zero-based slice number
+              NumFrames - how many frames (from the first) to read
+@OUTPUT     : PET - the images for those frames of the slice, one after
+                    the other
+@RETURNS    : ERR_NONE if all went well
+              ERR_IN_MINC if miicv_get failed (and sets ErrMsg)
+@DESCRIPTION: Reads the first NumFrames frames of one slice with a
+              single miicv_get.
+@METHOD     :
+@GLOBALS    : ErrMsg
+@CALLS      : MINC library
+@CREATED    : 2026/10/16 (from ReadSlice in rcbf.c)
+@MODIFIED   :
+---------------------------------------------------------------------------- */
+int ReadFrames (ImageInfoRec *Image, long Slice, long NumFrames, double *PET)
+{
+   long     Start [MAX_NC_DIMS], Count [MAX_NC_DIMS];
+
+   Start [Image->HeightDim] = 0;  Count [Image->HeightDim] = Image->Height;
+   Start [Image->WidthDim] = 0;   Count [Image->WidthDim] = Image->Width;
+   Start [Image->FrameDim] = 0;   Count [Image->FrameDim] = NumFrames;
+   if (Image->SliceDim != -1)
+   {
+      Start [Image->SliceDim] = Slice;
+      Count [Image->SliceDim] = 1;
+   }
+
+   if (miicv_get (Image->ICV, Start, Count, PET) == MI_ERROR)
+   {
+      sprintf (ErrMsg, "!! BOMB !! error code %d (%s) set by miicv_get",
+               ncerr, NCErrMsg (ncerr, errno));
+      return (ERR_IN_MINC);
+   }
+   return (ERR_NONE);
+}
+
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : CompareDoubles
+@INPUT      : a, b - pointers to the doubles to compare
+@OUTPUT     :
+@RETURNS    : -1, 0 or 1 as *a is less than, equal to or greater than *b
+@DESCRIPTION: Comparison function for qsort.
+@METHOD     :
+@GLOBALS    :
+@CALLS      :
+@CREATED    : 2026/10/16
+@MODIFIED   :
+---------------------------------------------------------------------------- */
+int CompareDoubles (const void *a, const void *b)
+{
+   double  x = *(const double *) a;
+   double  y = *(const double *) b;
+
+   return ((x < y) ? -1 : ((x > y) ? 1 : 0));
+}
+
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : ResampleTimes
+@INPUT      : NumSamples - number of blood samples
+              ts_Ca - blood sample times (increasing)
+              NumFrames - number of end-frame times
+              eft - end-frame times (increasing)
+@OUTPUT     : ts_new - the new time scale; must have room for
+                       NumSamples + NumFrames + (number of TIME_STEP
+                       points from ts_Ca[0] to eft[NumFrames-1]) times
+              FrameIndex - the index in ts_new of each end-frame time
+@RETURNS    : the number of elements in ts_new, or -1 if the blood data
+              doesn't span all the frames (or an end-frame time is zero)
+@DESCRIPTION: Builds the time scale of solveFDG.m: the blood sample
+              times, the end-frame times, and points every TIME_STEP
+              minutes, sorted, with duplicates removed, and cut off at
+              the last end-frame time.  (Including the end-frame times
+              is what getFDGplasma does.)
+@METHOD     : As in getFDGplasma.m and solveFDG.m, a leading time of
+              zero is dropped along with the duplicates (igrate then
+              integrates from zero), and the evenly spaced points start
+              at the first time that's left.
+@GLOBALS    :
+@CALLS      : qsort
+@CREATED    : 2026/10/16
+@MODIFIED   :
+---------------------------------------------------------------------------- */
+int ResampleTimes (int NumSamples, double ts_Ca[], int NumFrames,
+                   double eft[], double ts_new[], int FrameIndex[])
+{
+   double  First, Last, Prev;
+   int     NumSteps;
+   int     i, j, n;
+
+   Last = eft [NumFrames-1];
+   if ((eft [0] < ts_Ca [0]) || (Last > ts_Ca [NumSamples-1]))
+      return (-1);
+
+   First = ts_Ca [0];
+   if (First == 0)
+      First = min (ts_Ca [1], eft [0]);
+
+   n = 0;
+   for (i = 0; i < NumSamples; i++)
+      ts_new [n++] = ts_Ca [i];
+   for (j = 0; j < NumFrames; j++)
+      ts_new [n++] = eft [j];
+   NumSteps = (int) floor ((Last - First) / TIME_STEP + 1e-10) + 1;
+   for (i = 0; i < NumSteps; i++)
+      ts_new [n++] = First + i * TIME_STEP;
+
+   qsort (ts_new, n, sizeof (double), CompareDoubles);
+
+   for (i = 0, j = 0, Prev = 0; (i < n) && (ts_new [i] <= Last); i++)
+   {
+      if (ts_new [i] != Prev)
+         ts_new [j++] = ts_new [i];
+      Prev = ts_new [i];
+   }
+   n = j;
+
+   for (i = 0, j = 0; j < NumFrames; j++)
+   {
+      while ((i < n) && (ts_new [i] != eft [j]))
+         i++;
+      if (i == n)
+         return (-1);
+      FrameIndex [j] = i;
+   }
+   return (n);
+}
+
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : Integrate
+@INPUT      : n - number of points
+              t - times
+              y - values
+@OUTPUT     : yi - cumulative integral of y
+@RETURNS    : (void)
+@DESCRIPTION: The cumulative trapezoidal integral of igrate.m, which
+              starts from (0,0).
+@METHOD     :
+@GLOBALS    :
+@CALLS      :
+@CREATED    : 2026/10/16 (from igrate.m)
+@MODIFIED   :
+---------------------------------------------------------------------------- */
+void Integrate (int n, double t[], double y[], double yi[])
+{
+   double  Sum, tPrev, yPrev;
+   int     i;
+
+   for (i = 0, Sum = 0, tPrev = 0, yPrev = 0; i < n; i++)
+   {
+      Sum += (y [i] + yPrev) * ((t [i] - tPrev) / 2);
+      yi [i] = Sum;
+      tPrev = t [i];
+      yPrev = y [i];
+   }
+}
+
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : FrameSums
+@INPUT      : NumFrames - number of frames
+              FrameIndex - index of each end-frame time
+              C - integrated plasma curve
+              X - NUM_WEIGHTS weighting functions
+@OUTPUT     : sq - the NUM_WEIGHTS sums
+@RETURNS    : (void)
+@DESCRIPTION: For each weighting function, the sum over frames of the
+              increase in C over the frame times that function: sq1,
+              sq2 and (for one b) sq3 in solveFDG.m.
+@METHOD     :
+@GLOBALS    :
+@CALLS      :
+@CREATED    : 2026/10/16
+@MODIFIED   :
+---------------------------------------------------------------------------- */
+void FrameSums (int NumFrames, int FrameIndex[], double C[],
+                double *X[], double sq[])
+{
+   double  Prev, Delta;
+   int     f, w;
+
+   for (w = 0; w < NUM_WEIGHTS; w++)
+      sq [w] = 0;
+
+   for (f = 0, Prev = 0; f < NumFrames; f++)
+   {
+      Delta = C [FrameIndex [f]] - Prev;
+      Prev = C [FrameIndex [f]];
+      for (w = 0; w < NUM_WEIGHTS; w++)
+         sq [w] += Delta * X [w][f];
+   }
+}
+
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : PlasmaCoeffs
+@INPUT      : NumSamples, ts_Ca, Ca - the blood data
+              NumFrames, eft - end-frame times (within c_Time)
+              wtf - the four weighting function numbers (1-based)
+              v0 - assumed value of v0
+@OUTPUT     : Coeffs - filled in (W must already be allocated)
+@RETURNS    : ERR_NONE, or ERR_ARGS (and sets ErrMsg) if the blood data
+              doesn't span the frames
+@DESCRIPTION: Everything in solveFDG.m that comes before the pixel
+              loop.
+@METHOD     : The convolution of C1 with exp(-b*t) is done as in
+              cnvCa.m, one b at a time; only its values at the
+              end-frame times are kept.
+@GLOBALS    : ErrMsg
+@CALLS      : ResampleTimes, Lookup1, Integrate, FrameSums
+@CREATED    : 2026/10/16
+@MODIFIED   :
+---------------------------------------------------------------------------- */
+int PlasmaCoeffs (int NumSamples, double ts_Ca[], double Ca[],
+                  int NumFrames, double eft[], int wtf[], double v0,
+                  FDGCoeffs *Coeffs)
+{
+   double  *mft, *dt, *Ws [NUM_FUNCTIONS], *X [NUM_WEIGHTS];
+   double  *ts_new, *Ca_new, *C1, *C2, *C3;
+   int     *FrameIndex;
+   double   sq1 [NUM_WEIGHTS], sq2 [NUM_WEIGHTS], sq3 [NUM_WEIGHTS];
+   double   mftEnd, b, u, uPrev, tPrev, Sum;
+   int      MaxTimes, NumTimes;
+   int      f, i, k, w;
+
+   /*
+    * Mid-frame times, frame lengths, and the weighting functions
+    */
+
+   mft = (double *) mxCalloc ((NUM_FUNCTIONS + 2) * NumFrames,
+                              sizeof (double));
+   dt = mft + NumFrames;
+   for (i = 0; i < NUM_FUNCTIONS; i++)
+      Ws [i] = dt + (i+1) * NumFrames;
+
+   for (f = 0; f < NumFrames; f++)
+   {
+      mft [f] = (eft [f] + ((f > 0) ? eft [f-1] : 0)) / 2;
+      dt [f] = eft [f] - ((f > 0) ? eft [f-1] : 0);
+   }
+   mftEnd = mft [NumFrames-1];
+
+   for (f = 0; f < NumFrames; f++)
+   {
+      Ws [0][f] = 1;
+      Ws [1][f] = mft [f];
+      Ws [2][f] = sqrt (mft [f]);
+      Ws [3][f] = mft [f] * mft [f] / 20;
+      Ws [4][f] = dt [f];
+      Ws [5][f] = 1 / dt [f];
+      Ws [6][f] = exp (-mft [f] / 8);
+      Ws [7][f] = sin (mft [f] * M_PI / 2 / mftEnd);
+      Ws [8][f] = sin (mft [f] * M_PI / mftEnd);
+      Ws [9][f] = cos (M_PI * mft [f] / mftEnd);
+   }
+
+   for (w = 0; w < NUM_WEIGHTS; w++)
+   {
+      X [w] = Ws [wtf [w] - 1];
+      for (f = 0; f < NumFrames; f++)
+         Coeffs->W [w][f] = X [w][f] * dt [f];
+   }
+
+   /*
+    * Resample the blood data, and integrate it once and twice
+    */
+
+   MaxTimes = NumSamples + NumFrames +
+      (int) ((eft [NumFrames-1] - ts_Ca [0]) / TIME_STEP) + 2;
+   ts_new = (double *) mxCalloc (5 * MaxTimes, sizeof (double));
+   Ca_new = ts_new + MaxTimes;
+   C1 = Ca_new + MaxTimes;
+   C2 = C1 + MaxTimes;
+   C3 = C2 + MaxTimes;
+   FrameIndex = (int *) mxCalloc (NumFrames, sizeof (int));
+
+   NumTimes = ResampleTimes (NumSamples, ts_Ca, NumFrames, eft,
+                            ts_new, FrameIndex);
+   if (NumTimes < 0)
+   {
+      sprintf (ErrMsg, "Blood data must span the frames (%g to %g minutes)",
+               ts_Ca [0], eft [NumFrames-1]);
+      return (ERR_ARGS);
+   }
+
+   Lookup1 (ts_Ca, Ca, ts_new, Ca_new, NumSamples, NumTimes);
+   Integrate (NumTimes, ts_new, Ca_new, C1);
+   Integrate (NumTimes, ts_new, C1, C2);
+   FrameSums (NumFrames, FrameIndex, C1, X, sq1);
+   FrameSums (NumFrames, FrameIndex, C2, X, sq2);
+
+   Coeffs->p1 = -sq2 [0] / sq2 [1];
+   Coeffs->Offset = v0 * (sq1 [0] + sq1 [1] * Coeffs->p1);
+
+   /*
+    * Convolve C1 with exp(-b*t) for each b, and get p2, Q13b and Q22b
+    */
+
+   for (k = 0; k < NUM_B; k++)
+   {
+      b = B_FIRST + k * B_STEP;
+      Coeffs->b [k] = b;
+
+      for (i = 0, Sum = 0, uPrev = 0, tPrev = 0; i < NumTimes; i++)
+      {
+         u = C1 [i] * exp (ts_new [i] * b);
+         Sum += (u + uPrev) * ((ts_new [i] - tPrev) / 2);
+         C3 [i] = Sum * exp (-ts_new [i] * b);
+         uPrev = u;
+         tPrev = ts_new [i];
+      }
+      FrameSums (NumFrames, FrameIndex, C3, X, sq3);
+
+      Coeffs->p2 [k] = -sq3 [2] / sq3 [3];
+      Coeffs->Q13b [k] = sq3 [0] + sq3 [1] * Coeffs->p1;
+      Coeffs->Q22b [k] = sq2 [2] + sq2 [3] * Coeffs->p2 [k];
+   }
+
+   mxFree (mft);
+   mxFree (ts_new);
+   mxFree (FrameIndex);
+   return (ERR_NONE);
+}
+
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : SliceFDG
+@INPUT      : Coeffs - from PlasmaCoeffs
+              NumFrames - number of frames used
+              ImageSize - number of pixels
+              PET - the slice's frames, one after the other
+              glucose - plasma glucose concentration
+              tau, phi, Kt, Vd - the model parameters
+              wima - NUM_WEIGHTS*ImageSize doubles of work space
+@OUTPUT     : K1, K, CMRglc - the parametric images
+@RETURNS    : (void)
+@DESCRIPTION: The pixel loop of solveFDG.m: the weighted frame
+              integrals of each pixel, then K1 and K for every b, keeping
+              the b that best satisfies the model.
+@METHOD     : Like MATLAB's min, the search ignores NaN's, and takes the
+              first b if they're all NaN.
+              Each pixel is done on its own (its integrals are summed
+              over the frames in order, as before), so the pixels are
+              shared among threads if built with OpenMP, and the results
+              don't depend on how many there are.
+@GLOBALS    :
+@CALLS      :
+@CREATED    : 2026/10/16
+@MODIFIED   : 2026/10/16: one pass per pixel, done in parallel
+---------------------------------------------------------------------------- */
+void SliceFDG (FDGCoeffs *Coeffs, int NumFrames, long ImageSize,
+               double *PET, double glucose, double tau, double phi,
+               double Kt, double Vd, double *wima,
+               double K1[], double K[], double CMRglc[])
+{
+   double  *w0, *w1, *w2, *w3;
+   double   Kd_num, Kd, Kb, K1b, Cost, BestCost;
+   int      Best;
+   long     p;
+   int      f, k, w;
+
+   w0 = wima;
+   w1 = w0 + ImageSize;
+   w2 = w1 + ImageSize;
+   w3 = w2 + ImageSize;
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) \
+        private(Kd_num, Kd, Kb, K1b, Cost, BestCost, Best, f, k, w)
+#endif
+   for (p = 0; p < ImageSize; p++)
+   {
+      for (w = 0; w < NUM_WEIGHTS; w++)
+      {
+         wima [w*ImageSize + p] = 0;
+         for (f = 0; f < NumFrames; f++)
+            wima [w*ImageSize + p] += PET [f*ImageSize + p] * Coeffs->W [w][f];
+      }
+
+      Kd_num = (w0 [p] + w1 [p] * Coeffs->p1) - Coeffs->Offset;
+      Best = -1;
+      BestCost = 0;
+
+      for (k = 0; k < NUM_B; k++)
+      {
+         Kd = Kd_num / Coeffs->Q13b [k];
+         Kb = (w2 [p] + w3 [p] * Coeffs->p2 [k]) / Coeffs->Q22b [k];
+         K1b = Kd + Kb;
+         Cost = fabs ((K1b / Kd) *
+                      (K1b + glucose*tau*Kb / (phi + (tau-phi)*(Kb/K1b)) / Kt)
+                      / Vd - Coeffs->b [k]);
+         if ((Cost == Cost) && ((Best < 0) || (Cost < BestCost)))
+         {
+            Best = k;
+            BestCost = Cost;
+            K [p] = Kb;
+            K1 [p] = K1b;
+         }
+      }
+
+      if (Best < 0)
+      {
+         K [p] = (w2 [p] + w3 [p] * Coeffs->p2 [0]) / Coeffs->Q22b [0];
+         K1 [p] = Kd_num / Coeffs->Q13b [0] + K [p];
+      }
+
+      CMRglc [p] = glucose * 100 / (phi / K [p] + (tau - phi) / K1 [p]);
+   }
+}
+
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : mexFunction
+@INPUT      : nlhs, nrhs - number of output/input arguments (from MATLAB)
+              prhs - actual input arguments
+@OUTPUT     : plhs - actual output arguments
+@RETURNS    : (void)
+@DESCRIPTION:
+@METHOD     : Checks the arguments, computes the blood coefficients,
+              then reads and analyses one slice at a time.  Outputs that
+              weren't asked for are computed into a single slice's worth
+              of work space.
+@GLOBALS    : NaN, ErrMsg
+@CALLS      : everything above
+@CREATED    : 2026/10/16
+@MODIFIED   :
+---------------------------------------------------------------------------- */
+void mexFunction(int    nlhs,
+                 mxArray *plhs[],
+                 int    nrhs,
+                 const mxArray *prhs[])
+{
+   char        *Filename;
+   ImageInfoRec Image;
+   long        *Slices;
+   long         NumSlices, ImageSize;
+   int          NumSamples, NumFrames, NumEft;
+   double      *ts_Ca, *Ca, *eft;
+   double       c_Time, glucose, v0;
+   double      *Params;
+   long         wtf_long [NUM_WEIGHTS];
+   int          wtf [NUM_WEIGHTS];
+   Boolean      progress;
+   FDGCoeffs    Coeffs;
+   double      *PET, *wima;
+   double      *K1, *K, *CMRglc;
+   int          Result;
+   long         s;
+   int          f, w;
+
+   ncopts = 0;
+   ErrMsg = (char *) mxCalloc (256, sizeof (char));
+
+   if (HandleCacheCommand (nlhs, plhs, nrhs, prhs))
+   {
+      return;
+   }
+
+   if ((nrhs < MIN_IN_ARGS) || (nrhs > MAX_IN_ARGS))
+   {
+      ErrAbort ("Incorrect number of arguments", TRUE, ERR_ARGS);
+   }
+
+   if (ParseStringArg (MINC_FILENAME, &Filename) == NULL)
+   {
+      ErrAbort ("Error in filename", TRUE, ERR_ARGS);
+   }
+
+   NaN = CreateNaN();
+
+   Result = CacheOpenImage (Filename, &Image, NC_DOUBLE, NaN);
+   if (Result == ERR_NONE)          /* we'll read all of it, if compressed */
+      Result = CacheInflate (Image.CDF, NULL, NULL, NULL);
+   if (Result != ERR_NONE)
+   {
+      ErrAbort (ErrMsg, TRUE, Result);
+   }
+   if (Image.FrameDim == -1)
+   {
+      ErrAbort ("Study is non-dynamic", TRUE, ERR_ARGS);
+   }
+   ImageSize = Image.ImageSize;
+
+   /*
+    * Get the slices, and check that they're all in the file
+    */
+
+   NumSlices = mxGetM (SLICES) * mxGetN (SLICES);
+   Slices = (long *) mxCalloc (max (NumSlices, 1), sizeof (long));
+   if (ParseIntArg (SLICES, NumSlices, Slices) != NumSlices)
+   {
+      ErrAbort ("Slices must be a vector", TRUE, ERR_ARGS);
+   }
+   for (s = 0; s < NumSlices; s++)
+   {
+      if ((Slices [s] < 0) || (Slices [s] >= max (Image.Slices, 1)))
+      {
+         sprintf (ErrMsg, "Bad slice number: %ld (must be < %ld)",
+                  Slices [s], max (Image.Slices, 1));
+         ErrAbort (ErrMsg, TRUE, ERR_ARGS);
+      }
+   }
+
+   /*
+    * Get the blood data, frame times and parameters
+    */
+
+   NumSamples = CheckVector (TS_CA, "ts_Ca", -1);
+   CheckVector (CA, "Ca", NumSamples);
+   NumEft = CheckVector (EFT, "eft", -1);
+   CheckVector (MMC, "MMC", 4);
+
+   ts_Ca = mxGetPr (TS_CA);
+   Ca = mxGetPr (CA);
+   eft = mxGetPr (EFT);
+   Params = mxGetPr (MMC);
+
+   if ((NumSamples < 2) || (Monotonic (ts_Ca, NumSamples) != 1))
+   {
+      ErrAbort ("ts_Ca must be increasing", TRUE, ERR_ARGS);
+   }
+   if ((NumEft > 1) && (Monotonic (eft, NumEft) != 1))
+   {
+      ErrAbort ("eft must be increasing", TRUE, ERR_ARGS);
+   }
+
+   c_Time = mxGetScalar (C_TIME);
+   glucose = mxGetScalar (GLUCOSE);
+   v0 = mxGetScalar (V0_ARG);
+   progress = (nrhs > 10) && (mxGetScalar (PROGRESS) != 0);
+
+   if (ParseIntArg (WTF, NUM_WEIGHTS, wtf_long) != NUM_WEIGHTS)
+   {
+      ErrAbort ("wtf must be a 4 element vector", TRUE, ERR_ARGS);
+   }
+   for (w = 0; w < NUM_WEIGHTS; w++)
+   {
+      if ((wtf_long [w] < 1) || (wtf_long [w] > NUM_FUNCTIONS))
+      {
+         ErrAbort ("Value in wtf vector is out of range", TRUE, ERR_ARGS);
+      }
+      wtf [w] = (int) wtf_long [w];
+   }
+
+   /*
+    * Only the frames within the circulation time are used
+    */
+
+   for (f = 0, NumFrames = 0; f < NumEft; f++)
+   {
+      if (eft [f] <= c_Time)
+         NumFrames = f + 1;
+   }
+   if (NumFrames == 0)
+   {
+      ErrAbort ("The specified circulation time is too short", FALSE,
+                ERR_ARGS);
+   }
+   if (NumFrames > Image.Frames)
+   {
+      sprintf (ErrMsg, "eft has more frames (within c_Time) than the study (%ld)",
+               Image.Frames);
+      ErrAbort (ErrMsg, TRUE, ERR_ARGS);
+   }
+
+   for (w = 0; w < NUM_WEIGHTS; w++)
+   {
+      Coeffs.W [w] = (double *) mxCalloc (NumFrames, sizeof (double));
+   }
+   Result = PlasmaCoeffs (NumSamples, ts_Ca, Ca, NumFrames, eft, wtf, v0,
+                          &Coeffs);
+   if (Result != ERR_NONE)
+   {
+      ErrAbort (ErrMsg, TRUE, Result);
+   }
+
+   /*
+    * Work space, and the outputs (or a slice's worth of space for any
+    * that weren't asked for)
+    */
+
+   PET = (double *) mxCalloc (NumFrames * ImageSize, sizeof (double));
+   wima = (double *) mxCalloc (NUM_WEIGHTS * ImageSize, sizeof (double));
+
+   K1_OUT = mxCreateDoubleMatrix (ImageSize, NumSlices, mxREAL);
+   K1 = mxGetPr (K1_OUT);
+   if (nlhs > 1)
+   {
+      K_OUT = mxCreateDoubleMatrix (ImageSize, NumSlices, mxREAL);
+      K = mxGetPr (K_OUT);
+   }
+   else
+      K = (double *) mxCalloc (ImageSize, sizeof (double));
+   if (nlhs > 2)
+   {
+      CMRGLC_OUT = mxCreateDoubleMatrix (ImageSize, NumSlices, mxREAL);
+      CMRglc = mxGetPr (CMRGLC_OUT);
+   }
+   else
+      CMRglc = (double *) mxCalloc (ImageSize, sizeof (double));
+
+   for (s = 0; s < NumSlices; s++)
+   {
+      if (progress)
+         mexPrintf ("Doing slice %ld\n", Slices [s] + 1);
+
+      Result = ReadFrames (&Image, Slices [s], NumFrames, PET);
+      if (Result != ERR_NONE)
+      {
+         ErrAbort (ErrMsg, TRUE, Result);
+      }
+
+      SliceFDG (&Coeffs, NumFrames, ImageSize, PET, glucose,
+                Params [0], Params [1], Params [2], Params [3], wima,
+                K1 + s*ImageSize,
+                (nlhs > 1) ? K + s*ImageSize : K,
+                (nlhs > 2) ? CMRglc + s*ImageSize : CMRglc);
+   }
+}
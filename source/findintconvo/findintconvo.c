@@ -0,0 +1,248 @@
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : findintconvo.c (CMEX)
+@INPUT      : Ca_even - blood activity, resampled at evenly spaced times
+              ts_even - the (evenly spaced) times of Ca_even
+              k2_lookup - table of k2 values
+              midftimes, flengths - mid-frame times and frame lengths
+              w1 [, w2 [, w3]] - weighting functions (one element per
+                                 frame)
+              progress - accepted for compatibility with findintconvo.m,
+                         and ignored
+@OUTPUT     : int1 [, int2 [, int3]] - tables (one element per k2 value)
+                         of the weighted, frame-integrated convolution
+                         of Ca_even with exp(-k2*ts_even)
+@RETURNS    :
+@DESCRIPTION: CMEX replacement for findintconvo.m; see that file for
+              the details.  For every k2, the M-file builds exp(-k2*t),
+              convolves it with Ca_even, integrates the result across
+              frames, and then across all frames with each weighting
+              function -- a quadratic convolution and four trips
+              through MATLAB, several hundred times over.  Here the
+              whole table is built in one call, and each convolution
+              takes time proportional to the number of samples.
+@METHOD     : On an evenly spaced grid t[m] = t[0] + m*h, the sampled
+              exponential is exp(-k2*t[0]) * r^m with r = exp(-k2*h), so
+              the sum
+
+                 S[n] = sum_{j=0..n} Ca[j] r^(n-j)
+
+              satisfies S[n] = r*S[n-1] + Ca[n], and the convolution is
+              just h * exp(-k2*t[0]) * S[n] -- a first-order recursive
+              filter (see ExpConvolve in convolve.c).
+@GLOBALS    : NaN
+@CALLS      : IntConvoTables
+@CREATED    : 2026/10/16
+@MODIFIED   : 2026/10/16: moved the table building into intconvo.c
+                          (shared with rcbf)
+@VERSION    : $Id$
+              $Name:  $
+---------------------------------------------------------------------------- */
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+#include "mex.h"
+#include "emmageneral.h"
+#include "emmaproto.h"
+
+#define PROGNAME "findintconvo"
+
+#define CA_EVEN    prhs[0]
+#define TS_EVEN    prhs[1]
+#define K2_LOOKUP  prhs[2]
+#define MIDFTIMES  prhs[3]
+#define FLENGTHS   prhs[4]
+#define W1         prhs[5]
+#define MAX_WEIGHTS 3
+
+
+double  NaN;                    /* NaN in native C format */
+
+
+void usage (void)
+{
+   mexPrintf("\nUsage:\n");
+   mexPrintf("[int1 [,int2 [,int3]]] = %s (Ca_even, ts_even, k2_lookup, ...\n", PROGNAME);
+   mexPrintf("        midftimes, flengths, w1 [, w2 [, w3 [, progress]]])\n");
+}
+
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : CheckVector
+@INPUT      : Vector - MATLAB Matrix passed in by the caller
+              Name - what to call it in error messages
+              Length - required number of elements, or -1 for any
+@OUTPUT     :
+@RETURNS    : the number of elements in Vector
+              does not return if Vector is not a real vector of the
+              required length -- calls mexErrMsgTxt
+@DESCRIPTION:
+@METHOD     :
+@GLOBALS    :
+@CALLS      :
+@CREATED    : 2026/10/16
+@MODIFIED   :
+---------------------------------------------------------------------------- */
+int CheckVector (const mxArray *Vector, char *Name, int Length)
+{
+   char    msg[80];
+   int     NumElements;
+
+   NumElements = mxGetM (Vector) * mxGetN (Vector);
+   if (!mxIsDouble (Vector) || mxIsComplex (Vector) ||
+       (min (mxGetM (Vector), mxGetN (Vector)) > 1))
+   {
+      usage();
+      sprintf (msg, "%s must be a real vector", Name);
+      mexErrMsgTxt (msg);
+   }
+   if ((Length >= 0) && (NumElements != Length))
+   {
+      usage();
+      sprintf (msg, "%s must have %d elements", Name, Length);
+      mexErrMsgTxt (msg);
+   }
+   return (NumElements);
+}
+
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : GetWeight
+@INPUT      : Weight - one of the weighting functions passed by the caller
+              Name - what to call it in error messages
+              NumFrames - number of frames
+              EmptyIsUnity - TRUE if an empty weight means "all ones"
+@OUTPUT     :
+@RETURNS    : pointer to NumFrames weights (allocated with mxCalloc), or
+              NULL if the weight is empty and EmptyIsUnity is false
+@DESCRIPTION: Expands a weighting function into one weight per frame.
+              As well as a vector with one element per frame, a scalar
+              is accepted and applied to every frame.
+@METHOD     :
+@GLOBALS    :
+@CALLS      : CheckVector
+@CREATED    : 2026/10/16
+@MODIFIED   :
+---------------------------------------------------------------------------- */
+double *GetWeight (const mxArray *Weight, char *Name, int NumFrames,
+                   Boolean EmptyIsUnity)
+{
+   double  *Weights;
+   double  Value;
+   int     NumElements;
+   int     i;
+
+   NumElements = mxGetM (Weight) * mxGetN (Weight);
+   if ((NumElements == 0) && !EmptyIsUnity)
+   {
+      return (NULL);
+   }
+
+   Weights = (double *) mxCalloc (NumFrames, sizeof (double));
+   if ((NumElements == 0) || (NumElements == 1))
+   {
+      Value = (NumElements == 0) ? 1.0 : mxGetScalar (Weight);
+      for (i = 0; i < NumFrames; i++)
+      {
+         Weights [i] = Value;
+      }
+   }
+   else
+   {
+      CheckVector (Weight, Name, NumFrames);
+      memcpy (Weights, mxGetPr (Weight), NumFrames * sizeof (double));
+   }
+   return (Weights);
+}
+
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : mexFunction
+@INPUT      : nrhs, prhs[] - number and array of input arguments
+              nlhs - number of output arguments
+@OUTPUT     : plhs[0..nlhs-1] created and filled with the integral tables
+@RETURNS    : (void)
+@DESCRIPTION:
+@METHOD     : The tables are built by IntConvoTables (in intconvo.c).
+@GLOBALS    : NaN
+@CALLS      : CheckVector, GetWeight, IntConvoTables
+@CREATED    : 2026/10/16
+@MODIFIED   :
+---------------------------------------------------------------------------- */
+void mexFunction (int nlhs, mxArray *plhs [],
+                  int nrhs, const mxArray *prhs [])
+{
+   mxArray *mNaN;               /* NaN as a MATLAB Matrix */
+   double  *Ca, *Ts, *K2, *MidFTimes, *FLengths;
+   double  *Weights [MAX_WEIGHTS];     /* weights (per frame), or NULL */
+   double  *Tables [MAX_WEIGHTS];      /* the outputs */
+   char    Name [4];
+   int     NumSamples, TableSize, NumFrames;
+   int     NumWeights;
+   int     w;
+
+   if ((nrhs < 6) || (nrhs > 9))
+   {
+      usage();
+      mexErrMsgTxt("Incorrect number of input arguments!");
+   }
+
+   /*
+    * Only compute as many tables as were asked for (at least one, for
+    * ans), but insist on a weighting function for each.
+    */
+
+   NumWeights = min (nrhs - 5, MAX_WEIGHTS);
+   if (nlhs > NumWeights)
+   {
+      usage();
+      mexErrMsgTxt("Each output requires a weighting function");
+   }
+   NumWeights = max (nlhs, 1);
+
+   NumSamples = CheckVector (CA_EVEN, "Ca_even", -1);
+   CheckVector (TS_EVEN, "ts_even", NumSamples);
+   TableSize = CheckVector (K2_LOOKUP, "k2_lookup", -1);
+   NumFrames = CheckVector (MIDFTIMES, "midftimes", -1);
+   CheckVector (FLENGTHS, "flengths", NumFrames);
+
+   if (NumSamples < 2)
+   {
+      usage();
+      mexErrMsgTxt("Ca_even and ts_even must have at least two elements");
+   }
+
+   mexCallMATLAB (1, &mNaN, 0, NULL, "NaN");
+   NaN = *(mxGetPr(mNaN));
+
+   Ca = mxGetPr (CA_EVEN);
+   Ts = mxGetPr (TS_EVEN);
+   K2 = mxGetPr (K2_LOOKUP);
+   MidFTimes = mxGetPr (MIDFTIMES);
+   FLengths = mxGetPr (FLENGTHS);
+
+   /*
+    * Get the weights (w1 is all ones if empty; w2 and w3 are ignored if
+    * empty, and their tables left as zeros) and create the output tables.
+    */
+
+   for (w = 0; w < NumWeights; w++)
+   {
+      sprintf (Name, "w%d", w+1);
+      Weights [w] = GetWeight (prhs [5+w], Name, NumFrames, (w == 0));
+      plhs [w] = mxCreateDoubleMatrix (1, TableSize, mxREAL);
+      Tables [w] = mxGetPr (plhs [w]);
+   }
+
+   IntConvoTables (NumSamples, Ca, Ts, TableSize, K2,
+                   NumFrames, MidFTimes, FLengths,
+                   NumWeights, Weights, Tables);
+
+   /*
+    * mxCalloc'd memory is freed by MATLAB on return, so we needn't
+    * worry about the work space.
+    */
+}
@@ -0,0 +1,65 @@
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : bloodcorrect.h
+@DESCRIPTION: Types and prototypes for the blood delay and dispersion
+              correction in bloodcorrect.c (part of the EMMA library),
+              shared by delaycorrect and rcbf.
+@CREATED    : 2026/10/16
+@MODIFIED   : 2026/10/16: BloodData carries BloodCurve's work space;
+                          FitDeltaGrid returns the fit at the best delta
+@VERSION    : $Id$
+              $Name:  $
+---------------------------------------------------------------------------- */
+
+#ifndef _BLOODCORRECT_H
+#define _BLOODCORRECT_H
+
+#ifndef _EMMAGENERAL
+#include "emmageneral.h"
+#endif
+
+/*
+ * Simplex parameters for the delay fits
+ */
+
+#define DELAY_MAXITER      600
+#define DELAY_TOLERANCE    1
+
+/*
+ * Everything BloodCurve needs to compare the model to the brain
+ * activity: the blood curve (resampled at evenly spaced times), the
+ * frame times, and the activity to fit (the first numfitpoints frames).
+ * work must point to 2*numsamples doubles that BloodCurve can scribble
+ * on, so that it doesn't have to allocate them on every evaluation.
+ */
+
+typedef struct blooddata
+{
+    double *ts_even;
+    double *g_even;
+    int     numsamples;
+    int     numframes;
+    int     numfitpoints;
+    double *fstarts;
+    double *flengths;
+    double *fitdata;
+    double *work;
+}
+BloodData;
+
+double BloodCurve (double x[], void *blooddata);
+int ShiftBlood (int numsamples, double ts_even[], double g_even[],
+                double delta, double shifted_ts[], double shifted_g[]);
+double FitDelta (BloodData *data, double delta, int numvars,
+                 double init[], double final[], double *work);
+void FitDeltaGrid (BloodData *data, int numvars, double init[],
+                   int numdeltas, double deltas[], Boolean refine,
+                   double params[], double rss[], double *best_delta,
+                   double best_params[], double *best_rss);
+void SmoothDeriv (int nn, int npts, double y[], double dt,
+                  double yfit[], double z[]);
+int CorrectBlood (int numsamples, double g_even[], double ts_even[],
+                  int numframes, double fstarts[], double flengths[],
+                  double A[], double tau, double *delta,
+                  double Ca_even[], double new_ts_even[]);
+
+#endif
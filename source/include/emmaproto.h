@@ -14,6 +14,10 @@
 #ifndef EMMAPROTO_H
 #define EMMAPROTO_H
 
+#ifndef _EMMAGENERAL
+#include "emmageneral.h"
+#endif
+
 /* ----------------------------------------------------------------------
  * Numeric utility functions
  */
@@ -31,6 +35,21 @@ void Lookup2 (double *oldX, double *oldY,
 
 /* trapint.c */
 void TrapInt (int num_bins, double *times, double *values, double *area);
+void TrapCoeffs (int num_bins, double *times, double *weights, 
+                 double *coeffs);
+
+/* convolve.c */
+void Convolve (int na, double A[], int nb, double B[],
+               double spacing, int nc, double C[]);
+Boolean EvenlySpaced (int Length, double X[]);
+void ExpConvolve (int Length, double Ca[], double Ts[], double k,
+                  Boolean Even, double ExpFun[], double Convo[]);
+
+/* intconvo.c */
+void IntConvoTables (int NumSamples, double Ca[], double Ts[],
+                     int TableSize, double K2[],
+                     int NumFrames, double MidFTimes[], double FLengths[],
+                     int NumWeights, double *Weights[], double *Tables[]);
 
 /* intframes.c */
 void IntFrames (int Length, double *X, double *Y,
@@ -0,0 +1,49 @@
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : emmathread.h
+@DESCRIPTION: Types and prototypes for emmathread.c: the least that the
+              EMMA library needs to run a function in the background
+              (start a thread, then wait for it), on whatever threads
+              the platform has.
+@CREATED    : 2026/10/16
+@MODIFIED   :
+@VERSION    : $Id$
+              $Name:  $
+---------------------------------------------------------------------------- */
+
+#ifndef _EMMATHREAD_H
+#define _EMMATHREAD_H
+
+#ifndef _EMMAGENERAL
+#include "emmageneral.h"
+#endif
+
+/*
+ * Threads are POSIX threads if EMMA_PTHREADS is defined (see the
+ * Makefile for your platform), Win32 threads under Windows, and
+ * otherwise there are none: StartThread just calls the function.
+ */
+
+#if defined (EMMA_PTHREADS)
+#include <pthread.h>
+#elif defined (_WIN32)
+#include <windows.h>
+#endif
+
+typedef void (*ThreadFunc) (void *Arg);
+
+typedef struct
+{
+#if defined (EMMA_PTHREADS)
+   pthread_t  Handle;
+#elif defined (_WIN32)
+   HANDLE     Handle;
+#endif
+   ThreadFunc Func;
+   void      *Arg;
+   Boolean    Running;        /* started, and not yet waited for */
+} EmmaThread;
+
+Boolean StartThread (EmmaThread *Thread, ThreadFunc Func, void *Arg);
+void WaitThread (EmmaThread *Thread);
+
+#endif
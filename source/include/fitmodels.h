@@ -0,0 +1,61 @@
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : fitmodels.h
+@DESCRIPTION: Types and prototypes for the compiled objective functions
+              in fitmodels.c (part of the EMMA library), which let
+              nfmins fit the common kinetic models without calling back
+              into MATLAB.
+@CREATED    : 2026/10/16
+@MODIFIED   :
+@VERSION    : $Id$
+              $Name:  $
+---------------------------------------------------------------------------- */
+
+#ifndef _FITMODELS_H
+#define _FITMODELS_H
+
+#ifndef _EMMAGENERAL
+#include "emmageneral.h"
+#endif
+
+/*
+ * Everything a model needs to compare itself to the data: the input
+ * function (eg. blood activity) sampled at evenly spaced times, the
+ * frames across which the model is integrated, and the per-frame data
+ * to fit -- ie. the extra arguments passed to fit_b_curve.m and
+ * friends -- along with some work space.
+ */
+
+typedef struct
+{
+   double  *ts_even;            /* sample times of the input function */
+   double  *g_even;             /* the input function */
+   int      numsamples;
+   Boolean  even;               /* is ts_even really evenly spaced? */
+   double  *fstarts;            /* frame start times and lengths */
+   double  *flengths;
+   int      numframes;
+   double  *fitdata;            /* data to fit (first numfitpoints frames) */
+   int      numfitpoints;
+   double  *expfun;             /* work space: numsamples each */
+   double  *curve;
+   double  *curve2;
+   double  *frameints;          /* work space: numframes */
+} FitData;
+
+typedef double (*FitFunction) (double x[], FitData *data);
+
+typedef struct
+{
+   char        *Name;           /* name of the equivalent M-file */
+   int          NumParams;      /* number of elements in x[] */
+   FitFunction  Function;       /* returns sum of squared residuals */
+} FitModel;
+
+FitModel *FindFitModel (char Name[]);
+Boolean InitFitData (FitData *data,
+                     int numsamples, double *ts_even, double *g_even,
+                     int numframes, double *fstarts, double *flengths,
+                     int numfitpoints, double *fitdata);
+void FreeFitData (FitData *data);
+
+#endif
@@ -35,5 +35,7 @@ double CreateNaN (void);
 int ParseOptions (const mxArray *OptVector, int MaxOptions, Boolean *debug);
 char *ParseStringArg (const mxArray *Mstr, char *Cstr []);
 int ParseIntArg (const mxArray *Mvector, int MaxSize, long Cvector[]);
+Boolean HandleCacheCommand (int nlhs, mxArray *plhs[],
+                            int nrhs, const mxArray *prhs[]);
 
 #endif
@@ -15,6 +15,14 @@
               $Name:  $
 ---------------------------------------------------------------------------- */
 
+#ifndef _EMMAGENERAL
+#include <emmageneral.h>
+#endif
+
+#ifndef _EMMATHREAD_H
+#include "emmathread.h"
+#endif
+
 
 typedef struct
 {
@@ -71,10 +79,63 @@ typedef struct
    long     ImageSize;        /* Height * Width */
 } ImageInfoRec;
 
+/*
+ * State of a slab reader (see OpenSlabReader in mincutil.c): the study
+ * is read a few rows of one slice at a time, across a range of frames.
+ * While the caller works on one slab, the next is read into Spare in
+ * the background.
+ */
+
+typedef struct
+{
+   ImageInfoRec *Image;       /* the study (with a double ICV attached) */
+   long     EndSlice;         /* one past the last slice to read */
+   long     FirstFrame;       /* frames to read */
+   long     NumFrames;
+   long     SlabRows;         /* rows per slab (the last may be fewer) */
+   long     Slice;            /* slice, first row and number of rows */
+   long     Row;              /*   in the current slab */
+   long     Rows;             /*   (Rows is 0 when there are no more) */
+   long     NextSlice;        /* where the next slab starts */
+   long     NextRow;
+   double  *Buffer;           /* the current slab: Rows*Width pixels */
+                              /*   by NumFrames frames, frame by frame */
+   double  *Spare;            /* the next slab, if it's being read ahead */
+   double  *Allocated [2];    /* buffers to free when done */
+   long     AheadSlice;       /* where it is (AheadRows is 0 if there */
+   long     AheadRow;         /*   is no read ahead) */
+   long     AheadRows;
+   int      AheadResult;      /* miicv_get's result for it */
+   EmmaThread Thread;         /* ... which is reading it */
+} SlabReader;
+
 
 char *NCErrMsg (int NCErrCode, int SysErrCode);
 int OpenFile (char *Filename, int *CDF, int Mode);
 int GetVarInfo (int CDF, char vName[], VarInfoRec *vInfo);
 int GetImageInfo (int CDF, ImageInfoRec *Image);
 int OpenImage (char Filename[], ImageInfoRec *Image, int mode, double NaN);
+void AttachICV (ImageInfoRec *Image, nc_type Type, double NaN);
 void CloseImage (ImageInfoRec *Image);
+void FindMaxMin (double *Values, long Num, double *Max, double *Min);
+long RunLength (long List[], long Num, long First);
+void PutMaxMins (ImageInfoRec *ImInfo, long Slices[], long Frames[],
+                 long NumSlices, long NumFrames, double Max[], double Min[]);
+void PutMaxMin (ImageInfoRec *ImInfo, double *ImVals, 
+                long SliceNum, long FrameNum, 
+                Boolean DoSlices, Boolean DoFrames);
+int OpenSlabReader (ImageInfoRec *Image, long FirstSlice, long NumSlices,
+                    long FirstFrame, long NumFrames, long SlabRows,
+                    double *Buffer, SlabReader *Reader);
+int ReadNextSlab (SlabReader *Reader);
+void CloseSlabReader (SlabReader *Reader);
+
+/* minccache.c -- cache of open files for the CMEX readers */
+
+int CacheOpenFile (char Filename[], int *CDF);
+int CacheOpenImage (char Filename[], ImageInfoRec *Image, 
+                    nc_type Type, double NaN);
+int CacheInflate (int CDF, char VarName[], long Start[], long Count[]);
+void CacheFlush (char Filename[]);
+void CacheCloseAll (void);
+void CacheStats (long *Hits, long *Misses);
@@ -0,0 +1,90 @@
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : ncmap.h
+@DESCRIPTION: Types and prototypes for reading variables from NetCDF
+              classic (MINC 1) files through a memory map, and for
+              reading gzip-compressed ones a bit at a time -- see
+              ncmap.c (part of the EMMA library).  Also for parsing the
+              header of such files, and for keeping room to spare in
+              it -- see ncheader.c.
+@CREATED    : 2026/10/16
+@MODIFIED   :
+@VERSION    : $Id$
+              $Name:  $
+---------------------------------------------------------------------------- */
+
+#ifndef _NCMAP_H
+#define _NCMAP_H
+
+#ifndef _EMMAGENERAL
+#include "emmageneral.h"
+#endif
+
+/*
+ * How much of a header to read (or uncompress) at once, while looking
+ * for the end of it.  Headers bigger than MAX_HEADER are taken to be
+ * corrupt.
+ */
+
+#define HEADER_CHUNK       65536L
+#define MAX_HEADER         (64L*1048576L)
+
+/*
+ * How much room to leave in the header of a new file (and of an old
+ * one, if it ever has to be rewritten) for adding history, attributes
+ * and variables later, without rewriting all the data
+ */
+
+#define DEFAULT_HEADER_PAD 16384L
+
+/*
+ * A variable in a mapped file: where its values are, and how they're
+ * laid out (big-endian, last dimension varying fastest)
+ */
+
+typedef struct
+{
+   char    *Base;                     /* the whole file, mapped */
+   long     FileSize;
+   nc_type  Type;                     /* type of the values ... */
+   int      TypeSize;                 /* ... and its size in the file */
+   int      NumDims;
+   long     DimSizes [MAX_NC_DIMS];
+   long     Offset;                   /* of the first value in the file */
+   Boolean  IsRecord;                 /* (can't be mapped if so) */
+   char    *Data;                     /* the first value */
+} MappedVar;
+
+/*
+ * A compressed file being read (through a temporary uncompressed copy
+ * that is filled in as needed)
+ */
+
+typedef struct
+{
+   void          *Stream;             /* the gzip stream (a gzFile) */
+   int            File;               /* the uncompressed copy */
+   unsigned char *Header;             /* the header (and a bit more) */
+   long           HeaderLength;
+   long           Size;               /* of the uncompressed file ... */
+   long           Inflated;           /* ... and how much we've written */
+} CompressedFile;
+
+int ParseHeader (unsigned char *Header, long Length, char VarName[],
+                 MappedVar *Var, unsigned long *DataBegin,
+                 unsigned long *DataEnd);
+int EndDefine (int CDF, char Filename[], long Pad, Boolean *Rewritten);
+
+int MapVariable (char Filename[], char VarName[], MappedVar *Var);
+void MappedGet (MappedVar *Var, long Start[], long Count[],
+                Boolean Signed, double Dest[]);
+void MappedGetRaw (MappedVar *Var, long Start[], long Count[], void *Dest);
+void UnmapVariable (MappedVar *Var);
+
+Boolean IsCompressed (char Filename[]);
+int OpenCompressed (char Filename[], CompressedFile *File, int *CDF);
+int UncompressFile (char Filename[], char **TempName);
+int InflateVariable (CompressedFile *File, char VarName[],
+                     long Start[], long Count[]);
+void CloseCompressed (CompressedFile *File);
+
+#endif
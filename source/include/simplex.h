@@ -0,0 +1,45 @@
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : simplex.h
+@DESCRIPTION: Types and prototypes for the Nelder-Mead simplex minimiser
+              in simplex.c (part of the EMMA library), shared by nfmins
+              and delaycorrect.
+@CREATED    : 2026/10/16
+@MODIFIED   :
+@VERSION    : $Id$
+              $Name:  $
+---------------------------------------------------------------------------- */
+
+#ifndef _SIMPLEX_H
+#define _SIMPLEX_H
+
+#ifndef _EMMAGENERAL
+#include "emmageneral.h"
+#endif
+
+/*
+ * The function to minimise: takes the point x[] (numvars elements) and
+ * whatever else the caller passed as data.
+ */
+
+typedef double (*SimplexFunction) (double x[], void *data);
+
+typedef struct
+{
+   int              numvars;
+   double          *vertices;   /* numvars+1 rows of numvars+1 elements: */
+                                /* each is a vertex followed by the */
+                                /* function value there, best first */
+   double          *work;       /* space for the trial points */
+   SimplexFunction  function;
+   void            *data;
+   Boolean          progress;   /* print what's going on? */
+} Simplex;
+
+void CreateSimplex (Simplex *simplex, int numvars,
+                    SimplexFunction function, void *data, Boolean progress);
+void FreeSimplex (Simplex *simplex);
+void StartSimplex (Simplex *simplex, double start[]);
+int MinimizeSimplex (Simplex *simplex, int maxiter, double tol, double tol2,
+                     double minimum[], double *finalvalue);
+
+#endif
@@ -13,6 +13,7 @@
 #include <string.h>
 #include <minc.h>
 #include "ncblood.h"
+#include "ncmap.h"
 
 
 #define PROGNAME "includeblood"
@@ -309,16 +310,19 @@ void FillBloodStructures (int mincHandle, int bloodHandle)
 @GLOBALS    : 
 @CALLS      : ncopen (netCDF library)
               ncredef (netCDF library)
-	      ncendef (netCDF library)
+	      EndDefine (EMMA library)
 	      ncclose (netCDF library)
 	      CreateBloodStructures
 	      FillBloodStructures
 @CREATED    : May 30, 1994 by MW
-@MODIFIED   : 
+@MODIFIED   : Oct 16, 2026 - leave define mode with EndDefine, so that
+              the file is only rewritten if the blood data doesn't fit
+              in the room left in its header.
 ---------------------------------------------------------------------------- */
 int main (int argc, char *argv[])
 {
     int mincHandle, bloodHandle;
+    Boolean Rewritten;
 
     if (argc != 3)
     {
@@ -342,7 +346,17 @@ int main (int argc, char *argv[])
     
     CreateBloodStructures (mincHandle, bloodHandle);
 
-    ncendef (mincHandle);
+    if (EndDefine (mincHandle, argv[1], DEFAULT_HEADER_PAD, &Rewritten)
+	== MI_ERROR)
+    {
+	fprintf (stderr, "Could not update: %s\n", argv[1]);
+	return (-1);
+    }
+    if (Rewritten)
+    {
+	fprintf (stderr, "%s: header of %s was full -- whole file rewritten, "
+		 "with room to spare next time\n", PROGNAME, argv[1]);
+    }
 
     FillBloodStructures (mincHandle, bloodHandle);
 
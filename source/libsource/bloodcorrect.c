@@ -0,0 +1,660 @@
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : bloodcorrect.c
+@DESCRIPTION: Delay and dispersion correction of blood data for rCBF
+              analysis.  The delay fitting (BloodCurve, FitDelta and
+              FitDeltaGrid) used to live in delaycorrect.c; it is here
+              so that rcbf can do the whole of correctblood.m
+              (CorrectBlood) without going back to MATLAB.
+@GLOBALS    : NaN (must be defined elsewhere)
+@CREATED    : 2026/10/16 (from delaycorrect.c, by Mark Wolforth)
+@MODIFIED   :
+@VERSION    : $Id$
+              $Name:  $
+---------------------------------------------------------------------------- */
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "mex.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "emmageneral.h"
+#include "emmaproto.h"
+#include "simplex.h"
+#include "bloodcorrect.h"
+
+/*
+ * The delays tried by CorrectBlood (-5 to +10 sec, as in correctblood.m)
+ * and the starting point of each fit
+ */
+
+#define FIRST_DELTA        -5
+#define NUM_DELTAS         16
+#define FIT_TIME           60   /* fit frames starting before this time */
+
+static double InitParams [] = { .0001, .000125, .03 };
+
+extern double NaN;
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : VectorExponential
+@INPUT      :
+@OUTPUT     :
+@RETURNS    :
+@DESCRIPTION: Calculates the exponential of each member of a vector.  It also
+              allows a scale factor to be included in the exponent.
+@METHOD     :
+@GLOBALS    : none
+@CALLS      :
+@CREATED    :
+@MODIFIED   :
+---------------------------------------------------------------------------- */
+static void VectorExponential (int n, double scale, double A[], double C[])
+{
+   int   i;
+
+   for (i = 0; i < n; i++)
+   {
+      C[i] = exp (scale * A [i]);
+   }
+}
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : CopyVector
+@INPUT      :
+@OUTPUT     :
+@RETURNS    :
+@DESCRIPTION:
+@METHOD     :
+@GLOBALS    :
+@CALLS      :
+@CREATED    :
+@MODIFIED   :
+---------------------------------------------------------------------------- */
+static void CopyVector(double vec1[], const double vec2[], int size)
+{
+    int i;
+
+    for (i=0; i<size; i++)
+    {
+        vec1[i] = vec2[i];
+    }
+}
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : BloodCurve
+@INPUT      : x[] - alpha, beta, gamma (ie. K1, k2, V0)
+              blooddata - pointer to the BloodData to fit
+@OUTPUT     :
+@RETURNS    : sum of squared residuals
+@DESCRIPTION: The function minimised by the delay fits: the same as
+              fit_b_curve.m, except that a negative gamma is set to
+              zero.
+@METHOD     : The exponential and the convolution go in the BloodData's
+              work space, which is allocated once by the caller rather
+              than on every evaluation.
+@GLOBALS    :
+@CALLS      : VectorExponential, Convolve, IntFrames
+@CREATED    :
+@MODIFIED   : 2026/10/16: use the work space in the BloodData
+---------------------------------------------------------------------------- */
+double BloodCurve (double x[], void *blooddata)
+{
+    BloodData *data = (BloodData *) blooddata;
+    int    i;
+    double *Ntemp1, *Ntemp2;
+    double spacing;
+    double bcurve[8192];
+    double answer;
+
+    /*
+     * alpha (K1) = x[0]
+     *  beta (k2) = x[1]
+     * gamma (V0) = x[2]
+     */
+
+    if (x[2] < 0)
+    {
+	x[2] = 0;
+    }
+
+    Ntemp1 = data->work;
+    Ntemp2 = data->work + data->numsamples;
+    spacing = data->ts_even[1] - data->ts_even[0];
+
+    VectorExponential (data->numsamples, -x[1], data->ts_even, Ntemp1);
+    Convolve (data->numsamples, data->g_even, data->numsamples, Ntemp1,
+              spacing, data->numsamples, Ntemp2);
+
+    /*
+     * Now multiply Ntemp2[] (the convolution) by alpha, and then
+     * replace Ntemp2[] with alpha*conv + gamma * shifted_g_even
+     */
+
+    for (i = 0; i < data->numsamples; i++)
+    {
+        Ntemp2 [i] *= x[0];
+        Ntemp2 [i] += x[2] * data->g_even[i];
+    }
+
+    /* Now Ntemp2 corresponds to the vector i in b_curve.m (which is
+     * simply the "blood curve" in the time domain of ts_even); I have
+     * verified that the two match almost to within machine precision
+     * (max difference ~ 1e-12, mean difference ~ 1e-14)
+     */
+
+    /* Now integrate Ntemp2 frame-by-frame using fstarts and flengths */
+
+    IntFrames (data->numsamples, data->ts_even, Ntemp2, data->numframes,
+               data->fstarts, data->flengths, bcurve);
+
+    /* Replace any NaN's in bcurve with 0 */
+
+    answer = 0;
+
+    for (i = 0; i < data->numfitpoints; i++)
+    {
+        if (bcurve [i] != bcurve [i])     /* only true for NaN */
+        {
+            bcurve [i] = 0;
+        }
+        answer += (bcurve[i] - data->fitdata[i])*
+            (bcurve[i] - data->fitdata[i]);
+    }
+
+    return (answer);
+}
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : ShiftBlood
+@INPUT      : numsamples - number of elements in ts_even and g_even
+              ts_even - evenly spaced sample times
+              g_even - blood curve sampled at ts_even
+              delta - the delay (in the units of ts_even)
+@OUTPUT     : shifted_ts[] - the times at which the shifted curve is
+                             defined
+              shifted_g[] - the blood curve shifted right by delta, at
+                            those times
+@RETURNS    : the number of elements in shifted_ts and shifted_g (which
+              must each have room for numsamples)
+@DESCRIPTION: Shifts the blood curve in time by delta and drops the
+              samples that fall off the end -- ie.
+
+                 shifted_g = lookup ((ts_even-delta), g_even, ts_even)
+
+              with the NaN's removed (from shifted_ts too), as
+              correctblood.m does.
+@METHOD     :
+@GLOBALS    :
+@CALLS      : Lookup1
+@CREATED    : 2026/10/16 (from FitDelta)
+@MODIFIED   :
+---------------------------------------------------------------------------- */
+int ShiftBlood (int numsamples, double ts_even[], double g_even[],
+                double delta, double shifted_ts[], double shifted_g[])
+{
+    int       i, n;
+
+    if (delta != delta)                 /* no delay => no curve */
+    {
+        return (0);
+    }
+
+    for (i = 0; i < numsamples; i++)
+    {
+        shifted_ts[i] = ts_even[i] - delta;
+    }
+
+    Lookup1 (shifted_ts, g_even, ts_even, shifted_g,
+             numsamples, numsamples);
+
+    /*
+     * Keep only the samples where the shifted curve is defined (and
+     * the times that go with them)
+     */
+
+    for (i = 0, n = 0; i < numsamples; i++)
+    {
+        if (shifted_g[i] == shifted_g[i])
+        {
+            shifted_g[n] = shifted_g[i];
+            shifted_ts[n] = ts_even[i];
+            n++;
+        }
+    }
+    return (n);
+}
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : FitShifted
+@INPUT      : data - the blood data (unshifted), frame times and fit data
+              delta - the delay to fit for
+              numvars - number of parameters
+              init[] - starting point for the fit
+              simplex - set up by CreateSimplex to minimise BloodCurve
+                        on *shifted
+              shifted - a copy of *data, except that its ts_even and
+                        g_even point to room for data->numsamples
+                        values each, and its work to room for BloodCurve
+@OUTPUT     : final[] - the fitted parameters
+              *shifted - the shifted curve
+@RETURNS    : the residual sum of squares at final[], or NaN if the
+              shifted blood curve has fewer than two samples
+@DESCRIPTION: The work of FitDelta, with the simplex and the space for
+              the shifted curve supplied by the caller -- so that
+              FitDeltaGrid can do fits in several threads at once
+              without allocating anything (mxCalloc is not
+              thread-safe).
+@METHOD     :
+@GLOBALS    : NaN
+@CALLS      : ShiftBlood, StartSimplex, MinimizeSimplex
+@CREATED    : 2026/10/16 (from FitDelta)
+@MODIFIED   :
+---------------------------------------------------------------------------- */
+static double FitShifted (BloodData *data, double delta, int numvars,
+                          double init[], double final[],
+                          Simplex *simplex, BloodData *shifted)
+{
+    double    rss;
+    int       n;
+
+    n = ShiftBlood (data->numsamples, data->ts_even, data->g_even, delta,
+                    shifted->ts_even, shifted->g_even);
+    if (n < 2)
+    {
+        CopyVector (final, init, numvars);
+        return (NaN);
+    }
+    shifted->numsamples = n;
+
+    StartSimplex (simplex, init);
+    MinimizeSimplex (simplex, DELAY_MAXITER, DELAY_TOLERANCE,
+                     DELAY_TOLERANCE, final, &rss);
+
+    return (rss);
+}
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : FitDelta
+@INPUT      : data - the blood data (unshifted), frame times and fit data
+              delta - the delay to fit for
+              init[] - starting point for the fit
+              numvars - number of parameters
+              work - 2*data->numsamples doubles of work space (as well
+                     as the data->work used by BloodCurve)
+@OUTPUT     : final[] - the fitted parameters
+@RETURNS    : the residual sum of squares at final[], or NaN if the
+              shifted blood curve has fewer than two samples
+@DESCRIPTION: Does for one delay what the loop in correctblood.m used to
+              do: shifts the blood curve by delta, drops the samples
+              that fall off the end, and fits the model to the data.
+@METHOD     : The shift is done with Lookup1 (see ShiftBlood), exactly
+              as correctblood.m does with lookup.
+@GLOBALS    :
+@CALLS      : CreateSimplex, FitShifted, FreeSimplex
+@CREATED    : 2026/10/16
+@MODIFIED   :
+---------------------------------------------------------------------------- */
+double FitDelta (BloodData *data, double delta, int numvars,
+                 double init[], double final[], double *work)
+{
+    BloodData shifted;
+    Simplex   simplex;
+    double    rss;
+
+    shifted = *data;
+    shifted.ts_even = work;
+    shifted.g_even = work + data->numsamples;
+
+    CreateSimplex (&simplex, numvars, BloodCurve, &shifted, FALSE);
+    rss = FitShifted (data, delta, numvars, init, final, &simplex, &shifted);
+    FreeSimplex (&simplex);
+
+    return (rss);
+}
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : FitDeltaGrid
+@INPUT      : data - the blood data (unshifted), frame times and fit data
+              numvars - number of parameters
+              init[] - starting point for the first fit
+              numdeltas - number of delays to try
+              deltas[] - the delays
+              refine - whether to refine the best delay
+@OUTPUT     : params[] - numdeltas x numvars (column-major) fitted
+                         parameters, one row per delay
+              rss[] - residual sum of squares for each delay
+              *best_delta - the delay with the smallest residual
+              best_params[] - the numvars parameters fitted at
+                              *best_delta
+              *best_rss - the residual sum of squares at *best_delta
+@RETURNS    : (void)
+@DESCRIPTION: Fits the model for every delay in deltas[], as
+              correctblood.m used to with one call per delay, and picks
+              the best.
+              If refine is TRUE, and the best delay has a neighbour on
+              each side, a parabola is fitted through the three
+              residuals and one more fit is done at its minimum; if
+              that fit is better, its delay is returned instead.  This
+              gives a delay finer than the grid spacing for the cost of
+              one fit.  Either way, best_params and best_rss are those
+              of the fit at *best_delta (which, for a refined delay,
+              are not in params and rss).
+@METHOD     : The delays are split into one chunk of consecutive delays
+              per OpenMP thread (one chunk in all, without OpenMP), and
+              the chunks are fitted at the same time.  Within a chunk,
+              each fit starts from the result of the previous one, as
+              in correctblood.m -- neighbouring delays have very similar
+              fits, so this converges much faster than starting each
+              from init; only the first fit of each chunk starts from
+              init.  With one chunk the fits are exactly those of
+              correctblood.m's loop; with more, the results can differ
+              from them within the fit tolerance.
+              Each chunk has its own simplex, shifted curve and
+              BloodCurve work space, all allocated here before any
+              fitting starts.
+@GLOBALS    : NaN
+@CALLS      : CreateSimplex, FitShifted, FreeSimplex
+@CREATED    : 2026/10/16
+@MODIFIED   : 2026/10/16: return the fit at the refined delay too, and
+                          allocate BloodCurve's work space once
+              2026/10/16: chunks of delays fitted in parallel
+---------------------------------------------------------------------------- */
+void FitDeltaGrid (BloodData *data, int numvars, double init[],
+                   int numdeltas, double deltas[], Boolean refine,
+                   double params[], double rss[], double *best_delta,
+                   double best_params[], double *best_rss)
+{
+    BloodData *shifted;
+    Simplex   *simplexes;
+    double    *work, *chunkwork;
+    double    *start, *final;
+    double     d0, d1, d2, r0, r1, r2;
+    double     num, den, refined, refined_rss;
+    int        numchunks, chunksize;
+    int        chunk, first, last;
+    int        best;
+    int        i, j;
+
+    numchunks = 1;
+#ifdef _OPENMP
+    numchunks = omp_get_max_threads ();
+    if (numchunks > numdeltas)
+    {
+        numchunks = numdeltas;
+    }
+    if (numchunks < 1)
+    {
+        numchunks = 1;
+    }
+#endif
+
+    /*
+     * Per chunk: the shifted ts_even and g_even, BloodCurve's work
+     * space, and the start and end of each fit
+     */
+
+    chunksize = 4*data->numsamples + 2*numvars;
+    work = (double *) mxCalloc (numchunks * chunksize, sizeof (double));
+    shifted = (BloodData *) mxCalloc (numchunks, sizeof (BloodData));
+    simplexes = (Simplex *) mxCalloc (numchunks, sizeof (Simplex));
+    for (chunk = 0; chunk < numchunks; chunk++)
+    {
+        chunkwork = work + chunk*chunksize;
+        shifted[chunk] = *data;
+        shifted[chunk].ts_even = chunkwork;
+        shifted[chunk].g_even = chunkwork + data->numsamples;
+        shifted[chunk].work = chunkwork + 2*data->numsamples;
+        CreateSimplex (&simplexes[chunk], numvars, BloodCurve,
+                       &shifted[chunk], FALSE);
+    }
+
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(numchunks) schedule(static, 1) private(chunkwork, start, final, first, last, i, j)
+#endif
+    for (chunk = 0; chunk < numchunks; chunk++)
+    {
+        chunkwork = work + chunk*chunksize;
+        start = chunkwork + 4*data->numsamples;
+        final = start + numvars;
+        first = (int) ((long) numdeltas * chunk / numchunks);
+        last = (int) ((long) numdeltas * (chunk+1) / numchunks);
+
+        CopyVector (start, init, numvars);
+        for (i = first; i < last; i++)
+        {
+            rss[i] = FitShifted (data, deltas[i], numvars, start, final,
+                                 &simplexes[chunk], &shifted[chunk]);
+            for (j = 0; j < numvars; j++)
+            {
+                params[i + j*numdeltas] = final[j];
+            }
+            CopyVector (start, final, numvars);
+        }
+    }
+
+    best = -1;
+    for (i = 0; i < numdeltas; i++)
+    {
+        if ((rss[i] == rss[i]) && ((best < 0) || (rss[i] < rss[best])))
+        {
+            best = i;
+        }
+    }
+
+    if (best < 0)
+    {
+        *best_delta = NaN;
+        *best_rss = NaN;
+        CopyVector (best_params, init, numvars);
+    }
+    else
+    {
+        *best_delta = deltas[best];
+        *best_rss = rss[best];
+        for (j = 0; j < numvars; j++)
+        {
+            best_params[j] = params[best + j*numdeltas];
+        }
+    }
+
+    if (refine && (best > 0) && (best < numdeltas-1))
+    {
+        d0 = deltas[best-1];  r0 = rss[best-1];
+        d1 = deltas[best];    r1 = rss[best];
+        d2 = deltas[best+1];  r2 = rss[best+1];
+
+        num = (d1-d0)*(d1-d0)*(r1-r2) - (d1-d2)*(d1-d2)*(r1-r0);
+        den = (d1-d0)*(r1-r2) - (d1-d2)*(r1-r0);
+
+        if (den != 0)
+        {
+            refined = d1 - 0.5 * num / den;
+            if ((refined > min (d0, d2)) && (refined < max (d0, d2)))
+            {
+                final = work + 4*data->numsamples + numvars;
+                refined_rss = FitShifted (data, refined, numvars,
+                                          best_params, final,
+                                          &simplexes[0], &shifted[0]);
+                if (refined_rss < r1)
+                {
+                    *best_delta = refined;
+                    *best_rss = refined_rss;
+                    CopyVector (best_params, final, numvars);
+                }
+            }
+        }
+    }
+
+    for (chunk = 0; chunk < numchunks; chunk++)
+    {
+        FreeSimplex (&simplexes[chunk]);
+    }
+    mxFree (simplexes);
+    mxFree (shifted);
+    mxFree (work);
+}
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : SmoothDeriv
+@INPUT      : nn - number of points in the smoothing window (odd)
+              npts - number of elements in y
+              y[] - the evenly sampled function
+              dt - the sample spacing
+@OUTPUT     : yfit[] - y, smoothed
+              z[] - the derivative of y
+@RETURNS    : (void)
+@DESCRIPTION: Same as deriv.m: differentiates and smooths y by the
+              method of Sayers ("Inferring Significance from Biological
+              Signals"), fitting a parabola to each window of nn points.
+              The (nn-1)/2 points at either end, where the window
+              doesn't fit, are set to zero.
+@METHOD     :
+@GLOBALS    :
+@CALLS      :
+@CREATED    : 2026/10/16
+@MODIFIED   :
+---------------------------------------------------------------------------- */
+void SmoothDeriv (int nn, int npts, double y[], double dt,
+                  double yfit[], double z[])
+{
+    double  caa, cbb;
+    double  aa, bb;
+    int     half;
+    int     i, kk;
+
+    caa = 3.0 / (4.0 * nn * (nn*nn - 4));
+    cbb = 12.0 / ((double) nn * (nn*nn - 1));
+    half = (nn - 1) / 2;
+
+    for (i = 0; i < npts; i++)
+    {
+        yfit[i] = 0;
+        z[i] = 0;
+    }
+
+    for (i = half; i < npts - half; i++)
+    {
+        aa = 0;
+        bb = 0;
+        for (kk = -half; kk <= half; kk++)
+        {
+            aa += y[i+kk] * (3*nn*nn - 20*kk*kk - 7);
+            bb += y[i+kk] * kk;
+        }
+        yfit[i] = caa * aa;
+        z[i] = cbb * bb / dt;
+    }
+}
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : CorrectBlood
+@INPUT      : numsamples - number of elements in g_even and ts_even
+              g_even - the (uncorrected) blood curve, sampled at the
+                       times in ts_even
+              ts_even - evenly spaced times
+              numframes - number of frames
+              fstarts, flengths - frame start times and lengths
+              A[] - brain activity (eg. averaged over grey matter), one
+                    value per frame
+              tau - the dispersion time constant
+@OUTPUT     : *delta - the delay that best fits A (NaN if none fits)
+              Ca_even[] - g_even, corrected for dispersion and delay
+              new_ts_even[] - the times of Ca_even
+              (Ca_even and new_ts_even must each have room for
+              numsamples elements)
+@RETURNS    : the number of elements in Ca_even and new_ts_even
+@DESCRIPTION: Does what correctblood.m does (with do_delay true):
+              corrects g_even for dispersion by calculating
+              g(t) + tau*dg/dt, fits the blood curve model to the
+              frames of A starting in the first minute for each delay
+              from -5 to +10 sec, and shifts the corrected curve by the
+              delay that fits best.
+@METHOD     :
+@GLOBALS    :
+@CALLS      : SmoothDeriv, FitDeltaGrid, ShiftBlood
+@CREATED    : 2026/10/16
+@MODIFIED   :
+---------------------------------------------------------------------------- */
+int CorrectBlood (int numsamples, double g_even[], double ts_even[],
+                  int numframes, double fstarts[], double flengths[],
+                  double A[], double tau, double *delta,
+                  double Ca_even[], double new_ts_even[])
+{
+    BloodData data;
+    double   *work;
+    double   *smooth_g, *deriv_g, *fitdata, *params, *rss;
+    double    deltas [NUM_DELTAS];
+    double    best_params [3], best_rss;
+    int       i;
+
+    if (numsamples < 3)
+    {
+        *delta = NaN;
+        return (0);
+    }
+
+    work = (double *) mxCalloc (2*numsamples + numframes +
+                                4*NUM_DELTAS, sizeof (double));
+    smooth_g = work;
+    deriv_g = smooth_g + numsamples;
+    fitdata = deriv_g + numsamples;
+    params = fitdata + numframes;
+    rss = params + 3*NUM_DELTAS;
+
+    /*
+     * The dispersion correction, dropping the last sample (whose
+     * derivative isn't known) as correctblood.m does
+     */
+
+    SmoothDeriv (3, numsamples, g_even, ts_even[1] - ts_even[0],
+                 smooth_g, deriv_g);
+    for (i = 0; i < numsamples-1; i++)
+    {
+        smooth_g[i] += tau * deriv_g[i];
+    }
+
+    /*
+     * Only the frames in the first minute are fitted
+     */
+
+    data.numfitpoints = 0;
+    for (i = 0; i < numframes; i++)
+    {
+        if (fstarts[i] < FIT_TIME)
+            fitdata[data.numfitpoints++] = A[i];
+    }
+
+    data.ts_even = ts_even;
+    data.g_even = smooth_g;
+    data.numsamples = numsamples-1;
+    data.numframes = numframes;
+    data.fstarts = fstarts;
+    data.flengths = flengths;
+    data.fitdata = fitdata;
+    data.work = NULL;                   /* FitDeltaGrid supplies it */
+
+    for (i = 0; i < NUM_DELTAS; i++)
+    {
+        deltas[i] = FIRST_DELTA + i;
+    }
+
+    FitDeltaGrid (&data, 3, InitParams, NUM_DELTAS, deltas, FALSE,
+                  params, rss, delta, best_params, &best_rss);
+
+    i = ShiftBlood (numsamples-1, ts_even, smooth_g, *delta,
+                    new_ts_even, Ca_even);
+
+    mxFree (work);
+    return (i);
+}
@@ -0,0 +1,492 @@
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : convolve.c
+@DESCRIPTION: Provides Convolve, which calculates (all or part of) the
+              convolution of two evenly sampled functions.  Short
+              convolutions are done directly; long ones with an FFT,
+              so that the cost grows as n log n rather than n^2.  Also
+              provides ExpConvolve, for the common special case of
+              convolving with exp(-k*t).
+@GLOBALS    :
+@CREATED    : 2026/10/16
+@MODIFIED   : 2026/10/16: FFT work space and tables kept between calls
+              2026/10/16: NaN's and Inf's always convolved directly
+@VERSION    : $Id$
+              $Name:  $
+---------------------------------------------------------------------------- */
+
+#include <stdlib.h>
+#include <math.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "emmageneral.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+/*
+ * Convolve uses the FFT when the direct method would take more than
+ * FFT_CROSSOVER * N log2 N multiply-adds, where N is the FFT size.  The
+ * value is rough -- it's about where the two methods break even on a
+ * typical workstation -- but the choice is never off by much near the
+ * crossover, and is never in doubt far from it.
+ */
+
+#define FFT_CROSSOVER   4.0
+
+/*
+ * EvenlySpaced allows each step to differ from the first by this
+ * fraction of it, to allow for round-off in (eg.) 0:h:T.
+ */
+
+#define SPACING_TOLERANCE  1e-6
+
+/*
+ * The work space and twiddle tables of the last FFT size used (see
+ * GetWork), kept so that repeated convolutions of the same length --
+ * eg. one per objective function evaluation in delaycorrect -- don't
+ * have to rebuild them every time.
+ */
+
+static int      WorkN = 0;
+static double  *Work = NULL;
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : DirectConvolve
+@INPUT      : (see Convolve)
+@OUTPUT     : (see Convolve)
+@RETURNS    : (void)
+@DESCRIPTION: Calculates the first nc elements of the convolution the
+              obvious way.  na and nb must already have been trimmed so
+              that neither is more than nc.
+@METHOD     :
+@GLOBALS    :
+@CALLS      :
+@CREATED    : 93-8-23, Greg Ward (as Convolve in delaycorrect.c, based on
+                                  polynomial multiplication routine
+                                  from CEPHES)
+@MODIFIED   : 2026/10/16: moved to convolve.c, allowed A and B to
+                          have different lengths
+---------------------------------------------------------------------------- */
+static void DirectConvolve (int na, double A[], int nb, double B[],
+                            double spacing, int nc, double C[])
+{
+   int     i, j;
+   double  x;
+
+   for (i = 0; i < nc; i++)
+   {
+      C [i] = 0;
+   }
+
+   for (i = 0; i < na; i++)
+   {
+      x = A [i] * spacing;
+      for (j = 0; (j < nb) && (i+j < nc); j++)
+      {
+         C [i+j] += x * B [j];
+      }
+   }
+}     /* DirectConvolve */
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : FFT
+@INPUT      : N - number of points (must be a power of two)
+              Re[], Im[] - the complex sequence to transform
+              CosTab[], SinTab[] - cos and sin of 2*pi*k/N, k = 0..N/2-1
+              Inverse - TRUE for the inverse transform (without the 1/N)
+@OUTPUT     : Re[], Im[] - the transformed sequence
+@RETURNS    : (void)
+@DESCRIPTION: In-place radix-2 fast Fourier transform.
+@METHOD     : Iterative decimation in time: bit-reversal permutation
+              followed by log2(N) passes of butterflies.
+@GLOBALS    :
+@CALLS      :
+@CREATED    : 2026/10/16
+@MODIFIED   :
+---------------------------------------------------------------------------- */
+static void FFT (int N, double Re[], double Im[],
+                 double CosTab[], double SinTab[], Boolean Inverse)
+{
+   int     i, j, k, bit;
+   int     len, half, step;
+   double  wr, wi, tr, ti;
+
+   /* Shuffle into bit-reversed order */
+
+   for (i = 1, j = 0; i < N; i++)
+   {
+      for (bit = N >> 1; j & bit; bit >>= 1)
+      {
+         j ^= bit;
+      }
+      j |= bit;
+
+      if (i < j)
+      {
+         tr = Re [i]; Re [i] = Re [j]; Re [j] = tr;
+         ti = Im [i]; Im [i] = Im [j]; Im [j] = ti;
+      }
+   }
+
+   /* And combine ever-longer transforms */
+
+   for (len = 2; len <= N; len <<= 1)
+   {
+      half = len >> 1;
+      step = N / len;
+      for (i = 0; i < N; i += len)
+      {
+         for (j = 0; j < half; j++)
+         {
+            wr = CosTab [j*step];
+            wi = Inverse ? SinTab [j*step] : -SinTab [j*step];
+            k = i + j + half;
+
+            tr = Re [k] * wr - Im [k] * wi;
+            ti = Re [k] * wi + Im [k] * wr;
+            Re [k] = Re [i+j] - tr;
+            Im [k] = Im [i+j] - ti;
+            Re [i+j] += tr;
+            Im [i+j] += ti;
+         }
+      }
+   }
+}     /* FFT */
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : GetWork
+@INPUT      : N - size of FFT (a power of two)
+              Shared - TRUE to use (and keep) the saved work space;
+                 FALSE to make a private one, which the caller must free
+@OUTPUT     :
+@RETURNS    : work space for FFTConvolve: 4*N doubles, followed by the
+              cos and sin tables for N (N/2 of each); or NULL if out of
+              memory
+@DESCRIPTION: Gets the work space for an FFT of size N, reusing the one
+              from the last call if it was the same size.
+@METHOD     : Only the work space for the last size is kept, since a
+              caller doing many convolutions almost always does them
+              all the same length.  It is never freed (it's small).
+              Callers running in parallel (eg. the threads of a batch
+              of fits in nfmins) can't share it, so they get their own.
+@GLOBALS    : WorkN, Work
+@CALLS      :
+@CREATED    : 2026/10/16
+@MODIFIED   :
+---------------------------------------------------------------------------- */
+static double *GetWork (int N, Boolean Shared)
+{
+   double  *NewWork;
+   double  *CosTab, *SinTab;
+   int      i;
+
+   if (Shared && (N == WorkN))
+   {
+      return (Work);
+   }
+
+   NewWork = (double *) malloc (5 * N * sizeof (double));
+   if (NewWork == NULL)
+   {
+      return (NULL);
+   }
+
+   CosTab = NewWork + 4*N;
+   SinTab = CosTab + N/2;
+   for (i = 0; i < N/2; i++)
+   {
+      CosTab [i] = cos (2 * M_PI * i / N);
+      SinTab [i] = sin (2 * M_PI * i / N);
+   }
+
+   if (Shared)
+   {
+      free (Work);
+      Work = NewWork;
+      WorkN = N;
+   }
+   return (NewWork);
+}     /* GetWork */
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : FFTConvolve
+@INPUT      : (see Convolve)
+              N - size of FFT to use: a power of two >= na+nb-1
+@OUTPUT     : (see Convolve)
+@RETURNS    : TRUE if all went well
+              FALSE if we couldn't allocate the work space (in which
+              case C[] is untouched)
+@DESCRIPTION: Calculates the first nc elements of the convolution via
+              the convolution theorem.
+@METHOD     : Since A and B are both real, they are transformed together
+              by packing them into the real and imaginary parts of one
+              complex sequence; their individual transforms are then
+              separated using the symmetry of the transform of a real
+              sequence.  The product of the two transforms is then
+              transformed back.
+@GLOBALS    :
+@CALLS      : GetWork, FFT
+@CREATED    : 2026/10/16
+@MODIFIED   : 2026/10/16: work space and tables kept between calls
+---------------------------------------------------------------------------- */
+static Boolean FFTConvolve (int na, double A[], int nb, double B[],
+                            double spacing, int nc, double C[], int N)
+{
+   double  *Space;
+   double  *Re, *Im, *Pr, *Pi, *CosTab, *SinTab;
+   double  ar, ai, br, bi;
+   int     i, k, nk;
+   Boolean Shared;
+
+   Shared = TRUE;
+#ifdef _OPENMP
+   Shared = !omp_in_parallel ();
+#endif
+
+   Space = GetWork (N, Shared);
+   if (Space == NULL)
+   {
+      return (FALSE);
+   }
+   Re = Space;
+   Im = Re + N;
+   Pr = Im + N;
+   Pi = Pr + N;
+   CosTab = Pi + N;
+   SinTab = CosTab + N/2;
+
+   for (i = 0; i < N; i++)
+   {
+      Re [i] = (i < na) ? A [i] : 0;
+      Im [i] = (i < nb) ? B [i] : 0;
+   }
+
+   FFT (N, Re, Im, CosTab, SinTab, FALSE);
+
+   /*
+    * Unpack the transforms of A and B from that of A + iB, and multiply
+    * them together:
+    *   FA[k] = (Z[k] + conj(Z[N-k])) / 2
+    *   FB[k] = (Z[k] - conj(Z[N-k])) / 2i
+    */
+
+   for (k = 0; k < N; k++)
+   {
+      nk = (N - k) & (N - 1);
+      ar = (Re [k] + Re [nk]) / 2;
+      ai = (Im [k] - Im [nk]) / 2;
+      br = (Im [k] + Im [nk]) / 2;
+      bi = (Re [nk] - Re [k]) / 2;
+
+      Pr [k] = ar * br - ai * bi;
+      Pi [k] = ar * bi + ai * br;
+   }
+
+   FFT (N, Pr, Pi, CosTab, SinTab, TRUE);
+
+   for (i = 0; i < nc; i++)
+   {
+      C [i] = (i < na+nb-1) ? Pr [i] * spacing / N : 0;
+   }
+
+   if (!Shared)
+   {
+      free (Space);
+   }
+   return (TRUE);
+}     /* FFTConvolve */
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : AllFinite
+@INPUT      : n - number of elements in X[]
+              X[] - vector to check
+@OUTPUT     :
+@RETURNS    : TRUE if there are no NaN's or Inf's in X[]
+@DESCRIPTION: Lets Convolve keep non-finite values away from the FFT,
+              which would spread them through the whole result.
+@METHOD     : x - x is 0 for finite x, and NaN for a NaN or Inf (so
+              there's no need for isnan or isfinite, which not every
+              compiler has).
+@GLOBALS    :
+@CALLS      :
+@CREATED    : 2026/10/16
+@MODIFIED   :
+---------------------------------------------------------------------------- */
+static Boolean AllFinite (int n, double X[])
+{
+   int     i;
+
+   for (i = 0; i < n; i++)
+   {
+      if (!(X [i] - X [i] == 0))
+         return (FALSE);
+   }
+   return (TRUE);
+}     /* AllFinite */
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : Convolve
+@INPUT      : na - number of elements in A[]
+              A[] - the first function to convolve
+              nb - number of elements in B[]
+              B[] - the second function to convolve.  A[] and B[] must be
+                    sampled with the same uniform spacing.
+              spacing - the spacing of the time-domain to which A[] and
+                        B[] belong (and to which C[] will belong)
+              nc - number of elements of the convolution wanted (the
+                   whole thing has na+nb-1 elements; any beyond that
+                   are set to zero)
+@OUTPUT     : C[] - the first nc elements of the convolution of A[] and
+                    B[], scaled by spacing
+@RETURNS    : (void)
+@DESCRIPTION: Calculates a (possibly truncated) scaled convolution of two
+              functions, so that C[] approximates the integral of
+              A(t) B(T-t) dt.
+@METHOD     : Elements of A[] and B[] past the first nc can't affect
+              the first nc elements of the result, so they are ignored.
+              Then, if the direct method would take long enough, the
+              convolution is done with an FFT instead (falling back on
+              the direct method if there isn't enough memory).
+
+              The FFT is not used if there is a NaN or Inf in A[] or
+              B[]: every element of the transform would be NaN, and so
+              would every element of the result.  The direct method,
+              like nconv.m's filter, only spoils the elements that
+              really depend on the non-finite value.
+@GLOBALS    :
+@CALLS      : DirectConvolve, FFTConvolve, AllFinite
+@CREATED    : 2026/10/16
+@MODIFIED   :
+---------------------------------------------------------------------------- */
+void Convolve (int na, double A[], int nb, double B[],
+               double spacing, int nc, double C[])
+{
+   int     N, log2N;
+
+   if (na > nc) na = nc;
+   if (nb > nc) nb = nc;
+
+   if ((na <= 0) || (nb <= 0))
+   {
+      DirectConvolve (0, A, 0, B, spacing, nc, C);
+      return;
+   }
+
+   for (N = 1, log2N = 0; N < na+nb-1; N <<= 1, log2N++)
+      ;
+
+   if (((double) na * nb > FFT_CROSSOVER * N * log2N) &&
+       AllFinite (na, A) && AllFinite (nb, B) &&
+       FFTConvolve (na, A, nb, B, spacing, nc, C, N))
+   {
+      return;
+   }
+
+   DirectConvolve (na, A, nb, B, spacing, nc, C);
+}     /* Convolve */
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : EvenlySpaced
+@INPUT      : Length - number of elements in X[]
+              X[] - vector to check
+@OUTPUT     :
+@RETURNS    : TRUE if X[] is evenly spaced, to within SPACING_TOLERANCE
+              of its first step
+@DESCRIPTION: Lets callers of ExpConvolve decide whether they can use
+              the recursive filter.
+@METHOD     :
+@GLOBALS    :
+@CALLS      :
+@CREATED    : 2026/10/16
+@MODIFIED   :
+---------------------------------------------------------------------------- */
+Boolean EvenlySpaced (int Length, double X[])
+{
+   double  Spacing;
+   int     i;
+
+   if (Length < 2)
+   {
+      return (TRUE);
+   }
+
+   Spacing = X [1] - X [0];
+   for (i = 2; i < Length; i++)
+   {
+      if (fabs ((X [i] - X [i-1]) - Spacing) > SPACING_TOLERANCE * fabs (Spacing))
+      {
+         return (FALSE);
+      }
+   }
+   return (TRUE);
+}     /* EvenlySpaced */
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : ExpConvolve
+@INPUT      : Length - number of elements in Ca[] and Ts[]
+              Ca[] - the function to convolve with exp(-k*t)
+              Ts[] - the times at which Ca[] is sampled
+              k - the rate constant
+              Even - TRUE if Ts[] is evenly spaced (see EvenlySpaced)
+              ExpFun[] - work space of Length elements (only used if
+                         Even is FALSE)
+@OUTPUT     : Convo[] - the first Length elements of the convolution of
+                        Ca[] and exp(-k*Ts[]), scaled by the sample
+                        spacing
+@RETURNS    : (void)
+@DESCRIPTION: Convolves a function with a decaying exponential -- the
+              impulse response of a one-compartment model -- giving the
+              same result as building exp(-k*Ts[]) and calling Convolve,
+              but (when Ts[] is evenly spaced) in time proportional to
+              Length.
+@METHOD     : On an evenly spaced grid t[m] = t[0] + m*h, the sampled
+              exponential is exp(-k*t[0]) * r^m with r = exp(-k*h), so
+              the sum
+
+                 S[n] = sum_{j=0..n} Ca[j] r^(n-j)
+
+              satisfies S[n] = r*S[n-1] + Ca[n], and the convolution is
+              just h * exp(-k*t[0]) * S[n] -- a first-order recursive
+              filter.  Otherwise, the exponential is built explicitly
+              and handed to Convolve.
+@GLOBALS    :
+@CALLS      : Convolve
+@CREATED    : 2026/10/16
+@MODIFIED   :
+---------------------------------------------------------------------------- */
+void ExpConvolve (int Length, double Ca[], double Ts[], double k,
+                  Boolean Even, double ExpFun[], double Convo[])
+{
+   double  Spacing, Ratio, Scale, Sum;
+   int     i;
+
+   Spacing = Ts [1] - Ts [0];
+   if (!Even)
+   {
+      for (i = 0; i < Length; i++)
+      {
+         ExpFun [i] = exp (-k * Ts [i]);
+      }
+      Convolve (Length, Ca, Length, ExpFun, Spacing, Length, Convo);
+      return;
+   }
+
+   Ratio = exp (-k * Spacing);
+   Scale = Spacing * exp (-k * Ts [0]);
+   Sum = 0;
+   for (i = 0; i < Length; i++)
+   {
+      Sum = Ratio * Sum + Ca [i];
+      Convo [i] = Scale * Sum;
+   }
+}     /* ExpConvolve */
@@ -0,0 +1,115 @@
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : emmathread.c
+@DESCRIPTION: Runs a function in the background: StartThread starts it,
+              WaitThread waits for it to finish.  That is all the
+              library needs (eg. to read the next slab of a study while
+              the caller works on this one), so that is all there is --
+              no locks, no thread pools.  Uses POSIX threads if
+              EMMA_PTHREADS is defined, Win32 threads under Windows,
+              and otherwise just calls the function.
+@GLOBALS    : none
+@CREATED    : 2026/10/16
+@MODIFIED   :
+@VERSION    : $Id$
+              $Name:  $
+---------------------------------------------------------------------------- */
+
+#include <stdio.h>
+#include "emmageneral.h"
+#include "emmathread.h"
+
+
+#if defined (EMMA_PTHREADS)
+static void *RunThread (void *Arg)
+{
+   EmmaThread *Thread = (EmmaThread *) Arg;
+
+   (*Thread->Func) (Thread->Arg);
+   return (NULL);
+}
+#elif defined (_WIN32)
+static DWORD WINAPI RunThread (LPVOID Arg)
+{
+   EmmaThread *Thread = (EmmaThread *) Arg;
+
+   (*Thread->Func) (Thread->Arg);
+   return (0);
+}
+#endif
+
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : StartThread
+@INPUT      : Func - the function to run
+              Arg - its argument
+@OUTPUT     : *Thread - must stay where it is, and be passed to
+                 WaitThread before Func's results are used (or Thread
+                 is reused)
+@RETURNS    : TRUE if Func is running in another thread; FALSE if it
+              has already been run (because there are no threads, or
+              one couldn't be started)
+@DESCRIPTION: Starts Func (Arg) running in the background.
+              Func must not use the MATLAB API (mxCalloc, mexPrintf,
+              etc.), which may only be called from MATLAB's own thread;
+              and the caller must not touch whatever Func is working on
+              until WaitThread returns.
+@METHOD     : If the thread can't be started, Func is run there and then,
+              so the caller needn't care whether there are threads.
+@GLOBALS    :
+@CALLS      : pthread_create or CreateThread
+@CREATED    : 2026/10/16
+@MODIFIED   :
+---------------------------------------------------------------------------- */
+Boolean StartThread (EmmaThread *Thread, ThreadFunc Func, void *Arg)
+{
+   Thread->Func = Func;
+   Thread->Arg = Arg;
+   Thread->Running = FALSE;
+
+#if defined (EMMA_PTHREADS)
+   Thread->Running = (pthread_create (&Thread->Handle, NULL,
+                                      RunThread, Thread) == 0);
+#elif defined (_WIN32)
+   Thread->Handle = CreateThread (NULL, 0, RunThread, Thread, 0, NULL);
+   Thread->Running = (Thread->Handle != NULL);
+#endif
+
+   if (!Thread->Running)
+   {
+      (*Func) (Arg);
+   }
+   return (Thread->Running);
+}     /* StartThread */
+
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : WaitThread
+@INPUT      : Thread - as set by StartThread
+@OUTPUT     :
+@RETURNS    : (void)
+@DESCRIPTION: Waits for the function started by StartThread to finish.
+              Does nothing if it already has been waited for, or was
+              never really in the background.
+@METHOD     :
+@GLOBALS    :
+@CALLS      : pthread_join or WaitForSingleObject
+@CREATED    : 2026/10/16
+@MODIFIED   :
+---------------------------------------------------------------------------- */
+void WaitThread (EmmaThread *Thread)
+{
+   if (!Thread->Running)
+   {
+      return;
+   }
+
+#if defined (EMMA_PTHREADS)
+   pthread_join (Thread->Handle, NULL);
+#elif defined (_WIN32)
+   WaitForSingleObject (Thread->Handle, INFINITE);
+   CloseHandle (Thread->Handle);
+#endif
+   Thread->Running = FALSE;
+}     /* WaitThread */
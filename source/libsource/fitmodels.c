@@ -0,0 +1,291 @@
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : fitmodels.c
+@DESCRIPTION: Compiled versions of the objective functions used to fit
+              kinetic models to PET data -- fit_b_curve.m, fit_rcbf.m,
+              and fit_fdg.m -- so that nfmins can minimise them without
+              a round-trip through MATLAB for every function
+              evaluation.  Each takes the model parameters and a FitData
+              struct (set up once per fit by InitFitData), computes the
+              model's tissue curve on the evenly spaced time grid,
+              integrates it across frames, and returns the sum of
+              squared differences from the data.  Frames that the
+              input function doesn't span (ie. whose integral is NaN)
+              contribute zero, as in b_curve.m.
+
+              To add a model, write its FitFunction and add it to
+              FitModels[]; its M-file equivalent should take the same
+              arguments, ie. (args, g_even, ts_even, A, fstart, flengths).
+@GLOBALS    :
+@CREATED    : 2026/10/16
+@MODIFIED   :
+@VERSION    : $Id$
+              $Name:  $
+---------------------------------------------------------------------------- */
+
+#include <stdlib.h>
+#include <string.h>
+#include "emmageneral.h"
+#include "emmaproto.h"
+#include "fitmodels.h"
+
+
+static double FitBCurve (double x[], FitData *data);
+static double FitRCBF (double x[], FitData *data);
+static double FitFDG (double x[], FitData *data);
+
+static FitModel FitModels [] =
+{
+   { "fit_b_curve",  3, FitBCurve },
+   { "fit_rcbf",     2, FitRCBF },
+   { "fit_fdg",      3, FitFDG },
+   { NULL,           0, NULL }
+};
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : FindFitModel
+@INPUT      : Name - name of an objective function (as passed to nfmins)
+@OUTPUT     :
+@RETURNS    : pointer to the compiled model of that name, or NULL if
+              there isn't one
+@DESCRIPTION:
+@METHOD     :
+@GLOBALS    : FitModels
+@CALLS      :
+@CREATED    : 2026/10/16
+@MODIFIED   :
+---------------------------------------------------------------------------- */
+FitModel *FindFitModel (char Name[])
+{
+   FitModel  *Model;
+
+   for (Model = FitModels; Model->Name != NULL; Model++)
+   {
+      if (strcmp (Model->Name, Name) == 0)
+         return (Model);
+   }
+   return (NULL);
+}
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : InitFitData
+@INPUT      : numsamples - number of elements in ts_even and g_even
+              ts_even - evenly spaced sample times
+              g_even - input function sampled at ts_even
+              numframes - number of frames
+              fstarts, flengths - frame start times and lengths
+              numfitpoints - number of elements in fitdata (must be no
+                             more than numframes)
+              fitdata - data to fit, one value per frame
+@OUTPUT     : *data - filled in and given its work space
+@RETURNS    : TRUE if all went well
+              FALSE if the arguments don't make sense or we ran out of
+              memory
+@DESCRIPTION: Sets up a FitData struct for the FitFunctions.  The data
+              vectors themselves aren't copied, so must stay put until
+              the fit is done; FreeFitData frees the work space.
+@METHOD     :
+@GLOBALS    :
+@CALLS      : EvenlySpaced
+@CREATED    : 2026/10/16
+@MODIFIED   :
+---------------------------------------------------------------------------- */
+Boolean InitFitData (FitData *data,
+                     int numsamples, double *ts_even, double *g_even,
+                     int numframes, double *fstarts, double *flengths,
+                     int numfitpoints, double *fitdata)
+{
+   data->expfun = NULL;
+   data->frameints = NULL;
+
+   if ((numsamples < 2) || (numfitpoints > numframes))
+      return (FALSE);
+
+   data->ts_even = ts_even;
+   data->g_even = g_even;
+   data->numsamples = numsamples;
+   data->even = EvenlySpaced (numsamples, ts_even);
+   data->fstarts = fstarts;
+   data->flengths = flengths;
+   data->numframes = numframes;
+   data->fitdata = fitdata;
+   data->numfitpoints = numfitpoints;
+
+   data->expfun = (double *) malloc (3 * numsamples * sizeof (double));
+   data->frameints = (double *) malloc (numframes * sizeof (double));
+   if ((data->expfun == NULL) || (data->frameints == NULL))
+   {
+      FreeFitData (data);
+      return (FALSE);
+   }
+   data->curve = data->expfun + numsamples;
+   data->curve2 = data->curve + numsamples;
+
+   return (TRUE);
+}
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : FreeFitData
+@INPUT      : *data - struct set up by InitFitData
+@OUTPUT     :
+@RETURNS    : (void)
+@DESCRIPTION: Frees the work space allocated by InitFitData.
+@METHOD     :
+@GLOBALS    :
+@CALLS      :
+@CREATED    : 2026/10/16
+@MODIFIED   :
+---------------------------------------------------------------------------- */
+void FreeFitData (FitData *data)
+{
+   if (data->expfun != NULL)
+      free (data->expfun);
+   if (data->frameints != NULL)
+      free (data->frameints);
+   data->expfun = NULL;
+   data->frameints = NULL;
+}
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : Residual
+@INPUT      : *data - with the model curve in data->curve
+@OUTPUT     :
+@RETURNS    : sum of squared differences between the frame integrals of
+              the model curve and data->fitdata
+@DESCRIPTION: The part common to all the FitFunctions.
+@METHOD     : Frame integrals that are NaN (because the frame isn't
+              spanned by ts_even) are taken to be zero.
+@GLOBALS    :
+@CALLS      : IntFrames
+@CREATED    : 2026/10/16
+@MODIFIED   :
+---------------------------------------------------------------------------- */
+static double Residual (FitData *data)
+{
+   double  Sum, Value;
+   int     i;
+
+   IntFrames (data->numsamples, data->ts_even, data->curve,
+              data->numframes, data->fstarts, data->flengths,
+              data->frameints);
+
+   Sum = 0;
+   for (i = 0; i < data->numfitpoints; i++)
+   {
+      Value = data->frameints [i];
+      if (Value != Value)               /* only true for NaN */
+         Value = 0;
+      Value -= data->fitdata [i];
+      Sum += Value * Value;
+   }
+   return (Sum);
+}
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : FitBCurve
+@INPUT      : x[] - alpha, beta, gamma (ie. K1, k2, V0)
+              *data - g_even is the (shifted) blood curve
+@OUTPUT     :
+@RETURNS    : sum of squared residuals
+@DESCRIPTION: Same as fit_b_curve.m: the two-compartment model used for
+              blood delay correction,
+
+                 alpha * conv (g(t), exp(-beta*t)) + gamma * g(t)
+@METHOD     :
+@GLOBALS    :
+@CALLS      : ExpConvolve, Residual
+@CREATED    : 2026/10/16
+@MODIFIED   :
+---------------------------------------------------------------------------- */
+static double FitBCurve (double x[], FitData *data)
+{
+   int     i;
+
+   ExpConvolve (data->numsamples, data->g_even, data->ts_even, x[1],
+                data->even, data->expfun, data->curve);
+   for (i = 0; i < data->numsamples; i++)
+   {
+      data->curve [i] = x[0] * data->curve [i] + x[2] * data->g_even [i];
+   }
+   return (Residual (data));
+}
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : FitRCBF
+@INPUT      : x[] - K1, k2
+              *data - g_even is the arterial blood curve
+@OUTPUT     :
+@RETURNS    : sum of squared residuals
+@DESCRIPTION: Same as fit_rcbf.m: the one-compartment (Kety) rCBF model,
+
+                 K1 * conv (Ca(t), exp(-k2*t))
+@METHOD     :
+@GLOBALS    :
+@CALLS      : ExpConvolve, Residual
+@CREATED    : 2026/10/16
+@MODIFIED   :
+---------------------------------------------------------------------------- */
+static double FitRCBF (double x[], FitData *data)
+{
+   int     i;
+
+   ExpConvolve (data->numsamples, data->g_even, data->ts_even, x[1],
+                data->even, data->expfun, data->curve);
+   for (i = 0; i < data->numsamples; i++)
+   {
+      data->curve [i] *= x[0];
+   }
+   return (Residual (data));
+}
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : FitFDG
+@INPUT      : x[] - K1, k2, k3
+              *data - g_even is the plasma curve
+@OUTPUT     :
+@RETURNS    : sum of squared residuals
+@DESCRIPTION: Same as fit_fdg.m: the three-rate-constant FDG model (with
+              no dephosphorylation, ie. k4 = 0),
+
+                 K1/(k2+k3) * (k3 * conv (Cp(t), 1) +
+                               k2 * conv (Cp(t), exp(-(k2+k3)*t)))
+@METHOD     : conv (Cp(t), 1) is just ExpConvolve with a rate of zero.
+              If k2+k3 is zero the model reduces to K1 times that.
+@GLOBALS    :
+@CALLS      : ExpConvolve, Residual
+@CREATED    : 2026/10/16
+@MODIFIED   :
+---------------------------------------------------------------------------- */
+static double FitFDG (double x[], FitData *data)
+{
+   double  k23;
+   int     i;
+
+   k23 = x[1] + x[2];
+
+   ExpConvolve (data->numsamples, data->g_even, data->ts_even, 0.0,
+                data->even, data->expfun, data->curve);
+   if (k23 == 0)
+   {
+      for (i = 0; i < data->numsamples; i++)
+      {
+         data->curve [i] *= x[0];
+      }
+      return (Residual (data));
+   }
+
+   ExpConvolve (data->numsamples, data->g_even, data->ts_even, k23,
+                data->even, data->expfun, data->curve2);
+   for (i = 0; i < data->numsamples; i++)
+   {
+      data->curve [i] = x[0] / k23 *
+         (x[2] * data->curve [i] + x[1] * data->curve2 [i]);
+   }
+   return (Residual (data));
+}
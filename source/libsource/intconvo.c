@@ -0,0 +1,235 @@
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : intconvo.c
+@DESCRIPTION: IntConvoTables, which builds the tables of weighted
+              integrals used by the weighted-integral rCBF method (the
+              work of findintconvo.m).  Used by the findintconvo and
+              rcbf CMEX files.
+@GLOBALS    :
+@CREATED    : 2026/10/16 (from findintconvo.c)
+@MODIFIED   : 2026/10/16: tables built by several threads (OpenMP)
+@VERSION    : $Id$
+              $Name:  $
+---------------------------------------------------------------------------- */
+
+#include "mex.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "emmageneral.h"
+#include "emmaproto.h"
+
+/*
+ * Work space for building one block of the tables (see TableBlock):
+ * each thread has its own
+ */
+
+typedef struct
+{
+   double  *Convo;              /* convolution for the current k2 */
+   double  *ExpFun;             /* exp(-k2*ts) if ts isn't evenly spaced */
+   double  *Integrand;          /* Convo integrated across each frame */
+   Boolean *Select;             /* which frames have a valid integral */
+   double  *SelTimes;           /* mid-frame times of selected frames */
+   double  *SelWeights;         /* one weight (per selected frame) */
+   double  *Coeffs;             /* TrapCoeffs for selected frames */
+} TableWork;
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : TableBlock
+@INPUT      : First, Last - the range of K2 (First <= i < Last) to do
+              Work - this block's work space
+              Even - whether Ts is evenly spaced
+              FStart - frame start times
+              (the rest as for IntConvoTables)
+@OUTPUT     : Tables - elements First to Last-1 of each table
+@RETURNS    : (void)
+@DESCRIPTION: Does the work of IntConvoTables for a block of
+              consecutive k2 values.
+@METHOD     : Each convolution is done with ExpConvolve (a recursive
+              filter, if Ts is evenly spaced) and integrated across
+              frames with IntFrames.  Frames whose integral is NaN
+              (because the blood data doesn't span them) are dropped,
+              as in findintconvo.m, and the remaining frames are
+              integrated with TrapCoeffs weights -- which only have to
+              be recalculated when the set of dropped frames changes
+              from one k2 to the next.
+@GLOBALS    :
+@CALLS      : ExpConvolve, IntFrames, TrapCoeffs
+@CREATED    : 2026/10/16 (from IntConvoTables)
+@MODIFIED   :
+---------------------------------------------------------------------------- */
+static void TableBlock (int First, int Last, TableWork *Work, Boolean Even,
+                        int NumSamples, double Ca[], double Ts[],
+                        double K2[], int NumFrames, double FStart[],
+                        double MidFTimes[], double FLengths[],
+                        int NumWeights, double *Weights[], double *Tables[])
+{
+   Boolean SameSelection, Valid;
+   int     NumSelected;
+   int     i, j, k, w;
+
+   NumSelected = -1;            /* force the first calculation of Coeffs */
+
+   for (i = First; i < Last; i++)
+   {
+      ExpConvolve (NumSamples, Ca, Ts, K2 [i], Even, Work->ExpFun,
+                   Work->Convo);
+      IntFrames (NumSamples, Ts, Work->Convo, NumFrames,
+                 FStart, FLengths, Work->Integrand);
+
+      /*
+       * See if the same frames are valid as for the last k2 -- they
+       * nearly always will be -- and if not, recalculate the
+       * integration coefficients for the new set of frames.
+       */
+
+      SameSelection = (NumSelected >= 0);
+      for (j = 0; j < NumFrames; j++)
+      {
+         Valid = (Work->Integrand [j] == Work->Integrand [j]);   /* not NaN */
+         if (Valid != Work->Select [j])
+         {
+            SameSelection = FALSE;
+            Work->Select [j] = Valid;
+         }
+      }
+
+      if (!SameSelection)
+      {
+         for (j = 0, NumSelected = 0; j < NumFrames; j++)
+         {
+            if (Work->Select [j])
+               Work->SelTimes [NumSelected++] = MidFTimes [j];
+         }
+
+         for (w = 0; w < NumWeights; w++)
+         {
+            if (Weights [w] == NULL)
+               continue;
+            for (j = 0, k = 0; j < NumFrames; j++)
+            {
+               if (Work->Select [j])
+                  Work->SelWeights [k++] = Weights [w][j];
+            }
+            TrapCoeffs (NumSelected, Work->SelTimes, Work->SelWeights,
+                        Work->Coeffs + w*NumFrames);
+         }
+      }
+
+      for (w = 0; w < NumWeights; w++)
+      {
+         if (Weights [w] == NULL)
+            continue;
+         Tables [w][i] = 0;
+         for (j = 0, k = 0; j < NumFrames; j++)
+         {
+            if (Work->Select [j])
+               Tables [w][i] += Work->Coeffs [w*NumFrames + k++] *
+                                Work->Integrand [j];
+         }
+      }
+   }
+}     /* TableBlock */
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : IntConvoTables
+@INPUT      : NumSamples - number of elements in Ca and Ts
+              Ca - blood activity, resampled at the times in Ts
+              Ts - (evenly spaced) times
+              TableSize - number of elements in K2
+              K2 - table of k2 values
+              NumFrames - number of frames
+              MidFTimes, FLengths - mid-frame times and frame lengths
+              NumWeights - number of weighting functions
+              Weights - NumWeights pointers to weighting functions (one
+                        element per frame); a NULL pointer means that
+                        table isn't wanted
+@OUTPUT     : Tables - NumWeights pointers to tables of TableSize
+                       elements (ignored where Weights is NULL): for
+                       each k2, the weighted, frame-integrated
+                       convolution of Ca with exp(-k2*Ts)
+@RETURNS    : (void)
+@DESCRIPTION: See findintconvo.m.
+@METHOD     : The k2 values are split into one block of consecutive
+              values per OpenMP thread (just one block without OpenMP),
+              and each block is done by TableBlock with its own work
+              space.  Blocks rather than single k2's, so that each
+              thread can still reuse its integration coefficients from
+              one k2 to the next.
+@GLOBALS    :
+@CALLS      : EvenlySpaced, TableBlock
+@CREATED    : 2026/10/16 (from mexFunction in findintconvo.c)
+@MODIFIED   : 2026/10/16: k2 blocks done in parallel
+---------------------------------------------------------------------------- */
+void IntConvoTables (int NumSamples, double Ca[], double Ts[],
+                     int TableSize, double K2[],
+                     int NumFrames, double MidFTimes[], double FLengths[],
+                     int NumWeights, double *Weights[], double *Tables[])
+{
+   double    *FStart;           /* frame start times */
+   TableWork *Work;             /* one per block */
+   Boolean   Even;
+   int       NumBlocks;
+   int       b, j;
+
+   if (TableSize <= 0)
+      return;
+
+   FStart = (double *) mxCalloc (NumFrames, sizeof (double));
+   for (j = 0; j < NumFrames; j++)
+   {
+      FStart [j] = MidFTimes [j] - FLengths [j] / 2;
+   }
+   Even = EvenlySpaced (NumSamples, Ts);
+
+   NumBlocks = 1;
+#ifdef _OPENMP
+   NumBlocks = omp_get_max_threads ();
+   if (NumBlocks > TableSize)
+      NumBlocks = TableSize;
+#endif
+
+   /* All the work space is allocated here, as mxCalloc isn't thread-safe */
+
+   Work = (TableWork *) mxCalloc (NumBlocks, sizeof (TableWork));
+   for (b = 0; b < NumBlocks; b++)
+   {
+      Work[b].Convo = (double *) mxCalloc (NumSamples, sizeof (double));
+      Work[b].ExpFun = Even ? NULL :
+         (double *) mxCalloc (NumSamples, sizeof (double));
+      Work[b].Integrand = (double *) mxCalloc (NumFrames, sizeof (double));
+      Work[b].Select = (Boolean *) mxCalloc (NumFrames, sizeof (Boolean));
+      Work[b].SelTimes = (double *) mxCalloc (NumFrames, sizeof (double));
+      Work[b].SelWeights = (double *) mxCalloc (NumFrames, sizeof (double));
+      Work[b].Coeffs = (double *)
+         mxCalloc (NumWeights * NumFrames, sizeof (double));
+   }
+
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(NumBlocks) schedule(static, 1)
+#endif
+   for (b = 0; b < NumBlocks; b++)
+   {
+      TableBlock ((int) ((long) TableSize * b / NumBlocks),
+                  (int) ((long) TableSize * (b+1) / NumBlocks),
+                  &Work [b], Even, NumSamples, Ca, Ts, K2,
+                  NumFrames, FStart, MidFTimes, FLengths,
+                  NumWeights, Weights, Tables);
+   }
+
+   for (b = 0; b < NumBlocks; b++)
+   {
+      mxFree (Work[b].Convo);
+      if (Work[b].ExpFun != NULL)
+         mxFree (Work[b].ExpFun);
+      mxFree (Work[b].Integrand);
+      mxFree (Work[b].Select);
+      mxFree (Work[b].SelTimes);
+      mxFree (Work[b].SelWeights);
+      mxFree (Work[b].Coeffs);
+   }
+   mxFree (Work);
+   mxFree (FStart);
+}
@@ -6,7 +6,7 @@
               across several frames).
 @METHOD     : 
 @GLOBALS    : 
-@CALLS      : TrapInt(), Lookup1()
+@CALLS      : 
 @CREATED    : Sep 1993, Greg Ward
 @MODIFIED   : see RCS log
 @VERSION    : $Id: intframes.c,v 1.9 2004-09-21 18:40:33 bert Exp $
@@ -22,17 +22,6 @@
 #include <math.h>
 #include "emmageneral.h"
 
-#define MAX_X_LENGTH 1024       /* maximum number of elements of X that can */
-                                /* be found within each frame */
-
-void TrapInt (int num_bins, double *times, double *values,
-	      double *area);
-void Lookup1 (double *oldX, double *oldY,
-              double *newX, double *newY,
-              int TableRows,
-              int OutputRows);
-
-
 extern double NaN;
 
 /* ----------------------------- MNI Header -----------------------------------
@@ -52,8 +41,8 @@ extern double NaN;
                          FrameStart <= X <= FrameStop
 			 (evaluated trapezoidally)
 @RETURNS    : TRUE if all went well
-              FALSE if any frame had too many (> MAX_X_LENGTH) X and Y
-	         elements inside it (current max is 1024)
+              FALSE if the frame lies entirely outside of X (in which
+	         case *Integral is NaN)
 @DESCRIPTION: Taking Y as the values of a function, and X as the set
               of points on the x-axis corresponding to each value in
               Y, IntOneFrame determines which elements of X fall
@@ -79,14 +68,23 @@ extern double NaN;
               Furthermore, if IntOneFrame is called successively with the
 	      same X and Y and with *LowIndex not reset to zero, then
               the Frames must be non-overlapping and increasing.
-@METHOD     : 
+@METHOD     : Works straight from X and Y: the only values that aren't
+              already there are Y at FrameStart and FrameStop, which
+              are interpolated from the samples on either side (found
+              while looking for the first and last points inside the
+              frame).  The trapezoids are then summed in a single pass
+              from the first point to the last, so there is no limit
+              on the number of points in a frame.
 @GLOBALS    : 
-@CALLS      : TrapInt(), Lookup1()
+@CALLS      : 
 @CREATED    : 13 August 1993, Greg Ward (from code originally by Mark
               Wolforth [9 August] and modified by GPW [12-13 August])
 @MODIFIED   : 23 August 1993, GPW: moved to intframes.c, removed
               most #ifdef DEBUG blocks, changed return type from void
 	      to Boolean so we could indicate frame-too-long error
+              2026/10/16: integrate directly from X and Y instead of
+	      copying each frame into fixed-size arrays, so frames
+	      can hold any number of points
 ---------------------------------------------------------------------------- */
 Boolean IntOneFrame (double X[], double Y[], int XYLength, int *LowIndex,
 		     double FrameStart, double FrameStop,
@@ -95,10 +93,10 @@ Boolean IntOneFrame (double X[], double Y[], int XYLength, int *LowIndex,
 {
    int        i;
    int        HighIndex;
-   double     x_values[MAX_X_LENGTH];
-   double     y_values[MAX_X_LENGTH];
-   int        numBins;             /* actual number of elements of x_values */
-                                   /* and y_values used for integration     */
+   double     StartY, StopY;      /* Y interpolated at FrameStart/Stop */
+   double     FirstX, LastX;      /* ends of the interval integrated */
+   double     PrevX, PrevY;       /* left end of the current trapezoid */
+   double     Area;
 
 #ifdef DEBUG
    printf ("Current frame: start %g, stop %g\n",
@@ -147,88 +145,87 @@ Boolean IntOneFrame (double X[], double Y[], int XYLength, int *LowIndex,
       HighIndex--;                         /* Back up one point */
    }
 
-   if ((HighIndex - (*LowIndex) + 3) >= MAX_X_LENGTH)
-   {
-      printf ("BOMB in IntOneFrame!!\n");
-      printf ("Frame start = %g, frame stop = %g\n", FrameStart, FrameStop);
-      printf ("Global: Lowest x = %g, highest x = %g\n", X[0], X[XYLength-1]);
-      printf (" Frame: Lowest x = %g, highest x = %g\n", 
-	      X[*LowIndex], X[HighIndex]);
-      printf ("Number of elements = %d, max is %d\n", 
-	      (HighIndex - (*LowIndex) + 3), MAX_X_LENGTH);
-      printf ("Oh, NO!!!  Found too many X values within frame!");
-      return (FALSE);
-   }
-   
    /*
-    * Fill the x_values array
+    * Interpolate Y at the frame boundaries.  The samples on either side
+    * of FrameStart are X[*LowIndex-1] and X[*LowIndex]; those on either
+    * side of FrameStop are X[HighIndex] and X[HighIndex+1].  If a
+    * boundary lies outside of X, Y there is NaN, and that end of the
+    * interval is pulled in to the first (or last) point of X.
     */
-   
-   x_values[0] = FrameStart;
-   
-   for (i=1; i<(HighIndex-(*LowIndex)+2); i++)
+
+   if (*LowIndex > 0)
    {
-      x_values[i] = X[(*LowIndex)+i-1];
-      y_values[i] = Y[(*LowIndex)+i-1];
+      i = *LowIndex;
+      StartY = Y[i-1] + (Y[i] - Y[i-1]) / (X[i] - X[i-1]) * 
+               (FrameStart - X[i-1]);
    }
-   
-   numBins = i+1;
-   x_values[numBins-1] = FrameStop;
-   
-   /*
-    * Lookup the limits of the y_values array.  Note that either one (and
-    * possibly both, though this is unlikely) of these could result
-    * in a NaN; however, those are the ONLY possible NaN's.  (Unless we
-    * have been passed data with NaN's, which is Somebody Else's Problem.
-    */
-   
-   Lookup1 (X, Y, &(x_values[0]), &(y_values[0]), XYLength, 1);
-   Lookup1 (X, Y, &(x_values[numBins-1]), &(y_values[numBins-1]), XYLength, 1);
-   
-   
-   if (isnan (y_values[numBins-1]))
+   else
    {
-      numBins--;
-#ifdef DEBUG
-      printf ("Found NaN at end of y's, decreasing numBins from %d to %d\n",
-	      numBins+1, numBins);
-      printf ("New lower limit of x = %lg\n", x_values[0]);
-      printf ("New upper limit of x = %lg\n", x_values[numBins-1]);
-      printf ("y at new lower limit of x = %lg\n", y_values[0]);
-      printf ("y at new upper limit of x = %lg\n", y_values[numBins-1]);
-#endif
+      StartY = NaN;
+   }
+
+   if (HighIndex < XYLength-1)
+   {
+      i = HighIndex;
+      StopY = Y[i] + (Y[i+1] - Y[i]) / (X[i+1] - X[i]) * 
+              (FrameStop - X[i]);
+   }
+   else
+   {
+      StopY = NaN;
    }
 
-   if (isnan (y_values[0]))
+   /*
+    * Now sum up the trapezoids, from the start of the frame (or the
+    * first point inside it) through every point in the frame to the
+    * end of the frame (or the last point inside it).
+    */
+
+   if (isnan (StartY))
    {
 #ifdef DEBUG
       printf ("Found NaN at front of y's, starting integral with x=%lg\n",
-	      x_values[1]);
-      printf ("Integrating %d points from x=%g to %g (y=%g to %g)\n",
-	      numBins-1, x_values[1], x_values[numBins-1],
-	      y_values[1], y_values[numBins-1]);
+	      X[*LowIndex]);
 #endif
-      
-      TrapInt ((numBins-1), (x_values+1), (y_values+1), Integral);
+      FirstX = PrevX = X[*LowIndex];
+      PrevY = Y[*LowIndex];
+      i = *LowIndex + 1;
+   }
+   else
+   {
+      FirstX = PrevX = FrameStart;
+      PrevY = StartY;
+      i = *LowIndex;
+   }
 
-#ifdef DEBUG
-      printf ("Unnormalised integral = %g\n", *Integral);
-      printf ("Normalising by %g\n", (x_values[numBins-1] - x_values[1]));
-#endif
+   Area = 0;
+   for (; i <= HighIndex; i++)
+   {
+      Area = Area + ((PrevY + Y[i])/2 * (X[i] - PrevX));
+      PrevX = X[i];
+      PrevY = Y[i];
+   }
 
-      *Integral = *Integral / (x_values[numBins-1] - x_values[1]);
+   if (!isnan (StopY))
+   {
+      Area = Area + ((PrevY + StopY)/2 * (FrameStop - PrevX));
+      PrevX = FrameStop;
    }
-   else 
+#ifdef DEBUG
+   else
    {
-      TrapInt ((numBins), x_values, y_values, Integral);
+      printf ("Found NaN at end of y's, ending integral with x=%lg\n",
+	      PrevX);
+   }
+#endif
+   LastX = PrevX;
 
 #ifdef DEBUG
-      printf ("Unnormalised integral = %g\n", *Integral);
-      printf ("Normalising by %g\n", (x_values[numBins-1] - x_values[1]));
+   printf ("Unnormalised integral = %g\n", Area);
+   printf ("Normalising by %g\n", (LastX - FirstX));
 #endif
-      *Integral = *Integral / (x_values[numBins-1] - x_values[0]);
-   }
 
+   *Integral = Area / (LastX - FirstX);
    return (TRUE);
 
 }     /* IntOneFrame () */
@@ -6,7 +6,9 @@
               (as long as a global variable NaN is defined).
 @GLOBALS    : NaN (must be defined elsewhere)
 @CREATED    : Aug 1993, Greg Ward
-@MODIFIED   : 
+@MODIFIED   : 2026/10/16: table searches now start from where the last
+              one ended (or from an interpolated guess for evenly
+              spaced tables) instead of from the start of the table
 @VERSION    : $Id: lookup12.c,v 1.3 1997-10-21 15:53:06 greg Rel $
               $Name:  $
 ---------------------------------------------------------------------------- */
@@ -14,6 +16,221 @@
 extern double NaN;
 
 
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : UniformSpacing
+@INPUT      : oldX - lookup table abscissa (monotonic)
+              TableRows - number of elements in oldX
+@OUTPUT     : 
+@RETURNS    : the spacing of oldX if its elements are evenly spaced (to
+              within rounding error), or 0 if they are not
+@DESCRIPTION: Used to decide whether the position of a value in oldX
+              can be guessed directly, as (x - oldX[0]) / spacing.
+@METHOD     : 
+@GLOBALS    : 
+@CALLS      : 
+@CREATED    : 2026/10/16
+@MODIFIED   : 
+---------------------------------------------------------------------------- */
+static double UniformSpacing (double *oldX, int TableRows)
+{
+    int      k;
+    double   spacing, tolerance, error;
+
+    if (TableRows < 3)
+        return (0);
+
+    spacing = (oldX[TableRows-1] - oldX[0]) / (TableRows-1);
+    tolerance = 1e-9 * (spacing < 0 ? -spacing : spacing) * (TableRows-1);
+    if (spacing == 0)
+        return (0);
+
+    for (k = 1; k < TableRows-1; k++)
+    {
+        error = oldX[k] - (oldX[0] + k*spacing);
+        if ((error > tolerance) || (error < -tolerance))
+            return (0);
+    }
+    return (spacing);
+}
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : FindUpper
+@INPUT      : oldX - lookup table abscissa (monotonic)
+              TableRows - number of elements in oldX
+              x - value to look for; must be within the range of oldX
+              Guess - where to start looking (any value will work, but
+                 the closer it is to the answer, the quicker)
+              Decreasing - TRUE if oldX is decreasing, FALSE if increasing
+@OUTPUT     : 
+@RETURNS    : the smallest k >= 1 such that oldX[k] >= x (or, if
+              Decreasing, oldX[k] <= x).  The interpolating interval
+              for x is then oldX[k-1] .. oldX[k].
+@DESCRIPTION: Finds the interval of oldX containing x, starting from
+              a guess.  This gives exactly the same interval as the
+              simple linear search from the start of the table that
+              Lookup1 and Lookup2 used to do, including for tables
+              with repeated values.
+@METHOD     : Gallops away from Guess (in steps of 1, 2, 4, ...) until
+              the answer is bracketed, then does a binary search.  So
+              finding x takes time proportional to the log of its
+              distance from Guess -- when the values being looked up
+              are sorted, that distance is usually tiny.
+@GLOBALS    : 
+@CALLS      : 
+@CREATED    : 2026/10/16
+@MODIFIED   : 
+---------------------------------------------------------------------------- */
+#define BEFORE(v,x) (Decreasing ? ((v) > (x)) : ((v) < (x)))
+
+static int FindUpper (double *oldX, int TableRows, double x,
+                      int Guess, int Decreasing)
+{
+    int      lo, hi, mid, step;
+
+    if (Guess < 1) Guess = 1;
+    if (Guess > TableRows-1) Guess = TableRows-1;
+
+    /*
+     * Bracket the answer so that it lies in (lo, hi].  oldX[hi] is
+     * never BEFORE x, and oldX[lo] always is -- except that lo may
+     * end up at 0 without being checked, which is fine since the
+     * answer is never less than 1.
+     */
+
+    if (BEFORE (oldX[Guess], x))
+    {
+        lo = Guess;
+        step = 1;
+        hi = Guess + step;
+        while ((hi < TableRows-1) && BEFORE (oldX[hi], x))
+        {
+            lo = hi;
+            step *= 2;
+            hi = Guess + step;
+        }
+        if (hi > TableRows-1)
+            hi = TableRows-1;
+    }
+    else
+    {
+        hi = Guess;
+        step = 1;
+        lo = Guess - step;
+        while ((lo >= 1) && !BEFORE (oldX[lo], x))
+        {
+            hi = lo;
+            step *= 2;
+            lo = Guess - step;
+        }
+        if (lo < 0)
+            lo = 0;
+    }
+
+    while (hi - lo > 1)
+    {
+        mid = lo + (hi - lo) / 2;
+        if (BEFORE (oldX[mid], x))
+            lo = mid;
+        else
+            hi = mid;
+    }
+    return (hi);
+}
+
+#undef BEFORE
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : LookupTable
+@INPUT      : (see Lookup1)
+              Decreasing - TRUE if oldX is decreasing, FALSE if increasing
+@OUTPUT     : (see Lookup1)
+@RETURNS    : (void)
+@DESCRIPTION: Does the work for Lookup1 and Lookup2.
+@METHOD     : Each search starts from where the previous one finished,
+              so looking up a sorted newX[] takes a single pass through
+              the table.  If the table is evenly spaced, the search
+              instead starts from the element computed directly from
+              newX[i], which makes even unsorted lookups (eg. an image
+              full of values) take constant time each.  (The guess is
+              kept within the table before it is turned into an int,
+              and NaN's never get that far -- they are out of bounds.)
+@GLOBALS    : NaN
+@CALLS      : UniformSpacing, FindUpper
+@CREATED    : 2026/10/16 (from Lookup1)
+@MODIFIED   : 
+---------------------------------------------------------------------------- */
+static void LookupTable (double *oldX, double *oldY,
+                         double *newX, double *newY,
+                         int TableRows, int OutputRows,
+                         int Decreasing)
+{
+    int      i, j, k;
+    double   lowest, highest;
+    double   spacing;
+    double   guess;
+    double   slope;
+
+    if (TableRows < 1)
+    {
+        for (i = 0; i < OutputRows; i++)
+            newY [i] = NaN;
+        return;
+    }
+
+    lowest = Decreasing ? oldX [TableRows-1] : oldX [0];
+    highest = Decreasing ? oldX [0] : oldX [TableRows-1];
+    spacing = UniformSpacing (oldX, TableRows);
+    k = 1;
+
+    for (i=0; i<OutputRows; i++)
+    {
+        /*
+         * Make sure that newX [i] is within the bounds of oldX [0..TableSize-1]
+         * (written this way round so that a NaN newX [i] is out of bounds)
+         */
+
+        if (!((newX [i] >= lowest) && (newX [i] <= highest)))
+        {
+            newY [i] = NaN;
+            continue;                   /* skip to next newY */
+        }
+
+        if (TableRows == 1)             /* newX [i] must equal oldX [0] */
+        {
+            newY [i] = oldY [0];
+            continue;
+        }
+
+        /*
+         * Find the element (k = j+1) of oldX *just* past newX [i], starting
+         * from the last one found or from a direct estimate
+         */
+
+        if (spacing != 0)
+        {
+            guess = 1 + (newX [i] - oldX [0]) / spacing;
+            if (guess < 1)
+                guess = 1;
+            if (guess > TableRows-1)
+                guess = TableRows-1;
+            k = (int) guess;
+        }
+        k = FindUpper (oldX, TableRows, newX [i], k, Decreasing);
+        j = k - 1;
+
+        /*
+         * Now we have oldX [j] < newX [i] <= oldX [j+1] (or the reverse
+         * if Decreasing), so interpolate linearly to find newY [i]
+         */
+
+        slope = (oldY[j+1] - oldY[j]) / (oldX[j+1] - oldX[j]);
+        newY [i] =  oldY[j] + slope*(newX[i] - oldX[j]);
+    }       /* for i */
+}       /* LookupTable */
+
+
 /* ----------------------------- MNI Header -----------------------------------
 @NAME       : Lookup1
 @INPUT      : oldX, oldY - lookup table
@@ -41,54 +258,24 @@ extern double NaN;
               if that is not the case.  It may well loop infinitely or
               generate segmentation faults or other such
               unpleasantries.  Use Monotonic () before calling!!!
-@METHOD     : 
+@METHOD     : See LookupTable.  Costs O(TableRows + OutputRows) when
+              newX is sorted or oldX is evenly spaced, and at worst
+              O(OutputRows * log (TableRows)).
 @GLOBALS    : NaN - not-a-number as a C double
-@CALLS      : 
+@CALLS      : LookupTable
 @CREATED    : 93-6-27, Mark Wolforth & Greg Ward
 @MODIFIED   : 93-6-28, Greg Ward: moved to its own function, improved 
                                   checking for out-of-range newX
 	      93-8-22, GPW: moved (along with Lookup2) to lookup12.c
+              2026/10/16: search via LookupTable rather than from the
+                                  start of the table every time
 ---------------------------------------------------------------------------- */
 void Lookup1 (double *oldX, double *oldY,
               double *newX, double *newY,
               int TableRows,
               int OutputRows)
 {
-    int      i, j;
-    double   slope;
-
-    for (i=0; i<OutputRows; i++)
-    {
-        /*
-         * Make sure that newX [i] is within the bounds of oldX [0..TableSize-1]
-         * change this for oldX descending monotonic
-         */
-
-        if ((newX [i] < oldX [0]) || (newX [i] > oldX [TableRows-1]))
-        {
-            newY [i] = NaN;
-            continue;                   /* skip to next newY */
-        }
-
-        /*
-         * Find the element (j+1) of oldX *just* larger than newX [i]
-         * Note that we are guaranteed oldX[0] <= newX[i] <= oldX[TableRows-1]
-         */
-        
-        j = 0;
-        while (oldX [j+1] < newX [i])
-        {
-            j++;
-        }
-
-        /*
-         * Now we have oldX [j] < newX [i] <= oldX [j+1], so interpolate
-         * linearly to find newY [i]
-         */
-
-        slope = (oldY[j+1] - oldY[j]) / (oldX[j+1] - oldX[j]);
-        newY [i] =  oldY[j] + slope*(newX[i] - oldX[j]);
-    }       /* for i */
+    LookupTable (oldX, oldY, newX, newY, TableRows, OutputRows, 0);
 }       /* Lookup1 */
 
 
@@ -101,49 +288,17 @@ void Lookup1 (double *oldX, double *oldY,
               changed.  This one assumes that oldX is monotonically
               *decreasing*, and again unwanted behaviour may well
               result if this is not so.
-@METHOD     : 
+@METHOD     : See LookupTable.
 @GLOBALS    : NaN
-@CALLS      : 
+@CALLS      : LookupTable
 @CREATED    : 93-6-29 Greg Ward: basically a copy of Lookup1
 @MODIFIED   : 93-8-22, GPW: moved (along with Lookup1) to lookup12.c
+              2026/10/16: now shares LookupTable with Lookup1
 ---------------------------------------------------------------------------- */
 void Lookup2 (double *oldX, double *oldY,
               double *newX, double *newY,
               int TableRows,
               int OutputRows)
 {
-    int      i, j;
-    double   slope;
-
-    for (i=0; i<OutputRows; i++)
-    {
-        /*
-         * Make sure that newX[i] is within the bounds of oldX[0..TableSize-1]
-         */
-
-        if ((newX [i] > oldX [0]) || (newX [i] < oldX [TableRows-1]))
-        {
-            newY [i] = NaN;		/* newX not in table, so return NaN */
-            continue;                   /* skip to next newY */
-        }
-
-        /*
-         * Find the element (j+1) of oldX *just* smaller than newX [i]
-         * Note that we are guaranteed oldX[0] >= newX[i] >= oldX[TableRows-1]
-         */
-        
-        j = 0;
-        while (oldX [j+1] > newX [i])
-        {
-            j++;
-        }
-
-        /*
-         * Now we have oldX [j] > newX [i] >= oldX [j+1], so interpolate
-         * linearly to find newY [i]
-         */
-
-        slope = (oldY[j+1] - oldY[j]) / (oldX[j+1] - oldX[j]);
-        newY [i] =  oldY[j] + slope*(newX[i] - oldX[j]);
-    }       /* for i */
+    LookupTable (oldX, oldY, newX, newY, TableRows, OutputRows, 1);
 }       /* Lookup2 */
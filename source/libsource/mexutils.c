@@ -10,9 +10,12 @@
 
 #include <stdlib.h>  
 #include <stdio.h>
+#include <string.h>
 
 #include "mex.h"
+#include "minc.h"
 #include "mexutils.h"
+#include "mincutil.h"
 
 
 
@@ -181,3 +184,78 @@ int ParseIntArg (const mxArray *Mvector, int MaxSize, long Cvector[])
    return (VecSize);
 
 }     /* ParseIntArg */
+
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : HandleCacheCommand
+@INPUT      : nlhs, nrhs, prhs - as passed to mexFunction
+@OUTPUT     : plhs - for '-cachestats', the number of cache hits and misses
+@RETURNS    : TRUE if the first argument was a cache command (which has
+              now been carried out, so mexFunction should just return)
+              FALSE otherwise
+@DESCRIPTION: Lets the CMEX programs that use the open-file cache in
+              minccache.c share a common interface for managing it:
+
+                 prog ('-flush')              close all cached files
+                 prog ('-flush', 'filename')  close one cached file
+                 [hits, misses] = prog ('-cachestats')
+
+              Also registers CacheCloseAll with mexAtExit, so every
+              program that calls this should do so at the very start
+              of mexFunction.
+@METHOD     : 
+@GLOBALS    : 
+@CALLS      : standard mex functions, CacheFlush, CacheStats
+@CREATED    : 2026/10/16
+@MODIFIED   : 
+---------------------------------------------------------------------------- */
+Boolean HandleCacheCommand (int nlhs, mxArray *plhs[],
+                            int nrhs, const mxArray *prhs[])
+{
+   char     *Command;
+   char     *Filename;
+   long     Hits, Misses;
+
+   mexAtExit (CacheCloseAll);
+
+   if ((nrhs < 1) || (ParseStringArg (prhs[0], &Command) == NULL))
+   {
+      return (FALSE);
+   }
+
+   if (strcmp (Command, "-flush") == 0)
+   {
+      if (nrhs < 2)
+      {
+         CacheFlush (NULL);
+      }
+      else if (ParseStringArg (prhs[1], &Filename) != NULL)
+      {
+         CacheFlush (Filename);
+      }
+      else
+      {
+         mexErrMsgTxt ("Filename to flush must be a string");
+      }
+   }
+   else if (strcmp (Command, "-cachestats") == 0)
+   {
+      CacheStats (&Hits, &Misses);
+      plhs[0] = mxCreateDoubleMatrix (1, 1, mxREAL);
+      *mxGetPr (plhs[0]) = (double) Hits;
+      if (nlhs > 1)
+      {
+         plhs[1] = mxCreateDoubleMatrix (1, 1, mxREAL);
+         *mxGetPr (plhs[1]) = (double) Misses;
+      }
+   }
+   else
+   {
+      mxFree (Command);
+      return (FALSE);
+   }
+
+   mxFree (Command);
+   return (TRUE);
+}     /* HandleCacheCommand */
@@ -0,0 +1,517 @@
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : minccache.c
+@DESCRIPTION: A small cache of open MINC files for the CMEX readers
+              (mireadimages, mireadvar, miinquire).  Without it, every
+              call from MATLAB opens the file, parses the whole netCDF
+              header, sets up an ICV, and closes the file again -- which
+              adds up quickly when (eg.) getimages is called once per
+              slice.  With it, the file is opened once and stays open
+              (along with its ImageInfoRec and attached ICV) until it
+              changes on disk, is explicitly flushed, or is pushed out
+              by more recently used files.
+
+              A cached file is identified by its device and inode
+              numbers (so the same file reached by two different paths,
+              or through a symbolic link, is only opened once), and is
+              reopened if it has been replaced by another file of the
+              same name, or if its modification time or size has
+              changed since it was opened.  Since the modification time
+              only has a one-second resolution, anything that rewrites
+              a file in place should still flush it from the cache
+              explicitly (see miflushcache.m).
+
+              Note that every CMEX file is linked with its own copy of
+              the EMMA library, so each has its own cache.
+
+              gzip-compressed files are opened with OpenCompressed
+              (ncmap.c), which only uncompresses the file as far as
+              it is read.  Anything that reads from a file opened here
+              must call CacheInflate first, to make sure that the part
+              it's about to read has been uncompressed.  Compressed
+              files that OpenCompressed can't read that way (MINC 2 and
+              64-bit data NetCDF files) are uncompressed whole into a
+              temporary file, which is opened with miopen and removed
+              when the file leaves the cache.
+@GLOBALS    : ErrMsg (set by OpenFile and GetImageInfo on error)
+@CREATED    : 2026/10/16
+@MODIFIED   : 2026/10/16: read compressed files directly
+              2026/10/16: identify files by device and inode as well
+              2026/10/16: uncompress whole files OpenCompressed can't read
+@VERSION    : $Id$
+              $Name:  $
+---------------------------------------------------------------------------- */
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "minc.h"
+#include "emmageneral.h"
+#include "mincutil.h"
+#include "ncmap.h"
+#include "mierrors.h"
+
+#define MAX_CACHED_FILES  8     /* keep well below netCDF's open file limit */
+
+extern   char *ErrMsg;     /* should be defined in your main program */
+
+typedef struct
+{
+   char          *Filename;     /* NULL if this slot is unused */
+   dev_t          Dev;          /* the file itself (Ino is 0 if unknown) */
+   ino_t          Ino;
+   time_t         MTime;        /* modification time and size of the */
+   long           Size;         /* file when it was opened */
+   int            CDF;
+   Boolean        Compressed;   /* if so, Inflater keeps track of how */
+   CompressedFile Inflater;     /* much has been uncompressed */
+   char          *TempName;     /* whole uncompressed copy (NULL if none) */
+   Boolean        HaveImage;    /* has Image been filled in? */
+   ImageInfoRec   Image;
+   int            DoubleICV;    /* ICV's attached to the image variable, */
+   int            FloatICV;     /* created as needed (MI_ERROR if not) */
+   int            RawICV;
+   unsigned long  LastUsed;     /* for choosing which slot to recycle */
+} CacheEntry;
+
+static CacheEntry     Cache [MAX_CACHED_FILES];
+static unsigned long  UseCount = 0;
+static long           NumHits = 0;
+static long           NumMisses = 0;
+
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : CloseEntry
+@INPUT      : *Entry - cache slot to empty
+@OUTPUT     :
+@RETURNS    : (none)
+@DESCRIPTION: Frees the ICV's (if any), closes the file, and marks the
+              slot as unused.
+@METHOD     :
+@GLOBALS    :
+@CALLS      : miicv_free, ncclose, miclose, CloseCompressed
+@CREATED    : 2026/10/16
+@MODIFIED   : 2026/10/16: remove the uncompressed copy, if any
+---------------------------------------------------------------------------- */
+static void CloseEntry (CacheEntry *Entry)
+{
+   if (Entry->Filename == NULL)
+      return;
+
+   if (Entry->DoubleICV != MI_ERROR)
+      miicv_free (Entry->DoubleICV);
+   if (Entry->FloatICV != MI_ERROR)
+      miicv_free (Entry->FloatICV);
+   if (Entry->RawICV != MI_ERROR)
+      miicv_free (Entry->RawICV);
+   if (Entry->TempName != NULL)
+   {
+      miclose (Entry->CDF);
+      remove (Entry->TempName);
+      free (Entry->TempName);
+      Entry->TempName = NULL;
+   }
+   else
+   {
+      ncclose (Entry->CDF);
+   }
+   if (Entry->Compressed)
+      CloseCompressed (&Entry->Inflater);
+
+   free (Entry->Filename);
+   Entry->Filename = NULL;
+   Entry->HaveImage = FALSE;
+}     /* CloseEntry */
+
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : OpenUncompressed
+@INPUT      : Filename - a compressed file that OpenCompressed can't read
+@OUTPUT     : *Entry - CDF and TempName filled in
+@RETURNS    : ERR_NONE if all went well
+              otherwise as for UncompressFile, or ERR_IN_MINC if the
+              uncompressed file couldn't be opened (ErrMsg set)
+@DESCRIPTION: Uncompresses the whole file into a temporary file, and
+              opens that with miopen (so MINC 2 files work, if the MINC
+              library does).  The temporary file is removed by
+              CloseEntry.
+@METHOD     :
+@GLOBALS    : ErrMsg
+@CALLS      : UncompressFile, miopen
+@CREATED    : 2026/10/16
+@MODIFIED   :
+---------------------------------------------------------------------------- */
+static int OpenUncompressed (char Filename[], CacheEntry *Entry)
+{
+   int   Result;
+
+   Result = UncompressFile (Filename, &Entry->TempName);
+   if (Result != ERR_NONE)
+      return (Result);
+
+   Entry->CDF = miopen (Entry->TempName, NC_NOWRITE);
+   if (Entry->CDF == MI_ERROR)
+   {
+      sprintf (ErrMsg, "Error opening file %s: %s",
+               Filename, NCErrMsg (ncerr, errno));
+      remove (Entry->TempName);
+      free (Entry->TempName);
+      Entry->TempName = NULL;
+      return (ERR_IN_MINC);
+   }
+   return (ERR_NONE);
+}     /* OpenUncompressed */
+
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : LookupFile
+@INPUT      : Filename - name of the file to open
+@OUTPUT     :
+@RETURNS    : pointer to the cache slot holding the open file, or NULL
+              if the file could not be opened (ErrMsg set by OpenFile)
+@DESCRIPTION: Finds Filename in the cache, checking that it has not
+              changed on disk since it was opened.  If it is not there
+              (or is out of date), opens it in the least recently used
+              slot.
+@METHOD     : A slot holds Filename if it was opened under the same
+              name, or if it is the same file (same device and inode --
+              not available on every system, in which case st_ino is 0
+              and only the name is used).  It is only used if it is
+              still the same file, with the same modification time and
+              size; otherwise it is closed, so that a stale copy can't
+              be found again later under another name.
+@GLOBALS    : Cache, UseCount, NumHits, NumMisses
+@CALLS      : OpenFile, OpenCompressed, OpenUncompressed, CloseEntry
+@CREATED    : 2026/10/16
+@MODIFIED   : 2026/10/16: match on device and inode too
+              2026/10/16: fall back on OpenUncompressed
+---------------------------------------------------------------------------- */
+static CacheEntry *LookupFile (char Filename[])
+{
+   struct stat  StatBuf;
+   Boolean      Exists;
+   Boolean      SameName, SameFile;
+   CacheEntry  *Entry;
+   char        *Name;
+   int          Result;
+   int          i;
+
+   Exists = (stat (Filename, &StatBuf) == 0);
+
+   /* First see if we have it already */
+
+   for (i = 0; i < MAX_CACHED_FILES; i++)
+   {
+      Entry = &Cache [i];
+      if (Entry->Filename == NULL)
+         continue;
+
+      SameName = (strcmp (Entry->Filename, Filename) == 0);
+      SameFile = Exists && (StatBuf.st_ino != 0) &&
+                 (StatBuf.st_dev == Entry->Dev) &&
+                 (StatBuf.st_ino == Entry->Ino);
+      if (!SameName && !SameFile)
+         continue;
+
+      if (Exists &&
+          (SameFile || (StatBuf.st_ino == 0)) &&
+          (StatBuf.st_mtime == Entry->MTime) &&
+          ((long) StatBuf.st_size == Entry->Size))
+      {
+         NumHits++;
+         Entry->LastUsed = ++UseCount;
+         return (Entry);
+      }
+
+#ifdef DEBUG
+      printf ("%s has changed since it was cached; reopening\n", Filename);
+#endif
+      CloseEntry (Entry);
+   }
+
+   /* Not there (or stale), so find a free slot or recycle the oldest one */
+
+   NumMisses++;
+   Entry = &Cache [0];
+   for (i = 0; i < MAX_CACHED_FILES; i++)
+   {
+      if (Cache [i].Filename == NULL)
+      {
+         Entry = &Cache [i];
+         break;
+      }
+      if (Cache [i].LastUsed < Entry->LastUsed)
+         Entry = &Cache [i];
+   }
+   CloseEntry (Entry);
+
+   Name = (char *) malloc (strlen (Filename) + 1);
+   if (Name == NULL)
+   {
+      sprintf (ErrMsg, "Out of memory caching file %s", Filename);
+      return (NULL);
+   }
+   strcpy (Name, Filename);
+
+   /*
+    * A compressed file is read a bit at a time if it's NetCDF classic;
+    * anything else (OpenCompressed returns ERR_OTHER) is uncompressed
+    * whole, and then it's no longer compressed as far as we care
+    */
+
+   Entry->TempName = NULL;
+   Entry->Compressed = IsCompressed (Filename);
+   if (Entry->Compressed)
+   {
+      Result = OpenCompressed (Filename, &Entry->Inflater, &Entry->CDF);
+      if (Result == ERR_OTHER)
+      {
+         Entry->Compressed = FALSE;
+         Result = OpenUncompressed (Filename, Entry);
+      }
+   }
+   else
+   {
+      Result = OpenFile (Filename, &Entry->CDF, NC_NOWRITE);
+   }
+   if (Result != ERR_NONE)
+   {
+      free (Name);
+      return (NULL);
+   }
+
+   Entry->Filename = Name;
+   Entry->Dev = Exists ? StatBuf.st_dev : 0;
+   Entry->Ino = Exists ? StatBuf.st_ino : 0;
+   Entry->MTime = Exists ? StatBuf.st_mtime : 0;
+   Entry->Size = Exists ? (long) StatBuf.st_size : -1;
+   Entry->HaveImage = FALSE;
+   Entry->DoubleICV = Entry->FloatICV = Entry->RawICV = MI_ERROR;
+   Entry->LastUsed = ++UseCount;
+
+   return (Entry);
+}     /* LookupFile */
+
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : CacheOpenFile
+@INPUT      : Filename - name of the NetCDF/MINC file to open
+@OUTPUT     : *CDF - handle of the opened file
+@RETURNS    : ERR_NONE if file successfully opened
+              ERR_IN_MINC if any error opening file (ErrMsg set)
+@DESCRIPTION: Like OpenFile (always in NC_NOWRITE mode), but the file
+              comes from (and stays in) the cache.  The caller must
+              *not* close the file.
+@METHOD     :
+@GLOBALS    :
+@CALLS      : LookupFile
+@CREATED    : 2026/10/16
+@MODIFIED   :
+---------------------------------------------------------------------------- */
+int CacheOpenFile (char Filename[], int *CDF)
+{
+   CacheEntry  *Entry;
+
+   Entry = LookupFile (Filename);
+   if (Entry == NULL)
+   {
+      *CDF = MI_ERROR;
+      return (ERR_IN_MINC);
+   }
+
+   *CDF = Entry->CDF;
+   return (ERR_NONE);
+}     /* CacheOpenFile */
+
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : CacheOpenImage
+@INPUT      : Filename - name of the MINC file to open
+              Type - type of ICV wanted: NC_DOUBLE, NC_FLOAT, or
+                 MI_ORIGINAL_TYPE (see AttachICV)
+              NaN - value to which out-of-range values are mapped (see
+                 OpenImage)
+@OUTPUT     : *Image - struct describing the image variable, with an
+                 ICV of the requested type attached
+@RETURNS    : ERR_NONE if all went well
+              otherwise whatever OpenFile or GetImageInfo returned
+              (ErrMsg set)
+@DESCRIPTION: Like OpenImage (always in NC_NOWRITE mode), but the file,
+              the image info, and the ICV come from (and stay in) the
+              cache.  The caller must *not* call CloseImage.
+@METHOD     : Each cached file can have one ICV of each type attached
+              to it at once; they are created the first time they're
+              asked for.  For a compressed file, image-max and image-min
+              are uncompressed straight away, as the ICV reads them
+              along with any image.
+@GLOBALS    :
+@CALLS      : LookupFile, GetImageInfo, AttachICV, InflateVariable
+@CREATED    : 2026/10/16
+@MODIFIED   : 2026/10/16: compressed files
+---------------------------------------------------------------------------- */
+int CacheOpenImage (char Filename[], ImageInfoRec *Image, 
+                    nc_type Type, double NaN)
+{
+   CacheEntry  *Entry;
+   int         *ICV;
+   int          Result;
+
+   Entry = LookupFile (Filename);
+   if (Entry == NULL)
+   {
+      return (ERR_IN_MINC);
+   }
+
+   if (!Entry->HaveImage)
+   {
+      Result = GetImageInfo (Entry->CDF, &Entry->Image);
+      if ((Result == ERR_NONE) && Entry->Compressed)
+      {
+         Result = InflateVariable (&Entry->Inflater, MIimagemax, NULL, NULL);
+         if (Result == ERR_NO_VAR)
+            Result = ERR_NONE;
+         if (Result == ERR_NONE)
+            Result = InflateVariable (&Entry->Inflater, MIimagemin, NULL, NULL);
+         if (Result == ERR_NO_VAR)
+            Result = ERR_NONE;
+      }
+      if (Result != ERR_NONE)
+      {
+         return (Result);
+      }
+      Entry->HaveImage = TRUE;
+   }
+
+   switch (Type)
+   {
+      case NC_FLOAT:          ICV = &Entry->FloatICV;  break;
+      case MI_ORIGINAL_TYPE:  ICV = &Entry->RawICV;    break;
+      default:                ICV = &Entry->DoubleICV; break;
+   }
+   if (*ICV == MI_ERROR)
+   {
+      AttachICV (&Entry->Image, Type, NaN);
+      *ICV = Entry->Image.ICV;
+   }
+
+   *Image = Entry->Image;
+   Image->ICV = *ICV;
+   return (ERR_NONE);
+}     /* CacheOpenImage */
+
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : CacheInflate
+@INPUT      : CDF - a file opened by CacheOpenFile or CacheOpenImage
+              VarName - the variable about to be read from it (NULL
+                 for everything)
+              Start, Count - the hyperslab about to be read (NULL for
+                 the whole variable)
+@OUTPUT     :
+@RETURNS    : ERR_NONE if all went well
+              otherwise as for InflateVariable (ErrMsg set)
+@DESCRIPTION: If the file is compressed, uncompresses as much of it as
+              is needed to read the given hyperslab.  Otherwise, does
+              nothing.  Must be called before reading anything from a
+              cached file with the NetCDF or MINC libraries.
+@METHOD     :
+@GLOBALS    : Cache
+@CALLS      : InflateVariable
+@CREATED    : 2026/10/16
+@MODIFIED   :
+---------------------------------------------------------------------------- */
+int CacheInflate (int CDF, char VarName[], long Start[], long Count[])
+{
+   int   i;
+
+   for (i = 0; i < MAX_CACHED_FILES; i++)
+   {
+      if ((Cache [i].Filename != NULL) && (Cache [i].CDF == CDF))
+      {
+         if (!Cache [i].Compressed)
+            break;
+         return (InflateVariable (&Cache [i].Inflater, VarName, Start, Count));
+      }
+   }
+   return (ERR_NONE);
+}     /* CacheInflate */
+
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : CacheFlush
+@INPUT      : Filename - name of the file to drop from the cache, or
+                 NULL to drop everything
+@OUTPUT     :
+@RETURNS    : (none)
+@DESCRIPTION: Closes a cached file (or all of them).  Files that aren't
+              in the cache are silently ignored.
+@METHOD     :
+@GLOBALS    : Cache
+@CALLS      : CloseEntry
+@CREATED    : 2026/10/16
+@MODIFIED   :
+---------------------------------------------------------------------------- */
+void CacheFlush (char Filename[])
+{
+   int   i;
+
+   for (i = 0; i < MAX_CACHED_FILES; i++)
+   {
+      if ((Cache [i].Filename != NULL) &&
+          ((Filename == NULL) || (strcmp (Cache [i].Filename, Filename) == 0)))
+      {
+         CloseEntry (&Cache [i]);
+      }
+   }
+}     /* CacheFlush */
+
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : CacheCloseAll
+@INPUT      :
+@OUTPUT     :
+@RETURNS    : (none)
+@DESCRIPTION: Closes every cached file.  Meant to be registered with
+              mexAtExit, so that files are closed when MATLAB clears
+              the CMEX file.
+@METHOD     :
+@GLOBALS    :
+@CALLS      : CacheFlush
+@CREATED    : 2026/10/16
+@MODIFIED   :
+---------------------------------------------------------------------------- */
+void CacheCloseAll (void)
+{
+   CacheFlush (NULL);
+}
+
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : CacheStats
+@INPUT      :
+@OUTPUT     : *Hits - number of opens satisfied from the cache
+              *Misses - number of opens that had to go to the file
+@RETURNS    : (none)
+@DESCRIPTION: Reports how well the cache is doing.
+@METHOD     :
+@GLOBALS    : NumHits, NumMisses
+@CALLS      :
+@CREATED    : 2026/10/16
+@MODIFIED   :
+---------------------------------------------------------------------------- */
+void CacheStats (long *Hits, long *Misses)
+{
+   *Hits = NumHits;
+   *Misses = NumMisses;
+}
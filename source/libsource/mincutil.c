@@ -446,10 +446,11 @@ int GetImageInfo (int CDF, ImageInfoRec *Image)
 @DESCRIPTION: Open a MINC file and read relevant data about the image variable.
 @METHOD     : 
 @GLOBALS    : 
-@CALLS      : OpenFile, GetImageInfo, miicv{...} functions
+@CALLS      : OpenFile, GetImageInfo, AttachICV
 @CREATED    : 93-6-3, Greg Ward
 @MODIFIED   : 95-2-1, Mark Wolforth
                       -Added DO_FILLVALUE to the created ICV.
+              2026/10/16: ICV setup moved to AttachICV
 ---------------------------------------------------------------------------- */
 int OpenImage (char Filename[], ImageInfoRec *Image, int mode, double NaN)
 {
@@ -469,8 +470,59 @@ int OpenImage (char Filename[], ImageInfoRec *Image, int mode, double NaN)
       return (Result);
    }
 
+   AttachICV (Image, NC_DOUBLE, NaN);
+
+   return (ERR_NONE);
+}     /* OpenImage */
+
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : AttachICV
+@INPUT      : *Image - struct describing an image variable (as filled in
+                 by GetImageInfo)
+              Type - type that the ICV converts to and from (normally
+                 NC_DOUBLE; mireadimages can also ask for NC_FLOAT, or
+                 MI_ORIGINAL_TYPE for the raw stored values)
+              NaN - value to which out-of-range values are mapped (see
+                 OpenImage)
+@OUTPUT     : Image->ICV - ID of the newly created and attached ICV
+@RETURNS    : (none)
+@DESCRIPTION: Creates the image conversion variable used by EMMA to read
+              and write images as real values, and attaches it to the
+              image variable.  With MI_ORIGINAL_TYPE, the ICV does no
+              range conversion or normalisation at all (just the
+              dimension flipping, so that images come out the same way
+              up as they do with the other types).
+@METHOD     : 
+@GLOBALS    : 
+@CALLS      : miicv{...} functions
+@CREATED    : 2026/10/16, split out of OpenImage so that the file cache
+              (minccache.c) can attach an ICV to an already open file
+@MODIFIED   : 
+---------------------------------------------------------------------------- */
+void AttachICV (ImageInfoRec *Image, nc_type Type, double NaN)
+{
+   nc_type  StoredType;
+   int      IsSigned;
+
    Image->ICV = miicv_create ();
-   (void) miicv_setint (Image->ICV, MI_ICV_TYPE, NC_DOUBLE);
+
+   if (Type == MI_ORIGINAL_TYPE)
+   {
+      (void) miget_datatype (Image->CDF, Image->ID, &StoredType, &IsSigned);
+      (void) miicv_setint (Image->ICV, MI_ICV_TYPE, StoredType);
+      (void) miicv_setstr (Image->ICV, MI_ICV_SIGN, 
+                           IsSigned ? MI_SIGNED : MI_UNSIGNED);
+      (void) miicv_setint (Image->ICV, MI_ICV_DO_RANGE, FALSE);
+      (void) miicv_setint (Image->ICV, MI_ICV_DO_NORM, FALSE);
+      (void) miicv_setint (Image->ICV, MI_ICV_DO_DIM_CONV, TRUE);
+      (void) miicv_setint (Image->ICV, MI_ICV_DO_SCALAR, FALSE);
+      (void) miicv_attach (Image->ICV, Image->CDF, Image->ID);
+      return;
+   }
+
+   (void) miicv_setint (Image->ICV, MI_ICV_TYPE, Type);
    (void) miicv_setint (Image->ICV, MI_ICV_DO_RANGE, TRUE);
    (void) miicv_setint (Image->ICV, MI_ICV_DO_NORM, TRUE);
    (void) miicv_setint (Image->ICV, MI_ICV_DO_DIM_CONV, TRUE);
@@ -478,9 +530,7 @@ int OpenImage (char Filename[], ImageInfoRec *Image, int mode, double NaN)
    (void) miicv_setint (Image->ICV, MI_ICV_DO_FILLVALUE, TRUE);
    (void) miicv_setdbl (Image->ICV, MI_ICV_FILLVALUE, NaN);
    (void) miicv_attach (Image->ICV, Image->CDF, Image->ID);
-
-   return (ERR_NONE);
-}     /* OpenImage */
+}     /* AttachICV */
 
 
 
@@ -501,3 +551,682 @@ void CloseImage (ImageInfoRec *Image)
    miicv_free (Image->ICV);
    ncclose (Image->CDF);
 }
+
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : FindMaxMin
+@INPUT      : Values - pointer to array of doubles
+              Num - number of elements in Values
+@OUTPUT     : *Max, *Min - the largest and smallest of them (-DBL_MAX
+                 and DBL_MAX if there are none; NaN's are ignored)
+@RETURNS    : (void)
+@DESCRIPTION: Finds the max and min of an array in a single pass.
+@METHOD     : Keeps four running maxima and minima, one for each of
+              every four consecutive elements, and combines them at the
+              end.  The four are independent of each other, so the
+              compiler can keep them in one vector register and compare
+              four elements at once (or at least overlap the compares),
+              rather than waiting on one compare after another.
+@GLOBALS    :
+@CALLS      :
+@CREATED    : 2026/10/16
+@MODIFIED   :
+---------------------------------------------------------------------------- */
+void FindMaxMin (double *Values, long Num, double *Max, double *Min)
+{
+   double   Hi [4], Lo [4];
+   long     i;
+   int      j;
+
+   for (j = 0; j < 4; j++)
+   {
+      Hi [j] = - DBL_MAX;
+      Lo [j] = DBL_MAX;
+   }
+
+   for (i = 0; i + 4 <= Num; i += 4)
+   {
+      for (j = 0; j < 4; j++)
+      {
+         Hi [j] = (Values [i+j] > Hi [j]) ? Values [i+j] : Hi [j];
+         Lo [j] = (Values [i+j] < Lo [j]) ? Values [i+j] : Lo [j];
+      }
+   }
+   for (; i < Num; i++)                 /* the last few */
+   {
+      Hi [0] = (Values [i] > Hi [0]) ? Values [i] : Hi [0];
+      Lo [0] = (Values [i] < Lo [0]) ? Values [i] : Lo [0];
+   }
+
+   *Max = max (max (Hi [0], Hi [1]), max (Hi [2], Hi [3]));
+   *Min = min (min (Lo [0], Lo [1]), min (Lo [2], Lo [3]));
+}
+
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : UpdateValidRange
+@INPUT      : ImInfo - pointer to struct describing the image variable
+              Max, Min - range of some values just written to the image
+@OUTPUT     : (none)
+@RETURNS    : (void)
+@DESCRIPTION: Widens the image's valid_range attribute to take in Min
+              and Max, for floating-point volumes (whose valid_range is
+              just the range of the data).
+@METHOD     :
+@GLOBALS    :
+@CALLS      :
+@CREATED    : (as part of PutMaxMin)
+@MODIFIED   : 2026/10/16 - split out of PutMaxMin, so that it's done
+              once for many images rather than once for each
+---------------------------------------------------------------------------- */
+static void UpdateValidRange (ImageInfoRec *ImInfo, double Max, double Min)
+{
+   int      old_ncopts;
+   int      ret;
+   nc_type  range_type;
+   int      range_len;
+   int      update_vr;
+   double   valid_range[2];
+   double   vr_max;
+
+   if ((ImInfo->DataType == NC_FLOAT) || (ImInfo->DataType == NC_DOUBLE)) {
+
+      /* Get type and length of valid_range attribute */
+      old_ncopts = ncopts; ncopts = 0;
+      ret = ncattinq(ImInfo->CDF, ImInfo->ID, MIvalid_range,
+                     &range_type, &range_len);
+      ncopts = old_ncopts;
+
+      /* If type and length are okay, then read in old value and update */
+      if ((ret != MI_ERROR) &&
+          (range_type == NC_DOUBLE) && (range_len == 2)) {
+
+         (void) ncattget(ImInfo->CDF, ImInfo->ID, MIvalid_range, valid_range);
+
+         /* Test for first write of valid range */
+         vr_max = (ImInfo->DataType == NC_DOUBLE ?
+                   1.79769313e+308 : 3.402e+38);
+         update_vr = ((valid_range[0] < -vr_max) && (valid_range[1] > vr_max));
+
+         /* Check the range */
+         if ((Min < valid_range[0]) || update_vr)
+            valid_range[0] = Min;
+         if ((Max > valid_range[1]) || update_vr)
+            valid_range[1] = Max;
+
+         /* Check for whether float rounding is needed */
+         if (ImInfo->DataType == NC_FLOAT) {
+            valid_range[0] = (float) valid_range[0];
+            valid_range[1] = (float) valid_range[1];
+         }
+
+         /* Write it out */
+         (void) ncattput(ImInfo->CDF, ImInfo->ID, MIvalid_range,
+                         NC_DOUBLE, 2, valid_range);
+
+      }
+
+   }     /* if DataType is floating-point */
+
+}     /* UpdateValidRange */
+
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : RunLength
+@INPUT      : List[] - list of slice or frame numbers
+              Num - number of elements in List[]
+              First - index into List[] where the run starts
+@OUTPUT     : 
+@RETURNS    : the number of elements, starting at List[First], that
+              form a run of consecutive increasing numbers (always at
+              least 1)
+@DESCRIPTION: Used to find groups of slices or frames that can be read
+              or written with a single hyperslab.
+@METHOD     : 
+@GLOBALS    : 
+@CALLS      : 
+@CREATED    : 2026/10/16
+@MODIFIED   : 2026/10/16 - moved here from mireadimages.c, so that the
+              image writers can use it too
+---------------------------------------------------------------------------- */
+long RunLength (long List[], long Num, long First)
+{
+   long  i;
+
+   for (i = First+1; i < Num; i++)
+   {
+      if (List [i] != List [i-1] + 1)
+         break;
+   }
+   return (i - First);
+}     /* RunLength */
+
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : PutMaxMins
+@INPUT      : ImInfo - pointer to struct describing the image variable
+              Slices, Frames - the slices and frames of a set of images
+              NumSlices, NumFrames - number of elements of Slices and
+                Frames (0 if the file has no slice or time dimension)
+              Max, Min - the max and min of each image, with the frame
+                varying fastest (ie. for slice s and frame f, element
+                s*NumFrames + f; treat 0 slices or frames as 1 here)
+@OUTPUT     : (none)
+@RETURNS    : (void)
+@DESCRIPTION: Puts the max and min of a whole set of images into the
+              MIimagemax and MIimagemin variables associated with the
+              specified image variable, and updates the valid_range of
+              floating-point images.  This must be done before the
+              images themselves are written, since the ICV scales each
+              image according to its max and min.  The caller must make
+              sure that MIimagemax and MIimagemin exist in the file, and
+              that ImInfo->MaxID and ImInfo->MinID contain their
+              variable ID's.
+@METHOD     : If the slices and the frames are both runs of consecutive
+              numbers (as they usually are), the max and min are each
+              written in one hyperslab, and valid_range is updated just
+              once.  Otherwise, each image's max and min are written
+              separately (but valid_range is still updated just once).
+@GLOBALS    :
+@CALLS      : UpdateValidRange, RunLength, MINC library
+@CREATED    : 2026/10/16
+@MODIFIED   :
+---------------------------------------------------------------------------- */
+void PutMaxMins (ImageInfoRec *ImInfo, long Slices[], long Frames[],
+                 long NumSlices, long NumFrames, double Max[], double Min[])
+{
+   Boolean  DoSlices, DoFrames;
+   Boolean  Batched;
+   long     Start [2], Count [2];   /* might use 0, 1 or 2 elements */
+   long     NumImages;
+   long     s, f, i;
+   double   AllMax, AllMin;
+   double  *FileMax, *FileMin;
+
+   DoSlices = (NumSlices > 0);
+   DoFrames = (NumFrames > 0);
+   if (!DoSlices) NumSlices = 1;
+   if (!DoFrames) NumFrames = 1;
+   NumImages = NumSlices * NumFrames;
+
+#ifdef DEBUG
+   printf ("Slice dimension is %d\n", ImInfo->SliceDim);
+   printf ("Frame dimension is %d\n", ImInfo->FrameDim);
+   printf ("Putting max/min of %ld slices by %ld frames\n",
+           NumSlices, NumFrames);
+#endif
+
+   Batched = FALSE;
+   if ((!DoSlices || (RunLength (Slices, NumSlices, 0) == NumSlices)) &&
+       (!DoFrames || (RunLength (Frames, NumFrames, 0) == NumFrames)))
+   {
+      if (DoSlices)
+      {
+         Start [ImInfo->SliceDim] = Slices [0];
+         Count [ImInfo->SliceDim] = NumSlices;
+      }
+      if (DoFrames)
+      {
+         Start [ImInfo->FrameDim] = Frames [0];
+         Count [ImInfo->FrameDim] = NumFrames;
+      }
+
+      /*
+       * Our values have the frame varying fastest; if the file has the
+       * slice varying fastest, they have to be transposed first
+       */
+
+      FileMax = Max;
+      FileMin = Min;
+      if (DoSlices && DoFrames && (ImInfo->SliceDim > ImInfo->FrameDim) &&
+          (NumSlices > 1) && (NumFrames > 1))
+      {
+         FileMax = (double *) malloc (2 * NumImages * sizeof (double));
+         if (FileMax != NULL)
+         {
+            FileMin = FileMax + NumImages;
+            for (s = 0; s < NumSlices; s++)
+            {
+               for (f = 0; f < NumFrames; f++)
+               {
+                  FileMax [f*NumSlices + s] = Max [s*NumFrames + f];
+                  FileMin [f*NumSlices + s] = Min [s*NumFrames + f];
+               }
+            }
+         }
+      }
+
+      if (FileMax != NULL)
+      {
+         mivarput (ImInfo->CDF, ImInfo->MaxID, Start, Count,
+                   NC_DOUBLE, MI_SIGNED, FileMax);
+         mivarput (ImInfo->CDF, ImInfo->MinID, Start, Count,
+                   NC_DOUBLE, MI_SIGNED, FileMin);
+         if (FileMax != Max)
+            free (FileMax);
+         Batched = TRUE;
+      }
+   }
+
+   /*
+    * Otherwise, do them one at a time
+    */
+
+   if (!Batched)
+   {
+      for (s = 0; s < NumSlices; s++)
+      {
+         for (f = 0; f < NumFrames; f++)
+         {
+            if (DoSlices) Start [ImInfo->SliceDim] = Slices [s];
+            if (DoFrames) Start [ImInfo->FrameDim] = Frames [f];
+            i = s*NumFrames + f;
+            mivarput1 (ImInfo->CDF, ImInfo->MaxID, Start,
+                       NC_DOUBLE, MI_SIGNED, &Max [i]);
+            mivarput1 (ImInfo->CDF, ImInfo->MinID, Start,
+                       NC_DOUBLE, MI_SIGNED, &Min [i]);
+         }
+      }
+   }
+
+   /*
+    * Update the image valid_range attribute for floating-point volumes
+    */
+
+   AllMax = - DBL_MAX;
+   AllMin = DBL_MAX;
+   for (i = 0; i < NumImages; i++)
+   {
+      if (Max [i] > AllMax) AllMax = Max [i];
+      if (Min [i] < AllMin) AllMin = Min [i];
+   }
+   UpdateValidRange (ImInfo, AllMax, AllMin);
+
+}     /* PutMaxMins */
+
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : PutMaxMin
+@INPUT      : ImInfo - pointer to struct describing the image variable
+              ImVals - pointer to array of doubles containing the image data
+              SliceNum, FrameNum - needed to correctly place the max and min
+                values into the MIimagemax and MIimagemin variables
+              DoFrames - whether or not there is a time dimension in this file
+@OUTPUT     : (none)
+@RETURNS    : (void)
+@DESCRIPTION: Finds the max and min values of an image, and puts them
+              into the MIimagemax and MIimagemin variables associated
+              with the specified image variable.  Note: the caller must
+              make sure that MIimagemax and MIimagemin exist in the
+              file, and ensure that ImInfo->MaxID and ImInfo->MinID contain
+              their variable ID's.  (To write many images at once, use
+              FindMaxMin on each and then PutMaxMins on the lot.)
+@METHOD     :
+@GLOBALS    :
+@CALLS      : FindMaxMin, PutMaxMins
+@CREATED    : 93-6-3, Greg Ward
+@MODIFIED   : moved here from miwriteimages.c so that the CMEX writer
+              (miputimages) and the standalone miwriteimages share it
+              2026/10/16 - the work is now done by FindMaxMin and
+              PutMaxMins
+---------------------------------------------------------------------------- */
+void PutMaxMin (ImageInfoRec *ImInfo, double *ImVals,
+                long SliceNum, long FrameNum,
+                Boolean DoSlices, Boolean DoFrames)
+{
+   double   Max, Min;
+
+   FindMaxMin (ImVals, ImInfo->ImageSize, &Max, &Min);
+
+#ifdef DEBUG
+   printf ("Slice %ld, frame %ld: max is %lg, min is %lg\n",
+           (DoSlices) ? (SliceNum) : -1,
+           (DoFrames) ? (FrameNum) : -1,
+           Max, Min);
+#endif
+
+   PutMaxMins (ImInfo, &SliceNum, &FrameNum,
+               DoSlices ? 1 : 0, DoFrames ? 1 : 0, &Max, &Min);
+
+}     /* PutMaxMin */
+
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : OpenSlabReader
+@INPUT      : Image - the study, as opened by OpenImage or CacheOpenImage
+              FirstSlice, NumSlices - zero-based range of slices to read
+              FirstFrame, NumFrames - zero-based range of frames to read
+              SlabRows - number of image rows in each slab (0 for whole
+                 images)
+              Buffer - room for SlabRows*Width*NumFrames doubles, or NULL
+                 to have one allocated
+@OUTPUT     : Reader - ready for ReadNextSlab
+@RETURNS    : ERR_NONE if all went well
+              ERR_ARGS if the slices or frames aren't in the study
+              ERR_NO_MEM if the buffer couldn't be allocated
+              (ErrMsg is set on error)
+@DESCRIPTION: Sets up to stream a study through memory a slab at a time,
+              where a slab is a few rows of one slice across all the
+              wanted frames.  Analyses that work pixel by pixel can then
+              process any size of study with memory for just two slabs
+              (the one being worked on, and the next), rather than for a
+              whole slice of every frame.
+
+              Typical use:
+
+                 OpenSlabReader (&Image, 0, Image.Slices, 0, Image.Frames,
+                                 16, NULL, &Reader);
+                 while ((ReadNextSlab (&Reader) == ERR_NONE) &&
+                        (Reader.Rows > 0))
+                 {
+                    ... Reader.Buffer holds Reader.Rows rows of slice
+                    ... Reader.Slice, starting at row Reader.Row
+                 }
+                 CloseSlabReader (&Reader);
+
+              Each ReadNextSlab leaves the following slab being read
+              in the background (see ReadNextSlab), so between calls
+              the caller must not use the NetCDF or MINC libraries --
+              on any file -- and must not keep Reader.Buffer, which is
+              swapped with a spare buffer on each call.  CloseSlabReader
+              must be called before giving up part way (eg. on error).
+@METHOD     : A spare buffer for reading ahead is allocated here; if
+              there's no memory for it, slabs are just read one at a
+              time.
+@GLOBALS    : ErrMsg
+@CALLS      : 
+@CREATED    : 2026/10/16
+@MODIFIED   : 2026/10/16: read the next slab in the background
+---------------------------------------------------------------------------- */
+int OpenSlabReader (ImageInfoRec *Image, long FirstSlice, long NumSlices,
+                    long FirstFrame, long NumFrames, long SlabRows,
+                    double *Buffer, SlabReader *Reader)
+{
+   long  Slices, Frames;
+
+   Slices = (Image->SliceDim == -1) ? 1 : Image->Slices;
+   Frames = (Image->FrameDim == -1) ? 1 : Image->Frames;
+
+   if ((FirstSlice < 0) || (NumSlices < 0) ||
+       (FirstSlice + NumSlices > Slices))
+   {
+      sprintf (ErrMsg, "Bad slices: %ld to %ld (study has %ld)",
+               FirstSlice, FirstSlice + NumSlices - 1, Slices);
+      return (ERR_ARGS);
+   }
+   if ((FirstFrame < 0) || (NumFrames < 1) ||
+       (FirstFrame + NumFrames > Frames))
+   {
+      sprintf (ErrMsg, "Bad frames: %ld to %ld (study has %ld)",
+               FirstFrame, FirstFrame + NumFrames - 1, Frames);
+      return (ERR_ARGS);
+   }
+
+   if ((SlabRows <= 0) || (SlabRows > Image->Height))
+   {
+      SlabRows = Image->Height;
+   }
+
+   Reader->Image = Image;
+   Reader->EndSlice = FirstSlice + NumSlices;
+   Reader->FirstFrame = FirstFrame;
+   Reader->NumFrames = NumFrames;
+   Reader->SlabRows = SlabRows;
+   Reader->Slice = FirstSlice;
+   Reader->Row = 0;
+   Reader->Rows = 0;
+   Reader->NextSlice = FirstSlice;
+   Reader->NextRow = 0;
+   Reader->AheadRows = 0;
+   Reader->Thread.Running = FALSE;
+
+   Reader->Allocated [0] = NULL;
+   Reader->Allocated [1] = NULL;
+   Reader->Spare = NULL;
+   if (Buffer == NULL)
+   {
+      Buffer = (double *) malloc (SlabRows * Image->Width * NumFrames *
+                                  sizeof (double));
+      if (Buffer == NULL)
+      {
+         sprintf (ErrMsg, "Out of memory for a slab of %ld rows", SlabRows);
+         return (ERR_NO_MEM);
+      }
+      Reader->Allocated [0] = Buffer;
+   }
+   Reader->Buffer = Buffer;
+
+   Reader->Spare = (double *) malloc (SlabRows * Image->Width * NumFrames *
+                                      sizeof (double));
+   Reader->Allocated [1] = Reader->Spare;
+
+   return (ERR_NONE);
+}     /* OpenSlabReader */
+
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : GetSlab
+@INPUT      : Image - the study
+              Slice, Row, Rows - which slab
+              FirstFrame, NumFrames - and which frames
+@OUTPUT     : Buffer - the slab (laid out as described for ReadNextSlab)
+@RETURNS    : miicv_get's result (MI_ERROR on error, with ncerr set)
+@DESCRIPTION: Reads one slab.  Doesn't touch ErrMsg or anything of
+              MATLAB's, so may be run in the background.
+@METHOD     : One miicv_get per slab.  Since height and width are always
+              the last two image dimensions, a hyperslab of one slice
+              comes back frame by frame whichever order slice and time
+              are in.
+@GLOBALS    : 
+@CALLS      : MINC library
+@CREATED    : 2026/10/16 (from ReadNextSlab)
+@MODIFIED   : 
+---------------------------------------------------------------------------- */
+static int GetSlab (ImageInfoRec *Image, long Slice, long Row, long Rows,
+                    long FirstFrame, long NumFrames, double *Buffer)
+{
+   long     Start [MAX_NC_DIMS], Count [MAX_NC_DIMS];
+
+   Start [Image->HeightDim] = Row;
+   Count [Image->HeightDim] = Rows;
+   Start [Image->WidthDim] = 0;
+   Count [Image->WidthDim] = Image->Width;
+   if (Image->SliceDim != -1)
+   {
+      Start [Image->SliceDim] = Slice;
+      Count [Image->SliceDim] = 1;
+   }
+   if (Image->FrameDim != -1)
+   {
+      Start [Image->FrameDim] = FirstFrame;
+      Count [Image->FrameDim] = NumFrames;
+   }
+
+   return (miicv_get (Image->ICV, Start, Count, Buffer));
+}     /* GetSlab */
+
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : ReadAhead
+@INPUT      : Arg - the SlabReader
+@OUTPUT     : 
+@RETURNS    : (void)
+@DESCRIPTION: Reads the slab at AheadSlice/AheadRow into the reader's
+              spare buffer, leaving the result in AheadResult.  Run in
+              the background by ReadNextSlab.
+@METHOD     : 
+@GLOBALS    : 
+@CALLS      : GetSlab
+@CREATED    : 2026/10/16
+@MODIFIED   : 
+---------------------------------------------------------------------------- */
+static void ReadAhead (void *Arg)
+{
+   SlabReader *Reader = (SlabReader *) Arg;
+
+   Reader->AheadResult = GetSlab (Reader->Image, Reader->AheadSlice,
+                                  Reader->AheadRow, Reader->AheadRows,
+                                  Reader->FirstFrame, Reader->NumFrames,
+                                  Reader->Spare);
+}     /* ReadAhead */
+
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : NextSlab
+@INPUT      : Reader - set up by OpenSlabReader
+@OUTPUT     : *Slice, *Row - where the next slab to read starts
+@RETURNS    : the number of rows in that slab (0 if there are no more)
+@DESCRIPTION: Finds the next slab not yet read (or being read), and
+              moves the reader on past it.  Slabs go through each slice
+              from the first row to the last, and then on to the next
+              slice.
+@METHOD     : 
+@GLOBALS    : 
+@CALLS      : 
+@CREATED    : 2026/10/16 (from ReadNextSlab)
+@MODIFIED   : 
+---------------------------------------------------------------------------- */
+static long NextSlab (SlabReader *Reader, long *Slice, long *Row)
+{
+   long     Rows;
+
+   if (Reader->NextSlice >= Reader->EndSlice)
+   {
+      return (0);
+   }
+
+   *Slice = Reader->NextSlice;
+   *Row = Reader->NextRow;
+   Rows = min (Reader->SlabRows, Reader->Image->Height - *Row);
+
+   Reader->NextRow += Rows;
+   if (Reader->NextRow >= Reader->Image->Height)
+   {
+      Reader->NextRow = 0;
+      Reader->NextSlice++;
+   }
+   return (Rows);
+}     /* NextSlab */
+
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : ReadNextSlab
+@INPUT      : Reader - set up by OpenSlabReader
+@OUTPUT     : Reader->Buffer - the next slab: Reader->Rows rows of slice
+                 Reader->Slice, starting at row Reader->Row, for every
+                 frame.  Pixels are in the same order as in a whole
+                 image (so the slab is pixels Row*Width to
+                 (Row+Rows)*Width-1 of the slice), and frames follow one
+                 another -- ie. it's laid out like a MATLAB matrix with
+                 one column per frame.
+@RETURNS    : ERR_NONE if all went well (Reader->Rows is set to 0 once
+                 every slab has been read)
+              ERR_IN_MINC if miicv_get failed (ErrMsg is set)
+@DESCRIPTION: Gets the next slab of the study, and starts reading the
+              one after it in the background.
+@METHOD     : Double buffered: the slab returned was (usually) read into
+              the spare buffer while the caller was working on the last
+              one; once it's ready the two buffers are swapped, and the
+              following slab is started on in what is now the spare.
+              Only the first slab (or every slab, if there's no spare)
+              is read while the caller waits.  Without threads (see
+              emmathread.c) the "background" read happens there and
+              then, which is no slower than reading one at a time.
+@GLOBALS    : ErrMsg
+@CALLS      : GetSlab, NextSlab, StartThread, WaitThread
+@CREATED    : 2026/10/16
+@MODIFIED   : 2026/10/16: read the next slab in the background
+---------------------------------------------------------------------------- */
+int ReadNextSlab (SlabReader *Reader)
+{
+   double  *Temp;
+   int      Result;
+
+   if (Reader->AheadRows > 0)
+   {
+      WaitThread (&Reader->Thread);
+      Temp = Reader->Buffer;
+      Reader->Buffer = Reader->Spare;
+      Reader->Spare = Temp;
+      Reader->Slice = Reader->AheadSlice;
+      Reader->Row = Reader->AheadRow;
+      Reader->Rows = Reader->AheadRows;
+      Reader->AheadRows = 0;
+      Result = Reader->AheadResult;
+   }
+   else
+   {
+      Reader->Rows = NextSlab (Reader, &Reader->Slice, &Reader->Row);
+      if (Reader->Rows == 0)
+      {
+         return (ERR_NONE);
+      }
+      Result = GetSlab (Reader->Image, Reader->Slice, Reader->Row,
+                        Reader->Rows, Reader->FirstFrame,
+                        Reader->NumFrames, Reader->Buffer);
+   }
+
+   if (Result == MI_ERROR)
+   {
+      sprintf (ErrMsg, "!! BOMB !! error code %d (%s) set by miicv_get",
+               ncerr, NCErrMsg (ncerr, errno));
+      Reader->Rows = 0;
+      return (ERR_IN_MINC);
+   }
+
+   if (Reader->Spare != NULL)
+   {
+      Reader->AheadRows = NextSlab (Reader, &Reader->AheadSlice,
+                                    &Reader->AheadRow);
+      if (Reader->AheadRows > 0)
+      {
+         StartThread (&Reader->Thread, ReadAhead, Reader);
+      }
+   }
+
+   return (ERR_NONE);
+}     /* ReadNextSlab */
+
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : CloseSlabReader
+@INPUT      : Reader - set up by OpenSlabReader
+@OUTPUT     : 
+@RETURNS    : (void)
+@DESCRIPTION: Waits for any slab still being read, and frees the buffers
+              OpenSlabReader allocated.  The study itself is left open.
+@METHOD     : 
+@GLOBALS    : 
+@CALLS      : WaitThread
+@CREATED    : 2026/10/16
+@MODIFIED   : 2026/10/16: wait for the slab being read ahead
+---------------------------------------------------------------------------- */
+void CloseSlabReader (SlabReader *Reader)
+{
+   int      i;
+
+   WaitThread (&Reader->Thread);
+   for (i = 0; i < 2; i++)
+   {
+      if (Reader->Allocated [i] != NULL)
+      {
+         free (Reader->Allocated [i]);
+      }
+      Reader->Allocated [i] = NULL;
+   }
+   Reader->Buffer = NULL;
+   Reader->Spare = NULL;
+   Reader->Rows = 0;
+   Reader->AheadRows = 0;
+}     /* CloseSlabReader */
@@ -0,0 +1,585 @@
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : ncheader.c
+@DESCRIPTION: Deals directly with the header of a NetCDF classic file
+              (which is what a MINC 1 file is).  ParseHeader finds a
+              variable, or the extent of the data, without going through
+              the NetCDF library; ncmap.c uses it to read variables
+              through a memory map.
+
+              Also here: EndDefine, for leaving define mode with room
+              to spare in the header.  The data in a NetCDF classic file
+              starts right after the header, so if adding an attribute
+              or variable to an existing file makes the header bigger
+              than the space kept for it, the NetCDF library has to move
+              every byte of data further down the file.  With room to
+              spare, history, attributes and blood data can be added to
+              a file, however big, by rewriting just the header.
+
+              Nothing here uses ErrMsg (or anything else from
+              mincutil.c), so the stand-alone programs can use it.
+@GLOBALS    :
+@CREATED    : 2026/10/16
+@MODIFIED   :
+@VERSION    : $Id$
+              $Name:  $
+---------------------------------------------------------------------------- */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "minc.h"
+#include "emmageneral.h"
+#include "mierrors.h"
+#include "ncmap.h"
+
+/*
+ * Tags in the header of a NetCDF classic file
+ */
+
+#define NC_TAG_DIMENSION   10
+#define NC_TAG_VARIABLE    11
+#define NC_TAG_ATTRIBUTE   12
+
+
+/*
+ * Names and values in the header are padded to a multiple of 4 bytes
+ */
+
+#define PADDED(n)          (((n) + 3) & ~3L)
+
+/*
+ * A position in the header, and where it ends
+ */
+
+typedef struct
+{
+   unsigned char *Pos;
+   unsigned char *End;
+   Boolean        Bad;          /* set if we tried to read past End */
+} HeaderCursor;
+
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : TypeSize
+@INPUT      : Type - a NetCDF type
+@OUTPUT     :
+@RETURNS    : the number of bytes one value of Type takes in the file,
+              or 0 for an unknown type
+@DESCRIPTION:
+@METHOD     :
+@GLOBALS    :
+@CALLS      :
+@CREATED    : 2026/10/16
+@MODIFIED   :
+---------------------------------------------------------------------------- */
+static int TypeSize (long Type)
+{
+   switch (Type)
+   {
+      case NC_BYTE:
+      case NC_CHAR:   return (1);
+      case NC_SHORT:  return (2);
+      case NC_LONG:
+      case NC_FLOAT:  return (4);
+      case NC_DOUBLE: return (8);
+      default:        return (0);
+   }
+}
+
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : GetWord
+@INPUT      : Cursor - position in the header
+              Size - number of bytes (4 or 8)
+@OUTPUT     : Cursor - moved past the value
+@RETURNS    : the big-endian unsigned integer at the cursor (0 if it
+              runs past the end of the header, which sets Cursor->Bad)
+@DESCRIPTION:
+@METHOD     : 8-byte values (offsets in 64-bit offset files) that don't
+              fit in a long also set Cursor->Bad.
+@GLOBALS    :
+@CALLS      :
+@CREATED    : 2026/10/16
+@MODIFIED   :
+---------------------------------------------------------------------------- */
+static unsigned long GetWord (HeaderCursor *Cursor, int Size)
+{
+   unsigned long  Value;
+   int            i;
+
+   if (Cursor->Bad || (Cursor->End - Cursor->Pos < Size))
+   {
+      Cursor->Bad = TRUE;
+      return (0);
+   }
+
+   for (i = 0, Value = 0; i < Size; i++)
+   {
+      if ((i < Size - (int) sizeof (long)) && (Cursor->Pos [i] != 0))
+         Cursor->Bad = TRUE;
+      Value = (Value << 8) | Cursor->Pos [i];
+   }
+   Cursor->Pos += Size;
+   return (Value);
+}
+
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : Skip
+@INPUT      : Cursor - position in the header
+              Bytes - number of bytes to skip (rounded up to a multiple
+                      of 4, as everything in the header is padded)
+@OUTPUT     : Cursor - moved on
+@RETURNS    : (void)
+@DESCRIPTION:
+@METHOD     :
+@GLOBALS    :
+@CALLS      :
+@CREATED    : 2026/10/16
+@MODIFIED   :
+---------------------------------------------------------------------------- */
+static void Skip (HeaderCursor *Cursor, unsigned long Bytes)
+{
+   Bytes = (Bytes + 3) & ~3UL;
+   if (Cursor->Bad || ((unsigned long) (Cursor->End - Cursor->Pos) < Bytes))
+      Cursor->Bad = TRUE;
+   else
+      Cursor->Pos += Bytes;
+}
+
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : SkipAttributes
+@INPUT      : Cursor - at the start of an attribute list
+@OUTPUT     : Cursor - just after it
+@RETURNS    : (void)
+@DESCRIPTION:
+@METHOD     :
+@GLOBALS    :
+@CALLS      : GetWord, Skip
+@CREATED    : 2026/10/16
+@MODIFIED   :
+---------------------------------------------------------------------------- */
+static void SkipAttributes (HeaderCursor *Cursor)
+{
+   unsigned long  NumAtts, Num, Size, i;
+
+   (void) GetWord (Cursor, 4);                  /* NC_TAG_ATTRIBUTE or 0 */
+   NumAtts = GetWord (Cursor, 4);
+   for (i = 0; (i < NumAtts) && !Cursor->Bad; i++)
+   {
+      Skip (Cursor, GetWord (Cursor, 4));       /* name */
+      Size = TypeSize (GetWord (Cursor, 4));
+      Num = GetWord (Cursor, 4);
+      if (Size == 0)
+         Cursor->Bad = TRUE;
+      else
+         Skip (Cursor, Num * Size);
+   }
+}
+
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : ParseHeader
+@INPUT      : Header - the start of a NetCDF classic file
+              Length - number of bytes available at Header (which may
+                 not be the whole file)
+              VarName - name of the variable wanted (or NULL)
+@OUTPUT     : Var - where VarName's values are, etc. (everything but
+                 Base and Data, which are up to the caller)
+              DataBegin - (if not NULL) the offset of the first data in
+                 the file (ie. the end of the space kept for the header),
+                 or 0 if there are no variables
+              DataEnd - (if not NULL) the offset just past the last
+                 data in the file (ie. the size the file should be)
+@RETURNS    : ERR_NONE if all went well
+              ERR_NO_VAR if VarName isn't in the file
+              ERR_BAD_MINC if the header runs past Length (or is
+                 corrupt -- there's no telling which)
+              ERR_OTHER if the file is not in NetCDF classic format
+              (ErrMsg is not set)
+@DESCRIPTION: Finds a variable (or just the size of the file) from the
+              header of a NetCDF classic file.
+@METHOD     : Follows the NetCDF classic format specification: magic
+              number ("CDF" and version 1, or 2 for 64-bit offsets),
+              record count, then the dimension, global attribute and
+              variable lists.  Every field is bounds-checked.
+@GLOBALS    :
+@CALLS      : GetWord, Skip, SkipAttributes
+@CREATED    : 2026/10/16
+@MODIFIED   :
+---------------------------------------------------------------------------- */
+int ParseHeader (unsigned char *Header, long Length, char VarName[],
+                 MappedVar *Var, unsigned long *DataBegin,
+                 unsigned long *DataEnd)
+{
+   HeaderCursor   Cursor;
+   int            Version;
+   unsigned long  NumRecs, NumDims, NumVars, NameLen, Begin, Size, i, j;
+   unsigned long  FixedEnd, RecBegin, RecSize, FirstBegin;
+   long           DimSizes [MAX_NC_DIMS];
+   long           VarDims [MAX_NC_DIMS];
+   int            NumVarDims;
+   long           Type;
+   Boolean        IsRecord, Found, Matched;
+
+   /*
+    * Magic number and number of records
+    */
+
+   if ((Length < 8) || (strncmp ((char *) Header, "CDF", 3) != 0) ||
+       ((Header [3] != 1) && (Header [3] != 2)))
+   {
+      return (ERR_OTHER);
+   }
+   Version = Header [3];
+
+   Cursor.Pos = Header + 4;
+   Cursor.End = Header + Length;
+   Cursor.Bad = FALSE;
+   NumRecs = GetWord (&Cursor, 4);
+   if (NumRecs == 0xFFFFFFFFUL)                 /* still being written */
+      NumRecs = 0;
+
+   /*
+    * Dimensions (a size of zero marks the record dimension)
+    */
+
+   (void) GetWord (&Cursor, 4);                 /* NC_TAG_DIMENSION or 0 */
+   NumDims = GetWord (&Cursor, 4);
+   if (NumDims > MAX_NC_DIMS)
+      Cursor.Bad = TRUE;
+   for (i = 0; (i < NumDims) && !Cursor.Bad; i++)
+   {
+      Skip (&Cursor, GetWord (&Cursor, 4));
+      DimSizes [i] = (long) GetWord (&Cursor, 4);
+   }
+
+   SkipAttributes (&Cursor);
+
+   /*
+    * Variables: look for the one we want, and keep track of where the
+    * data ends
+    */
+
+   (void) GetWord (&Cursor, 4);                 /* NC_TAG_VARIABLE or 0 */
+   NumVars = GetWord (&Cursor, 4);
+   Found = Matched = FALSE;
+   FixedEnd = RecSize = 0;
+   RecBegin = FirstBegin = 0;
+   for (i = 0; (i < NumVars) && !Cursor.Bad; i++)
+   {
+      NameLen = GetWord (&Cursor, 4);
+      Found = !Cursor.Bad && (VarName != NULL) &&
+              (NameLen == strlen (VarName)) &&
+              ((unsigned long) (Cursor.End - Cursor.Pos) >= NameLen) &&
+              (strncmp ((char *) Cursor.Pos, VarName, NameLen) == 0);
+      Skip (&Cursor, NameLen);
+
+      NumVarDims = (int) GetWord (&Cursor, 4);
+      if (NumVarDims > MAX_NC_DIMS)
+         Cursor.Bad = TRUE;
+      for (j = 0; (j < (unsigned long) NumVarDims) && !Cursor.Bad; j++)
+      {
+         VarDims [j] = (long) GetWord (&Cursor, 4);
+         if ((unsigned long) VarDims [j] >= NumDims)
+            Cursor.Bad = TRUE;
+      }
+
+      SkipAttributes (&Cursor);
+      Type = (long) GetWord (&Cursor, 4);
+      (void) GetWord (&Cursor, 4);              /* vsize (may be wrong) */
+      Begin = GetWord (&Cursor, (Version == 1) ? 4 : 8);
+      if (Cursor.Bad)
+         break;
+      if (TypeSize (Type) == 0)
+      {
+         Cursor.Bad = TRUE;
+         break;
+      }
+
+      /*
+       * Size of one record's worth (for a record variable) or of the
+       * whole variable (otherwise), padded as in the file
+       */
+
+      IsRecord = (NumVarDims > 0) && (DimSizes [VarDims [0]] == 0);
+      Size = TypeSize (Type);
+      for (j = IsRecord ? 1 : 0; j < (unsigned long) NumVarDims; j++)
+         Size *= DimSizes [VarDims [j]];
+      Size = (Size + 3) & ~3UL;
+
+      if ((i == 0) || (Begin < FirstBegin))
+         FirstBegin = Begin;
+
+      if (IsRecord)
+      {
+         if ((RecSize == 0) || (Begin < RecBegin))
+            RecBegin = Begin;
+         RecSize += Size;
+      }
+      else if (Begin + Size > FixedEnd)
+      {
+         FixedEnd = Begin + Size;
+      }
+
+      if (Found)
+      {
+         Var->Type = (nc_type) Type;
+         Var->TypeSize = TypeSize (Type);
+         Var->NumDims = NumVarDims;
+         for (j = 0; j < (unsigned long) NumVarDims; j++)
+            Var->DimSizes [j] = DimSizes [VarDims [j]];
+         if (IsRecord)
+            Var->DimSizes [0] = (long) NumRecs;
+         Var->Offset = (long) Begin;
+         Var->IsRecord = IsRecord;
+         Matched = TRUE;
+         if ((DataBegin == NULL) && (DataEnd == NULL))
+            break;
+      }
+      Found = FALSE;
+   }
+
+   if (Cursor.Bad)
+      return (ERR_BAD_MINC);
+
+   if (DataBegin != NULL)
+      *DataBegin = FirstBegin;
+   if (DataEnd != NULL)
+   {
+      *DataEnd = FixedEnd;
+      if ((RecSize > 0) && (RecBegin + NumRecs * RecSize > FixedEnd))
+         *DataEnd = RecBegin + NumRecs * RecSize;
+   }
+
+   if ((VarName != NULL) && !Matched)
+      return (ERR_NO_VAR);
+
+   return (ERR_NONE);
+}
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : ReadDataBegin
+@INPUT      : Filename - a NetCDF classic file
+@OUTPUT     : Version - 1 for a classic file, 2 for 64-bit offsets
+              DataBegin - offset of the first data in the file (0 if
+                 there are no variables)
+@RETURNS    : ERR_NONE if all went well
+              ERR_IN_MINC if the file couldn't be opened
+              ERR_NO_MEM if we ran out of memory
+              ERR_OTHER if it's not a NetCDF classic file
+@DESCRIPTION: Finds out how much space there is for the header of a
+              file, as it stands on disk.
+@METHOD     : Reads the header a chunk at a time until ParseHeader has
+              all of it.
+@GLOBALS    :
+@CALLS      : ParseHeader
+@CREATED    : 2026/10/16
+@MODIFIED   :
+---------------------------------------------------------------------------- */
+static int ReadDataBegin (char Filename[], int *Version,
+                          unsigned long *DataBegin)
+{
+   FILE           *fp;
+   unsigned char  *Header, *Bigger;
+   long            Length;
+   size_t          Num;
+   int             Result;
+
+   fp = fopen (Filename, "rb");
+   if (fp == NULL)
+      return (ERR_IN_MINC);
+
+   Header = NULL;
+   Length = 0;
+   do
+   {
+      Bigger = (unsigned char *) realloc (Header, Length + HEADER_CHUNK);
+      if (Bigger == NULL)
+      {
+         Result = ERR_NO_MEM;
+         break;
+      }
+      Header = Bigger;
+      Num = fread (Header + Length, 1, HEADER_CHUNK, fp);
+      if (Num == 0)
+      {
+         Result = ERR_OTHER;
+         break;
+      }
+      Length += (long) Num;
+      Result = ParseHeader (Header, Length, NULL, NULL, DataBegin, NULL);
+   } while ((Result == ERR_BAD_MINC) && (Length < MAX_HEADER));
+
+   if (Result == ERR_NONE)
+      *Version = Header [3];
+   else if (Result == ERR_BAD_MINC)
+      Result = ERR_OTHER;
+
+   free (Header);
+   fclose (fp);
+   return (Result);
+}
+
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : AttributesSize
+@INPUT      : CDF - an open NetCDF file
+              VarID - a variable (or NC_GLOBAL)
+              NumAtts - the number of attributes it has
+@OUTPUT     :
+@RETURNS    : the number of bytes the attribute list will take up in
+              the header
+@DESCRIPTION:
+@METHOD     : Each attribute has its name (a length and the padded
+              characters), its type, the number of values, and the
+              padded values.
+@GLOBALS    :
+@CALLS      : ncattname, ncattinq
+@CREATED    : 2026/10/16
+@MODIFIED   :
+---------------------------------------------------------------------------- */
+static long AttributesSize (int CDF, int VarID, int NumAtts)
+{
+   char     Name [MAX_NC_NAME];
+   nc_type  Type;
+   int      Length;
+   long     Size;
+   int      i;
+
+   Size = 8;                                    /* tag and count */
+   for (i = 0; i < NumAtts; i++)
+   {
+      ncattname (CDF, VarID, i, Name);
+      ncattinq (CDF, VarID, Name, &Type, &Length);
+      Size += 4 + PADDED ((long) strlen (Name)) + 8 +
+              PADDED ((long) Length * nctypelen (Type));
+   }
+   return (Size);
+}
+
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : DefinedHeaderSize
+@INPUT      : CDF - a NetCDF file in define mode
+              Version - 1 for a classic file, 2 for 64-bit offsets
+@OUTPUT     :
+@RETURNS    : the number of bytes the header will take up when the file
+              leaves define mode, or -1 on error
+@DESCRIPTION: Works out the size of the header from the dimensions,
+              attributes and variables currently defined, the same way
+              the NetCDF library does when it writes it.
+@METHOD     :
+@GLOBALS    :
+@CALLS      : ncinquire, ncdiminq, ncvarinq, AttributesSize
+@CREATED    : 2026/10/16
+@MODIFIED   :
+---------------------------------------------------------------------------- */
+static long DefinedHeaderSize (int CDF, int Version)
+{
+   char     Name [MAX_NC_NAME];
+   nc_type  Type;
+   int      NumDims, NumVars, NumAtts, RecDim, VarDims;
+   int      DimIDs [MAX_VAR_DIMS];
+   long     Length, Size;
+   int      i;
+
+   if (ncinquire (CDF, &NumDims, &NumVars, &NumAtts, &RecDim) == MI_ERROR)
+      return (-1);
+
+   Size = 8;                                    /* magic and record count */
+
+   Size += 8;                                   /* dimensions */
+   for (i = 0; i < NumDims; i++)
+   {
+      if (ncdiminq (CDF, i, Name, &Length) == MI_ERROR)
+         return (-1);
+      Size += 4 + PADDED ((long) strlen (Name)) + 4;
+   }
+
+   Size += AttributesSize (CDF, NC_GLOBAL, NumAtts);
+
+   Size += 8;                                   /* variables */
+   for (i = 0; i < NumVars; i++)
+   {
+      if (ncvarinq (CDF, i, Name, &Type, &VarDims, DimIDs, &NumAtts)
+          == MI_ERROR)
+         return (-1);
+      Size += 4 + PADDED ((long) strlen (Name)) + 4 + 4 * VarDims +
+              AttributesSize (CDF, i, NumAtts) +
+              8 + ((Version == 1) ? 4 : 8);     /* type, size and offset */
+   }
+
+   return (Size);
+}
+
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : EndDefine
+@INPUT      : CDF - a NetCDF file in define mode
+              Filename - the name of the file if it existed before it
+                 was put in define mode; NULL if it has just been
+                 created
+              Pad - how much room (in bytes) to leave in the header
+                 for adding to it later
+@OUTPUT     : *Rewritten - TRUE if the header outgrew the space kept for
+                 it, so that the whole file had to be rewritten
+@RETURNS    : MI_NOERROR if all went well, MI_ERROR otherwise
+@DESCRIPTION: Use instead of ncendef: leaves room in the header of a
+              new file, and only rewrites an existing file when there's
+              no getting out of it -- in which case it leaves room, so
+              that it won't happen again next time.
+@METHOD     : The NetCDF library moves the data if there's less than
+              the free space asked for after the header, even if the
+              header itself would still fit.  So for an existing file,
+              we only ask for free space if we've worked out that the
+              new header doesn't fit in the space that's already there.
+              Files whose header we can't read (eg. MINC 2 files) are
+              just passed on to ncendef.
+@GLOBALS    :
+@CALLS      : ReadDataBegin, DefinedHeaderSize, nc__enddef
+@CREATED    : 2026/10/16
+@MODIFIED   :
+---------------------------------------------------------------------------- */
+int EndDefine (int CDF, char Filename[], long Pad, Boolean *Rewritten)
+{
+   unsigned long  DataBegin;
+   int            Version;
+   long           Needed;
+   size_t         MinFree;
+
+   *Rewritten = FALSE;
+   MinFree = (size_t) Pad;
+
+   if (Filename != NULL)
+   {
+      if ((ReadDataBegin (Filename, &Version, &DataBegin) != ERR_NONE) ||
+          (DataBegin == 0))
+      {
+         return (ncendef (CDF));
+      }
+
+      Needed = DefinedHeaderSize (CDF, Version);
+      if (Needed < 0)
+         return (ncendef (CDF));
+
+      if ((unsigned long) Needed <= DataBegin)
+         MinFree = 0;
+      else
+         *Rewritten = TRUE;
+   }
+
+   if (nc__enddef (CDF, MinFree, 4, 0, 4) != NC_NOERR)
+      return (MI_ERROR);
+   return (MI_NOERROR);
+}
@@ -0,0 +1,882 @@
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : ncmap.c
+@DESCRIPTION: Reads variables straight out of a memory-mapped NetCDF
+              classic file (which is what an uncompressed MINC 1 file
+              is).  A fixed-size variable in such a file is one
+              contiguous block of big-endian values at an offset given
+              in the header, so once the header has been parsed, a
+              hyperslab can be converted directly from the mapped pages
+              into the caller's array -- with no stdio buffering and no
+              intermediate copy.
+
+              Anything that can't be read this way (compressed or
+              MINC 2 files, record variables, systems without mmap) is
+              reported as ERR_OTHER by MapVariable, so that the caller
+              can fall back on the NetCDF library.
+
+              Also here, since it uses the same header parsing (see
+              ncheader.c): reading gzip-compressed NetCDF classic files
+              a bit at a time (OpenCompressed and friends), for the
+              open-file cache -- and, for other compressed files,
+              uncompressing them whole (UncompressFile).
+@GLOBALS    : ErrMsg
+@CREATED    : 2026/10/16
+@MODIFIED   :
+@VERSION    : $Id$
+              $Name:  $
+---------------------------------------------------------------------------- */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "minc.h"
+#include "emmageneral.h"
+#include "mierrors.h"
+#include "mincutil.h"
+#include "ncmap.h"
+
+#ifndef _WIN32
+#include <zlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#endif
+
+extern char *ErrMsg;
+
+/*
+ * How much of a compressed file to uncompress at once when reading
+ * data (see InflateTo)
+ */
+
+#define INFLATE_CHUNK      1048576L
+
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : MapVariable
+@INPUT      : Filename - the file
+              VarName - name of the variable wanted
+@OUTPUT     : Var - where the variable's values are, etc.
+@RETURNS    : ERR_NONE if all went well
+              ERR_IN_MINC if the file can't be opened
+              ERR_NO_VAR if the variable isn't in the file
+              ERR_OTHER if the file or variable can't be read through a
+                 map (not NetCDF classic format, a record variable, or
+                 no mmap on this system)
+              (ErrMsg is set if not ERR_NONE)
+@DESCRIPTION: Maps the whole file into memory (read-only), and finds
+              the variable's values from the header.  Call
+              UnmapVariable when finished.
+@METHOD     :
+@GLOBALS    : ErrMsg
+@CALLS      : mmap, ParseHeader
+@CREATED    : 2026/10/16
+@MODIFIED   :
+---------------------------------------------------------------------------- */
+int MapVariable (char Filename[], char VarName[], MappedVar *Var)
+{
+#ifdef _WIN32
+   sprintf (ErrMsg, "Memory-mapped reads are not available on this system");
+   return (ERR_OTHER);
+#else
+   int            fd;
+   struct stat    StatBuf;
+   void          *Base;
+   unsigned long  Size;
+   int            Result;
+   int            i;
+
+   Var->Base = NULL;
+
+   fd = open (Filename, O_RDONLY);
+   if (fd < 0)
+   {
+      sprintf (ErrMsg, "Error opening file %s", Filename);
+      return (ERR_IN_MINC);
+   }
+   if ((fstat (fd, &StatBuf) != 0) || (StatBuf.st_size < 8) ||
+       (StatBuf.st_size != (off_t) (long) StatBuf.st_size))
+   {
+      close (fd);
+      sprintf (ErrMsg, "%s is not a NetCDF classic file", Filename);
+      return (ERR_OTHER);
+   }
+
+   Base = mmap (NULL, (size_t) StatBuf.st_size, PROT_READ, MAP_SHARED, fd, 0);
+   close (fd);
+   if (Base == MAP_FAILED)
+   {
+      sprintf (ErrMsg, "Unable to map file %s", Filename);
+      return (ERR_OTHER);
+   }
+
+   Var->Base = (char *) Base;
+   Var->FileSize = (long) StatBuf.st_size;
+
+   Result = ParseHeader ((unsigned char *) Base, Var->FileSize, VarName,
+                         Var, NULL, NULL);
+   switch (Result)
+   {
+      case ERR_NONE:
+         break;
+      case ERR_NO_VAR:
+         sprintf (ErrMsg, "Variable %s not found in file %s", VarName,
+                  Filename);
+         break;
+      case ERR_BAD_MINC:
+         sprintf (ErrMsg, "Could not parse the header of %s", Filename);
+         Result = ERR_OTHER;
+         break;
+      default:
+         sprintf (ErrMsg, "%s is not a NetCDF classic file", Filename);
+         Result = ERR_OTHER;
+         break;
+   }
+   if (Result != ERR_NONE)
+   {
+      UnmapVariable (Var);
+      return (Result);
+   }
+
+   /*
+    * Check that it's a fixed-size variable that lies within the file
+    */
+
+   if (Var->IsRecord)
+   {
+      UnmapVariable (Var);
+      sprintf (ErrMsg, "Variable %s can't be read through a map", VarName);
+      return (ERR_OTHER);
+   }
+
+   Size = Var->TypeSize;
+   for (i = 0; i < Var->NumDims; i++)
+      Size *= Var->DimSizes [i];
+   if ((Var->Offset > Var->FileSize) ||
+       (Size > (unsigned long) (Var->FileSize - Var->Offset)))
+   {
+      UnmapVariable (Var);
+      sprintf (ErrMsg, "Variable %s runs past the end of %s", VarName,
+               Filename);
+      return (ERR_OTHER);
+   }
+
+   Var->Data = Var->Base + Var->Offset;
+   return (ERR_NONE);
+#endif
+}
+
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : ForEachRun
+@INPUT      : Var - a mapped variable
+              Start, Count - the hyperslab (already checked)
+              Func - called for each contiguous run of values in the
+                     hyperslab, with a pointer to the run in the map,
+                     the number of values in it, and how many values of
+                     the hyperslab came before it
+              Dest - passed on to Func
+@OUTPUT     :
+@RETURNS    : (void)
+@DESCRIPTION: Walks through a hyperslab, in order, one run (along the
+              last dimension) at a time.
+@METHOD     :
+@GLOBALS    :
+@CALLS      :
+@CREATED    : 2026/10/16
+@MODIFIED   :
+---------------------------------------------------------------------------- */
+static void ForEachRun (MappedVar *Var, long Start[], long Count[],
+                        void (*Func) (MappedVar *, char *, long, long,
+                                      void *, Boolean),
+                        void *Dest, Boolean Signed)
+{
+   long     Index [MAX_NC_DIMS];
+   long     Stride [MAX_NC_DIMS];
+   long     RunLength, Offset, Done;
+   int      Last, d;
+
+   if (Var->NumDims == 0)
+   {
+      Func (Var, Var->Data, 1, 0, Dest, Signed);
+      return;
+   }
+
+   Last = Var->NumDims - 1;
+   Stride [Last] = 1;
+   for (d = Last - 1; d >= 0; d--)
+      Stride [d] = Stride [d+1] * Var->DimSizes [d+1];
+   for (d = 0; d <= Last; d++)
+   {
+      if (Count [d] == 0)
+         return;
+      Index [d] = Start [d];
+   }
+
+   RunLength = Count [Last];
+   Done = 0;
+   while (TRUE)
+   {
+      for (d = 0, Offset = 0; d <= Last; d++)
+         Offset += Index [d] * Stride [d];
+      Func (Var, Var->Data + Offset * Var->TypeSize, RunLength, Done,
+            Dest, Signed);
+      Done += RunLength;
+
+      for (d = Last - 1; d >= 0; d--)
+      {
+         if (++Index [d] < Start [d] + Count [d])
+            break;
+         Index [d] = Start [d];
+      }
+      if (d < 0)
+         break;
+   }
+}
+
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : ConvertRun, CopyRun
+@INPUT      : Var - the mapped variable
+              Src - a run of values in the map
+              Num - number of values in the run
+              Done - number of values already stored in Dest
+              Signed - (ConvertRun only) whether integers are signed
+@OUTPUT     : Dest - the values, as doubles (ConvertRun) or in their own
+                     type and native byte order (CopyRun)
+@RETURNS    : (void)
+@DESCRIPTION: Functions passed to ForEachRun by MappedGet and
+              MappedGetRaw.
+@METHOD     : Values are assembled a byte at a time from big-endian
+              order, which works whatever the host's byte order.
+              ConvertRun has a separate loop for each type, rather than
+              switching on the type for every value.
+@GLOBALS    :
+@CALLS      :
+@CREATED    : 2026/10/16
+@MODIFIED   :
+---------------------------------------------------------------------------- */
+static Boolean HostLittleEndian (void)
+{
+   int  One = 1;
+
+   return (*(char *) &One == 1);
+}
+
+static void Unpack (MappedVar *Var, unsigned char *Src, long Num,
+                    char *Dest)
+{
+   long        i;
+   int         b, Size;
+
+   Size = Var->TypeSize;
+   if (!HostLittleEndian () || (Size == 1))
+   {
+      memcpy (Dest, Src, Num * Size);
+      return;
+   }
+   for (i = 0; i < Num; i++, Src += Size, Dest += Size)
+   {
+      for (b = 0; b < Size; b++)
+         Dest [b] = Src [Size - 1 - b];
+   }
+}
+
+static void CopyRun (MappedVar *Var, char *Src, long Num, long Done,
+                     void *Dest, Boolean Signed)
+{
+   Unpack (Var, (unsigned char *) Src, Num,
+           (char *) Dest + Done * Var->TypeSize);
+}
+
+static void ConvertRun (MappedVar *Var, char *Src, long Num, long Done,
+                        void *Dest, Boolean Signed)
+{
+   unsigned char  *In;
+   double         *Out;
+   union
+   {
+      unsigned char  b [8];
+      float          f;
+      double         d;
+   }        Value;
+   unsigned int    u;
+   long     i;
+   int      b, Flip;
+
+   In = (unsigned char *) Src;
+   Out = (double *) Dest + Done;
+
+   /*
+    * One loop per type (and signedness), so that the type is only
+    * looked at once per run.  Integers are put together from their
+    * big-endian bytes; floating-point values are copied into Value with
+    * their bytes reversed (b ^ Flip) if the host is little-endian.
+    */
+
+   switch (Var->Type)
+   {
+      case NC_BYTE:
+      case NC_CHAR:
+         if (Signed)
+            for (i = 0; i < Num; i++)
+               Out [i] = (double) (signed char) In [i];
+         else
+            for (i = 0; i < Num; i++)
+               Out [i] = (double) In [i];
+         break;
+      case NC_SHORT:
+         if (Signed)
+            for (i = 0; i < Num; i++, In += 2)
+               Out [i] = (double) (short) ((In [0] << 8) | In [1]);
+         else
+            for (i = 0; i < Num; i++, In += 2)
+               Out [i] = (double) ((In [0] << 8) | In [1]);
+         break;
+      case NC_LONG:
+         for (i = 0; i < Num; i++, In += 4)
+         {
+            u = ((unsigned int) In [0] << 24) | ((unsigned int) In [1] << 16) |
+                ((unsigned int) In [2] << 8) | (unsigned int) In [3];
+            Out [i] = Signed ? (double) (int) u : (double) u;
+         }
+         break;
+      case NC_FLOAT:
+         Flip = HostLittleEndian () ? 3 : 0;
+         for (i = 0; i < Num; i++, In += 4)
+         {
+            for (b = 0; b < 4; b++)
+               Value.b [b] = In [b ^ Flip];
+            Out [i] = Value.f;
+         }
+         break;
+      default:
+         Flip = HostLittleEndian () ? 7 : 0;
+         for (i = 0; i < Num; i++, In += 8)
+         {
+            for (b = 0; b < 8; b++)
+               Value.b [b] = In [b ^ Flip];
+            Out [i] = Value.d;
+         }
+         break;
+   }
+}
+
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : MappedGet
+@INPUT      : Var - set up by MapVariable
+              Start, Count - the hyperslab to read (as for ncvarget; the
+                 caller must check that it's within the variable)
+              Signed - whether integer values are signed (as given by
+                 miget_datatype)
+@OUTPUT     : Dest - the values, converted to double, with the last
+                 dimension varying fastest (like mivarget to NC_DOUBLE)
+@RETURNS    : (void)
+@DESCRIPTION:
+@METHOD     :
+@GLOBALS    :
+@CALLS      : ForEachRun, ConvertRun
+@CREATED    : 2026/10/16
+@MODIFIED   :
+---------------------------------------------------------------------------- */
+void MappedGet (MappedVar *Var, long Start[], long Count[],
+                Boolean Signed, double Dest[])
+{
+   ForEachRun (Var, Start, Count, ConvertRun, Dest, Signed);
+}
+
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : MappedGetRaw
+@INPUT      : Var - set up by MapVariable
+              Start, Count - the hyperslab to read
+@OUTPUT     : Dest - the values exactly as stored (Var->TypeSize bytes
+                 each), but in the host's byte order
+@RETURNS    : (void)
+@DESCRIPTION:
+@METHOD     : On big-endian hosts, and for byte data, this is a straight
+              copy out of the map.
+@GLOBALS    :
+@CALLS      : ForEachRun, CopyRun
+@CREATED    : 2026/10/16
+@MODIFIED   :
+---------------------------------------------------------------------------- */
+void MappedGetRaw (MappedVar *Var, long Start[], long Count[], void *Dest)
+{
+   ForEachRun (Var, Start, Count, CopyRun, Dest, FALSE);
+}
+
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : UnmapVariable
+@INPUT      : Var - set up by MapVariable
+@OUTPUT     :
+@RETURNS    : (void)
+@DESCRIPTION: Unmaps the file.
+@METHOD     :
+@GLOBALS    :
+@CALLS      : munmap
+@CREATED    : 2026/10/16
+@MODIFIED   :
+---------------------------------------------------------------------------- */
+void UnmapVariable (MappedVar *Var)
+{
+#ifndef _WIN32
+   if (Var->Base != NULL)
+      (void) munmap (Var->Base, (size_t) Var->FileSize);
+#endif
+   Var->Base = NULL;
+}
+
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : IsCompressed
+@INPUT      : Filename - the file
+@OUTPUT     :
+@RETURNS    : TRUE if the file is gzip-compressed
+@DESCRIPTION: Checks the file's magic number (rather than its name).
+@METHOD     :
+@GLOBALS    :
+@CALLS      :
+@CREATED    : 2026/10/16
+@MODIFIED   :
+---------------------------------------------------------------------------- */
+Boolean IsCompressed (char Filename[])
+{
+   FILE          *fp;
+   unsigned char  Magic [2];
+   Boolean        Compressed;
+
+   fp = fopen (Filename, "rb");
+   if (fp == NULL)
+      return (FALSE);
+   Compressed = (fread (Magic, 1, 2, fp) == 2) &&
+                (Magic [0] == 0x1f) && (Magic [1] == 0x8b);
+   fclose (fp);
+   return (Compressed);
+}
+
+
+
+#ifndef _WIN32
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : InflateTo
+@INPUT      : File - set up by OpenCompressed
+              End - offset in the uncompressed file that must be
+                    available for reading
+@OUTPUT     : File - updated
+@RETURNS    : ERR_NONE if all went well
+              ERR_IN_MINC if there was an error uncompressing (or
+                 writing the uncompressed copy); ErrMsg set
+@DESCRIPTION: Uncompresses the file as far as End (and a little beyond).
+@METHOD     : The gzip stream can only be read in order, so this just
+              carries on from wherever the last call stopped.  We always
+              read ahead by at least INFLATE_CHUNK bytes, because the
+              NetCDF library reads (and keeps) whole blocks around what
+              it's asked for: none of those blocks may include bytes
+              that haven't been written yet.
+@GLOBALS    : ErrMsg
+@CALLS      : gzread
+@CREATED    : 2026/10/16
+@MODIFIED   :
+---------------------------------------------------------------------------- */
+static int InflateTo (CompressedFile *File, long End)
+{
+   char     *Buffer;
+   long      Target;
+   int       Num;
+
+   Target = End + INFLATE_CHUNK;
+   if (Target > File->Size)
+      Target = File->Size;
+   if (File->Inflated >= Target)
+      return (ERR_NONE);
+
+   Buffer = (char *) malloc (INFLATE_CHUNK);
+   if (Buffer == NULL)
+   {
+      sprintf (ErrMsg, "Out of memory uncompressing file");
+      return (ERR_NO_MEM);
+   }
+
+   while (File->Inflated < Target)
+   {
+      Num = gzread ((gzFile) File->Stream, Buffer, INFLATE_CHUNK);
+      if (Num < 0)
+      {
+         free (Buffer);
+         sprintf (ErrMsg, "Error uncompressing file");
+         return (ERR_IN_MINC);
+      }
+      if (Num == 0)                     /* short file: nothing more to do */
+      {
+         File->Size = File->Inflated;
+         break;
+      }
+      if (pwrite (File->File, Buffer, Num, (off_t) File->Inflated) != Num)
+      {
+         free (Buffer);
+         sprintf (ErrMsg, "Error writing uncompressed file (disk full?)");
+         return (ERR_IN_MINC);
+      }
+      File->Inflated += Num;
+   }
+
+   free (Buffer);
+   return (ERR_NONE);
+}
+
+#endif
+
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : OpenCompressed
+@INPUT      : Filename - a gzip-compressed NetCDF classic (MINC 1) file
+@OUTPUT     : File - keeps track of how much of the file has been
+                 uncompressed; pass it to InflateVariable before reading
+                 anything, and to CloseCompressed when done
+              *CDF - the NetCDF ID of the (uncompressed) file
+@RETURNS    : ERR_NONE if all went well
+              ERR_IN_MINC if the file couldn't be opened
+              ERR_OTHER if it's not a compressed NetCDF classic file, or
+                 this system can't read compressed files directly
+              (ErrMsg set if not ERR_NONE)
+@DESCRIPTION: Opens a compressed file for reading, without uncompressing
+              all of it first.  Only the header is uncompressed here;
+              everything else waits until it's asked for, so the time
+              taken to read (say) the first slice of a study depends on
+              where that slice is in the file, not on the size of the
+              whole file.
+@METHOD     : The file is uncompressed in-process (with zlib) into a
+              sparse temporary file that is already its full size, so
+              the NetCDF library can be used on it as normal.  The
+              temporary file is removed as soon as it has been opened,
+              so it disappears by itself when the file is closed, and
+              only takes up as much disk space as has been read.
+@GLOBALS    : ErrMsg
+@CALLS      : gzopen, gzread, ParseHeader, InflateTo, OpenFile
+@CREATED    : 2026/10/16
+@MODIFIED   :
+---------------------------------------------------------------------------- */
+int OpenCompressed (char Filename[], CompressedFile *File, int *CDF)
+{
+#ifdef _WIN32
+   sprintf (ErrMsg, "Compressed files can't be read directly on this system");
+   return (ERR_OTHER);
+#else
+   gzFile          Stream;
+   unsigned char  *Header, *Bigger;
+   long            Length;
+   unsigned long   DataEnd;
+   char           *TmpDir;
+   char           *TempName;
+   int             Num;
+   int             Result;
+
+   File->Stream = NULL;
+   File->File = -1;
+   File->Header = NULL;
+
+   Stream = gzopen (Filename, "rb");
+   if (Stream == NULL)
+   {
+      sprintf (ErrMsg, "Error opening file %s", Filename);
+      return (ERR_IN_MINC);
+   }
+
+   /*
+    * Uncompress (into memory) until we have the whole header
+    */
+
+   Header = NULL;
+   Length = 0;
+   do
+   {
+      Bigger = (unsigned char *) realloc (Header, Length + HEADER_CHUNK);
+      if (Bigger == NULL)
+      {
+         Result = ERR_NO_MEM;
+         break;
+      }
+      Header = Bigger;
+      Num = gzread (Stream, Header + Length, HEADER_CHUNK);
+      if (Num <= 0)
+      {
+         Result = ERR_OTHER;
+         break;
+      }
+      Length += Num;
+      Result = ParseHeader (Header, Length, NULL, NULL, NULL, &DataEnd);
+   } while ((Result == ERR_BAD_MINC) && (Length < MAX_HEADER));
+
+   if (Result != ERR_NONE)
+   {
+      free (Header);
+      gzclose (Stream);
+      if (Result == ERR_NO_MEM)
+      {
+         sprintf (ErrMsg, "Out of memory uncompressing file %s", Filename);
+         return (ERR_NO_MEM);
+      }
+      sprintf (ErrMsg, "%s is not a compressed NetCDF (MINC 1) file",
+               Filename);
+      return (ERR_OTHER);
+   }
+
+   File->Stream = (void *) Stream;
+   File->Header = Header;
+   File->HeaderLength = Length;
+   File->Size = ((long) DataEnd > Length) ? (long) DataEnd : Length;
+
+   /*
+    * Make the temporary file: all of it, with what we've uncompressed
+    * so far at the start
+    */
+
+   TmpDir = getenv ("TMPDIR");
+   if ((TmpDir == NULL) || (*TmpDir == '\0'))
+      TmpDir = "/tmp";
+   TempName = (char *) malloc (strlen (TmpDir) + 16);
+   if (TempName == NULL)
+   {
+      CloseCompressed (File);
+      sprintf (ErrMsg, "Out of memory uncompressing file %s", Filename);
+      return (ERR_NO_MEM);
+   }
+   sprintf (TempName, "%s/emmaXXXXXX", TmpDir);
+
+   File->File = mkstemp (TempName);
+   if ((File->File < 0) ||
+       (write (File->File, Header, Length) != Length) ||
+       (ftruncate (File->File, (off_t) File->Size) != 0))
+   {
+      if (File->File >= 0)
+         unlink (TempName);
+      free (TempName);
+      CloseCompressed (File);
+      sprintf (ErrMsg, "Error creating temporary file to uncompress %s",
+               Filename);
+      return (ERR_OUT_TEMP);
+   }
+   File->Inflated = Length;
+
+   /*
+    * Make sure the NetCDF library's first read (of the header) can't
+    * see anything we haven't written; then open it, and let it go
+    */
+
+   Result = InflateTo (File, Length);
+   if (Result == ERR_NONE)
+      Result = OpenFile (TempName, CDF, NC_NOWRITE);
+
+   unlink (TempName);
+   free (TempName);
+   if (Result != ERR_NONE)
+      CloseCompressed (File);
+
+   return (Result);
+#endif
+}
+
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : UncompressFile
+@INPUT      : Filename - a gzip-compressed file
+@OUTPUT     : *TempName - name of a temporary file holding all of it,
+                 uncompressed (allocated with malloc; the caller must
+                 remove the file and free the name)
+@RETURNS    : ERR_NONE if all went well
+              ERR_IN_MINC if the file couldn't be read or uncompressed
+              ERR_OUT_TEMP if the temporary file couldn't be written
+              ERR_NO_MEM if out of memory
+              ERR_OTHER if this system can't uncompress files
+              (ErrMsg set if not ERR_NONE)
+@DESCRIPTION: Uncompresses a whole file, for those that OpenCompressed
+              can't handle (anything but NetCDF classic: MINC 2, ie.
+              HDF5, or 64-bit data NetCDF files).  This is what
+              openimage used to do with gunzip, but in-process.
+@METHOD     :
+@GLOBALS    : ErrMsg
+@CALLS      : gzopen, gzread
+@CREATED    : 2026/10/16
+@MODIFIED   :
+---------------------------------------------------------------------------- */
+int UncompressFile (char Filename[], char **TempName)
+{
+#ifdef _WIN32
+   sprintf (ErrMsg, "Compressed files can't be read directly on this system");
+   return (ERR_OTHER);
+#else
+   gzFile   Stream;
+   char    *TmpDir;
+   char    *Buffer;
+   int      fd, Num;
+   int      Result;
+
+   *TempName = NULL;
+   Stream = gzopen (Filename, "rb");
+   if (Stream == NULL)
+   {
+      sprintf (ErrMsg, "Error opening file %s", Filename);
+      return (ERR_IN_MINC);
+   }
+
+   TmpDir = getenv ("TMPDIR");
+   if ((TmpDir == NULL) || (*TmpDir == '\0'))
+      TmpDir = "/tmp";
+   *TempName = (char *) malloc (strlen (TmpDir) + 16);
+   Buffer = (char *) malloc (INFLATE_CHUNK);
+   if ((*TempName == NULL) || (Buffer == NULL))
+   {
+      free (*TempName);
+      free (Buffer);
+      *TempName = NULL;
+      gzclose (Stream);
+      sprintf (ErrMsg, "Out of memory uncompressing file %s", Filename);
+      return (ERR_NO_MEM);
+   }
+   sprintf (*TempName, "%s/emmaXXXXXX", TmpDir);
+
+   fd = mkstemp (*TempName);
+   Result = (fd < 0) ? ERR_OUT_TEMP : ERR_NONE;
+   while (Result == ERR_NONE)
+   {
+      Num = gzread (Stream, Buffer, INFLATE_CHUNK);
+      if (Num == 0)
+         break;
+      if (Num < 0)
+         Result = ERR_IN_MINC;
+      else if (write (fd, Buffer, Num) != Num)
+         Result = ERR_OUT_TEMP;
+   }
+
+   free (Buffer);
+   gzclose (Stream);
+   if ((fd >= 0) && (close (fd) != 0) && (Result == ERR_NONE))
+      Result = ERR_OUT_TEMP;
+
+   if (Result != ERR_NONE)
+   {
+      if (fd >= 0)
+         unlink (*TempName);
+      free (*TempName);
+      *TempName = NULL;
+      if (Result == ERR_IN_MINC)
+         sprintf (ErrMsg, "Error uncompressing file %s", Filename);
+      else
+         sprintf (ErrMsg, "Error creating temporary file to uncompress %s",
+                  Filename);
+   }
+   return (Result);
+#endif
+}
+
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : InflateVariable
+@INPUT      : File - set up by OpenCompressed
+              VarName - the variable about to be read (NULL for
+                 everything in the file)
+              Start, Count - the hyperslab about to be read (both NULL
+                 for the whole variable)
+@OUTPUT     : File - updated
+@RETURNS    : ERR_NONE if all went well
+              ERR_NO_VAR if there's no such variable
+              otherwise as for InflateTo
+              (ErrMsg set if not ERR_NONE)
+@DESCRIPTION: Uncompresses as much of the file as is needed to read a
+              hyperslab.
+@METHOD     : Only the end of the hyperslab matters, since the file can
+              only be uncompressed in order.  Record variables are
+              spread through the whole of the record section, so we
+              just uncompress to the end of the file for those.
+@GLOBALS    : ErrMsg
+@CALLS      : ParseHeader, InflateTo
+@CREATED    : 2026/10/16
+@MODIFIED   :
+---------------------------------------------------------------------------- */
+int InflateVariable (CompressedFile *File, char VarName[],
+                     long Start[], long Count[])
+{
+#ifdef _WIN32
+   return (ERR_NONE);
+#else
+   MappedVar   Var;
+   long        Last, Stride, End;
+   int         d;
+
+   if (VarName == NULL)
+      return (InflateTo (File, File->Size));
+
+   if (ParseHeader (File->Header, File->HeaderLength, VarName, &Var,
+                    NULL, NULL) != ERR_NONE)
+   {
+      sprintf (ErrMsg, "Variable %s not found", VarName);
+      return (ERR_NO_VAR);
+   }
+
+   if (Var.IsRecord)
+      return (InflateTo (File, File->Size));
+
+   /* Offset of the last value in the hyperslab */
+
+   Last = 0;
+   Stride = 1;
+   for (d = Var.NumDims - 1; d >= 0; d--)
+   {
+      if (Start == NULL)
+         Last += (Var.DimSizes [d] - 1) * Stride;
+      else if (Count [d] > 0)
+         Last += (Start [d] + Count [d] - 1) * Stride;
+      else
+         return (ERR_NONE);              /* nothing to read */
+      Stride *= Var.DimSizes [d];
+   }
+   End = Var.Offset + (Last + 1) * Var.TypeSize;
+
+   return (InflateTo (File, End));
+#endif
+}
+
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : CloseCompressed
+@INPUT      : File - set up by OpenCompressed
+@OUTPUT     :
+@RETURNS    : (void)
+@DESCRIPTION: Closes the gzip stream and the temporary file.  (The
+              NetCDF file must be closed separately, with ncclose.)
+@METHOD     :
+@GLOBALS    :
+@CALLS      : gzclose
+@CREATED    : 2026/10/16
+@MODIFIED   :
+---------------------------------------------------------------------------- */
+void CloseCompressed (CompressedFile *File)
+{
+#ifndef _WIN32
+   if (File->Stream != NULL)
+      gzclose ((gzFile) File->Stream);
+   if (File->File >= 0)
+      close (File->File);
+   free (File->Header);
+#endif
+   File->Stream = NULL;
+   File->File = -1;
+   File->Header = NULL;
+}
@@ -0,0 +1,478 @@
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : simplex.c
+@DESCRIPTION: The Nelder-Mead simplex minimiser used by nfmins and
+              delaycorrect (which used to have identical copies of it).
+              It follows MATLAB's fmins: the same starting simplex,
+              reflection/expansion/contraction/shrink steps, and
+              termination test.
+
+              The simplex lives in one contiguous block, one row per
+              vertex (the vertex followed by the function value there),
+              and is kept sorted best-first.  Since each step replaces
+              only the worst vertex, the new vertex is simply inserted
+              into place, rather than re-sorting the whole simplex; only
+              a shrink (which moves every vertex) needs a full sort.
+@GLOBALS    :
+@CREATED    : 2026/10/16 (from MinimizeSimplex and friends in nfmins.c
+              and delaycorrect.c, by Mark Wolforth)
+@MODIFIED   :
+@VERSION    : $Id$
+              $Name:  $
+---------------------------------------------------------------------------- */
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "mex.h"
+#include "emmageneral.h"
+#include "simplex.h"
+
+#define ALPHA              1
+#define BETA               0.5
+#define GAMMA              2
+
+/* Row i of the simplex, and the function value in it */
+
+#define VERTEX(s,i)        ((s)->vertices + (i) * ((s)->numvars + 1))
+#define FUNCVAL(s,i)       (VERTEX(s,i) [(s)->numvars])
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : CreateSimplex
+@INPUT      : numvars - number of variables
+              function - the function to minimise
+              data - passed to function along with each point
+              progress - TRUE to print the simplex as we go
+@OUTPUT     : *simplex - ready for StartSimplex
+@RETURNS    : (void)
+@DESCRIPTION: Allocates the simplex and its work space.  Memory is
+              allocated with mxCalloc, so doesn't need to be freed
+              before returning to MATLAB (but can be, with FreeSimplex).
+@METHOD     :
+@GLOBALS    :
+@CALLS      :
+@CREATED    : 2026/10/16
+@MODIFIED   :
+---------------------------------------------------------------------------- */
+void CreateSimplex (Simplex *simplex, int numvars,
+                    SimplexFunction function, void *data, Boolean progress)
+{
+   simplex->numvars = numvars;
+   simplex->function = function;
+   simplex->data = data;
+   simplex->progress = progress;
+
+   simplex->vertices = (double *) mxCalloc ((numvars+1) * (numvars+1),
+                                            sizeof (double));
+   simplex->work = (double *) mxCalloc (6*numvars + 1, sizeof (double));
+}
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : FreeSimplex
+@INPUT      : *simplex - set up by CreateSimplex
+@OUTPUT     :
+@RETURNS    : (void)
+@DESCRIPTION:
+@METHOD     :
+@GLOBALS    :
+@CALLS      :
+@CREATED    : 2026/10/16
+@MODIFIED   :
+---------------------------------------------------------------------------- */
+void FreeSimplex (Simplex *simplex)
+{
+   mxFree (simplex->vertices);
+   mxFree (simplex->work);
+}
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : PrintSimplex
+@INPUT      : *simplex
+@OUTPUT     :
+@RETURNS    : (void)
+@DESCRIPTION: Prints the vertices and function values.
+@METHOD     :
+@GLOBALS    :
+@CALLS      :
+@CREATED    :
+@MODIFIED   : 2026/10/16: moved to simplex.c
+---------------------------------------------------------------------------- */
+static void PrintSimplex (Simplex *simplex)
+{
+   int i,j;
+
+   mexPrintf ("Vertices:\n");
+   for (i=0; i<(simplex->numvars+1); i++)
+   {
+      for (j=0; j<simplex->numvars; j++)
+      {
+         mexPrintf ("%lf  ", VERTEX(simplex,i) [j]);
+      }
+      mexPrintf ("\n");
+   }
+
+   mexPrintf ("Function Values:\n");
+   for (i=0; i<(simplex->numvars+1); i++)
+   {
+      mexPrintf ("%lf\n", FUNCVAL(simplex,i));
+   }
+}
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : InsertVertex
+@INPUT      : *simplex - with rows 0 .. row-1 already sorted
+              row - the row to move into place
+@OUTPUT     : *simplex - with rows 0 .. row sorted
+@RETURNS    : (void)
+@DESCRIPTION: Moves one vertex up the simplex until it is after every
+              vertex with a function value no greater than its own.
+              This puts it exactly where the old bubble sort would have.
+@METHOD     :
+@GLOBALS    :
+@CALLS      :
+@CREATED    : 2026/10/16 (replaces SortSimplex)
+@MODIFIED   :
+---------------------------------------------------------------------------- */
+static void InsertVertex (Simplex *simplex, int row)
+{
+   double *temp;
+   size_t  rowsize;
+   int     pos;
+
+   for (pos = row; (pos > 0) && (FUNCVAL(simplex,pos-1) > FUNCVAL(simplex,row));
+        pos--)
+      ;
+
+   if (pos < row)
+   {
+      rowsize = (simplex->numvars+1) * sizeof (double);
+      temp = simplex->work + 5*simplex->numvars;
+      memcpy (temp, VERTEX(simplex,row), rowsize);
+      memmove (VERTEX(simplex,pos+1), VERTEX(simplex,pos), (row-pos) * rowsize);
+      memcpy (VERTEX(simplex,pos), temp, rowsize);
+   }
+}
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : SortSimplex
+@INPUT      : *simplex
+@OUTPUT     : *simplex - with vertices sorted by function value, best
+                         first
+@RETURNS    : (void)
+@DESCRIPTION: Insertion sort (stable, like the bubble sort it replaces).
+@METHOD     :
+@GLOBALS    :
+@CALLS      : InsertVertex
+@CREATED    :
+@MODIFIED   : 2026/10/16: moved to simplex.c; insertion sort
+---------------------------------------------------------------------------- */
+static void SortSimplex (Simplex *simplex)
+{
+   int i;
+
+   for (i=1; i<(simplex->numvars+1); i++)
+   {
+      InsertVertex (simplex, i);
+   }
+}
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : Evaluate
+@INPUT      : *simplex
+              x[] - point at which to evaluate the function
+@OUTPUT     :
+@RETURNS    : the function value at x
+@DESCRIPTION:
+@METHOD     :
+@GLOBALS    :
+@CALLS      : simplex->function
+@CREATED    : 2026/10/16
+@MODIFIED   :
+---------------------------------------------------------------------------- */
+static double Evaluate (Simplex *simplex, double x[])
+{
+   return ((*simplex->function) (x, simplex->data));
+}
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : StartSimplex
+@INPUT      : *simplex - set up by CreateSimplex
+              start[] - starting point
+@OUTPUT     : *simplex - the starting simplex around start[], sorted
+@RETURNS    : (void)
+@DESCRIPTION: Builds the starting simplex as fmins does: one vertex at
+              0.9*start, and one for each variable with just that
+              variable increased by 10% (or set to 0.1, if zero).
+@METHOD     :
+@GLOBALS    :
+@CALLS      : Evaluate, SortSimplex
+@CREATED    :
+@MODIFIED   : 2026/10/16: moved to simplex.c (was GetStartingSimplex)
+---------------------------------------------------------------------------- */
+void StartSimplex (Simplex *simplex, double start[])
+{
+   double *vertex;
+   int     numvars;
+   int     i;
+
+   numvars = simplex->numvars;
+
+   vertex = VERTEX(simplex,0);
+   for (i=0; i<numvars; i++)
+   {
+      vertex[i] = 0.9 * start[i];
+   }
+   vertex[numvars] = Evaluate (simplex, vertex);
+
+   for (i=1; i<(numvars+1); i++)
+   {
+      vertex = VERTEX(simplex,i);
+      memcpy (vertex, start, numvars * sizeof (double));
+      if (vertex[i-1] != 0)
+      {
+         vertex[i-1] *= 1.1;
+      }
+      else
+      {
+         vertex[i-1] = 0.1;
+      }
+      vertex[numvars] = Evaluate (simplex, vertex);
+   }
+
+   SortSimplex (simplex);
+
+   if (simplex->progress)
+   {
+      mexPrintf ("Starting simplex:\n");
+      PrintSimplex (simplex);
+   }
+}
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : Terminated
+@INPUT      : *simplex
+              tol - tolerance on the vertices
+              tol2 - tolerance on the function values
+@OUTPUT     :
+@RETURNS    : TRUE if every vertex (and its function value) is within
+              tolerance of the best one
+@DESCRIPTION:
+@METHOD     :
+@GLOBALS    :
+@CALLS      :
+@CREATED    :
+@MODIFIED   : 2026/10/16: moved to simplex.c; use fabs rather than the
+              abs macro
+---------------------------------------------------------------------------- */
+static Boolean Terminated (Simplex *simplex, double tol, double tol2)
+{
+   double *best, *vertex;
+   int     numvars;
+   int     i,j;
+
+   numvars = simplex->numvars;
+   best = VERTEX(simplex,0);
+
+   for (i=1; i<(numvars+1); i++)
+   {
+      vertex = VERTEX(simplex,i);
+      for (j=0; j<numvars; j++)
+      {
+         if (fabs (vertex[j] - best[j]) > tol)
+         {
+            return (FALSE);
+         }
+      }
+      if (fabs (vertex[numvars] - best[numvars]) > tol2)
+      {
+         return (FALSE);
+      }
+   }
+   return (TRUE);
+}
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : MinimizeSimplex
+@INPUT      : *simplex - set up by StartSimplex
+              maxiter - maximum number of function evaluations
+              tol, tol2 - termination tolerances (see Terminated)
+@OUTPUT     : minimum[] - the best vertex found
+              *finalvalue - the function value there
+@RETURNS    : the number of function evaluations
+@DESCRIPTION: Runs the simplex search until it converges or maxiter is
+              reached.
+@METHOD     :
+@GLOBALS    :
+@CALLS      : Evaluate, Terminated, InsertVertex, SortSimplex
+@CREATED    :
+@MODIFIED   : 2026/10/16: moved to simplex.c; contiguous simplex, and
+              only the new vertex is sorted into place
+---------------------------------------------------------------------------- */
+int MinimizeSimplex (Simplex *simplex, int maxiter, double tol, double tol2,
+                     double minimum[], double *finalvalue)
+{
+   char    *how;
+   int      numvars;
+   int      i,j;
+   int      count;
+   double   temp_double;
+   double  *vbar, *vr, *ve, *vt, *vc;
+   double  *vk;
+   double   fr, fe, ft, fc, fk;
+   double  *best, *worst, *vertex;
+   Boolean  shrunk;
+
+   numvars = simplex->numvars;
+   vbar = simplex->work;
+   vr = vbar + numvars;
+   ve = vr + numvars;
+   vt = ve + numvars;
+   vc = vt + numvars;
+
+   best = VERTEX(simplex,0);
+   worst = VERTEX(simplex,numvars);
+
+   count = numvars+1;
+
+   while (count < maxiter)
+   {
+      if (simplex->progress)
+      {
+         mexPrintf ("Current simplex:\n");
+         PrintSimplex (simplex);
+      }
+
+      if (Terminated (simplex, tol, tol2))
+      {
+         if (simplex->progress)
+         {
+            mexPrintf ("Terminated after %d iterations.\n", count);
+         }
+         break;
+      }
+
+      for (i=0; i<numvars; i++)
+      {
+         temp_double = 0;
+         for (j=0; j<numvars; j++)
+         {
+            temp_double += VERTEX(simplex,j) [i];
+         }
+         vbar[i] = temp_double / numvars;
+         vr[i] = ((1+ALPHA)*vbar[i]) - (ALPHA*worst[i]);
+      }
+
+      fr = Evaluate (simplex, vr);
+      count++;
+
+      vk = vr;
+      fk = fr;
+      how = "Reflect.\n";
+      shrunk = FALSE;
+
+      if (fr < FUNCVAL(simplex,numvars-1))
+      {
+         if (fr < best[numvars])
+         {
+            for (i=0; i<numvars; i++)
+            {
+               ve[i] = GAMMA*vr[i] + (1-GAMMA)*vbar[i];
+            }
+
+            fe = Evaluate (simplex, ve);
+            count++;
+
+            if (fe < best[numvars])
+            {
+               vk = ve;
+               fk = fe;
+               how = "Expand.\n";
+            }
+         }
+      }
+      else
+      {
+         memcpy (vt, worst, numvars * sizeof (double));
+         ft = worst[numvars];
+         if (fr < ft)
+         {
+            memcpy (vt, vr, numvars * sizeof (double));
+            ft = fr;
+         }
+
+         for (i=0; i<numvars; i++)
+         {
+            vc[i] = BETA*vt[i] + (1-BETA)*vbar[i];
+         }
+
+         fc = Evaluate (simplex, vc);
+         count++;
+
+         if (fc < FUNCVAL(simplex,numvars-1))
+         {
+            vk = vc;
+            fk = fc;
+            how = "Contract.\n";
+         }
+         else
+         {
+            for (i=1; i<numvars; i++)
+            {
+               vertex = VERTEX(simplex,i);
+               for (j=0; j<numvars; j++)
+               {
+                  vertex[j] = (best[j] + vertex[j])/2;
+               }
+               vertex[numvars] = Evaluate (simplex, vertex);
+            }
+            count += numvars - 1;
+
+            vk = vt;            /* vt is no longer needed */
+            for (i=0; i<numvars; i++)
+            {
+               vk[i] = (best[i] + worst[i])/2;
+            }
+            fk = Evaluate (simplex, vk);
+            count++;
+
+            how = "Shrink\n";
+            shrunk = TRUE;
+         }
+      }
+
+      memcpy (worst, vk, numvars * sizeof (double));
+      worst[numvars] = fk;
+
+      if (shrunk)
+      {
+         SortSimplex (simplex);
+      }
+      else
+      {
+         InsertVertex (simplex, numvars);
+      }
+
+      if (simplex->progress)
+      {
+         mexPrintf ("\n-----------------------\nIteration: %s", how);
+      }
+   }
+
+   if ((count >= maxiter) && simplex->progress)
+   {
+      mexPrintf ("Maximum number of iterations exceeded!\n");
+   }
+
+   memcpy (minimum, best, numvars * sizeof (double));
+   *finalvalue = best[numvars];
+
+   return (count);
+}
@@ -19,6 +19,9 @@
 @VERSION    : $Id: trapint.c,v 1.3 1997-10-20 18:30:45 greg Rel $
               $Name:  $
 ---------------------------------------------------------------------------- */
+
+#include <stddef.h>
+
 void TrapInt (int num_bins, double *times, double *values,
 	      double *area)
 {
@@ -32,3 +35,55 @@ void TrapInt (int num_bins, double *times, double *values,
 			 (times[current_bin+1]-times[current_bin]));
     }
 }
+
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : TrapCoeffs
+@INPUT      : num_bins - the number of points in times[] (and weights[])
+              times[]  - vector of points on the abscissa
+              weights[] - optional weight for each point (NULL for none)
+@OUTPUT     : coeffs[] - num_bins coefficients such that the trapezoidal
+                         integral of any values[] sampled at times[] (and
+                         multiplied point-by-point by weights[]) is
+                         simply the sum of coeffs[i]*values[i]
+@RETURNS    : (void)
+@DESCRIPTION: Turns trapezoidal integration into a dot product, so that
+              callers integrating many functions over the same times
+              (eg. every pixel of a dynamic study) can compute the
+              coefficients once and then sweep through their data in
+              whatever order suits its layout in memory.
+@METHOD     : Point i contributes to the trapezoids on either side of
+              it, each with half of that trapezoid's width, so
+              coeffs[i] = weights[i] * (times[i+1] - times[i-1]) / 2,
+              with the end points getting only their one half-width.
+@GLOBALS    : 
+@CALLS      : 
+@CREATED    : 2026/10/16
+@MODIFIED   : 
+---------------------------------------------------------------------------- */
+void TrapCoeffs (int num_bins, double *times, double *weights, 
+                 double *coeffs)
+{
+    int i;
+
+    if (num_bins < 2)
+    {
+        for (i = 0; i < num_bins; i++)
+            coeffs[i] = 0;
+        return;
+    }
+
+    coeffs[0] = (times[1] - times[0]) / 2;
+    for (i = 1; i < num_bins-1; i++)
+    {
+        coeffs[i] = (times[i+1] - times[i-1]) / 2;
+    }
+    coeffs[num_bins-1] = (times[num_bins-1] - times[num_bins-2]) / 2;
+
+    if (weights != NULL)
+    {
+        for (i = 0; i < num_bins; i++)
+            coeffs[i] *= weights[i];
+    }
+}
@@ -3,6 +3,7 @@
 #include <stdlib.h>
 #include "time_stamp.h"
 #include "minc.h"
+#include "ncmap.h"
 
 #define PROGNAME "micreate"
 
@@ -48,6 +49,8 @@ void usage (void)
               MINC routines
 @CREATED    : May 31, 1993 by MW
 @MODIFIED   : Aug 11, 1993, GPW - added provisions for no parent file.
+              Oct 16, 2026 - open the parent with miopen, so that it can
+              be a compressed file.
 ---------------------------------------------------------------------------- */
 void CreateChild (char parent_file[], char child_file[],
                   int *parent_CDF, int *child_CDF,
@@ -66,7 +69,7 @@ void CreateChild (char parent_file[], char child_file[],
 
     if (parent_file != NULL)
     {
-        *parent_CDF = ncopen (parent_file, NC_NOWRITE);
+        *parent_CDF = miopen (parent_file, NC_NOWRITE);  /* may be compressed */
 	if (*parent_CDF == MI_ERROR)
 	{
 	    fprintf (stderr, "Error opening input file : %s\n", parent_file);
@@ -82,7 +85,7 @@ void CreateChild (char parent_file[], char child_file[],
     if (*child_CDF == MI_ERROR) 
     {
         fprintf (stderr, "Error creating child file : %s\n", child_file);
-        ncclose (*parent_CDF);
+        miclose (*parent_CDF);
         exit (-1);
     }
     
@@ -217,7 +220,9 @@ void CopyVars (int parent_CDF, int child_CDF, int num_variables,
 @GLOBALS    : 
 @CALLS      : 
 @CREATED    : May 31, 1993 by MW
-@MODIFIED   :
+@MODIFIED   : Oct 16, 2026 - leave room in the header (EndDefine) before
+              copying any variables, so that adding to the header later
+              doesn't mean rewriting the whole file.
 ---------------------------------------------------------------------------- */
 
 int main (int argc, char *argv[]) 
@@ -226,6 +231,7 @@ int main (int argc, char *argv[])
     int parent_CDF, child_CDF;
     char *tm_stamp;
     int i;
+    Boolean Rewritten;
     
     tm_stamp = time_stamp (argc, argv);
 
@@ -254,6 +260,19 @@ int main (int argc, char *argv[])
 
     CreateChild (parent_file, child_file, &parent_CDF, &child_CDF, tm_stamp);
 
+    /* 
+     * Write the header now, with room to spare; CopyVars (and anyone
+     * else adding to the file later) then just uses up some of it.
+     */
+
+    if (EndDefine (child_CDF, NULL, DEFAULT_HEADER_PAD, &Rewritten) 
+	== MI_ERROR)
+    {
+	fprintf (stderr, "Error writing child file : %s\n", child_file);
+	exit (-1);
+    }
+    ncredef (child_CDF);
+
     /* Copy variables from parent to child only if a parent was given */
 
     if (parent_file != NULL)
@@ -264,7 +283,7 @@ int main (int argc, char *argv[])
 	    argv[i] = argv[i+3];
 	}
 	CopyVars (parent_CDF, child_CDF, argc-3, argv);
-	ncclose (parent_CDF);
+	miclose (parent_CDF);
     }
 
     ncclose (child_CDF);
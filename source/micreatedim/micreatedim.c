@@ -2,6 +2,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include "minc.h"
+#include "ncmap.h"
 
 #define PROGNAME "micreatedim"
 #define MINC_FILE argv[1]
@@ -22,8 +23,10 @@
               length.
 @GLOBALS    : ncopts
 @CALLS      : netCDF library
+              EndDefine
 @CREATED    : June 3, 1993 by MW
-@MODIFIED   : 
+@MODIFIED   : Oct 16, 2026 - leave define mode with EndDefine, so that
+              the file is only rewritten if the header has no room left.
 ---------------------------------------------------------------------------- */
 
 
@@ -69,6 +72,7 @@ int main (int argc, char *argv[])
     int file_CDF;
     long length;
     int status;
+    Boolean Rewritten;
 
 
     ncopts = 0;
@@ -111,6 +115,19 @@ int main (int argc, char *argv[])
 	ncclose (file_CDF);
 	exit (-1);
     }
+
+    if (EndDefine (file_CDF, MINC_FILE, DEFAULT_HEADER_PAD, &Rewritten)
+	== MI_ERROR)
+    {
+	fprintf (stderr, "Could not update MINC file.\n");
+	ncclose (file_CDF);
+	exit (-1);
+    }
+    if (Rewritten)
+    {
+	fprintf (stderr, "%s: header of %s was full -- whole file rewritten, "
+		 "with room to spare next time\n", PROGNAME, MINC_FILE);
+    }
     
     ncclose (file_CDF);
     exit(0);
@@ -25,8 +25,9 @@
 
 /*
  * Define the valid command line arguments (-size, -type, -valid_range,
- * -orientation, and -value); what type of arguments should follow them;
- * and where to put those arguments when found.
+ * -orientation, -value, -nofill, and -header_pad); what type of
+ * arguments should follow them; and where to put those arguments when
+ * found.
  */
       
      
@@ -44,6 +45,10 @@ ArgvInfo ArgTable [] =
        "orientation of the image dimensions: transverse, coronal, or sagittal"},
    {"-value", ARGV_FLOAT, (char *) 1, (char *) &gImageVal,
        "value with which to fill the image" },
+   {"-nofill", ARGV_CONSTANT, (char *) TRUE, (char *) &gNoFill,
+       "don't fill the image variable (it will all be written later)" },
+   {"-header_pad", ARGV_INT, (char *) 1, (char *) &gHeaderPad,
+       "bytes to leave free in the header, for adding attributes later" },
    {"-clobber", ARGV_CONSTANT, (char *) TRUE, (char *) &gClobberFlag,
        "overwrite child file if it already exists" },
       
@@ -163,6 +168,11 @@ Boolean GetArgs (int *pargc, char *argv[],
       ErrAbort ("-size option is required and sizes must be non-negative integers", TRUE, 1);
    }
 
+   if (gHeaderPad < 0)
+   {
+      ErrAbort ("-header_pad must be a non-negative number of bytes", TRUE, 1);
+   }
+
 #ifdef DEBUG
    printf ("GetArgs: Number of args left after parsing: %d\n", *pargc);
    for (i = 0; i <= *pargc; i++)
@@ -39,6 +39,7 @@
 #include "ParseArgv.h"
 #include "minc.h"
 #include "mincutil.h"           /* for NCErrMsg () */
+#include "ncmap.h"              /* for EndDefine () */
 #include "time_stamp.h"
 #include "micreateimage.h"
 #include "args.h"
@@ -78,6 +79,8 @@ char   *gOrientation = "transverse";
 char   *gChildFile;
 char   *gParentFile;
 double  gImageVal = DBL_MAX;
+int     gNoFill = FALSE;
+int     gHeaderPad = DEFAULT_HEADER_PAD;
 int     gClobberFlag = FALSE;
 
 /* Type strings (borrowed from Peter Neelin's mincinfo.c) */
@@ -226,6 +229,10 @@ void DumpInfo (int CDF)
               Oct 27, 1993, GPW - moved from micreate.c to micreateimage.c;
               removed copying of attributes and history update; renamed
               from CreateChild to OpenFiles.
+              Oct 16, 2026 - open the parent with miopen, so that it can
+              be a compressed file.
+              Oct 16, 2026 - create the child in no-fill mode if -nofill
+              or -value was given.
 ---------------------------------------------------------------------------- */
 Boolean OpenFiles (char parent_file[], char child_file[],
                    int *parent_CDF,    int *child_CDF)
@@ -239,7 +246,7 @@ Boolean OpenFiles (char parent_file[], char child_file[],
    
    if (parent_file != NULL)
    {
-      *parent_CDF = ncopen (parent_file, NC_NOWRITE);
+      *parent_CDF = miopen (parent_file, NC_NOWRITE);  /* may be compressed */
       if (*parent_CDF == MI_ERROR)
       {
          sprintf (ErrMsg, "Error opening input file %s: %s\n", 
@@ -267,10 +274,19 @@ Boolean OpenFiles (char parent_file[], char child_file[],
    {
       sprintf (ErrMsg, "Error creating file %s: %s\n",
                child_file, NCErrMsg (ncerr, errno));
-      ncclose (*parent_CDF);
+      miclose (*parent_CDF);
       return (FALSE);
    }
 
+   /*
+    * If the image is going to be filled with a value anyway (or the
+    * caller is going to write all of it), don't have the NetCDF library
+    * fill it too: that would write the whole file an extra time.
+    */
+
+   if (gNoFill || (gImageVal != DBL_MAX))
+      ncsetfill (*child_CDF, NC_NOFILL);
+
    /* 
     * Now just check to make sure the file exists and has non-zero size
     * (because NetCDF fails to report disk full!)
@@ -280,7 +296,7 @@ Boolean OpenFiles (char parent_file[], char child_file[],
    {
       sprintf (ErrMsg, "File %s was not created: disk may be full\n",
 	       child_file);
-      ncclose (*parent_CDF);
+      miclose (*parent_CDF);
       ncclose (*child_CDF);
       return (FALSE);
    }
@@ -289,7 +305,7 @@ Boolean OpenFiles (char parent_file[], char child_file[],
    {
       sprintf (ErrMsg, "Error creating file %s: disk may be full\n",
 	       child_file);
-      ncclose (*parent_CDF);
+      miclose (*parent_CDF);
       ncclose (*child_CDF);
       return (FALSE);
    }      
@@ -639,17 +655,20 @@ void UpdateHistory (int ChildCDF, char *TimeStamp)
               update the history line.  The child file should be in 
               definition mode when CopyOthers() is called; it will be
 	      ncendef()'d (put in update mode) before variable values are
-	      copied, and left that way on exit.
+	      copied, and left that way on exit.  (gHeaderPad bytes are
+	      left free in the header, for adding to it later.)
 @METHOD     : 
 @GLOBALS    : 
 @CALLS      : UpdateHistory
 @CREATED    : fall 1993, Greg Ward
-@MODIFIED   : 
+@MODIFIED   : Oct 16, 2026 - leave room in the header (EndDefine).
 ---------------------------------------------------------------------------- */
 Boolean CopyOthers (int ParentCDF, int ChildCDF, 
 		    int NumExclude, int Exclude[],
 		    char *TimeStamp)
 {
+   Boolean Rewritten;
+
 #ifdef DEBUG
    printf ("CopyOthers:\n");
    printf (" copying variable definitions...\n");
@@ -672,7 +691,7 @@ Boolean CopyOthers (int ParentCDF, int ChildCDF,
 #ifdef DEBUG
    printf (" ncendef'ing and copying variable values...\n");
 #endif
-   if (ncendef (ChildCDF) == MI_ERROR)
+   if (EndDefine (ChildCDF, NULL, gHeaderPad, &Rewritten) == MI_ERROR)
    {
       sprintf (ErrMsg, "Error updating file (ncendef): %s",
 	       NCErrMsg (ncerr, errno));
@@ -704,90 +723,137 @@ Boolean CopyOthers (int ParentCDF, int ChildCDF,
 @RETURNS    : TRUE if successful, FALSE on error
 @DESCRIPTION: Fills the image variable in the child file with 
               a given value.  File must be in data mode.
-@METHOD     : 
+@METHOD     : The image variable is written one image (ie. one slice of
+              one frame) at a time from a single image's worth of
+              memory, so filling even a large dynamic study takes very
+              little memory.  (The file should have been created in
+              no-fill mode, so that the NetCDF library doesn't fill it
+              first.)
 @GLOBALS    : 
 @CALLS      : 
 @CREATED    : 95/6/28, Greg Ward
-@MODIFIED   : 
+@MODIFIED   : 2026/10/16 - write one image at a time rather than the
+              whole volume at once; element counts are now long.
 ---------------------------------------------------------------------------- */
 Boolean FillImage (int CDF, int NumDim, int DimIDs[], double Value)
 {
    int   i;
    long  start[MAX_NC_DIMS], count[MAX_NC_DIMS];
-   int   image_elt = 1;		/* # elements in MIimage variable */
-   int   maxmin_elt = 1;	/* # elements in MIimage{max,min} vars */
+   long  dimlength[MAX_NC_DIMS];
+   long  image_elt = 1;		/* # elements in one image */
+   long  maxmin_elt = 1;	/* # elements in MIimage{max,min} vars */
+   long  num_images;
+   long  buf_elt, j;
    double *values;
    int   var_id;
+   Boolean success;
    
    
    /* 
-    * First compute the total number of elements in the image, and
-    * also make a count vector for passing to mivarput().
+    * First compute the size of a single image, and the number of
+    * images (which is also the size of image-max and image-min);
+    * and make start and count vectors for writing the first image.
     */
 
    for (i = 0; i < NumDim; i++)
    {
-      long   dimlength;
       char   dimname [MAX_NC_NAME];
 
-      ncdiminq (CDF, DimIDs[i], dimname, &dimlength);
-      if (dimlength > 0)
+      ncdiminq (CDF, DimIDs[i], dimname, &dimlength[i]);
+      if (dimlength[i] > 0)
       {
-	 image_elt *= dimlength;
-	 if (i < NumDim-2) maxmin_elt *= dimlength;
+	 if (i < NumDim-2)
+	 {
+	    maxmin_elt *= dimlength[i];
+	    count[i] = 1;
+	 }
+	 else
+	 {
+	    image_elt *= dimlength[i];
+	    count[i] = dimlength[i];
+	 }
 	 start[i] = 0;
-	 count[i] = dimlength;
       }
       else
       {
-	 fprintf (stderr, "Image dimension %s has length %d\n",
-		  dimname, dimlength);
+	 fprintf (stderr, "Image dimension %s has length %ld\n",
+		  dimname, dimlength[i]);
 	 return (FALSE);
       }
    }
-   assert (maxmin_elt <= image_elt);
 
    /*
-    * Now allocate and fill a big chunk of memory that will hold
-    * image_elt copies of Value.
+    * Now allocate and fill enough memory for one image (or for
+    * image-max/min, if that's bigger -- which it won't be, except
+    * for absurdly small images)
     */
 
-   values = (double *) malloc (image_elt * sizeof (double));
-   for (i = 0; i < image_elt; i++)
-      values[i] = Value;
+   buf_elt = (image_elt > maxmin_elt) ? image_elt : maxmin_elt;
+   values = (double *) malloc ((size_t) buf_elt * sizeof (double));
+   if (values == NULL)
+   {
+      fprintf (stderr, "Out of memory filling image in %s\n", gChildFile);
+      return (FALSE);
+   }
+   for (j = 0; j < buf_elt; j++)
+      values[j] = Value;
    
-   /* Put the values into the image variable in the MINC file */
+   /* 
+    * Put the values into the image variable in the MINC file, stepping
+    * through the frames and slices (with the last of the non-image
+    * dimensions varying fastest)
+    */
    
    var_id = ncvarid (CDF, MIimage);
    if (var_id == MI_ERROR)
    {
       fprintf (stderr, "Could not find image variable in %s\n", gChildFile);
+      free (values);
       return (FALSE);
    }
 
-   if (mivarput (CDF, var_id, start, count, NC_DOUBLE, NULL, values)
-       == MI_ERROR)
+   success = TRUE;
+   for (num_images = 0; num_images < maxmin_elt; num_images++)
    {
-      fprintf (stderr, "Error writing image values to %s: %s\n",
-	       gChildFile, NCErrMsg(ncerr, errno));
-      return (FALSE);
+      if (mivarput (CDF, var_id, start, count, NC_DOUBLE, NULL, values)
+	  == MI_ERROR)
+      {
+	 fprintf (stderr, "Error writing image values to %s: %s\n",
+		  gChildFile, NCErrMsg(ncerr, errno));
+	 success = FALSE;
+	 break;
+      }
+
+      for (i = NumDim-3; i >= 0; i--)
+      {
+	 if (++start[i] < dimlength[i]) break;
+	 start[i] = 0;
+      }
    }
 
    /* 
     * Now do the same for the image-max and image-min variables.
     * Since we've just filled image with a single value, we can use
-    * that same value for all elememts of image-max and image-min.
-    * In fact, since maxmin_elt has to be <= image_elt, we can 
-    * just reuse the values array that we've just created.
+    * that same value for all elememts of image-max and image-min,
+    * and write them each in one go.
     */
 
-   var_id = ncvarid (CDF, MIimagemax);
-   mivarput (CDF, var_id, start, count, NC_DOUBLE, MI_SIGNED, values);
-   var_id = ncvarid (CDF, MIimagemin);
-   mivarput (CDF, var_id, start, count, NC_DOUBLE, MI_SIGNED, values);
+   if (success)
+   {
+      for (i = 0; i < NumDim-2; i++)
+      {
+	 start[i] = 0;
+	 count[i] = dimlength[i];
+      }
+
+      var_id = ncvarid (CDF, MIimagemax);
+      mivarput (CDF, var_id, start, count, NC_DOUBLE, MI_SIGNED, values);
+      var_id = ncvarid (CDF, MIimagemin);
+      mivarput (CDF, var_id, start, count, NC_DOUBLE, MI_SIGNED, values);
+   }
 
    free (values);
-   return (TRUE);
+   return (success);
 }
 
 
@@ -888,6 +954,19 @@ int main (int argc, char *argv[])
       ERROR_CHECK
 	 (CopyOthers (ParentCDF, ChildCDF, NumExclude, Exclude, TimeStamp));
    }
+   else
+   {
+      Boolean Rewritten;
+
+      /* Leave room in the header, as CopyOthers does */
+
+      if (EndDefine (ChildCDF, NULL, gHeaderPad, &Rewritten) == MI_ERROR)
+      {
+	 sprintf (ErrMsg, "Error updating file (ncendef): %s",
+		  NCErrMsg (ncerr, errno));
+	 ErrAbort (ErrMsg, FALSE, 1);
+      }
+   }
 
    if (gImageVal != DBL_MAX)
       ERROR_CHECK (FillImage (ChildCDF, NumDim, DimIDs, gImageVal));
@@ -895,7 +974,7 @@ int main (int argc, char *argv[])
    ncclose (ChildCDF);
    if (ParentCDF != -1)
    {
-      ncclose (ParentCDF);
+      miclose (ParentCDF);
    }
    return (0);
 
@@ -46,6 +46,8 @@ extern char   *gOrientation;
 extern char   *gChildFile;
 extern char   *gParentFile;
 extern double  gImageVal;
+extern int     gNoFill;
+extern int     gHeaderPad;
 extern int     gClobberFlag;
 
 /* Function prototypes: globally needed functions defined in micreateimage.c */
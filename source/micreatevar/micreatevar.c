@@ -4,6 +4,7 @@
 #include <ctype.h>
 #include "minc.h"
 #include "emmageneral.h"
+#include "ncmap.h"
 
 #define PROGNAME "micreatevar"
 
@@ -98,8 +99,10 @@ Boolean GetDatatype (char type_name[], nc_type *datatype)
 @GLOBALS    : ncopts
 @CALLS      : MINC library
               netCDF library
+              EndDefine
 @CREATED    : June 1, 1993 by MW
-@MODIFIED   : 
+@MODIFIED   : Oct 16, 2026 - leave define mode with EndDefine, so that
+              the file is only rewritten if the header has no room left.
 ---------------------------------------------------------------------------- */
 
 void main (int argc, char *argv[])
@@ -110,6 +113,7 @@ void main (int argc, char *argv[])
     int     status;
     int     i;
     nc_type datatype;
+    Boolean Rewritten;
     
     ncopts = 0;
 
@@ -172,6 +176,19 @@ void main (int argc, char *argv[])
 	ncclose (file_CDF);
 	exit (-1);
     }
+
+    if (EndDefine (file_CDF, MINC_FILE, DEFAULT_HEADER_PAD, &Rewritten)
+	== MI_ERROR)
+    {
+	fprintf (stderr, "Unable to update MINC file.\n");
+	ncclose (file_CDF);
+	exit (-1);
+    }
+    if (Rewritten)
+    {
+	fprintf (stderr, "%s: header of %s was full -- whole file rewritten, "
+		 "with room to spare next time\n", PROGNAME, MINC_FILE);
+    }
     
     ncclose (file_CDF);
     exit (0);
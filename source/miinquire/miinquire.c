@@ -902,13 +902,24 @@ void mexFunction (int nargout, mxArray *outargs [],      /* output args */
 
    ncopts = 0;
    ErrMsg = (char *) mxCalloc (256, sizeof(char));
+
+   /* Handle '-flush' and '-cachestats' before anything else */
+
+   if (HandleCacheCommand (nargout, outargs, nargin, inargs))
+   {
+      return;
+   }
+
    if (nargin == 0) ErrAbort ("Not enough arguments", TRUE, ERR_ARGS);
 
 #if DEBUG
    printf ("Parsing the filename.\n");
 #endif
 
-   /* Parse filename and open MINC file */
+   /* 
+    * Parse filename and open MINC file (or get it from the cache -- in
+    * which case it must not be closed)
+    */
 
    if (ParseStringArg (MINC_FILE, &Filename) == NULL)
    {
@@ -919,7 +930,7 @@ void mexFunction (int nargout, mxArray *outargs [],      /* output args */
    printf ("Filename: %s\n", Filename);
 #endif
 
-   OpenFile (Filename, &CDF, NC_NOWRITE);
+   CacheOpenFile (Filename, &CDF);
    if (CDF == MI_ERROR)
    {
       ErrAbort (ErrMsg, TRUE, ERR_IN_MINC );
@@ -940,7 +951,6 @@ void mexFunction (int nargout, mxArray *outargs [],      /* output args */
       Result = GeneralInfo (CDF, &NUM_DIMS, &NUM_GATTS, &NUM_VARS);
       if (Result < 0)
       {
-         ncclose (CDF);
          ErrAbort (ErrMsg, TRUE, Result);
       }
       return;
@@ -972,7 +982,6 @@ void mexFunction (int nargout, mxArray *outargs [],      /* output args */
 #if 1+1==3
       if (cur_outarg >= nargout)                /* eg. if cur_outarg==0 we must have >= 1 output arg */
       {
-         ncclose (CDF);
          ErrAbort ("Not enough output arguments", TRUE, ERR_ARGS);
       }
 #endif
@@ -984,7 +993,6 @@ void mexFunction (int nargout, mxArray *outargs [],      /* output args */
 #endif
       if (ParseStringArg (inargs[cur_inarg], &Option) == NULL)
       {
-         ncclose (CDF);
          ErrAbort ("Option argument must be a string", TRUE, ERR_ARGS);
       }
 #if DEBUG
@@ -1041,7 +1049,6 @@ void mexFunction (int nargout, mxArray *outargs [],      /* output args */
       }
       else
       {
-         ncclose (CDF);
          sprintf (ErrMsg, "Unknown option: %s", Option);
          ErrAbort (ErrMsg, TRUE, ERR_ARGS);
       }
@@ -1049,12 +1056,9 @@ void mexFunction (int nargout, mxArray *outargs [],      /* output args */
       /* If ANY of the option-based calls above resulted in an error, BOMB! */
       if (Result != ERR_NONE)
       {
-         ncclose (CDF);
          ErrAbort (ErrMsg, TRUE, Result);
       }
       
    }
 
-   ncclose (CDF);
-
 }
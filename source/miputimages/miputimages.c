@@ -0,0 +1,460 @@
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : miputimages (CMEX)
+@INPUT      :
+@OUTPUT     :
+@RETURNS    :
+@DESCRIPTION: CMEX routine to write images from a MATLAB matrix straight
+              into a MINC file.  This is the in-process counterpart of
+              the standalone miwriteimages: rather than having MATLAB
+              dump the images to a temporary file and then shelling out
+              to miwriteimages to read them back in, the images are
+              written directly from the MATLAB matrix.  See
+              miwriteimages.m for details.
+@METHOD     :
+@GLOBALS    :
+@CALLS      :
+@CREATED    : 2026/10/16, by analogy with mireadimages.c and the
+              standalone miwriteimages.c
+@MODIFIED   :
+@COMMENTS   : For full usage documentation, see miwriteimages.m
+@VERSION    : $Id$
+              $Name:  $
+---------------------------------------------------------------------------- */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <float.h>
+#include <errno.h>
+#include "mex.h"
+#include "minc.h"
+#include "mierrors.h"
+#include "mexutils.h"         /* N.B. must link in mexutils.o */
+#include "mincutil.h"
+
+#define PROGNAME "miputimages"
+
+/*
+ * Constants to check for argument number and position
+ */
+
+#define MIN_IN_ARGS        2
+#define MAX_IN_ARGS        4
+
+/* ...POS macros: 1-based, used to determine if input args are present */
+
+#define SLICES_POS         3
+#define FRAMES_POS         4
+
+/*
+ * Macros to access the input arguments from MATLAB
+ * (N.B. these only work in mexFunction())
+ */
+
+#define MINC_FILENAME  prhs[0]
+#define VECTOR_IMAGES  prhs[1]                  /* images to write: one */
+                                                /* per column */
+#define SLICES         prhs[SLICES_POS-1]       /* slices to write - vector */
+#define FRAMES         prhs[FRAMES_POS-1]       /* ditto for frames */
+
+char       *ErrMsg ;             /* set as close to the occurence of the
+                                    error as possible; displayed by whatever
+                                    code exits */
+
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : ErrAbort
+@INPUT      : msg - character to string to print just before aborting
+              PrintUsage - whether or not to print a usage summary before
+                aborting
+              ExitCode - one of the standard codes from mierrors.h -- NOTE!
+                this parameter is NOT currently used, but I've included it for
+                consistency with other functions named ErrAbort in other
+                programs
+@OUTPUT     : none - function does not return!!!
+@RETURNS    :
+@DESCRIPTION: Optionally prints a usage summary, and calls mexErrMsgTxt with
+              the supplied msg, which ABORTS the mex-file!!!
+@METHOD     :
+@GLOBALS    : requires PROGNAME macro
+@CALLS      : standard mex functions
+@CREATED    : 2026/10/16 (copied from mireadimages.c)
+@MODIFIED   :
+---------------------------------------------------------------------------- */
+void ErrAbort (char msg[], Boolean PrintUsage, int ExitCode)
+{
+   if (PrintUsage)
+   {
+      (void) mexPrintf ("Usage: %s ('MINC_file', images [, slices", PROGNAME);
+      (void) mexPrintf (" [, frames]])\n");
+   }
+   (void) mexErrMsgTxt (msg);
+}
+
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : CheckBounds
+@INPUT      : Slices[], Frames[] - lists of desired slices/frames
+              NumSlices, NumFrames - number of elements used in each array
+              Image - pointer to struct describing the image:
+                # of frames/slices, etc.
+@OUTPUT     :
+@RETURNS    : FALSE if any member of Slices[] or Frames[] is out-of-bounds,
+                or if both multiple slices and multiple frames are given
+              TRUE otherwise
+@DESCRIPTION: Ensures that no slice or frame number is out of bounds (i.e.
+              less than zero, or greater than or equal to the number of
+	      slices/frames: note zero-based!).  The caller should already
+              have zeroed NumSlices (NumFrames) if the file has no
+              slice (frame) dimension.
+@METHOD     :
+@GLOBALS    : ErrMsg
+@CALLS      :
+@CREATED    : 2026/10/16 (adapted from miwriteimages.c)
+@MODIFIED   :
+---------------------------------------------------------------------------- */
+Boolean CheckBounds (long Slices[], long Frames[],
+		     long NumSlices, long NumFrames,
+		     ImageInfoRec *Image)
+{
+   int   i;
+
+   if ((NumSlices > 1) && (NumFrames > 1))
+   {
+      strcpy (ErrMsg, "Cannot write both multiple slices and multiple frames");
+      return (FALSE);
+   }
+
+   for (i = 0; i < NumSlices; i++)
+   {
+      if ((Slices [i] >= Image->Slices) || (Slices [i] < 0))
+      {
+         sprintf (ErrMsg, "Bad slice number: %ld (must be < %ld)",
+                  Slices[i], Image->Slices);
+         return (FALSE);
+      }
+   }     /* for i - loop slices */
+
+   for (i = 0; i < NumFrames; i++)
+   {
+      if ((Frames [i] >= Image->Frames) || (Frames [i] < 0))
+      {
+         sprintf (ErrMsg, "Bad frame number: %ld (must be < %ld)",
+                  Frames[i], Image->Frames);
+         return (FALSE);
+      }
+   }     /* for i - loop frames */
+
+   return (TRUE);
+}     /* CheckBounds */
+
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : WriteImages
+@INPUT      : Image - where the images are going
+              Slices - vector containing list of slices to write
+              Frames - vector containing list of frames to write
+              NumSlices - the number of elements of Slices[] actually used
+              NumFrames - the number of elements of Frames[] actually used
+              VectorImages - the images themselves, one after the other
+                (ie. the real part of the MATLAB matrix passed in)
+@OUTPUT     :
+@RETURNS    : ERR_NONE if all went well
+              ERR_OUT_MINC if some problem writing to MINC file
+                (this should not happen!!!)
+              also sets ErrMsg in the event of an error
+@DESCRIPTION: Writes images from VectorImages into the
+              image variable specified by *Image at the slice/frame
+              locations specified by Slices[] and Frames[].  This is
+              the same as WriteImages in miwriteimages.c, except that
+              the images come straight from memory rather than from a
+              temporary file, so there is no intermediate buffer.
+@METHOD     : The max and min of every image are found first, and put
+              in the file all at once by PutMaxMins.  Then each run of
+              consecutive frames (or of consecutive slices, if there is
+              just one frame) is written with one call to miicv_put,
+              since the images of a run are already one after the other
+              in VectorImages.
+@GLOBALS    : ErrMsg
+@CALLS      : FindMaxMin, PutMaxMins, RunLength, MINC library
+@CREATED    : 2026/10/16 (adapted from miwriteimages.c)
+@MODIFIED   : 2026/10/16 - write runs of images with one hyperslab
+---------------------------------------------------------------------------- */
+int WriteImages (ImageInfoRec *Image,
+                 long Slices[],
+                 long Frames[],
+                 long NumSlices,
+                 long NumFrames,
+                 double *VectorImages)
+{
+   long     slice, frame;
+   long     SliceRun, FrameRun;
+   long     Start [MAX_NC_DIMS], Count [MAX_NC_DIMS];
+   Boolean  DoFrames;
+   Boolean  DoSlices;
+   int      RetVal;
+   double  *Max, *Min;
+   long     i;
+
+   /*
+    * Always write an *entire* image (or several, one after the other).
+    */
+
+   Start [Image->HeightDim] = 0; Count [Image->HeightDim] = Image->Height;
+   Start [Image->WidthDim] = 0;  Count [Image->WidthDim] = Image->Width;
+
+   /*
+    * Handle files with missing frames or slices.  See the function
+    * ReadImages in the file mireadimages.c for a detailed explanation.
+    */
+
+   if (NumFrames > 0)
+   {
+      Count [Image->FrameDim] = 1;
+      DoFrames = TRUE;
+   }
+   else
+   {
+      DoFrames = FALSE;
+      NumFrames = 1;
+   }
+
+   if (NumSlices > 0)
+   {
+      Count [Image->SliceDim] = 1;
+      DoSlices = TRUE;
+   }
+   else
+   {
+      DoSlices = FALSE;
+      NumSlices = 1;
+   }
+
+   /*
+    * The image-max and image-min have to be in the file before the
+    * images are (the ICV scales each image by them), so find them all
+    * first and put them all at once.
+    */
+
+   Max = (double *) mxCalloc (2 * NumSlices * NumFrames, sizeof (double));
+   Min = Max + NumSlices * NumFrames;
+   for (i = 0; i < NumSlices * NumFrames; i++)
+   {
+      FindMaxMin (VectorImages + i * Image->ImageSize, Image->ImageSize,
+                  &Max [i], &Min [i]);
+   }
+   PutMaxMins (Image, Slices, Frames,
+               DoSlices ? NumSlices : 0, DoFrames ? NumFrames : 0, Max, Min);
+   mxFree (Max);
+
+   for (slice = 0; slice < NumSlices; slice += SliceRun)
+   {
+      SliceRun = 1;
+      if (DoSlices)
+      {
+         if (NumFrames == 1)
+            SliceRun = RunLength (Slices, NumSlices, slice);
+         Start [Image->SliceDim] = Slices [slice];
+         Count [Image->SliceDim] = SliceRun;
+      }
+
+      for (frame = 0; frame < NumFrames; frame += FrameRun)
+      {
+         FrameRun = 1;
+         if (DoFrames)
+         {
+            FrameRun = RunLength (Frames, NumFrames, frame);
+            Start [Image->FrameDim] = Frames [frame];
+            Count [Image->FrameDim] = FrameRun;
+         }
+
+         RetVal = miicv_put (Image->ICV, Start, Count, VectorImages);
+         if (RetVal == MI_ERROR)
+         {
+            sprintf (ErrMsg, "INTERNAL BUG: Fail on miicv_put: Error code %d",
+                     ncerr);
+            return (ERR_OUT_MINC);
+         }
+
+         VectorImages += SliceRun * FrameRun * Image->ImageSize;
+
+      }     /* for frame */
+   }     /* for slice */
+
+   /*
+    * Use the MIcomplete attribute to signal that we are done writing
+    */
+
+   miattputstr (Image->CDF, Image->ID, MIcomplete, MI_TRUE);
+   return (ERR_NONE);
+
+}     /* WriteImages */
+
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : GetList
+@INPUT      : Mlist - MATLAB vector of zero-based slice or frame numbers
+              DimPresent - whether the corresponding dimension exists
+              Descr - "slice" or "frame", for error messages
+@OUTPUT     : *List - the numbers, converted to longs (allocated
+                      here with mxCalloc, as long as Mlist -- there is
+                      no limit on how many slices or frames are written)
+@RETURNS    : number of elements in *List (zero if the dimension is
+              absent from the file); does not return on error
+@DESCRIPTION: Parses the slice or frame list, and checks that it agrees
+              with the file: a list must be given for a dimension that
+              is present, and one given for an absent dimension is
+              ignored with a warning.
+@METHOD     :
+@GLOBALS    : ErrMsg
+@CALLS      : ParseIntArg
+@CREATED    : 2026/10/16
+@MODIFIED   : 2026/10/16: list allocated to fit, rather than limited to
+                          1024 elements
+---------------------------------------------------------------------------- */
+long GetList (const mxArray *Mlist, Boolean DimPresent, char *Descr,
+              long **List, ImageInfoRec *Image)
+{
+   long     Num;
+
+   /* (always at least one element, so that *List is never NULL) */
+
+   Num = (Mlist == NULL) ? 0 : (long) (mxGetM(Mlist) * mxGetN(Mlist));
+   *List = (long *) mxCalloc (max (Num, 1), sizeof (long));
+
+   if (Num == 0)
+   {
+      if (DimPresent)
+      {
+         CloseImage (Image);
+         sprintf (ErrMsg, "File contains %s dimension; "
+                  "%s list must be provided", Descr, Descr);
+         ErrAbort (ErrMsg, TRUE, ERR_ARGS);
+      }
+      return (0);
+   }
+
+   Num = ParseIntArg (Mlist, Num, *List);
+   if (Num < 0)
+   {
+      CloseImage (Image);
+      sprintf (ErrMsg, "%s vector bad format: must be numeric "
+               "and one-dimensional", Descr);
+      ErrAbort (ErrMsg, TRUE, ERR_ARGS);
+   }
+
+   if (!DimPresent && (Num > 0))
+   {
+      mexPrintf ("Warning: file has no %s dimension; supplied %s "
+                 "list will be ignored\n", Descr, Descr);
+      Num = 0;
+   }
+
+   return (Num);
+}     /* GetList */
+
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : mexFunction
+@INPUT      : nlhs, nrhs - number of output/input arguments (from MATLAB)
+              prhs - actual input arguments
+@OUTPUT     : plhs - actual output arguments (none)
+@RETURNS    : (void)
+@DESCRIPTION:
+@METHOD     :
+@GLOBALS    : ErrMsg
+@CALLS      :
+@CREATED    : 2026/10/16 (main() of miwriteimages.c turned CMEX)
+@MODIFIED   :
+---------------------------------------------------------------------------- */
+void mexFunction(int    nlhs,
+                 mxArray *plhs[],
+                 int    nrhs,
+                 const mxArray *prhs[])
+{
+   char        *Filename;
+   ImageInfoRec ImInfo;
+   long        *Slice;
+   long        *Frame;
+   long         NumSlices;
+   long         NumFrames;
+   long         NumImages;
+   int          Result;
+
+   ncopts = 0;
+   ErrMsg = (char *) mxCalloc (256, sizeof (char));
+
+   if ((nrhs < MIN_IN_ARGS) || (nrhs > MAX_IN_ARGS))
+   {
+      ErrAbort ("Incorrect number of arguments", TRUE, ERR_ARGS);
+   }
+
+   if (ParseStringArg (MINC_FILENAME, &Filename) == NULL)
+   {
+      ErrAbort ("Error in filename", TRUE, ERR_ARGS);
+   }
+
+   if (!mxIsDouble (VECTOR_IMAGES) || mxIsComplex (VECTOR_IMAGES) ||
+       mxIsSparse (VECTOR_IMAGES))
+   {
+      ErrAbort ("Images must be a full, real matrix of doubles",
+                TRUE, ERR_ARGS);
+   }
+
+   Result = OpenImage (Filename, &ImInfo, NC_WRITE, CreateNaN());
+   if (Result != ERR_NONE)
+   {
+      ErrAbort (ErrMsg, TRUE, Result);
+   }
+
+   if ((ImInfo.MaxID == MI_ERROR) || (ImInfo.MinID == MI_ERROR))
+   {
+      CloseImage (&ImInfo);
+      sprintf (ErrMsg, "Missing image-max or image-min variable in file %s",
+               Filename);
+      ErrAbort (ErrMsg, TRUE, ERR_IN_MINC);
+   }
+
+   NumSlices = GetList ((nrhs >= SLICES_POS) ? SLICES : NULL,
+                        ImInfo.SliceDim != -1, "slice", &Slice, &ImInfo);
+   NumFrames = GetList ((nrhs >= FRAMES_POS) ? FRAMES : NULL,
+                        ImInfo.FrameDim != -1, "frame", &Frame, &ImInfo);
+
+   if (!CheckBounds (Slice, Frame, NumSlices, NumFrames, &ImInfo))
+   {
+      CloseImage (&ImInfo);
+      ErrAbort (ErrMsg, TRUE, ERR_ARGS);
+   }
+
+   /*
+    * The images matrix must have one whole image per column, and
+    * one column for every slice/frame given.
+    */
+
+   NumImages = max (NumSlices, 1) * max (NumFrames, 1);
+   if (((long) mxGetM (VECTOR_IMAGES) != ImInfo.ImageSize) ||
+       ((long) mxGetN (VECTOR_IMAGES) != NumImages))
+   {
+      CloseImage (&ImInfo);
+      sprintf (ErrMsg, "Images matrix must be %ld x %ld (it is %ld x %ld)",
+               ImInfo.ImageSize, NumImages,
+               (long) mxGetM (VECTOR_IMAGES), (long) mxGetN (VECTOR_IMAGES));
+      ErrAbort (ErrMsg, TRUE, ERR_ARGS);
+   }
+
+   Result = WriteImages (&ImInfo, Slice, Frame, NumSlices, NumFrames,
+                         mxGetPr (VECTOR_IMAGES));
+   if (Result != ERR_NONE)
+   {
+      CloseImage (&ImInfo);
+      ErrAbort (ErrMsg, TRUE, Result);
+   }
+
+   CloseImage (&ImInfo);
+
+}     /* mexFunction */
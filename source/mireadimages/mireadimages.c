@@ -32,6 +32,12 @@
 #include "mierrors.h"         /* mine and Mark's */
 #include "mexutils.h"         /* N.B. must link in mexutils.o */
 #include "mincutil.h"
+#include "ncmap.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 #define TRUE 1
 #define FALSE 0
@@ -50,7 +56,7 @@ double  NaN;                    /* NaN in native C format */
 
 
 #define MIN_IN_ARGS        1
-#define MAX_IN_ARGS        6
+#define MAX_IN_ARGS        6    /* not counting the precision string */
 
 /* ...POS macros: 1-based, used to determine if input args are present */
 
@@ -72,9 +78,17 @@ double  NaN;                    /* NaN in native C format */
 #define NUM_ROWS       prhs[NUM_ROWS_POS-1]
 #define OLD_MEMORY     prhs[OLD_MEMORY_POS-1]   /* old memory space to re-use */
 #define VECTOR_IMAGES  plhs[0]                  /* array of images: one per columns */
+#define SCALE          plhs[1]                  /* raw -> real scale and */
+#define OFFSET         plhs[2]                  /* offset, one per column */
 
-#define MAX_READABLE   1024           /* max number of slices or frames that
-                                        can be read at a time */
+/*
+ * Possible values of the optional precision argument (always the last
+ * argument, if given)
+ */
+
+#define PREC_DOUBLE        0    /* 'double': real values (the default) */
+#define PREC_SINGLE        1    /* 'single': real values, as floats */
+#define PREC_RAW           2    /* 'raw': values as stored in the file */
 
 /*
  * Global variables (with apologies).  Interesting note:  when ErrMsg is
@@ -113,7 +127,8 @@ void ErrAbort (char msg[], Boolean PrintUsage, int ExitCode)
    if (PrintUsage)
    {
       (void) mexPrintf ("Usage: %s ('MINC_file' [, slices", PROGNAME);
-      (void) mexPrintf (" [, frames [, old_matrix [, start_row [, num_rows]]]]])\n");
+      (void) mexPrintf (" [, frames [, old_matrix [, start_row [, num_rows]]]]]");
+      (void) mexPrintf (" [, 'double'|'single'|'raw'] [, 'prefetch', next_slices])\n");
    }
    (void) mexErrMsgTxt (msg);
 }
@@ -137,7 +152,8 @@ void ErrAbort (char msg[], Boolean PrintUsage, int ExitCode)
 @GLOBALS    : ErrMsg
 @CALLS      : 
 @CREATED    : 
-@MODIFIED   : 
+@MODIFIED   : 2026/10/16: multiple slices *and* multiple frames are now
+              allowed (all frames of all slices are read)
 ---------------------------------------------------------------------------- */
 Boolean CheckBounds (long Slices[], long Frames[],
                      long NumSlices, long NumFrames,
@@ -153,12 +169,6 @@ Boolean CheckBounds (long Slices[], long Frames[],
            Image->Slices, Image->Frames);
 #endif
 
-   if ((NumSlices > 1) && (NumFrames > 1))
-   {
-      strcpy (ErrMsg, "Cannot read both multiple slices and multiple frames");
-      return (FALSE);
-   }
-
    for (i = 0; i < NumSlices; i++)
    {
       if ((Slices [i] >= Image->Slices) || (Slices [i] < 0))
@@ -209,9 +219,85 @@ Boolean CheckBounds (long Slices[], long Frames[],
 
 
 
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : TransposeImages
+@INPUT      : Images - buffer holding Rows*Cols images of Size bytes
+                each, stored as a Rows x Cols array of images with the
+                column index varying fastest
+              Size - number of bytes per image
+              Rows, Cols - dimensions of the array of images
+@OUTPUT     : Images - the same images, rearranged so that the row
+                index varies fastest
+@RETURNS    : ERR_NONE if all went well
+              ERR_NO_MEM if we couldn't allocate the (small) work space
+@DESCRIPTION: Transposes an array of images in place, moving whole
+              images around.  Used by ReadImages to turn a hyperslab
+              read in frame-major order (as it is stored in most
+              dynamic MINC files) into the slice-major column order
+              that mireadimages returns, without needing a second
+              image buffer.
+@METHOD     : Follows the cycles of the permutation, using one image's
+              worth of temporary storage and one flag per image to
+              mark images that have already been moved.
+@GLOBALS    : ErrMsg
+@CALLS      : 
+@CREATED    : 2026/10/16
+@MODIFIED   : 2026/10/16: works in bytes, so any type of image will do
+---------------------------------------------------------------------------- */
+int TransposeImages (char *Images, long Size, long Rows, long Cols)
+{
+   long     NumImages;
+   long     first, cur, src;
+   char     *Moved;
+   char     *Temp;
+
+   NumImages = Rows * Cols;
+   Moved = (char *) mxCalloc (NumImages, sizeof (char));
+   Temp = (char *) mxCalloc (Size, sizeof (char));
+   if ((Moved == NULL) || (Temp == NULL))
+   {
+      sprintf (ErrMsg, "Error allocating work space to reorder images");
+      return (ERR_NO_MEM);
+   }
+
+   for (first = 0; first < NumImages; first++)
+   {
+      if (Moved [first])
+         continue;
+
+      /*
+       * The image that belongs at position cur = c*Rows + r is the one
+       * currently at position r*Cols + c.  Walk the cycle starting at
+       * first, pulling each image into place.
+       */
+
+      memcpy (Temp, Images + first*Size, Size);
+      cur = first;
+      for (;;)
+      {
+         Moved [cur] = TRUE;
+         src = (cur % Rows) * Cols + (cur / Rows);
+         if (src == first)
+            break;
+         memcpy (Images + cur*Size, Images + src*Size, Size);
+         cur = src;
+      }
+      memcpy (Images + cur*Size, Temp, Size);
+   }
+
+   mxFree (Temp);
+   mxFree (Moved);
+   return (ERR_NONE);
+}     /* TransposeImages */
+
+
+
 /* ----------------------------- MNI Header -----------------------------------
 @NAME       : ReadImages
-@INPUT      : *Image - struct describing the image
+@INPUT      : *Image - struct describing the image; Image->ICV must
+                 convert to the type implied by Class
+              Class - MATLAB class of the matrix to create (only used
+                 if *Mimages is NULL)
               Slices[] - vector of zero-based slice numbers to read
               Frames[] - vector of zero-based frame numbers to read
               NumSlices - number of elements in Slices[]
@@ -242,7 +328,20 @@ Boolean CheckBounds (long Slices[], long Frames[],
               is missing from the MINC file, NumSlices or NumFrames
               (whichever applies, possibly both) should be zero.  ReadImages
               will read the "only" slice/frame in the file then.
-@METHOD     : 
+@METHOD     : Runs of consecutive frames (and, when the file layout
+              allows it, of consecutive slices) are read with a single
+              miicv_get each, rather than one call per image.  The runs
+              are chosen so that every hyperslab lands in a contiguous
+              block of columns of the output matrix: a run of frames
+              always does (each slice's frames are adjacent columns),
+              and a run of slices does when all the requested frames
+              form a single run and the slice dimension varies more
+              slowly than time in the file (or there is only one frame).
+              Finally, if the slices and the frames each form a single
+              run but time varies more slowly than the slices (the
+              usual case for dynamic files), the whole lot is read
+              with one miicv_get and then rearranged in place with
+              TransposeImages.
 @GLOBALS    : ErrMsg
 @CALLS      : standard library, MINC functions
 @CREATED    : 93-6-6, Greg Ward
@@ -252,9 +351,15 @@ Boolean CheckBounds (long Slices[], long Frames[],
                       -Removed the non functional code that mapped out
                        of range values to NaN.  This is superseded
                        by changes to the library.
+              2026/10/16: read contiguous runs of slices/frames as
+                       single hyperslabs; allow multiple slices and
+                       multiple frames in one call
+              2026/10/16: added Class, so that images can be read as
+                       single or in their stored type
 @COMMENTS   : 
 ---------------------------------------------------------------------------- */
 int ReadImages (ImageInfoRec *Image,
+                mxClassID Class,
                 long    Slices [],
                 long    Frames [],
                 long    NumSlices,
@@ -264,20 +369,24 @@ int ReadImages (ImageInfoRec *Image,
                 mxArray  **Mimages)
 {
    long     slice, frame;
+   long     SliceRun, FrameRun; /* number of slices/frames read at once */
+   Boolean  SliceRuns;          /* can we read runs of several slices? */
    long     Start [MAX_NC_DIMS], Count [MAX_NC_DIMS];
-   long     Size;               /* the number of doubles per image (taking
+   long     Size;               /* the number of values per image (taking
                                    NumRows into account!) */
-   double   *VectorImages;
+   long     ImageBytes;         /* and the number of bytes */
+   char     *VectorImages;
    Boolean  DoFrames;           /* false if NumFrames (NumSlices) == 0, so we*/
    Boolean  DoSlices;           /* know to not set a frame (slice) number */
    int      RetVal;             /* from miicv_get -- if this is MI_ERROR */
                                 /* we have a problem!!  Should NOT!!! happen */
    /*
-    * Setup start/count vectors.  We will always read from one image at
-    * a time, because the user is allowed to specify slices/frames such
-    * that non-contiguous images are read.  However, the image rows read
-    * are always contiguous, so we'll set the Height elements of Start/
-    * Count just once -- right here -- and leave them alone in the loops.
+    * Setup start/count vectors.  The user is allowed to specify
+    * slices/frames such that non-contiguous images are read, so the
+    * slice/frame elements of Start/Count are set per run in the loops
+    * below.  However, the image rows read are always contiguous, so
+    * we'll set the Height elements of Start/Count just once -- right
+    * here -- and leave them alone in the loops.
     */
 
    Start [Image->HeightDim] = StartRow;
@@ -349,7 +458,8 @@ int ReadImages (ImageInfoRec *Image,
        printf ("Allocating new memory for return value.\n");
 #endif
 
-       *Mimages = mxCreateDoubleMatrix(Size, NumSlices*NumFrames, mxREAL);
+       *Mimages = mxCreateNumericMatrix (Size, NumSlices*NumFrames, 
+                                         Class, mxREAL);
        if (*Mimages == NULL)
        {
            sprintf (ErrMsg, "Error allocating %ld x %ld image matrix!\n", 
@@ -363,7 +473,8 @@ int ReadImages (ImageInfoRec *Image,
     * that it points at.
     */
    
-   VectorImages = mxGetPr (*Mimages);
+   VectorImages = (char *) mxGetData (*Mimages);
+   ImageBytes = Size * mxGetElementSize (*Mimages);
 
 
 #ifdef DEBUG
@@ -372,28 +483,81 @@ int ReadImages (ImageInfoRec *Image,
 #endif
 
    /*
-    * Now loop through slices and frames to read in the images, one at a time.
+    * Decide whether runs of slices can be read together: the images
+    * for several slices must come back from the file in the same order
+    * as the columns of the output matrix (slice-major).
     */
 
-   for (slice = 0; slice < NumSlices; slice++)
+   SliceRuns = DoSlices &&
+               (RunLength (Frames, NumFrames, 0) == NumFrames) &&
+               (!DoFrames || (NumFrames == 1) ||
+                (Image->SliceDim < Image->FrameDim));
+
+   /*
+    * If that fails only because time varies more slowly than slices in
+    * the file, we can still read everything in one go if the slices
+    * are a single run too -- we just have to transpose the images once
+    * they're in memory.
+    */
+
+   if (DoSlices && DoFrames && !SliceRuns &&
+       (NumSlices > 1) && (NumFrames > 1) &&
+       (RunLength (Slices, NumSlices, 0) == NumSlices) &&
+       (RunLength (Frames, NumFrames, 0) == NumFrames))
+   {
+      Start [Image->SliceDim] = Slices [0];
+      Count [Image->SliceDim] = NumSlices;
+      Start [Image->FrameDim] = Frames [0];
+      Count [Image->FrameDim] = NumFrames;
+
+#ifdef DEBUG
+      printf ("Reading all %ld images at once, then transposing\n",
+              NumSlices*NumFrames);
+#endif
+      RetVal = miicv_get (Image->ICV, Start, Count, VectorImages);
+      if (RetVal == MI_ERROR)
+      {
+         sprintf (ErrMsg, "!! BOMB !! error code %d (%s) set by miicv_get",
+                  ncerr, NCErrMsg (ncerr, errno));
+         return (ERR_IN_MINC);
+      }
+
+      return (TransposeImages (VectorImages, ImageBytes, NumFrames, NumSlices));
+   }
+
+   /*
+    * Now loop through slices and frames to read in the images, one run
+    * of slices and one run of frames at a time.
+    */
+
+   for (slice = 0; slice < NumSlices; slice += SliceRun)
    {  
-      /* Set the slice for all frames read in this slice */
+      /* Set the slice(s) for all frames read in this run of slices */
 
+      SliceRun = 1;
       if (DoSlices)
       {
+         if (SliceRuns)
+         {
+            SliceRun = RunLength (Slices, NumSlices, slice);
+         }
          Start [Image->SliceDim] = Slices [slice];
+         Count [Image->SliceDim] = SliceRun;
       }
 
-      for (frame = 0L; frame < NumFrames; frame++)
+      for (frame = 0L; frame < NumFrames; frame += FrameRun)
       {
-         /* Set the frame for this one image only */
+         /* Set the frame(s) for this run of images only */
 
+         FrameRun = 1;
          if (DoFrames)
          {
+            FrameRun = RunLength (Frames, NumFrames, frame);
             Start [Image->FrameDim] = Frames [frame];
+            Count [Image->FrameDim] = FrameRun;
          }
 
-         /* Now read the image */
+         /* Now read the images */
 
 #ifdef DEBUG
          printf ("Start: %ld %ld %ld %ld;  Count: %ld %ld %ld %ld\n",
@@ -408,7 +572,7 @@ int ReadImages (ImageInfoRec *Image,
             return (ERR_IN_MINC);
          }
 
-         VectorImages += Size;
+         VectorImages += ImageBytes * SliceRun * FrameRun;
 
       }     /* for frame */
 
@@ -419,7 +583,7 @@ int ReadImages (ImageInfoRec *Image,
     */
 
 #ifdef DEBUG
-   printf ("Total number of doubles: %ld\n", 
+   printf ("Total number of values: %ld\n", 
 	   Size*NumFrames*NumSlices);
 #endif   
 
@@ -434,6 +598,318 @@ int ReadImages (ImageInfoRec *Image,
 
 
 
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : InflateImages
+@INPUT      : *Image - struct describing the image
+              Slices[], Frames[], NumSlices, NumFrames, StartRow, NumRows
+                 - the images about to be read (exactly as passed to
+                 ReadImages)
+@OUTPUT     : 
+@RETURNS    : ERR_NONE if all went well
+              otherwise as for CacheInflate (ErrMsg set)
+@DESCRIPTION: If the file is compressed, makes sure that it has been
+              uncompressed as far as the last of the images we're
+              about to read -- but no further, so that reading the
+              first slice of a big compressed study is quick.
+@METHOD     : Only the end of the data read matters (the file can only
+              be uncompressed in order), so it's enough to ask for the
+              hyperslab that spans all of the slices and frames.
+@GLOBALS    : 
+@CALLS      : CacheInflate
+@CREATED    : 2026/10/16
+@MODIFIED   : 
+---------------------------------------------------------------------------- */
+int InflateImages (ImageInfoRec *Image,
+                   long Slices [], long Frames [],
+                   long NumSlices, long NumFrames,
+                   long StartRow, long NumRows)
+{
+   long     Start [MAX_NC_DIMS], Count [MAX_NC_DIMS];
+   long     i;
+
+   Start [Image->HeightDim] = StartRow;
+   Count [Image->HeightDim] = NumRows;
+   Start [Image->WidthDim] = 0L;
+   Count [Image->WidthDim] = Image->Width;
+
+   if (NumSlices > 0)
+   {
+      Start [Image->SliceDim] = Count [Image->SliceDim] = 0L;
+      for (i = 0; i < NumSlices; i++)
+         Count [Image->SliceDim] = max (Count [Image->SliceDim], Slices [i]+1);
+   }
+   if (NumFrames > 0)
+   {
+      Start [Image->FrameDim] = Count [Image->FrameDim] = 0L;
+      for (i = 0; i < NumFrames; i++)
+         Count [Image->FrameDim] = max (Count [Image->FrameDim], Frames [i]+1);
+   }
+
+   return (CacheInflate (Image->CDF, MIimage, Start, Count));
+}     /* InflateImages */
+
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : RawClass
+@INPUT      : *Image - struct describing the image
+@OUTPUT     : 
+@RETURNS    : the MATLAB class that best matches the type (and sign) in
+              which the image variable is stored
+@DESCRIPTION: Used to pick the class of the matrix returned in 'raw'
+              mode.
+@METHOD     : 
+@GLOBALS    : 
+@CALLS      : miget_datatype
+@CREATED    : 2026/10/16
+@MODIFIED   : 
+---------------------------------------------------------------------------- */
+mxClassID RawClass (ImageInfoRec *Image)
+{
+   nc_type  Type;
+   int      IsSigned;
+
+   (void) miget_datatype (Image->CDF, Image->ID, &Type, &IsSigned);
+   switch (Type)
+   {
+      case NC_BYTE:   return (IsSigned ? mxINT8_CLASS : mxUINT8_CLASS);
+      case NC_CHAR:   return (mxUINT8_CLASS);
+      case NC_SHORT:  return (IsSigned ? mxINT16_CLASS : mxUINT16_CLASS);
+      case NC_LONG:   return (IsSigned ? mxINT32_CLASS : mxUINT32_CLASS);
+      case NC_FLOAT:  return (mxSINGLE_CLASS);
+      default:        return (mxDOUBLE_CLASS);
+   }
+}     /* RawClass */
+
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : GetScaling
+@INPUT      : *Image - struct describing the image
+              Slices[], Frames[], NumSlices, NumFrames - the images read
+                 (exactly as passed to ReadImages)
+@OUTPUT     : Scale[], Offset[] - for each column of the matrix returned
+                 by ReadImages in 'raw' mode, the values such that
+                 raw*Scale + Offset gives the real (physical) values
+@RETURNS    : (none)
+@DESCRIPTION: Works out how MINC would have converted each raw image to
+              real values: the valid range of the image variable is
+              mapped linearly onto the range given by image-min and
+              image-max for that image.  Floating-point images are not
+              rescaled by MINC, so they get a scale of 1 and offset of 0.
+@METHOD     : image-max and image-min may have any subset of the
+              non-image dimensions of the image variable (usually time
+              and/or zspace, or none at all).  Their dimension ID's are
+              matched up with those of the image variable to find
+              which slice/frame number goes where in the coordinate
+              vector.  If either is missing, MINC's defaults (0 and 1)
+              are used.
+@GLOBALS    : 
+@CALLS      : miget_valid_range, ncvarinq, mivarget1
+@CREATED    : 2026/10/16
+@MODIFIED   : 
+---------------------------------------------------------------------------- */
+void GetScaling (ImageInfoRec *Image,
+                 long Slices [], long Frames [],
+                 long NumSlices, long NumFrames,
+                 double Scale [], double Offset [])
+{
+   int      ImDims [MAX_NC_DIMS];
+   int      MaxDims [MAX_NC_DIMS];
+   int      NumMaxDims;
+   long     Coord [MAX_NC_DIMS];
+   double   ValidRange [2];
+   double   ImMax, ImMin;
+   Boolean  HaveMaxMin;
+   long     slice, frame, col;
+   int      i, j;
+
+   NumSlices = max (NumSlices, 1);
+   NumFrames = max (NumFrames, 1);
+
+   if ((Image->DataType == NC_FLOAT) || (Image->DataType == NC_DOUBLE))
+   {
+      for (col = 0; col < NumSlices*NumFrames; col++)
+      {
+         Scale [col] = 1.0;
+         Offset [col] = 0.0;
+      }
+      return;
+   }
+
+   (void) miget_valid_range (Image->CDF, Image->ID, ValidRange);
+   ncvarinq (Image->CDF, Image->ID, NULL, NULL, NULL, ImDims, NULL);
+
+   HaveMaxMin = (Image->MaxID != MI_ERROR) && (Image->MinID != MI_ERROR);
+   if (HaveMaxMin)
+   {
+      ncvarinq (Image->CDF, Image->MaxID, NULL, NULL, 
+                &NumMaxDims, MaxDims, NULL);
+   }
+   ImMax = 1.0;
+   ImMin = 0.0;
+
+   col = 0;
+   for (slice = 0; slice < NumSlices; slice++)
+   {
+      for (frame = 0; frame < NumFrames; frame++)
+      {
+         if (HaveMaxMin)
+         {
+            /* image-max and image-min have the same dimensions, so the
+             * same Coord vector does for both */
+
+            for (i = 0; i < NumMaxDims; i++)
+            {
+               Coord [i] = 0;
+               for (j = 0; j < Image->NumDims; j++)
+               {
+                  if (ImDims [j] != MaxDims [i])
+                     continue;
+                  if ((j == Image->SliceDim) && (Slices != NULL))
+                     Coord [i] = Slices [slice];
+                  else if ((j == Image->FrameDim) && (Frames != NULL))
+                     Coord [i] = Frames [frame];
+               }
+            }
+
+            mivarget1 (Image->CDF, Image->MaxID, Coord, 
+                       NC_DOUBLE, MI_SIGNED, &ImMax);
+            mivarget1 (Image->CDF, Image->MinID, Coord, 
+                       NC_DOUBLE, MI_SIGNED, &ImMin);
+         }
+
+         Scale [col] = (ImMax - ImMin) / (ValidRange[1] - ValidRange[0]);
+         Offset [col] = ImMin - ValidRange[0] * Scale [col];
+         col++;
+      }
+   }
+}     /* GetScaling */
+
+
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : PrefetchFile
+@INPUT      : Filename - the MINC file
+              Image - the study, as read by this call
+              NextSlices - zero-based slices the caller will read next
+              NumNext - number of elements in NextSlices
+              Frames, NumFrames - the frames to read of each (as for
+                 this call)
+              StartRow, NumRows - and the rows
+@OUTPUT     : 
+@RETURNS    : (void)
+@DESCRIPTION: Asks the operating system to start reading the images the
+              caller is going to want next into its cache, in the
+              background, so that the next call finds its data already
+              in memory rather than waiting on the disk while MATLAB was
+              busy with the last slice.
+@METHOD     : Finds where the image variable lies in the file from the
+              NetCDF header (MapVariable), works out the byte range of
+              each wanted image (or part of an image), and gives each
+              run of adjacent ranges to posix_fadvise (POSIX_FADV_WILLNEED).
+              The read-ahead happens in the kernel, so nothing here
+              waits for it.  Files that can't be mapped (eg. compressed
+              ones, or images in record variables) are advised as a
+              whole.  A no-op where posix_fadvise isn't available.
+@GLOBALS    : 
+@CALLS      : MapVariable, UnmapVariable
+@CREATED    : 2026/10/16
+@MODIFIED   : 2026/10/16: advise just the next slices' images, not the
+                          whole file
+---------------------------------------------------------------------------- */
+void PrefetchFile (char Filename[], ImageInfoRec *Image,
+                   long NextSlices[], long NumNext,
+                   long Frames[], long NumFrames,
+                   long StartRow, long NumRows)
+{
+#if !defined(_WIN32) && defined(POSIX_FADV_WILLNEED)
+   MappedVar  Var;
+   long       Stride [MAX_NC_DIMS];
+   long       Begin, End, RunBegin, RunEnd;
+   long       Total, Frames1;
+   Boolean    FrameMajor;
+   long       i, s, f;
+   int        fd, d;
+
+   if (Image->SliceDim == -1)        /* nothing to read but what we have */
+   {
+      return;
+   }
+
+   fd = open (Filename, O_RDONLY);
+   if (fd < 0)
+   {
+      return;
+   }
+
+   if (MapVariable (Filename, MIimage, &Var) != ERR_NONE)
+   {
+      (void) posix_fadvise (fd, 0, 0, POSIX_FADV_WILLNEED);
+      (void) close (fd);
+      return;
+   }
+
+   /*
+    * Bytes from one element of each dimension to the next
+    */
+
+   Stride [Var.NumDims-1] = Var.TypeSize;
+   for (d = Var.NumDims-2; d >= 0; d--)
+   {
+      Stride [d] = Stride [d+1] * Var.DimSizes [d+1];
+   }
+
+   /*
+    * Go through the images in the order they're in the file, so that
+    * neighbours can be advised together
+    */
+
+   Frames1 = max (NumFrames, 1);
+   Total = NumNext * Frames1;
+   FrameMajor = (Image->FrameDim != -1) &&
+                (Image->FrameDim < Image->SliceDim);
+
+   RunBegin = RunEnd = 0;
+   for (i = 0; i < Total; i++)
+   {
+      s = FrameMajor ? (i % NumNext) : (i / Frames1);
+      f = FrameMajor ? (i / NumNext) : (i % Frames1);
+      if ((NextSlices [s] < 0) || (NextSlices [s] >= Image->Slices))
+         continue;
+
+      Begin = Var.Offset + NextSlices [s] * Stride [Image->SliceDim] +
+              StartRow * Stride [Image->HeightDim];
+      if (Image->FrameDim != -1)
+         Begin += Frames [f] * Stride [Image->FrameDim];
+      End = Begin + NumRows * Stride [Image->HeightDim];
+
+      if (Begin != RunEnd)
+      {
+         if (RunEnd > RunBegin)
+            (void) posix_fadvise (fd, (off_t) RunBegin,
+                                  (off_t) (RunEnd - RunBegin),
+                                  POSIX_FADV_WILLNEED);
+         RunBegin = Begin;
+      }
+      RunEnd = End;
+   }
+   if (RunEnd > RunBegin)
+   {
+      (void) posix_fadvise (fd, (off_t) RunBegin,
+                            (off_t) (RunEnd - RunBegin),
+                            POSIX_FADV_WILLNEED);
+   }
+
+   UnmapVariable (&Var);
+   (void) close (fd);
+#endif
+}     /* PrefetchFile */
+
+
+
+
 /* ----------------------------- MNI Header -----------------------------------
 @NAME       : mexFunction
 @INPUT      : nlhs, nrhs - number of output/input arguments (from MATLAB)
@@ -455,6 +931,13 @@ int ReadImages (ImageInfoRec *Image,
                  frame vector.
               06 October, 1993 by MW: Solved some memory fragmentation
                  problems by forcing MATLAB to reuse old memory.
+              16 October, 2026: Files are now opened through the
+                 open-file cache (minccache.c) and left open; added
+                 the '-flush' and '-cachestats' commands.
+              16 October, 2026: Added the optional precision argument
+                 and the scale/offset outputs.
+              16 October, 2026: Added the 'prefetch' hint.
+              16 October, 2026: Compressed files are read directly.
 ---------------------------------------------------------------------------- */
 void mexFunction(int    nlhs,
                  mxArray *plhs[],
@@ -463,20 +946,80 @@ void mexFunction(int    nlhs,
 {
    char        *Filename;
    ImageInfoRec ImInfo;
-   long         Slice[MAX_READABLE];
-   long         Frame[MAX_READABLE];
+   long        *Slice;
+   long        *Frame;
    long         NumSlices;
    long         NumFrames;
+   long         NumImages;
    long         StartRow;
    long         NumRows;
    Boolean      StartRowGiven;   /* so we can have an 'intelligent' default */
                                  /* for NumRows */
    double      *junk_data;
    int          Result;
+   char        *PrecString;
+   long         i;
+   int          Precision;
+   nc_type      ICVType;
+   mxClassID    Class;
+   Boolean      Prefetch;
+   const mxArray *NextSlices;
+   long        *Next;
+   long         NumNext;
+   double      *Scale, *Offset;
 
    ncopts = 0;
    ErrMsg = (char *) mxCalloc (256, sizeof (char));
 
+   /* Handle '-flush' and '-cachestats' before anything else */
+
+   if (HandleCacheCommand (nlhs, plhs, nrhs, prhs))
+   {
+      return;
+   }
+
+   /*
+    * A trailing 'prefetch', next_slices pair says that the caller is
+    * going to read more of the file next (nothing, if next_slices is
+    * empty).  It comes after everything else, even the precision.
+    */
+
+   Prefetch = FALSE;
+   NextSlices = NULL;
+   if ((nrhs > MIN_IN_ARGS + 1) && mxIsChar (prhs [nrhs-2]))
+   {
+      ParseStringArg (prhs [nrhs-2], &PrecString);
+      if (strcmp (PrecString, "prefetch") == 0)
+      {
+         NextSlices = prhs [nrhs-1];
+         Prefetch = !mxIsEmpty (NextSlices);
+         nrhs -= 2;
+      }
+   }
+
+   /*
+    * If the last argument is a string, it's the precision ('double',
+    * 'single', or 'raw') -- pull it off before counting the rest.
+    */
+
+   Precision = PREC_DOUBLE;
+   if ((nrhs > MIN_IN_ARGS) && mxIsChar (prhs [nrhs-1]))
+   {
+      ParseStringArg (prhs [nrhs-1], &PrecString);
+      if (strcmp (PrecString, "double") == 0)
+         Precision = PREC_DOUBLE;
+      else if (strcmp (PrecString, "single") == 0)
+         Precision = PREC_SINGLE;
+      else if (strcmp (PrecString, "raw") == 0)
+         Precision = PREC_RAW;
+      else
+      {
+         sprintf (ErrMsg, "Unknown precision: %s (must be 'double', 'single', or 'raw')", PrecString);
+         ErrAbort (ErrMsg, TRUE, ERR_ARGS);
+      }
+      nrhs--;
+   }
+
    /* First make sure a valid number of arguments was given. */
 
    if ((nrhs < MIN_IN_ARGS) || (nrhs > MAX_IN_ARGS))
@@ -502,15 +1045,31 @@ void mexFunction(int    nlhs,
    NaN = CreateNaN();
    
    /*
-    * Open MINC file, get info about image, and setup ICV
+    * Open MINC file, get info about image, and setup ICV (or get all
+    * three from the cache if we've read this file before).  N.B. the
+    * file must not be closed -- it stays in the cache for next time.
     */
 
-   Result = OpenImage (Filename, &ImInfo, NC_NOWRITE, NaN);
+   switch (Precision)
+   {
+      case PREC_SINGLE: ICVType = NC_FLOAT;          break;
+      case PREC_RAW:    ICVType = MI_ORIGINAL_TYPE;  break;
+      default:          ICVType = NC_DOUBLE;         break;
+   }
+
+   Result = CacheOpenImage (Filename, &ImInfo, ICVType, NaN);
    if (Result != ERR_NONE)
    {
       ErrAbort (ErrMsg, TRUE, Result);
    }
 
+   switch (Precision)
+   {
+      case PREC_SINGLE: Class = mxSINGLE_CLASS;      break;
+      case PREC_RAW:    Class = RawClass (&ImInfo);  break;
+      default:          Class = mxDOUBLE_CLASS;      break;
+   }
+
    /* 
     * If the vector of slices is given, parse it into a vector of longs.
     * If not, just read slice 0 by default.  Note that if the slice (z)
@@ -518,13 +1077,14 @@ void mexFunction(int    nlhs,
     * tried to supply a list of slices anyway, a warning is printed.
     */
 
+   Slice = Frame = NULL;
    if ((nrhs >= SLICES_POS) && (mxGetM(SLICES)>0) && (mxGetN(SLICES)>0))
    {
-
-       NumSlices = ParseIntArg (SLICES, MAX_READABLE, Slice);
+       NumSlices = mxGetM(SLICES) * mxGetN(SLICES);
+       Slice = (long *) mxCalloc (NumSlices, sizeof (long));
+       NumSlices = ParseIntArg (SLICES, NumSlices, Slice);
        if (NumSlices < 0)
        {
-           CloseImage (&ImInfo);
            switch (NumSlices)
            {
                case mexARGS_TOO_BIG:
@@ -559,10 +1119,11 @@ void mexFunction(int    nlhs,
 
    if ((nrhs >= FRAMES_POS) && (mxGetM(FRAMES)>0) && (mxGetN(FRAMES)>0))
    {
-       NumFrames = ParseIntArg (FRAMES, MAX_READABLE, Frame);
+       NumFrames = mxGetM(FRAMES) * mxGetN(FRAMES);
+       Frame = (long *) mxCalloc (NumFrames, sizeof (long));
+       NumFrames = ParseIntArg (FRAMES, NumFrames, Frame);
        if (NumFrames < 0)
        {
-           CloseImage (&ImInfo);
            switch (NumFrames)
            {
                case mexARGS_TOO_BIG:
@@ -603,6 +1164,8 @@ void mexFunction(int    nlhs,
    /* at by OLD_MEMORY, if it exists.  If it's the wrong size, we want  */
    /* to free it, and allocate new memory of the correct size.          */
 
+   NumImages = max (NumSlices, 1) * max (NumFrames, 1);
+
    if (nrhs >= OLD_MEMORY_POS)
    {
 
@@ -611,12 +1174,13 @@ void mexFunction(int    nlhs,
 #ifdef DEBUG
        printf("Image size: %ld\n", ImInfo.ImageSize);
        printf("Old memory rows: %ld\n", mxGetM(OLD_MEMORY));
-       printf("Image cols: %ld\n", (NumSlices+NumFrames-1));
+       printf("Image cols: %ld\n", NumImages);
        printf("Old memory cols: %ld\n", mxGetN(OLD_MEMORY));
 #endif       
 
        if ((mxGetM(OLD_MEMORY) != (ImInfo.ImageSize)) ||
-           (mxGetN(OLD_MEMORY) != (NumSlices+NumFrames-1)))
+           (mxGetN(OLD_MEMORY) != NumImages) ||
+           (mxGetClassID(OLD_MEMORY) != Class))
        {
 
            /*
@@ -645,8 +1209,8 @@ void mexFunction(int    nlhs,
                {
                    ErrAbort("Could not allocate memory!\n", FALSE, -1);
                }                   
-               mxFree(mxGetPr(OLD_MEMORY));
-               mxSetPr(OLD_MEMORY, junk_data);
+               mxFree(mxGetData(OLD_MEMORY));
+               mxSetData(OLD_MEMORY, junk_data);
            }
 
            /*
@@ -680,7 +1244,7 @@ void mexFunction(int    nlhs,
             * the size later.
             */
 
-           VECTOR_IMAGES = mxCreateDoubleMatrix(1,1,mxREAL);
+           VECTOR_IMAGES = mxCreateNumericMatrix(1,1,Class,mxREAL);
            if (VECTOR_IMAGES == NULL)
            {
                ErrAbort("Could not allocate memory!\n", FALSE, -1);
@@ -692,7 +1256,7 @@ void mexFunction(int    nlhs,
             * part, since we won't be needing this memory.
             */
 
-           mxFree(mxGetPr(VECTOR_IMAGES));
+           mxFree(mxGetData(VECTOR_IMAGES));
 
            /*
             * Now, we redefine the size of the left hand side argument
@@ -708,7 +1272,7 @@ void mexFunction(int    nlhs,
             * necessary for creating the left hand side argument.
             */
 
-           mxSetPr(VECTOR_IMAGES, mxGetPr(OLD_MEMORY));
+           mxSetData(VECTOR_IMAGES, mxGetData(OLD_MEMORY));
 
            /*
             * Finally, we set the real part pointer of the old Matrix
@@ -716,7 +1280,7 @@ void mexFunction(int    nlhs,
             * return.
             */
 
-           mxSetPr(OLD_MEMORY, NULL);
+           mxSetData(OLD_MEMORY, NULL);
        }
    }
    else 
@@ -764,24 +1328,82 @@ void mexFunction(int    nlhs,
 
    if (!CheckBounds(Slice,Frame,NumSlices,NumFrames,StartRow,NumRows,&ImInfo))
    {
-      CloseImage (&ImInfo);
       ErrAbort (ErrMsg, TRUE, ERR_ARGS);
    }
    
 
-   /* And read the images to a MATLAB Matrix (of doubles!) */
+   /* And read the images to a MATLAB Matrix (of doubles, by default) */
+
+   Result = InflateImages (&ImInfo, Slice, Frame, NumSlices, NumFrames,
+                           StartRow, NumRows);
+   if (Result != ERR_NONE) 
+   {
+      ErrAbort (ErrMsg, TRUE, Result);
+   }
 
-   Result = ReadImages (&ImInfo, 
+   Result = ReadImages (&ImInfo, Class,
                         Slice, Frame, 
                         NumSlices, NumFrames, 
                         StartRow, NumRows,
                         &VECTOR_IMAGES);
    if (Result != ERR_NONE) 
    {
-      CloseImage (&ImInfo);
       ErrAbort (ErrMsg, TRUE, Result);
    }
 
-   CloseImage (&ImInfo);
+   if (Prefetch)
+   {
+      NumNext = mxGetM (NextSlices) * mxGetN (NextSlices);
+      Next = (long *) mxCalloc (NumNext, sizeof (long));
+      if (ParseIntArg (NextSlices, NumNext, Next) == NumNext)
+      {
+         PrefetchFile (Filename, &ImInfo, Next, NumNext, Frame, NumFrames,
+                       StartRow, NumRows);
+      }
+      mxFree (Next);
+   }
+
+   /*
+    * If asked for, return the scale and offset that turn each column
+    * into real values.  These are only interesting in 'raw' mode; 
+    * otherwise the images are already real, so they're just 1 and 0.
+    */
+
+   if (nlhs > 1)
+   {
+      SCALE = mxCreateDoubleMatrix (1, NumImages, mxREAL);
+      Scale = mxGetPr (SCALE);
+
+      /* (still need somewhere to put the offsets if they weren't asked for) */
+
+      if (nlhs > 2)
+      {
+         OFFSET = mxCreateDoubleMatrix (1, NumImages, mxREAL);
+         Offset = mxGetPr (OFFSET);
+      }
+      else
+      {
+         Offset = (double *) mxCalloc (NumImages, sizeof (double));
+      }
+
+      if (Precision == PREC_RAW)
+      {
+         GetScaling (&ImInfo, Slice, Frame, NumSlices, NumFrames,
+                     Scale, Offset);
+      }
+      else
+      {
+         for (i = 0; i < NumImages; i++)
+         {
+            Scale [i] = 1.0;
+            Offset [i] = 0.0;
+         }
+      }
+
+      if (nlhs <= 2)
+      {
+         mxFree (Offset);
+      }
+   }
 
 }     /* mexFunction */
@@ -2,6 +2,7 @@
 @NAME       : mireadvar.c (CMEX)
 @INPUT      : MATLAB input arguments: MINC filename, variable name, 
               vector of starting positions and vector of edge lengths
+              (or cell arrays of names, starts and edge lengths)
 @OUTPUT     : If the desired variable exists and the given dimensions
               are valid (ie. not out of range), returns the specified
               hyperslab from it, jammed into a one-dimensional MATLAB
@@ -24,6 +25,9 @@
 	      93/8/25, changed if (debug) to #ifdef DEBUG and removed 
 	         debug variable; removed OPTIONS argument; replaced
 		 gpw.h with direct inclusion of its contents
+              2026/10/16, added the 'mmap' and 'raw' options, which read
+                 uncompressed files through a memory map
+              2026/10/16, added reading a list of variables in one call
 @COMMENTS   : 
 @VERSION    : $Id: mireadvar.c,v 1.13 2004-03-11 15:42:43 bert Exp $
               $Name:  $
@@ -40,6 +44,7 @@
 #include "mierrors.h"
 #include "mexutils.h"         /* be sure to link in mexutils.o */
 #include "mincutil.h"         /* and mincutil.o */
+#include "ncmap.h"            /* and ncmap.o */
 
 #define PROGNAME "mireadvar"
 
@@ -63,6 +68,10 @@
 
 #define MAX_OPTIONS     1
 
+#define READ_NORMAL     0        /* how to read, from the options string */
+#define READ_MMAP       1        /* 'mmap': doubles, through a map */
+#define READ_RAW        2        /* 'raw': as stored, through a map */
+
 
 /*
  *  Global variable: ErrMsg
@@ -93,7 +102,10 @@ void ErrAbort (char msg[], Boolean PrintUsage, int ExitCode)
       (void) mexPrintf ("Usage: %s ('MINC_file', 'var_name', ", PROGNAME);
       (void) mexPrintf ("[, start, count[, options]])\n");
       (void) mexPrintf ("where start and count are MATLAB vectors containing the starting index and\n");
-      (void) mexPrintf ("number of elements to read for each dimension of variable var_name.\n\n");
+      (void) mexPrintf ("number of elements to read for each dimension of variable var_name,\n");
+      (void) mexPrintf ("and options is 'mmap' or 'raw'.  To read several variables at once,\n");
+      (void) mexPrintf ("give a cell array of names (and of start and count vectors, if any):\n");
+      (void) mexPrintf ("  [a, b] = %s ('MINC_file', {'a', 'b'})\n\n", PROGNAME);
    }
    (void) mexErrMsgTxt (msg);
 }
@@ -314,6 +326,249 @@ int ReadValues (VarInfoRec *vInfo,
 
 
 
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : RawClass
+@INPUT      : *vInfo - struct describing the variable
+@OUTPUT     : *Type, *IsSigned - the type and sign of the stored values
+@RETURNS    : the MATLAB class that best matches them
+@DESCRIPTION: Used to pick the class of the matrix returned in 'raw' mode.
+@METHOD     : 
+@GLOBALS    : 
+@CALLS      : miget_datatype
+@CREATED    : 2026/10/16 (from RawClass in mireadimages.c)
+@MODIFIED   : 
+---------------------------------------------------------------------------- */
+mxClassID RawClass (VarInfoRec *vInfo, nc_type *Type, int *IsSigned)
+{
+   (void) miget_datatype (vInfo->CDF, vInfo->ID, Type, IsSigned);
+   switch (*Type)
+   {
+      case NC_BYTE:   return (*IsSigned ? mxINT8_CLASS : mxUINT8_CLASS);
+      case NC_CHAR:   return (mxUINT8_CLASS);
+      case NC_SHORT:  return (*IsSigned ? mxINT16_CLASS : mxUINT16_CLASS);
+      case NC_LONG:   return (*IsSigned ? mxINT32_CLASS : mxUINT32_CLASS);
+      case NC_FLOAT:  return (mxSINGLE_CLASS);
+      default:        return (mxDOUBLE_CLASS);
+   }
+}     /* RawClass */
+
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : ReadMapped
+@INPUT      : Filename - the file (which is already open as vInfo->CDF)
+              *vInfo - struct, tells which variable to read
+              Start[], Count[] - hyperslab to read, as for ReadValues
+              Mode - READ_MMAP to convert the values to double, or
+                READ_RAW to return them in the type they're stored in
+@OUTPUT     : **Dest - a MATLAB Matrix, allocated here
+@RETURNS    : ERR_NONE if all goes well
+              ERR_OTHER if there are no values to read
+              ERR_IN_MINC if there is some error reading the MINC file
+@DESCRIPTION: Like ReadValues, but if the file is in NetCDF classic
+              format (uncompressed MINC 1), the values are taken straight
+              from a memory map of the file rather than going through
+              the NetCDF library.  Any other file (or a record variable)
+              is quietly read with mivarget instead.
+@METHOD     : In 'raw' mode the values are only byte-swapped (if need
+              be) into a matrix of the matching class; otherwise each
+              is converted to double, using the variable's signtype,
+              just as mivarget would.
+@GLOBALS    : ErrMsg
+@CALLS      : MapVariable, MappedGet, MappedGetRaw, UnmapVariable,
+              RawClass, ReadValues, mivarget
+@CREATED    : 2026/10/16
+@MODIFIED   : 
+---------------------------------------------------------------------------- */
+int ReadMapped (char *Filename, VarInfoRec *vInfo, 
+                long Start [], long Count [], int Mode,
+                mxArray **Dest)
+{
+   MappedVar   Var;
+   mxClassID   Class;
+   nc_type     Type;
+   int         IsSigned;
+   long        TotSize;
+   int         i;
+
+   TotSize = 1;
+   for (i = 0; i < vInfo->NumDims; i++)
+   {
+      TotSize *= Count [i];
+   }
+   if (TotSize == 0)
+   {
+      ErrMsg = "No values to read";
+      return ERR_OTHER;
+   }
+
+   Class = RawClass (vInfo, &Type, &IsSigned);
+
+   if (MapVariable (Filename, vInfo->Name, &Var) != ERR_NONE)
+   {
+      /*
+       * Can't map it -- fall back on the NetCDF library
+       */
+
+      if (Mode != READ_RAW)
+      {
+         return (ReadValues (vInfo, Start, Count, Dest));
+      }
+
+      *Dest = mxCreateNumericMatrix (TotSize, 1, Class, mxREAL);
+      if (mivarget (vInfo->CDF, vInfo->ID, Start, Count, Type,
+                    IsSigned ? MI_SIGNED : MI_UNSIGNED,
+                    mxGetData (*Dest)) == MI_ERROR)
+      {
+         ErrMsg = "Error reading from file!";
+         return ERR_IN_MINC;
+      }
+      return ERR_NONE;
+   }
+
+   if (Mode == READ_RAW)
+   {
+      *Dest = mxCreateNumericMatrix (TotSize, 1, Class, mxREAL);
+      MappedGetRaw (&Var, Start, Count, mxGetData (*Dest));
+   }
+   else
+   {
+      *Dest = mxCreateDoubleMatrix (TotSize, 1, mxREAL);
+      MappedGet (&Var, Start, Count, (Boolean) IsSigned, mxGetPr (*Dest));
+   }
+
+   UnmapVariable (&Var);
+   return ERR_NONE;
+}     /* ReadMapped */
+
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : ReadVariable
+@INPUT      : Filename - the file (which is already open as CDFid)
+              CDFid - the file, as returned by CacheOpenFile
+              Varname - the variable to read
+              Mstart, Mcount - MATLAB vectors of starting points and
+                counts, or NULL to read the whole variable
+              Mode - READ_NORMAL, READ_MMAP or READ_RAW
+@OUTPUT     : **Dest - a MATLAB Matrix, allocated here (empty if the
+                variable does not exist)
+@RETURNS    : ERR_NONE if all goes well (even if the variable doesn't
+                exist)
+              ERR_ARGS if just one of Mstart and Mcount is given (even
+                if the variable doesn't exist), or they don't fit the
+                variable
+              otherwise as for CacheInflate, ReadValues and ReadMapped
+              (ErrMsg set if not ERR_NONE)
+@DESCRIPTION: Reads one variable (or a hyperslab of it) from an open
+              file; everything mexFunction does once it has the file.
+@METHOD     : 
+@GLOBALS    : ErrMsg
+@CALLS      : GetVarInfo, ParseIntArg, CheckBounds, MakeDefaultVectors,
+              CacheInflate, ReadValues, ReadMapped
+@CREATED    : 2026/10/16 (split out of mexFunction)
+@MODIFIED   : 
+---------------------------------------------------------------------------- */
+int ReadVariable (char *Filename, int CDFid, char *Varname,
+                  const mxArray *Mstart, const mxArray *Mcount,
+                  int Mode, mxArray **Dest)
+{
+   int      Result;           /* return value from various functions */
+   VarInfoRec  VarInfo;       /* a nice handy structure */
+   long     Start [MAX_NC_DIMS];
+   long     Count [MAX_NC_DIMS];
+   int      NumStart;      /* number of elements in Start[] and Count[] */
+   int      NumCount;
+
+   /*
+    * The start and count vectors must BOTH be given if either one is --
+    * whether or not the variable is there
+    */
+
+   if ((Mstart == NULL) != (Mcount == NULL))
+   {
+      sprintf (ErrMsg, "Cannot supply just one of start and count "
+               "vectors (variable %s)", Varname);
+      return ERR_ARGS;
+   }
+
+   Result = GetVarInfo (CDFid, Varname, &VarInfo);
+   if (Result != ERR_NONE)       /* variable does not exist */
+   {                             /* so return empty matrix */
+      *Dest = mxCreateDoubleMatrix (0, 0, mxREAL);
+      return ERR_NONE;
+   }
+
+   /*
+    * If the start and count vectors are given, parse them and verify
+    * their validity.  Otherwise call MakeDefaultVectors to set things
+    * up to read the entire variable.
+    */
+
+   if (Mstart != NULL)
+   {
+      memset (Start, 0, MAX_NC_DIMS * sizeof (*Start));
+      memset (Count, 0, MAX_NC_DIMS * sizeof (*Count));
+      NumStart = ParseIntArg (Mstart, MAX_NC_DIMS, Start);
+      NumCount = ParseIntArg (Mcount, MAX_NC_DIMS, Count);
+
+      Result = CheckBounds (&VarInfo,Start,Count,NumStart,NumCount);
+      if (Result != ERR_NONE)
+      {
+         return Result;
+      }
+   }     /* if start and count vectors given */
+   else
+   {
+      MakeDefaultVectors (&VarInfo,Start,Count,&NumStart,&NumCount);
+   }
+
+   /* If the file is compressed, make sure we've uncompressed this far */
+
+   Result = CacheInflate (CDFid, Varname, Start, Count);
+   if (Result != ERR_NONE)
+   {
+      return Result;
+   }
+
+   if (Mode == READ_NORMAL)
+      Result = ReadValues (&VarInfo, Start, Count, Dest);
+   else
+      Result = ReadMapped (Filename, &VarInfo, Start, Count, Mode, Dest);
+
+   return Result;
+}     /* ReadVariable */
+
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : GetCellVector
+@INPUT      : Mcell - a MATLAB cell array of start or count vectors
+              Index - which one to get
+@OUTPUT     : 
+@RETURNS    : the vector, or NULL if that element is empty (meaning
+              "the whole variable")
+@DESCRIPTION: 
+@METHOD     : 
+@GLOBALS    : 
+@CALLS      : mxGetCell
+@CREATED    : 2026/10/16
+@MODIFIED   : 
+---------------------------------------------------------------------------- */
+const mxArray *GetCellVector (const mxArray *Mcell, int Index)
+{
+   const mxArray  *Vector;
+
+   Vector = mxGetCell (Mcell, Index);
+   if ((Vector == NULL) || mxIsEmpty (Vector))
+   {
+      return (NULL);
+   }
+   return (Vector);
+}     /* GetCellVector */
+
+
+
 /* ----------------------------- MNI Header -----------------------------------
 @NAME       : mexFunction
 @INPUT      : nlhs, nrhs - number of output, input arguments supplied by
@@ -325,18 +580,27 @@ int ReadValues (VarInfoRec *vInfo,
               optional vectors of starting points and counts (as per
               ncvarget and mivarget), reads a hyperslab of values from
               the MINC variable into a one-dimensional MATLAB Matrix.
-@METHOD     : Parses the filename and variable name from the MATLAB input
-              arguments.  Opens the MINC file, reads information about
-              the variable and its dimensions.  Parses the start/count
-              vectors if they are given and checks them for validity;
-              if not given, sets up defaults to read the entire variable.
-              Reads the hyperslab.
+              The variable name may also be a cell array of names, in
+              which case each variable goes to its own output argument,
+              and the start and count (if given) must be cell arrays
+              with a vector (or [], for the whole variable) for each.
+@METHOD     : Parses the filename and variable name(s) from the MATLAB
+              input arguments.  Opens the MINC file, then reads each
+              variable with ReadVariable -- so a list of variables is
+              read with the file opened (or found in the cache) just
+              once.  Variables with no output argument to go to are
+              not read.
 @GLOBALS    : ErrMsg
 @CALLS      : standard mex, library functions; ErrAbort, ParseOptions,
-              ParseStringArg, OpenFile, GetVarInfo, ParseIntArg,
-              CheckBounds, MakeDefaultVectors, ReadValues.
+              ParseStringArg, CacheOpenFile, GetCellVector,
+              ReadVariable.
 @CREATED    : 93-5-31, Greg Ward.
 @MODIFIED   : 93-6-16, standardized error handling
+              2026-10-16, files now come from the open-file cache;
+                 added '-flush' and '-cachestats'
+              2026-10-16, added the 'mmap' and 'raw' options
+              2026-10-16, compressed files are read directly
+              2026-10-16, can read a list of variables at once
 ---------------------------------------------------------------------------- */
 void mexFunction (int nlhs, mxArray *plhs [],
                   int nrhs, const mxArray *prhs [])
@@ -345,15 +609,44 @@ void mexFunction (int nlhs, mxArray *plhs [],
    char     *Varname;
    int      CDFid;
    int      Result;           /* return value from various functions */
-   VarInfoRec  VarInfo;       /* a nice handy structure */
-   long     Start [MAX_NC_DIMS];
-   long     Count [MAX_NC_DIMS];
-   int      NumStart;      /* number of elements in Start[] and Count[] */
-   int      NumCount;
+   char     *Options;
+   int      Mode;
+   Boolean  IsList;           /* was a cell array of names given? */
+   int      NumVars;
+   int      i;
    
    ncopts = 0;
    ErrMsg = (char *) mxCalloc (256, sizeof (char));
 
+   /*
+    * Handle '-flush' and '-cachestats' before anything else
+    */
+   if (HandleCacheCommand (nlhs, plhs, nrhs, prhs))
+   {
+      return;
+   }
+
+   /*
+    * If the last argument (after the variable name) is a string, it's
+    * the options -- pull it off before counting the rest.
+    */
+   Mode = READ_NORMAL;
+   if ((nrhs > MIN_IN_ARGS) && mxIsChar (prhs [nrhs-1]))
+   {
+      ParseStringArg (prhs [nrhs-1], &Options);
+      if (strcmp (Options, "mmap") == 0)
+         Mode = READ_MMAP;
+      else if (strcmp (Options, "raw") == 0)
+         Mode = READ_RAW;
+      else
+      {
+         sprintf (ErrMsg, "Unknown option: %s (must be 'mmap' or 'raw')",
+                  Options);
+         ErrAbort (ErrMsg, TRUE, ERR_ARGS);
+      }
+      nrhs--;
+   }
+
    /*
     * Ensure that caller supplied correct number of input arguments
     */
@@ -367,75 +660,86 @@ void mexFunction (int nlhs, mxArray *plhs [],
 
 
    /*
-    * Parse the two string options -- these are required
+    * Parse the two string options -- these are required.  (If the
+    * variable names come in a cell array, they're parsed one at a time
+    * as they're read; but check the start and count cell arrays now.)
     */
 
    if (ParseStringArg (FILENAME, &Filename) == NULL)
    {
       ErrAbort ("Filename must be a string", TRUE, ERR_ARGS);
    }
-   if (ParseStringArg (VARNAME, &Varname) == NULL)
+
+   IsList = (Boolean) mxIsCell (VARNAME);
+   NumVars = 1;
+   if (IsList)
+   {
+      NumVars = mxGetNumberOfElements (VARNAME);
+      if (nlhs > NumVars)
+      {
+         ErrAbort ("More output arguments than variable names", 
+                   TRUE, ERR_ARGS);
+      }
+      if ((nrhs >= START_POS) &&
+          (!mxIsCell (START) ||
+           (mxGetNumberOfElements (START) != NumVars) ||
+           ((nrhs >= COUNT_POS) &&
+            (!mxIsCell (COUNT) ||
+             (mxGetNumberOfElements (COUNT) != NumVars)))))
+      {
+         ErrAbort ("With a list of variables, start and count must be "
+                   "cell arrays with one vector for each", TRUE, ERR_ARGS);
+      }
+   }
+   else if (ParseStringArg (VARNAME, &Varname) == NULL)
    {
       ErrAbort ("Variable name must be a string", TRUE, ERR_ARGS);
    }
 
    /*
-    * Open the file and get info about the variable and its dimensions
+    * Open the file (or get it from the cache -- in which case it must
+    * not be closed)
     */
 
-   Result = OpenFile (Filename, &CDFid, NC_NOWRITE);
+   Result = CacheOpenFile (Filename, &CDFid);
    if (Result != ERR_NONE)
    {
       ErrAbort (ErrMsg, TRUE, Result);
    }
 
-   Result = GetVarInfo (CDFid, Varname, &VarInfo);
-   if (Result != ERR_NONE)       /* variable does not exist */
-   {                             /* so return empty matrix */
-      ncclose (CDFid);
-      RET_VECTOR = mxCreateDoubleMatrix (0, 0, mxREAL);
+   if (!IsList)
+   {
+      Result = ReadVariable (Filename, CDFid, Varname,
+                             (nrhs >= START_POS) ? START : NULL,
+                             (nrhs >= COUNT_POS) ? COUNT : NULL,
+                             Mode, &RET_VECTOR);
+      if (Result != ERR_NONE)
+      {
+         ErrAbort (ErrMsg, TRUE, Result);
+      }
       return;
    }
 
    /*
-    * If the start and count vectors are given (and they must BOTH be
-    * given if either one is), parse them and verify their validity.
-    * Otherwise call MakeDefaultVectors to set things up to read the
-    * entire variable.
+    * Read each variable in the list into its own output argument
+    * (there's always room for at least one, even if nlhs is 0)
     */
 
-   if (nrhs >= START_POS)           /* parse the start and count vectors */
+   for (i = 0; (i < NumVars) && (i < max (nlhs, 1)); i++)
    {
-      if (nrhs < COUNT_POS)         /* can't have one without the other! */
+      if ((mxGetCell (VARNAME, i) == NULL) ||
+          (ParseStringArg (mxGetCell (VARNAME, i), &Varname) == NULL))
       {
-         ncclose (CDFid);
-         ErrAbort ("Cannot supply just one of start and count vectors", 
-                   TRUE, ERR_ARGS);
+         ErrAbort ("Variable names must all be strings", TRUE, ERR_ARGS);
       }
-      memset (Start, 0, MAX_NC_DIMS * sizeof (*Start));
-      memset (Count, 0, MAX_NC_DIMS * sizeof (*Count));
-      NumStart = ParseIntArg (START, MAX_NC_DIMS, Start);
-      NumCount = ParseIntArg (COUNT, MAX_NC_DIMS, Count);
 
-      Result = CheckBounds (&VarInfo,Start,Count,NumStart,NumCount);
+      Result = ReadVariable (Filename, CDFid, Varname,
+                   (nrhs >= START_POS) ? GetCellVector (START, i) : NULL,
+                   (nrhs >= COUNT_POS) ? GetCellVector (COUNT, i) : NULL,
+                   Mode, &plhs [i]);
       if (Result != ERR_NONE)
       {
-         ncclose (CDFid);
          ErrAbort (ErrMsg, TRUE, Result);
       }
-   }     /* if start and count vectors given */
-   else
-   {
-      MakeDefaultVectors (&VarInfo,Start,Count,&NumStart,&NumCount);
    }
-
-   Result = ReadValues (&VarInfo, Start, Count, &RET_VECTOR);
-
-   ncclose (CDFid);
-
-   if (Result != ERR_NONE)
-   {
-      ErrAbort (ErrMsg, TRUE, Result);
-   }  
 }     /* mexFunction */
-
@@ -3,7 +3,8 @@
 @DESCRIPTION: Write values into an attribute in a MINC file.
 @GLOBALS    : 
 @CREATED    : September 2004, Bert Vincent
-@MODIFIED   : 
+@MODIFIED   : October 2026 - leave define mode with EndDefine, so that
+              the file is only rewritten if the header has no room left.
 @VERSION    : $Id: miwriteatt.c,v 1.1 2004-11-22 19:56:13 bert Exp $
               $Name:  $
 ---------------------------------------------------------------------------- */
@@ -13,6 +14,7 @@
 #include <stdlib.h>
 #include "minc.h"
 #include "emmageneral.h"
+#include "ncmap.h"
 
 #define MINC_FILE      argv[1]
 #define VAR_NAME       argv[2]
@@ -33,6 +35,7 @@ int main (int argc, char *argv[])
 {
     int fd;
     int varid;
+    Boolean Rewritten;
     
     ncopts = 0;
     
@@ -91,5 +94,15 @@ int main (int argc, char *argv[])
         miattputstr(fd, varid, ATT_NAME, DATA_STR);
     }
 
+    if (EndDefine(fd, MINC_FILE, DEFAULT_HEADER_PAD, &Rewritten) < 0) {
+        fprintf(stderr, "%s: error updating %s\n", PROGNAME, MINC_FILE);
+        miclose(fd);
+        exit(-1);
+    }
+    if (Rewritten) {
+        fprintf(stderr, "%s: header of %s was full -- whole file rewritten, "
+                "with room to spare next time\n", PROGNAME, MINC_FILE);
+    }
+
     miclose(fd);
 }
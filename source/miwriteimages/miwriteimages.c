@@ -36,12 +36,32 @@
 				/* in one go (this is the same as  */
 				/* MAXREADABLE in mireadimages.c */
 
+#define RUN_BYTES     (8L*1048576L)  /* most memory to use for the images */
+                                     /* written by one miicv_put (there */
+                                     /* are two buffers this big) */
+
 /* Error codes returned by GetVector: */
 
 #define VECTOR_BAD -1
 #define VECTOR_LONG -2
 #define VECTOR_EMPTY -3
 
+/*
+ * A run of consecutive images (slices or frames) from the temp file,
+ * with the max and min of each
+ */
+
+typedef struct
+{
+   FILE    *TempFile;
+   long     ImageSize;
+   long     Slice, Frame;       /* where the run starts in Slices[] and */
+   long     SliceRun, FrameRun; /* Frames[], and how long it is in each */
+   double  *Buffer;             /* the images, one after the other */
+   double  *Max, *Min;          /* of each image */
+   long     NumRead;            /* images actually read by ReadRun */
+} RunBuffer;
+
 /*
  * Global variables (with apologies)
  */
@@ -378,156 +398,39 @@ Boolean ReadNextImage (double *Buffer, long ImageSize, FILE *InFile)
 
 
 /* ----------------------------- MNI Header -----------------------------------
-@NAME       : PutMaxMin
-@INPUT      : ImInfo - pointer to struct describing the image variable
-              ImVals - pointer to array of doubles containing the image data
-              SliceNum, FrameNum - needed to correctly place the max and min
-                values into the MIimagemax and MIimagemin variables
-              DoFrames - whether or not there is a time dimension in this file
-@OUTPUT     : (none)
+@NAME       : ReadRun
+@INPUT      : Arg - the RunBuffer to fill: TempFile, ImageSize and the
+                    run's SliceRun and FrameRun must be set
+@OUTPUT     : Arg - Buffer, Max and Min filled in for each image read,
+                    and NumRead set
 @RETURNS    : (void)
-@DESCRIPTION: Finds the max and min values of an image, and puts them
-              into the MIimagemax and MIimagemin variables associated
-              with the specified image variable.  Note: the caller must
-              make sure that MIimagemax and MIimagemin exist in the
-              file, and ensure that ImInfo->MaxID and ImInfo->MinID contain
-              their variable ID's.
-@METHOD     : 
+@DESCRIPTION: Reads the next run of images from the temp file, and finds
+              the max and min of each.  Stops early (with NumRead less
+              than the number of images in the run) if the temp file
+              runs out.
+@METHOD     : Run by WriteImages in the background (see StartThread),
+              so it must not touch the MINC file or ErrMsg.
 @GLOBALS    : 
-@CALLS      : 
-@CREATED    : 93-6-3, Greg Ward
+@CALLS      : ReadNextImage, FindMaxMin
+@CREATED    : 2026/10/16
 @MODIFIED   : 
 ---------------------------------------------------------------------------- */
-void PutMaxMin (ImageInfoRec *ImInfo, double *ImVals, 
-                long SliceNum, long FrameNum, 
-                Boolean DoSlices, Boolean DoFrames)
+static void ReadRun (void *Arg)
 {
-   int      i;
-   double   Max, Min;
-   long     Coord [2];          /* might use 0, 1 or 2 elements */
-   int      old_ncopts;
-   int      ret;
-   nc_type  range_type;
-   int      range_len;
-   int      update_vr;
-   double   valid_range[2];
-   double   vr_max;
-
-#ifdef DEBUG
-   int      NumDims;            /* number of dimensions in imagemax/imagemin */
-   int      Dims [4];           /* dimension ID's of imagemax/imagemin */
-
-   printf ("Slice dimension is %d\n", ImInfo->SliceDim);
-   printf ("Frame dimension is %d\n", ImInfo->FrameDim);
-
-   ncvarinq (ImInfo->CDF, ImInfo->MaxID, NULL, NULL, &NumDims, Dims, NULL);
-   printf ("MIimagemax has %d dimensions: ", NumDims);
-   for (i = 0; i < NumDims; i++)
-   {
-      printf ("%5d", Dims [i]);
-   }
-   putchar ('\n');
-
-   ncvarinq (ImInfo->CDF, ImInfo->MinID, NULL, NULL, &NumDims, Dims, NULL);
-   printf ("MIimagemin has %d dimensions: ", NumDims);
-   for (i = 0; i < NumDims; i++)
-   {
-      printf ("%5d", Dims [i]);
-   }
-   putchar ('\n');
-#endif
-
-   Max = - DBL_MAX;
-   Min = DBL_MAX;
-
-   /*
-    * Find the actual max and min values in the buffer
-    */
+   RunBuffer  *Run = (RunBuffer *) Arg;
+   double     *Image;
+   long        i;
 
-   for (i = 0; i < ImInfo->ImageSize; i++)
+   for (i = 0; i < Run->SliceRun * Run->FrameRun; i++)
    {
-      if (ImVals [i] > Max)
-      {
-         Max = ImVals [i];
-      }
-
-      if (ImVals [i] < Min)
-      {
-         Min = ImVals [i];
-      }
-   }     /* for i */
-
-   /*
-    * Now figure out the Coord vector (where to put the max and min
-    * within the MIimagemax and MIimagemin variables), and put 'em there
-    */
-
-   if (DoFrames)        /* i.e. some frame was specified */
-   { 
-      Coord [ImInfo->FrameDim] = FrameNum;
+      Image = Run->Buffer + i * Run->ImageSize;
+      if (!ReadNextImage (Image, Run->ImageSize, Run->TempFile))
+         break;
+      FindMaxMin (Image, Run->ImageSize, &Run->Max [i], &Run->Min [i]);
    }
+   Run->NumRead = i;
+}     /* ReadRun */
 
-   if (DoSlices)
-   {
-      Coord [ImInfo->SliceDim] = SliceNum;
-   }
-
-#ifdef DEBUG
-   printf ("Slice %ld, frame %ld: max is %lg, min is %lg\n", 
-           (DoSlices) ? (SliceNum) : -1,
-           (DoFrames) ? (FrameNum) : -1,
-           Max, Min);
-   if (DoSlices && DoFrames)
-      printf ("Coord vector is: %ld %ld\n", Coord [0], Coord [1]);
-   
-#endif
-
-   mivarput1 (ImInfo->CDF, ImInfo->MaxID, Coord, NC_DOUBLE, MI_SIGNED, &Max);
-   mivarput1 (ImInfo->CDF, ImInfo->MinID, Coord, NC_DOUBLE, MI_SIGNED, &Min);
-
-   /*
-    * Update the image valid_range attribute for floating-point volumes
-    */
-   if ((ImInfo->DataType == NC_FLOAT) || (ImInfo->DataType == NC_DOUBLE)) {
-
-      /* Get type and length of valid_range attribute */
-      old_ncopts = ncopts; ncopts = 0;
-      ret = ncattinq(ImInfo->CDF, ImInfo->ID, MIvalid_range, 
-                     &range_type, &range_len);
-      ncopts = old_ncopts;
-
-      /* If type and length are okay, then read in old value and update */
-      if ((ret != MI_ERROR) && 
-          (range_type == NC_DOUBLE) && (range_len == 2)) {
-
-         (void) ncattget(ImInfo->CDF, ImInfo->ID, MIvalid_range, valid_range);
-
-         /* Test for first write of valid range */
-         vr_max = (ImInfo->DataType == NC_DOUBLE ? 
-                   1.79769313e+308 : 3.402e+38);
-         update_vr = ((valid_range[0] < -vr_max) && (valid_range[1] > vr_max));
-
-         /* Check the range */
-         if ((Min < valid_range[0]) || update_vr)
-            valid_range[0] = Min;
-         if ((Max > valid_range[1]) || update_vr)
-            valid_range[1] = Max;
-
-         /* Check for whether float rounding is needed */
-         if (ImInfo->DataType == NC_FLOAT) {
-            valid_range[0] = (float) valid_range[0];
-            valid_range[1] = (float) valid_range[1];
-         }
-
-         /* Write it out */
-         (void) ncattput(ImInfo->CDF, ImInfo->ID, MIvalid_range, 
-                         NC_DOUBLE, 2, valid_range);
-
-      }
-
-   }     /* if DataType is floating-point */
-
-}     /* PutMaxMin */
 
 
 /* ----------------------------- MNI Header -----------------------------------
@@ -544,17 +447,39 @@ void PutMaxMin (ImageInfoRec *ImInfo, double *ImVals,
               ERR_IN_TEMP = ran out of data reading the temp file
               ERR_OUT_MINC = some problem writing to MINC file
                 (this should not happen!!!)
+              ERR_NO_MEM = not enough memory for the image buffers
               also sets ErrMsg in the event of an error
 @DESCRIPTION: Reads images sequentially from TempFile, and writes them into
               the image variable specified by *Image at the slice/frame
               locations specified by Slices[] and Frames[].  Smart enough
               to handle files with no time dimension, but assumes there
               is always a z dimension.
-@METHOD     : 
+@METHOD     : The images are handled a run at a time, a run being as
+              many consecutive slices (or frames) as will fit in
+              RUN_BYTES.  This works because only one of Slices[] and
+              Frames[] can have more than one element, and the images in
+              the temp file are in the same order as they are in a
+              hyperslab of that dimension.  For each run, the max and
+              min of every image are put in the file all at once (they
+              have to be there before the images are written, as the
+              ICV scales each image by them), and then the whole run is
+              converted and written with one call to miicv_put.
+
+              There are two run buffers: while one run is being
+              converted and written, the next one is read from the temp
+              file (and its max and min found) by ReadRun, in another
+              thread if there are threads.  The conversion itself stays
+              in miicv_put, on this thread -- the MINC and NetCDF
+              libraries are not thread-safe, and the ICV's scaling,
+              valid range and NaN handling are not worth duplicating --
+              so it is the reading and scanning that overlaps with the
+              converting and writing.
 @GLOBALS    : 
-@CALLS      : 
+@CALLS      : RunLength, ReadRun, StartThread, WaitThread, PutMaxMins
 @CREATED    : 93-6-3, Greg Ward
-@MODIFIED   : 
+@MODIFIED   : 16 Oct 2026 - write runs of consecutive images with one
+              hyperslab (and their max/min values with one more),
+              reading the next run in the background
 ---------------------------------------------------------------------------- */
 int WriteImages (FILE *TempFile,
                  ImageInfoRec *Image,
@@ -563,20 +488,20 @@ int WriteImages (FILE *TempFile,
                  long NumSlices,
                  long NumFrames)
 {
-   int      slice, frame;
-   long     Start [MAX_NC_DIMS], Count [MAX_NC_DIMS];
-   double   *Buffer;
-   Boolean  DoFrames;
-   Boolean  DoSlices;
-   Boolean  Success;
-   int      RetVal;
-
-   Buffer = (double *) calloc (Image->ImageSize, sizeof (double));
+   long       slice, frame;
+   long       MaxRun;
+   long       Start [MAX_NC_DIMS], Count [MAX_NC_DIMS];
+   RunBuffer  Runs [2];
+   RunBuffer  *Run, *Next;
+   EmmaThread Thread;
+   Boolean    DoFrames;
+   Boolean    DoSlices;
+   int        Result;
+   int        i;
 
    /*
-    * First ensure that we will always read an *entire* image, but only
-    * one slice/frame at a time (no matter how many slices/frames we
-    * may be reading)
+    * First ensure that we will always write an *entire* image (or
+    * several, one after the other)
     */
 
    Start [Image->HeightDim] = 0; Count [Image->HeightDim] = Image->Height;
@@ -611,64 +536,147 @@ int WriteImages (FILE *TempFile,
       NumSlices = 1;
    }
 
+   /*
+    * Allocate two buffers, each with room for the longest run we'll
+    * write (and the max and min of each image in it)
+    */
+
+   MaxRun = RUN_BYTES / (Image->ImageSize * (long) sizeof (double));
+   if (MaxRun < 1)
+      MaxRun = 1;
+   if (MaxRun > NumSlices * NumFrames)
+      MaxRun = NumSlices * NumFrames;
+
+   Result = ERR_NONE;
+   for (i = 0; i < 2; i++)
+   {
+      Runs [i].TempFile = TempFile;
+      Runs [i].ImageSize = Image->ImageSize;
+      Runs [i].Buffer = (double *)
+         malloc (MaxRun * Image->ImageSize * sizeof (double));
+      Runs [i].Max = (double *) malloc (2 * MaxRun * sizeof (double));
+      if ((Runs [i].Buffer == NULL) || (Runs [i].Max == NULL))
+         Result = ERR_NO_MEM;
+      else
+         Runs [i].Min = Runs [i].Max + MaxRun;
+   }
+   if (Result != ERR_NONE)
+   {
+      for (i = 0; i < 2; i++)
+      {
+         free (Runs [i].Buffer);
+         free (Runs [i].Max);
+      }
+      sprintf (ErrMsg, "Out of memory");
+      return (ERR_NO_MEM);
+   }
+
 #ifdef DEBUG
-   printf ("Ready to start writing.\n");
+   printf ("Ready to start writing (up to %ld images at a time).\n", MaxRun);
    printf ("NumFrames = %ld, DoFrames = %d\n", NumFrames, (int) DoFrames);
    printf ("NumSlices = %ld, DoSlices = %d\n", NumSlices, (int) DoSlices);
 #endif
 
-  
-   for (slice = 0; slice < NumSlices; slice++)
+   /*
+    * Go through the slices and frames a run at a time: a run of slices
+    * if there is just one frame, otherwise a run of frames.  Note that
+    * NumSlices and NumFrames will be one even if DoSlices or DoFrames
+    * is false; so there is always at least one run, but it acts
+    * slightly differently depending on DoSlices and DoFrames.  Run is
+    * the one being written (NULL to begin with), Next the one being
+    * read.
+    */
+
+   Run = NULL;
+   Next = &Runs [0];
+   slice = frame = 0;
+   while (TRUE)
    {
-      if (DoSlices)
+      /* Start reading the run at slice, frame (if there is one)... */
+
+      if (slice < NumSlices)
       {
-         Start [Image->SliceDim] = Slices [slice];
+         Next->Slice = slice;
+         Next->Frame = frame;
+         Next->SliceRun = 1;
+         Next->FrameRun = 1;
+         if (DoSlices && (NumFrames == 1))
+            Next->SliceRun = min (RunLength (Slices, NumSlices, slice), MaxRun);
+         if (DoFrames)
+            Next->FrameRun = min (RunLength (Frames, NumFrames, frame), MaxRun);
+         StartThread (&Thread, ReadRun, Next);
       }
 
-      /* 
-       * Loop through all frames, reading/writing one image each time.
-       * Note that NumFrames will be one even if DoFrames is false; 
-       * so this loop WILL always execute, but it and the functions it calls
-       * (particularly PutMaxMin) act slightly differently depending on
-       * the value of DoFrames,
+      /*
+       * ...while writing the one before it (at least one of SliceRun
+       * and FrameRun is 1 here)
        */
 
-      for (frame = 0; frame < NumFrames; frame++)
+      if (Run != NULL)
       {
-         Success = ReadNextImage (Buffer, Image->ImageSize, TempFile);
-         if (!Success)
+         if (DoSlices)
          {
-            sprintf (ErrMsg, 
-                    "Error reading from temporary file at slice %d, frame %d", 
-                    slice, frame);
-            return (ERR_IN_TEMP);
+            Start [Image->SliceDim] = Slices [Run->Slice];
+            Count [Image->SliceDim] = Run->SliceRun;
          }
-
-         PutMaxMin (Image, Buffer,
-                    Slices [slice], Frames [frame],
-                    DoSlices, DoFrames);
-
          if (DoFrames)
          {
-            Start [Image->FrameDim] = Frames [frame];
+            Start [Image->FrameDim] = Frames [Run->Frame];
+            Count [Image->FrameDim] = Run->FrameRun;
          }
 
-         RetVal = miicv_put (Image->ICV, Start, Count, Buffer);
-         if (RetVal == MI_ERROR)
+         PutMaxMins (Image, Slices + Run->Slice, Frames + Run->Frame,
+                     DoSlices ? Run->SliceRun : 0,
+                     DoFrames ? Run->FrameRun : 0,
+                     Run->Max, Run->Min);
+
+         if (miicv_put (Image->ICV, Start, Count, Run->Buffer) == MI_ERROR)
          {
             sprintf (ErrMsg, "INTERNAL BUG: Fail on miicv_put: Error code %d",
                      ncerr);
-            return (ERR_OUT_MINC);
+            Result = ERR_OUT_MINC;
          }
-      }     /* for frame */
-   }     /* for slice */
+      }
+
+      WaitThread (&Thread);
+      if ((Result != ERR_NONE) || (slice >= NumSlices))
+         break;
+
+      Run = Next;
+      Next = (Run == &Runs [0]) ? &Runs [1] : &Runs [0];
+      if (Run->NumRead < Run->SliceRun * Run->FrameRun)
+      {
+         sprintf (ErrMsg, 
+                  "Error reading from temporary file at slice %ld, "
+                  "frame %ld",
+                  Run->Slice + Run->NumRead / Run->FrameRun,
+                  Run->Frame + Run->NumRead % Run->FrameRun);
+         Result = ERR_IN_TEMP;
+         break;
+      }
+
+      frame += Run->FrameRun;
+      if (frame >= NumFrames)
+      {
+         slice += Run->SliceRun;
+         frame = 0;
+      }
+   }
 
    /*
-    * Use the MIcomplete attribute to signal that we are done writing
+    * The reader has stopped by now, so its buffers can go; then use
+    * the MIcomplete attribute to signal that we are done writing
     */
-   miattputstr (Image->CDF, Image->ID, MIcomplete, MI_TRUE);
-   free (Buffer);
-   return (ERR_NONE);
+
+   for (i = 0; i < 2; i++)
+   {
+      free (Runs [i].Buffer);
+      free (Runs [i].Max);
+   }
+
+   if (Result == ERR_NONE)
+      miattputstr (Image->CDF, Image->ID, MIcomplete, MI_TRUE);
+   return (Result);
 
 }     /* WriteImages */
 
@@ -0,0 +1,123 @@
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : nconv.c (CMEX)
+@INPUT      : a, b - vectors to convolve
+              spacing - (optional) sample spacing of a and b; default 1
+@OUTPUT     : c - the convolution of a and b, scaled by spacing
+@RETURNS    : 
+@DESCRIPTION: CMEX replacement for nconv.m.  Gives the same result, but
+              uses Convolve (in the EMMA library), which switches to an
+              FFT for long vectors -- so convolving two n-point vectors
+              takes time proportional to n log n rather than n^2.
+@METHOD     : 
+@GLOBALS    : 
+@CALLS      : Convolve
+@CREATED    : 2026/10/16
+@MODIFIED   : 
+@VERSION    : $Id$
+              $Name:  $
+---------------------------------------------------------------------------- */
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include "mex.h"
+#include "emmageneral.h"
+#include "emmaproto.h"
+
+#define PROGNAME "nconv"
+
+#define A_IN     prhs[0]
+#define B_IN     prhs[1]
+#define SPACING  prhs[2]
+#define C_OUT    plhs[0]
+
+
+void usage (void)
+{
+    mexPrintf("\nUsage:\n");
+    mexPrintf("c = %s (a, b [, spacing])\n", PROGNAME);
+}
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : CheckVector
+@INPUT      : Vector - MATLAB Matrix passed in by the caller
+              Name - what to call it in error messages
+@OUTPUT     : 
+@RETURNS    : the number of elements in Vector
+              does not return if Vector is not a real vector -- calls
+              mexErrMsgTxt
+@DESCRIPTION: 
+@METHOD     : 
+@GLOBALS    : 
+@CALLS      : 
+@CREATED    : 2026/10/16
+@MODIFIED   : 
+---------------------------------------------------------------------------- */
+int CheckVector (const mxArray *Vector, char *Name)
+{
+    char    msg[80];
+
+    if (!mxIsDouble (Vector) || mxIsComplex (Vector) ||
+        (min (mxGetM (Vector), mxGetN (Vector)) > 1))
+    {
+        usage();
+        sprintf (msg, "%s must be a real vector", Name);
+        mexErrMsgTxt (msg);
+    }
+    return (mxGetM (Vector) * mxGetN (Vector));
+}
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : mexFunction
+@INPUT      : nrhs, prhs[] - number and array of input arguments
+              nlhs - number of output arguments
+@OUTPUT     : plhs[0] created and points to the convolution
+@RETURNS    : (void)
+@DESCRIPTION: 
+@METHOD     : The result has length(a)+length(b)-1 elements, and (like
+              nconv.m, which gets it from filter) is a column if the
+              longer of a and b is a column, and a row otherwise.
+@GLOBALS    : 
+@CALLS      : CheckVector, Convolve
+@CREATED    : 2026/10/16
+@MODIFIED   : 
+---------------------------------------------------------------------------- */
+void mexFunction (int nlhs, mxArray *plhs [],
+                  int nrhs, const mxArray *prhs [])
+{
+    const mxArray *Longer;
+    int     na, nb, nc;
+    double  spacing;
+
+    if ((nrhs < 1) || (nrhs > 3))
+    {
+        usage();
+        mexErrMsgTxt("Incorrect number of input arguments!");
+    }
+
+    na = CheckVector (A_IN, "a");
+    nb = (nrhs >= 2) ? CheckVector (B_IN, "b") : na;
+    spacing = (nrhs >= 3) ? mxGetScalar (SPACING) : 1.0;
+
+    if ((na == 0) || (nb == 0))
+    {
+        C_OUT = mxCreateDoubleMatrix (0, 0, mxREAL);
+        return;
+    }
+
+    nc = na + nb - 1;
+    Longer = (nrhs < 2 || na > nb) ? A_IN : B_IN;
+    if (mxGetN (Longer) == 1)
+    {
+        C_OUT = mxCreateDoubleMatrix (nc, 1, mxREAL);
+    }
+    else
+    {
+        C_OUT = mxCreateDoubleMatrix (1, nc, mxREAL);
+    }
+
+    Convolve (na, mxGetPr (A_IN),
+              nb, mxGetPr ((nrhs >= 2) ? B_IN : A_IN),
+              spacing, nc, mxGetPr (C_OUT));
+}
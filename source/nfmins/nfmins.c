@@ -9,7 +9,16 @@
 @GLOBALS    : 
 @CALLS      : 
 @CREATED    : October 29, 1993 by Mark Wolforth
-@MODIFIED   : 
+@MODIFIED   : 2026/10/16: objective functions with a compiled equivalent
+              (see fitmodels.c) are evaluated in C instead of calling
+              back into MATLAB
+              2026/10/16: batch mode -- with a compiled objective and a
+              matrix of data (one row per voxel), fit every row in one
+              call
+              2026/10/16: use the simplex minimiser in simplex.c (shared
+              with delaycorrect)
+              2026/10/16: batch fits are shared among threads (when
+              built with OpenMP)
 @VERSION    : $Id: nfmins.c,v 1.7 2004-03-11 15:42:43 bert Exp $
               $Name:  $
 ---------------------------------------------------------------------------- */
@@ -18,8 +27,13 @@
 #include <string.h>
 #include <stdlib.h>
 #include <math.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 #include "mex.h"
 #include "emmageneral.h"
+#include "fitmodels.h"
+#include "simplex.h"
 
 
 #define PROGNAME "nfmins"
@@ -37,12 +51,34 @@
 #define OPTIONS            prhs[2]
 #define GRAD               prhs[3]    /* Ignored */
 
-#define ALPHA              1
-#define BETA               0.5
-#define GAMMA              2
+/*
+ * The extra arguments taken by the compiled objective functions:
+ * (x, g_even, ts_even, A, fstart, flengths)
+ */
 
-#define FUNCVAL            (numvars)
+#define NUM_MODEL_ARGS     5
+#define MODEL_DATA         3    /* A is arguments[3] */
 
+/*
+ * How to evaluate the objective function: either with a compiled
+ * model, or by calling a MATLAB function with x followed by the
+ * extra arguments.
+ */
+
+typedef struct
+{
+    FitModel *model;            /* NULL if calling back to MATLAB */
+    FitData   data;
+    char     *funfcn;
+    mxArray **arguments;
+    int       numargs;
+    mxArray  *answer[1];
+    int       numproblems;      /* number of rows of A (batch mode) */
+    double   *batchdata;        /* A itself, if numproblems > 1 */
+    double   *fitdata;          /* the current row of A */
+} Objective;
+
+double  NaN;                    /* needed by IntFrames */
 Boolean progress;
 char    *ErrMsg ;         /*
                            * set as close to the occurence of the
@@ -80,42 +116,6 @@ void ErrAbort (char msg[], Boolean PrintUsage, int ExitCode)
 }
 
 
-/* ----------------------------- MNI Header -----------------------------------
-@NAME       : CreateLocalMatrix
-@INPUT      : 
-@OUTPUT     : 
-@RETURNS    : 
-@DESCRIPTION:               
-@METHOD     : 
-@GLOBALS    : 
-@CALLS      : 
-@CREATED    : 
-@MODIFIED   : 
----------------------------------------------------------------------------- */
-double **CreateLocalMatrix(int rows, int cols)
-{
-    int i;
-    double **matrix;
-
-    matrix = (double **) mxCalloc (rows, sizeof(double *));
-    if (matrix == NULL)
-    {
-        ErrAbort("Out of memory!", FALSE, -1);
-    }
-    
-    for (i=0; i<rows; i++)
-    {
-        matrix[i] = (double *) mxCalloc (cols, sizeof(double));
-        if (matrix[i] == NULL)
-        {
-            ErrAbort("Out of memory!", FALSE, -1);
-        }
-    }
-    
-    return (matrix);
-}
-
-
 /* ----------------------------- MNI Header -----------------------------------
 @NAME       : GetArguments
 @INPUT      : 
@@ -207,412 +207,335 @@ void CopyVector(double vec1[], const double vec2[], int size)
 
 
 /* ----------------------------- MNI Header -----------------------------------
-@NAME       : SortSimplex
-@INPUT      : 
+@NAME       : IsRealVector
+@INPUT      : Arg - a MATLAB Matrix
 @OUTPUT     : 
-@RETURNS    : 
-@DESCRIPTION:               
+@RETURNS    : number of elements in Arg if it is a real vector, or -1
+@DESCRIPTION: 
 @METHOD     : 
 @GLOBALS    : 
 @CALLS      : 
-@CREATED    : 
+@CREATED    : 2026/10/16
 @MODIFIED   : 
 ---------------------------------------------------------------------------- */
-void SortSimplex (double **simplex, int numvars)
+int IsRealVector (const mxArray *Arg)
 {
-    int i;
-    Boolean bubbled;
-    double *pointer;
-    
-    bubbled = TRUE;
-
-    while (bubbled)
+    if (!mxIsDouble (Arg) || mxIsComplex (Arg) ||
+        (min (mxGetM (Arg), mxGetN (Arg)) != 1))
     {
-        bubbled = FALSE;
-        for (i=0; i<numvars; i++)
-        {
-            if (simplex[i][FUNCVAL] > simplex[i+1][FUNCVAL])
-            {
-                pointer = simplex[i];
-                simplex[i] = simplex[i+1];
-                simplex[i+1] = pointer;
-                bubbled = TRUE;
-            }
-        }
-    }    
+        return (-1);
+    }
+    return (max (mxGetM (Arg), mxGetN (Arg)));
 }
 
 
 /* ----------------------------- MNI Header -----------------------------------
-@NAME       : PrintSimplex
-@INPUT      : 
-@OUTPUT     : 
-@RETURNS    : 
-@DESCRIPTION:               
+@NAME       : SetupObjective
+@INPUT      : funfcn - name of the objective function
+              arguments[] - x (arguments[0]) and the extra arguments
+                            for the objective function
+              numargs - number of elements in arguments[]
+              numvars - number of elements in x
+@OUTPUT     : *objective - ready for EvalObjective
+@RETURNS    : (void)
+@DESCRIPTION: Decides how the objective function will be evaluated.  If
+              funfcn names one of the compiled models in fitmodels.c,
+              and the arguments are what that model expects, the model
+              is used; otherwise we call funfcn in MATLAB.
+
+              If a compiled model is used and A is a matrix rather
+              than a vector, each row of A is a separate problem;
+              objective->numproblems is set to the number of rows, and
+              SelectProblem must be called to choose a row before
+              fitting.
 @METHOD     : 
-@GLOBALS    : 
-@CALLS      : 
-@CREATED    : 
+@GLOBALS    : progress
+@CALLS      : FindFitModel, IsRealVector, InitFitData
+@CREATED    : 2026/10/16
 @MODIFIED   : 
 ---------------------------------------------------------------------------- */
-void PrintSimplex (double **simplex, int numvars)
+void SetupObjective (char *funfcn, mxArray *arguments[], int numargs,
+                     int numvars, Objective *objective)
 {
-    int i,j;
+    mxArray *mNaN;
+    int numsamples, numframes, numfitpoints;
+    double *fitdata;
+
+    objective->funfcn = funfcn;
+    objective->arguments = arguments;
+    objective->numargs = numargs;
+    objective->answer[0] = NULL;
+    objective->numproblems = 1;
+    objective->batchdata = NULL;
+
+    objective->model = FindFitModel (funfcn);
+    if (objective->model == NULL)
+    {
+        return;
+    }
 
-    printf ("Vertices:\n");
-    
-    for (i=0; i<(numvars+1); i++)
+    /*
+     * Arguments are (x, g_even, ts_even, A, fstart, flengths); make sure
+     * they're all there and consistent before trusting them to the
+     * compiled version.
+     */
+
+    if ((numargs == NUM_MODEL_ARGS+1) &&
+        (numvars == objective->model->NumParams))
     {
-	for (j=0; j<(numvars); j++)
-	{
-	    printf ("%lf  ", simplex[i][j]);
-	}
-	printf ("\n");
+        numsamples = IsRealVector (arguments[1]);
+        numfitpoints = IsRealVector (arguments[MODEL_DATA]);
+        numframes = IsRealVector (arguments[4]);
+        fitdata = mxGetPr (arguments[MODEL_DATA]);
+
+        /*
+         * A matrix of data means a batch of problems, one per row.
+         * The rows aren't contiguous, so each is copied out to
+         * objective->fitdata as it is needed.
+         */
+
+        if ((numfitpoints < 0) && mxIsDouble (arguments[MODEL_DATA]) &&
+            !mxIsComplex (arguments[MODEL_DATA]))
+        {
+            objective->numproblems = mxGetM (arguments[MODEL_DATA]);
+            numfitpoints = mxGetN (arguments[MODEL_DATA]);
+            objective->batchdata = fitdata;
+            objective->fitdata = (double *) mxCalloc (numfitpoints,
+                                                      sizeof (double));
+            fitdata = objective->fitdata;
+        }
+
+        if ((numsamples > 1) && (numframes > 0) && (numfitpoints > 0) &&
+            (IsRealVector (arguments[2]) == numsamples) &&
+            (IsRealVector (arguments[5]) == numframes) &&
+            InitFitData (&objective->data,
+                         numsamples, mxGetPr (arguments[2]),
+                         mxGetPr (arguments[1]),
+                         numframes, mxGetPr (arguments[4]),
+                         mxGetPr (arguments[5]),
+                         numfitpoints, fitdata))
+        {
+            mexCallMATLAB (1, &mNaN, 0, NULL, "NaN");
+            NaN = *(mxGetPr(mNaN));
+
+            if (progress)
+            {
+                printf ("Using compiled objective function %s\n", funfcn);
+            }
+            return;
+        }
     }
-    
-    printf ("Function Values:\n");
-    for (i=0; i<(numvars+1); i++)
+
+    if (progress)
     {
-	printf ("%lf\n",simplex[i][FUNCVAL]);
+        printf ("Arguments don't match compiled %s; calling MATLAB\n",
+                funfcn);
     }
+    objective->model = NULL;
+    objective->numproblems = 1;
+    objective->batchdata = NULL;
 }
 
 
 /* ----------------------------- MNI Header -----------------------------------
-@NAME       : GetStartingSimplex
-@INPUT      : 
+@NAME       : SelectProblem
+@INPUT      : objective - set up by SetupObjective, in batch mode
+              problem - which row of A to fit next (zero-based)
 @OUTPUT     : 
-@RETURNS    : 
-@DESCRIPTION:               
+@RETURNS    : (void)
+@DESCRIPTION: Copies one row of A to where the compiled model will look
+              for its data.
 @METHOD     : 
 @GLOBALS    : 
 @CALLS      : 
-@CREATED    : 
+@CREATED    : 2026/10/16
 @MODIFIED   : 
 ---------------------------------------------------------------------------- */
-void GetStartingSimplex(double start[], int numvars,
-                        char *funfcn, mxArray *arguments[], int numargs,
-                        double **simplex)
+void SelectProblem (Objective *objective, int problem)
 {
-    mxArray *answer[1];
     int i;
 
-    if (progress)
-    {
-	printf ("Creating a matrix for the function return.\n");
-    }
-    
-    answer[0] = mxCreateDoubleMatrix(1,1,mxREAL);
-
-    if (progress)
-    {
-	printf ("Filling the first vertex.\n");
-    }
-
-    for (i=0; i<numvars; i++)
-    {
-        simplex[0][i] = 0.9 * start[i];
-    }
-
-    if (progress)
-    {
-	printf ("Filling the first function value.\n");
-    }
-
-    mxSetPr(arguments[0], simplex[0]);
-    mexCallMATLAB(1, answer, numargs, arguments, funfcn);
-    simplex[0][FUNCVAL] = mxGetScalar(answer[0]);
-
-    if (progress)
-    {
-	printf ("Filling the remaining vertices.\n");
-    }
-    
-    for (i=1; i<(numvars+1); i++)
-    {
-
-	if (progress)
-	{
-	    printf ("Copying a starting vector.\n");
-	}
-
-        CopyVector(simplex[i], start, numvars);
-
-	if (progress)
-	{
-	    printf ("Comparing element (%d,%d) to zero.\n", i, (i-1));
-	}
-
-        if (simplex[i][i-1] != 0)
-        {
-	    if (progress)
-	    {
-		printf ("Okay, set it equal to 1.1 times itself.\n");
-	    }
-            simplex[i][i-1] *= 1.1;
-        }
-        else
-        {
-	    if (progress)
-	    {
-		printf ("Set it equal to 0.1.\n");
-	    }
-            simplex[i][i-1] = 0.1;
-        }
-	
-	if (progress)
-	{
-	    printf ("Get the function value for this vertex.\n");
-	}
-
-        mxSetPr(arguments[0], simplex[i]);
-        mexCallMATLAB(1, answer, numargs, arguments, funfcn);
-        simplex[i][FUNCVAL] = mxGetScalar(answer[0]);
-    }
-
-    SortSimplex(simplex, numvars);
-
-    if (progress)
+    for (i = 0; i < objective->data.numfitpoints; i++)
     {
-	printf("Starting simplex:\n");
-	PrintSimplex(simplex, numvars);
+        objective->fitdata[i] =
+            objective->batchdata[problem + i*objective->numproblems];
     }
 }
 
 
 /* ----------------------------- MNI Header -----------------------------------
-@NAME       : Terminated
-@INPUT      : 
+@NAME       : EvalObjective
+@INPUT      : x[] - point at which to evaluate the objective function
+              data - the Objective set up by SetupObjective
 @OUTPUT     : 
-@RETURNS    : 
-@DESCRIPTION:               
+@RETURNS    : value of the objective function at x
+@DESCRIPTION: 
 @METHOD     : 
 @GLOBALS    : 
-@CALLS      : 
-@CREATED    : 
-@MODIFIED   : 
+@CALLS      : the compiled model, or mexCallMATLAB
+@CREATED    : 2026/10/16 (from code repeated throughout MinimizeSimplex)
+@MODIFIED   : 2026/10/16: copy x into arguments[0] instead of pointing
+              arguments[0] at it
 ---------------------------------------------------------------------------- */
-Boolean Terminated (double **simplex, int numvars, double tol, double tol2)
+double EvalObjective (double x[], void *data)
 {
-    int i,j;
-    
-    for (i=1; i<(numvars+1); i++)
+    Objective *objective = (Objective *) data;
+    double value;
+
+    if (objective->model != NULL)
     {
-        for (j=0; j<numvars; j++)
-        {
-            if (abs(simplex[i][j] - simplex[0][j]) > tol)
-            {
-                return (FALSE);
-            }
-        }
-        if (abs(simplex[i][FUNCVAL] - simplex[0][FUNCVAL]) > tol2)
-        {
-            return (FALSE);
-        }
+        return ((*objective->model->Function) (x, &objective->data));
     }
-    return (TRUE);
+
+    /*
+     * x is somewhere in the middle of the simplex, so must be copied
+     * into arguments[0] -- which owns its own data, and frees it when
+     * it's destroyed -- rather than handed to it with mxSetPr
+     */
+
+    memcpy (mxGetPr (objective->arguments[0]), x,
+            mxGetN (objective->arguments[0]) * sizeof (double));
+    mexCallMATLAB(1, objective->answer, objective->numargs,
+                  objective->arguments, objective->funfcn);
+    value = mxGetScalar(objective->answer[0]);
+    mxDestroyArray (objective->answer[0]);
+    return (value);
 }
 
 
 /* ----------------------------- MNI Header -----------------------------------
-@NAME       : MinimizeSimplex
-@INPUT      : 
-@OUTPUT     : 
-@RETURNS    : 
-@DESCRIPTION:               
-@METHOD     : 
+@NAME       : FitBatch
+@INPUT      : objective - set up by SetupObjective, in batch mode
+              numvars - number of elements of start[]
+              start[] - where to start every fit
+              maxiter, tol, tol2 - as for MinimizeSimplex
+@OUTPUT     : return_argument[] - the fitted parameters, one row for
+                 each problem (ie. a numproblems x numvars MATLAB matrix)
+              return_values[] - the final function value of each fit
+@RETURNS    : (void)
+@DESCRIPTION: Fits every row of A, each starting from the same point.
+              If A has no rows there is nothing to fit, and the (empty)
+              outputs are left alone.
+@METHOD     : The fits are independent of each other, and the compiled
+              model makes no calls to MATLAB, so when built with OpenMP
+              the rows are shared out among threads.  Each thread gets
+              its own copy of the objective (with its own row of data
+              and work space) and its own simplex; these are all made
+              here, before the threads start, since mxCalloc mustn't be
+              called from any but the main thread.  The simplexes don't
+              print their progress, for the same reason.
 @GLOBALS    : 
-@CALLS      : 
-@CREATED    : 
+@CALLS      : InitFitData, CreateSimplex, SelectProblem, StartSimplex,
+              MinimizeSimplex, FreeFitData
+@CREATED    : 2026/10/16 (from mexFunction)
 @MODIFIED   : 
 ---------------------------------------------------------------------------- */
-void MinimizeSimplex (double **simplex, char *funfcn, mxArray *arguments[],
-                      int numargs, int numvars, int maxiter, double tol,
-		      double tol2, double minimum[], double *finalvalue)
+void FitBatch (Objective *objective, int numvars, double start[],
+               int maxiter, double tol, double tol2,
+               double return_argument[], double return_values[])
 {
-    mxArray *answer[1];
-    char how[256];
-    int i,j;
-    int count;
-    double temp_double;
-    double *temp_vector;
-    double *vbar;
-    double *vr;
-    double fr;
-    double *vk;
-    double fk;
-    double *ve;
-    double fe;
-    double *vt;
-    double ft;
-    double *vc;
-    double fc;
-    
+    int numthreads;
+    Objective *objectives;
+    Simplex *simplexes;
+    double *minima;
+    int numproblems;
+    int problem;
+    int thread;
+    int i;
 
-    answer[0] = mxCreateDoubleMatrix(1,1,mxREAL);
-    temp_vector = (double *) mxCalloc (numvars, sizeof (double));
-    vbar = (double *) mxCalloc (numvars, sizeof (double));
-    vr = (double *) mxCalloc (numvars, sizeof (double));
-    vk = (double *) mxCalloc (numvars, sizeof (double));
-    ve = (double *) mxCalloc (numvars, sizeof (double));
-    vt = (double *) mxCalloc (numvars, sizeof (double));
-    vc = (double *) mxCalloc (numvars, sizeof (double));
+    if (objective->numproblems < 1)
+    {
+        return;
+    }
 
-    count = numvars+1;
-    
-    while (count < maxiter)
+    numthreads = 1;
+#ifdef _OPENMP
+    numthreads = omp_get_max_threads ();
+    if (numthreads > objective->numproblems)
     {
-	if (progress)
-	{
-	    printf ("Current simplex:\n");
-	    PrintSimplex(simplex, numvars);
-	}
-	
-	
-        if (Terminated(simplex, numvars, tol, tol2))
+        numthreads = objective->numproblems;
+    }
+    if (numthreads < 1)
+    {
+        numthreads = 1;
+    }
+#endif
+
+    objectives = (Objective *) mxCalloc (numthreads, sizeof (Objective));
+    simplexes = (Simplex *) mxCalloc (numthreads, sizeof (Simplex));
+    minima = (double *) mxCalloc (numthreads * numvars, sizeof (double));
+
+    /*
+     * Thread 0 uses the objective that was set up already; the others
+     * get copies with their own data and work space (if any copy
+     * can't be made, we just use fewer threads)
+     */
+
+    objectives[0] = *objective;
+    for (thread = 1; thread < numthreads; thread++)
+    {
+        objectives[thread] = *objective;
+        objectives[thread].fitdata = (double *)
+            mxCalloc (objective->data.numfitpoints, sizeof (double));
+        if (!InitFitData (&objectives[thread].data,
+                          objective->data.numsamples,
+                          objective->data.ts_even,
+                          objective->data.g_even,
+                          objective->data.numframes,
+                          objective->data.fstarts,
+                          objective->data.flengths,
+                          objective->data.numfitpoints,
+                          objectives[thread].fitdata))
         {
-	    if (progress)
-	    {
-		printf ("Terminated after %d iterations.\n", count);
-	    }
+            numthreads = thread;
             break;
         }
+    }
+    for (thread = 0; thread < numthreads; thread++)
+    {
+        CreateSimplex (&simplexes[thread], numvars, EvalObjective,
+                       &objectives[thread], FALSE);
+    }
 
-        for (i=0; i<numvars; i++)
-        {
-            temp_double = 0;
-            for (j=0; j<numvars; j++)
-            {
-                temp_double += simplex[j][i];
-            }
-            vbar[i] = temp_double / numvars;
-            vr[i] = ((1+ALPHA)*vbar[i]) - (ALPHA*simplex[numvars][i]);
-        }           
-        
-        mxSetPr(arguments[0], vr);
-        mexCallMATLAB(1, answer, numargs, arguments, funfcn); 
-        fr = mxGetScalar(answer[0]);
-
-        count++;
-
-        CopyVector (vk, vr, numvars);
-        fk = fr;
-
-	strcpy (how, "Reflect.\n");
-        
-        if (fr < simplex[numvars-1][FUNCVAL])
-        {
-            if (fr < simplex[0][FUNCVAL])
-            {
-                for (i=0; i<numvars; i++)
-                {
-                    ve[i] = GAMMA*vr[i] + (1-GAMMA)*vbar[i];
-                }
-                
-                mxSetPr(arguments[0], ve);
-                mexCallMATLAB(1, answer, numargs, arguments, funfcn); 
-                fe = mxGetScalar(answer[0]);
-
-                count++;
-                
-                if (fe < simplex[0][FUNCVAL])
-                {
-                    CopyVector(vk,ve,numvars);
-                    fk = fe;
-		    
-		    strcpy (how, "Expand.\n");
-
-                }
-            }
-        }
-        else 
-        {
-            CopyVector(vt,simplex[numvars], numvars);
-            ft = simplex[numvars][FUNCVAL];
-            if (fr < ft)
-            {
-                CopyVector(vt,vr,numvars);
-                ft = fr;
-            }
-            
-            for (i=0; i<numvars; i++)
-            {
-                vc[i] = BETA*vt[i] + (1-BETA)*vbar[i];
-            }
-                
-            mxSetPr(arguments[0], vc);
-            mexCallMATLAB(1, answer, numargs, arguments, funfcn);     
-            fc = mxGetScalar(answer[0]);
-            
-            count++;
-            
-            if (fc < simplex[numvars-1][FUNCVAL])
-            {
-                CopyVector(vk,vc,numvars);
-                fk = fc;
+    if (progress)
+    {
+        printf ("Fitting %d problems with %d thread(s).\n",
+                objective->numproblems, numthreads);
+    }
 
-		strcpy (how, "Contract.\n");
+    numproblems = objective->numproblems;
 
-            }
-            else 
-            {
-                for (i=1; i<numvars; i++)
-                {
-                    for (j=0; j<numvars; j++)
-                    {
-                        temp_vector[j] = (simplex[0][j] + simplex[i][j])/2;
-                    }
-                    CopyVector(simplex[i], temp_vector, numvars);
-                                
-                    mxSetPr(arguments[0], simplex[i]);
-                    mexCallMATLAB(1, answer, numargs, arguments, funfcn);     
-                    simplex[i][FUNCVAL] = mxGetScalar(answer[0]);
-                    
-                }
-                
-                count += numvars - 1;
-
-                for (i=0; i<numvars; i++)
-                {
-                    vk[i] = (simplex[0][i] + simplex[numvars][i])/2;
-                }
-                
-                mxSetPr(arguments[0], vk);
-                mexCallMATLAB(1, answer, numargs, arguments, funfcn); 
-                fk = mxGetScalar(answer[0]);
-
-		strcpy (how,"Shrink\n");
-                
-                count++;
-                
-            }
-        }
-        
-        for (i=0; i<numvars; i++)
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(numthreads) schedule(dynamic) private(thread, i)
+#endif
+    for (problem = 0; problem < numproblems; problem++)
+    {
+        thread = 0;
+#ifdef _OPENMP
+        thread = omp_get_thread_num ();
+#endif
+        SelectProblem (&objectives[thread], problem);
+        StartSimplex (&simplexes[thread], start);
+        MinimizeSimplex (&simplexes[thread], maxiter, tol, tol2,
+                         minima + thread*numvars, &return_values[problem]);
+
+        for (i = 0; i < numvars; i++)
         {
-            simplex[numvars][i] = vk[i];
+            return_argument[problem + i*numproblems] =
+                minima[thread*numvars + i];
         }
-        simplex[numvars][FUNCVAL] = fk;
-        
-        SortSimplex (simplex, numvars);
-
-	if (progress)
-	{
-	    printf ("\n-----------------------\nIteration: %s", how);
-	}
-	
     }
-    if ((count >= maxiter) && progress)
-    {
-	printf ("Maximum number of iterations exceeded!\n");
-    }	
-
-    CopyVector (minimum, simplex[0], numvars);
-    *finalvalue = simplex[0][FUNCVAL];
 
+    for (thread = 0; thread < numthreads; thread++)
+    {
+        FreeSimplex (&simplexes[thread]);
+        FreeFitData (&objectives[thread].data);
+    }
+    mxFree (minima);
+    mxFree (simplexes);
+    mxFree (objectives);
 }
 
-    
 
 /* ----------------------------- MNI Header -----------------------------------
 @NAME       : mexFunction
@@ -641,10 +564,12 @@ void mexFunction(int    nlhs,
     double tol;
     double tol2;
     double *start;
-    double **simplex;
+    Simplex simplex;
     double *minimum;
     double finalvalue;
     double *return_argument;
+    double *return_values;
+    Objective objective;
     
 
     ErrMsg = (char *) mxCalloc (256, sizeof (char));
@@ -707,34 +632,65 @@ void mexFunction(int    nlhs,
             arguments[i] = (mxArray *) prhs[i+3];
         }
     }
-    arguments[0] = mxCreateDoubleMatrix (1,1,mxREAL);
-    mxSetM (arguments[0], 1);
-    mxSetN (arguments[0], numvars);
+    arguments[0] = mxCreateDoubleMatrix (1, numvars, mxREAL);
 
 
+    SetupObjective (funfcn, arguments, numargs, numvars, &objective);
+
     /*
      * Now we need a starting simplex close to the initial
      * point given by the user.
      */
 
     start = mxGetPr (START);
-    simplex = CreateLocalMatrix (numvars+1, numvars+1);
+    CreateSimplex (&simplex, numvars, EvalObjective, &objective, progress);
+    minimum = (double *) mxCalloc (numvars, sizeof (double));
+
+    /*
+     * In batch mode, fit each row of the data (see FitBatch), starting every
+     * one from the same point, and return one row of parameters (and
+     * one final function value) per problem.
+     */
+
+    if (objective.batchdata != NULL)
+    {
+        plhs[0] = mxCreateDoubleMatrix(objective.numproblems, numvars,
+                                       mxREAL);
+        return_argument = mxGetPr (plhs[0]);
+        if (nlhs > 1)
+        {
+            plhs[1] = mxCreateDoubleMatrix(objective.numproblems, 1, mxREAL);
+            return_values = mxGetPr (plhs[1]);
+        }
+        else
+        {
+            return_values = (double *) mxCalloc (max(objective.numproblems,1),
+                                                 sizeof (double));
+        }
+
+        FitBatch (&objective, numvars, start, maxiter, tol, tol2,
+                  return_argument, return_values);
+        return;
+    }
 
     if (progress)
     {
 	printf ("Getting the starting simplex.\n");
     }
 
-    GetStartingSimplex (start, numvars, funfcn, arguments, numargs, simplex);
+    StartSimplex (&simplex, start);
 
     if (progress)
     {
 	printf ("Minimizing the simplex.\n");
     }
 
-    minimum = (double *) mxCalloc (numvars, sizeof (double));
-    MinimizeSimplex (simplex, funfcn, arguments, numargs, numvars, maxiter,
-                     tol, tol2, minimum, &finalvalue);
+    MinimizeSimplex (&simplex, maxiter, tol, tol2, minimum, &finalvalue);
+
+    if (objective.model != NULL)
+    {
+        FreeFitData (&objective.data);
+    }
 
     plhs[0] = mxCreateDoubleMatrix(1, numvars, mxREAL);
     return_argument = mxGetPr (plhs[0]);
@@ -29,8 +29,8 @@
 #define AREA    plhs[0]
 
 
-extern void TrapInt (int num_bins, double *times, double *values,
-                     double *area);
+extern void TrapCoeffs (int num_bins, double *times, double *weights,
+                        double *coeffs);
 
 
 void usage (void)
@@ -169,11 +169,22 @@ Boolean CheckInputs (const mxArray *X, const mxArray *Y, const mxArray *Weight,
 @OUTPUT     : prhs[0] created and points to a vector
 @RETURNS    : (void)
 @DESCRIPTION: 
-@METHOD     : 
+@METHOD     : The trapezoid widths (times the weights, if given) are
+              turned into one coefficient per time point by TrapCoeffs,
+              so each integral is just a weighted sum of its column or
+              row of Y.  Without a weight, Y has one function per
+              column, so each area is a dot product down a contiguous
+              column.  With a weight, Y has one function per *row*
+              (eg. one row per pixel, one column per frame), so we
+              sweep through Y a column (frame) at a time, adding that
+              frame's contribution to every area at once -- this reads
+              Y strictly in memory order, and the inner loops are
+              simple enough for the compiler to vectorise.
 @GLOBALS    : 
-@CALLS      : CheckInputs
+@CALLS      : CheckInputs, TrapCoeffs
 @CREATED    : 
-@MODIFIED   : 
+@MODIFIED   : 2026/10/16: integrate via TrapCoeffs, reading Y in memory
+              order in both the weighted and unweighted cases
 ---------------------------------------------------------------------------- */
 void mexFunction (int nlhs, mxArray *plhs [],
                   int nrhs, const mxArray *prhs [])
@@ -181,11 +192,10 @@ void mexFunction (int nlhs, mxArray *plhs [],
     double *X;               /* these just point to the real parts */
     double *Y;               /* of various MATLAB Matrix objects */
     double *CurColumn;
-    double *CurRow;
-    double *Rowpointer;
-    double *Weightpointer;
     double *Weight;
     double *Area;
+    double *Coeffs;          /* one per time point, from TrapCoeffs */
+    double Sum;
     int xrows, ycols;
     int i,j;
 
@@ -212,6 +222,7 @@ void mexFunction (int nlhs, mxArray *plhs [],
 
     X = mxGetPr (TIMES);
     Y = mxGetPr (VALUES);
+    Weight = NULL;
     if (nrhs == 3) 
     {
         Weight = mxGetPr (WEIGHT);
@@ -230,32 +241,42 @@ void mexFunction (int nlhs, mxArray *plhs [],
         return;
     }
     
+    Coeffs = (double *) mxCalloc (xrows, sizeof (double));
+    if (Coeffs == NULL)
+    {
+        mexErrMsgTxt("Unable to allocate memory.");
+    }
+    TrapCoeffs (xrows, X, Weight, Coeffs);
+
     if (nrhs != 3)
     {
-	for (i=0; i<ycols; i++)
-	{
-	    CurColumn = Y + (i*xrows);
-	    TrapInt (xrows, X, CurColumn, &(Area[i]));
-	}
+        for (i=0; i<ycols; i++)
+        {
+            CurColumn = Y + (i*xrows);
+            Sum = 0;
+            for (j=0; j<xrows; j++)
+            {
+                Sum += Coeffs[j] * CurColumn[j];
+            }
+            Area[i] = Sum;
+        }
     }
     else {    
 
-	CurRow = (double *) mxCalloc(xrows, sizeof(double));
-	if (CurRow == NULL)
-	{
-	    mexErrMsgTxt("Unable to allocate memory.");
-	}
+        /*
+         * Here ycols is the number of rows of Y (one function per row),
+         * and xrows the number of columns.  Area was zeroed by
+         * mxCreateDoubleMatrix, so just accumulate one column at a time.
+         */
 
-	for (i=0; i<ycols; i++)
-	{
-	    Rowpointer = CurRow;
-	    Weightpointer = Weight;
-	    for (j=0; j<xrows; j++)
-	    {
-		*(Rowpointer++) = ((*(Y + i + j*ycols)) * (*(Weightpointer++)));
-	    }
-	    TrapInt (xrows, X, CurRow, &(Area[i]));
-	}
+        for (j=0; j<xrows; j++)
+        {
+            CurColumn = Y + (j*ycols);
+            for (i=0; i<ycols; i++)
+            {
+                Area[i] += Coeffs[j] * CurColumn[i];
+            }
+        }
 
 	/*
 	 * A weight was passed, so we want to transpose the AREA matrix.
@@ -265,4 +286,6 @@ void mexFunction (int nlhs, mxArray *plhs [],
         mxSetM(AREA, ycols);
         mxSetN(AREA, 1);
     }
+
+    mxFree (Coeffs);
 }
@@ -0,0 +1,1069 @@
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : rcbf (CMEX)
+@INPUT      : filename - the dynamic PET study (MINC)
+              slices - zero-based slice numbers to analyse
+              FrameTimes, FrameLengths - frame start times and lengths
+              g_even - arterial blood activity (cross-calibrated, in
+                       Bq/g_blood), resampled at the times in ts_even
+              ts_even - evenly spaced times
+              k2_lookup - table of k2 values (1/sec)
+              correction - whether to do delay/dispersion correction
+              tau - dispersion time constant (sec)
+              progress - whether to print progress messages
+              K1file, V0file - (optional) existing MINC files (eg. made
+                       by newimage) into which to write the K1 and V0
+                       images, one slice at a time; '' for none
+@OUTPUT     : K1, k2, V0 - one column per slice, in the units rcbf2.m
+                       returns them
+              delta - the blood delay found for each slice (0 if there
+                       was no correction)
+@RETURNS    :
+@DESCRIPTION: The whole of rcbf2.m's slice loop, for every slice in one
+              call: reads each slice's frames straight from the file,
+              integrates and masks them, fits the delay for the slice
+              (if correction is on, using the same automatic grey-matter
+              mask as rcbf2.m in batch mode), and computes K1, k2 and V0
+              by the three-weighted-integral method.
+
+              The findintconvo tables depend only on the blood curve, so
+              they are built once -- or, with delay correction, once for
+              each distinct delay, since the delays all come from the
+              same grid of whole seconds -- rather than once per slice.
+@METHOD     : See rcbf2.m for the method and the units.  The weighting
+              functions are those of rcbf2.m: 1, t and sqrt(t), at the
+              mid-frame times.  Slices are done one after the other, but
+              the pixels of each slice are shared among threads when
+              built with OpenMP (see SliceRates).
+@GLOBALS    : NaN, ErrMsg
+@CALLS      : CacheOpenImage, CacheInflate, OpenImage, PutMaxMin,
+              CorrectBlood, IntConvoTables, IntFrames, TrapCoeffs, Lookup1,
+              Lookup2, Monotonic
+@CREATED    : 2026/10/16, from rcbf2.m
+@MODIFIED   : 2026/10/16: compute the rates for each slice in parallel
+@VERSION    : $Id$
+              $Name:  $
+---------------------------------------------------------------------------- */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+#include <float.h>
+#include <errno.h>
+#include "mex.h"
+#include "minc.h"
+#include "mierrors.h"
+#include "mexutils.h"         /* N.B. must link in mexutils.o */
+#include "mincutil.h"
+#include "emmaproto.h"
+#include "bloodcorrect.h"
+
+#define PROGNAME "rcbf"
+
+/*
+ * Constants to check for argument number and position
+ */
+
+#define MIN_IN_ARGS        10
+#define MAX_IN_ARGS        12
+
+#define MINC_FILENAME      prhs[0]
+#define SLICES             prhs[1]
+#define FRAMETIMES         prhs[2]
+#define FRAMELENGTHS       prhs[3]
+#define G_EVEN             prhs[4]
+#define TS_EVEN            prhs[5]
+#define K2_LOOKUP          prhs[6]
+#define CORRECTION         prhs[7]
+#define TAU                prhs[8]
+#define PROGRESS           prhs[9]
+#define K1_FILENAME        prhs[10]
+#define V0_FILENAME        prhs[11]
+
+#define K1_OUT             plhs[0]
+#define K2_OUT             plhs[1]
+#define V0_OUT             plhs[2]
+#define DELTA_OUT          plhs[3]
+
+/*
+ * Unit conversions (see rcbf2.m): the PET data goes from nCi/mL_tissue
+ * to Bq/g_tissue, and the results from g_blood/(g_tissue*sec) and
+ * 1/sec to mL_blood/(100 g_tissue*min) and 1/min.
+ */
+
+#define PET_SCALE          (37/1.05)
+#define K1_SCALE           (100*60/1.05)
+#define K2_SCALE           60
+#define V0_SCALE           (100/1.05)
+
+#define MASK_THRESHOLD     1.8  /* grey matter mask for delay correction */
+#define NUM_WEIGHTS        3
+#define MAX_TABLES         32   /* most tables (ie. delays) kept at once */
+#define RATE_BLOCK         4096 /* pixels per block shared out by SliceRates */
+
+/*
+ * Everything that depends only on the blood curve: the weighted
+ * integrals of the blood activity, and the k2/rR lookup table.
+ */
+
+typedef struct
+{
+   double   Delta;                  /* delay of the blood curve used */
+   double   CaInt [NUM_WEIGHTS];    /* Ca_int1..3 */
+   double  *Conv [NUM_WEIGHTS];     /* conv_int1..3 (in k2_lookup order) */
+   double  *rR;                     /* rR, sorted ... */
+   double  *k2Sorted;               /* ... and the k2 for each */
+} RateTable;
+
+double   NaN;                    /* NaN in native C format */
+char    *ErrMsg;                 /* set as close to the occurence of the
+                                    error as possible; displayed by whatever
+                                    code exits */
+
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : ErrAbort
+@INPUT      : msg - character to string to print just before aborting
+              PrintUsage - whether or not to print a usage summary before
+                aborting
+              ExitCode - one of the standard codes from mierrors.h -- NOTE!
+                this parameter is NOT currently used, but I've included it for
+                consistency with other functions named ErrAbort in other
+                programs
+@OUTPUT     : none - function does not return!!!
+@RETURNS    :
+@DESCRIPTION: Optionally prints a usage summary, and calls mexErrMsgTxt with
+              the supplied msg, which ABORTS the mex-file!!!
+@METHOD     :
+@GLOBALS    : requires PROGNAME macro
+@CALLS      : standard mex functions
+@CREATED    : 2026/10/16 (copied from mireadimages.c)
+@MODIFIED   :
+---------------------------------------------------------------------------- */
+void ErrAbort (char msg[], Boolean PrintUsage, int ExitCode)
+{
+   if (PrintUsage)
+   {
+      (void) mexPrintf ("Usage: [K1, k2, V0, delta] = %s (filename, slices, ...\n", PROGNAME);
+      (void) mexPrintf ("          FrameTimes, FrameLengths, g_even, ts_even, k2_lookup, ...\n");
+      (void) mexPrintf ("          correction, tau, progress [, K1file [, V0file]])\n");
+   }
+   (void) mexErrMsgTxt (msg);
+}
+
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : CheckVector
+@INPUT      : Vector - MATLAB Matrix passed in by the caller
+              Name - what to call it in error messages
+              Length - required number of elements, or -1 for any
+@OUTPUT     :
+@RETURNS    : the number of elements in Vector
+              does not return if Vector is not a real vector of the
+              required length
+@DESCRIPTION:
+@METHOD     :
+@GLOBALS    : ErrMsg
+@CALLS      : ErrAbort
+@CREATED    : 2026/10/16 (copied from findintconvo.c)
+@MODIFIED   :
+---------------------------------------------------------------------------- */
+int CheckVector (const mxArray *Vector, char *Name, int Length)
+{
+   int     NumElements;
+
+   NumElements = mxGetM (Vector) * mxGetN (Vector);
+   if (!mxIsDouble (Vector) || mxIsComplex (Vector) ||
+       (min (mxGetM (Vector), mxGetN (Vector)) > 1))
+   {
+      sprintf (ErrMsg, "%s must be a real vector", Name);
+      ErrAbort (ErrMsg, TRUE, ERR_ARGS);
+   }
+   if ((Length >= 0) && (NumElements != Length))
+   {
+      sprintf (ErrMsg, "%s must have %d elements", Name, Length);
+      ErrAbort (ErrMsg, TRUE, ERR_ARGS);
+   }
+   return (NumElements);
+}
+
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : ReadSlice
+@INPUT      : Image - the study, with a double ICV attached
+              Slice - zero-based slice number
+@OUTPUT     : PET - the images for every frame of the slice, one after
+                    the other
+@RETURNS    : ERR_NONE if all went well
+              ERR_IN_MINC if miicv_get failed (and sets ErrMsg)
+@DESCRIPTION: Reads all frames of one slice with a single miicv_get.
+              With only one slice in the hyperslab the images come back
+              in frame order, whichever of slice and time varies faster
+              in the file.
+@METHOD     :
+@GLOBALS    : ErrMsg
+@CALLS      : MINC library
+@CREATED    : 2026/10/16
+@MODIFIED   :
+---------------------------------------------------------------------------- */
+int ReadSlice (ImageInfoRec *Image, long Slice, double *PET)
+{
+   long     Start [MAX_NC_DIMS], Count [MAX_NC_DIMS];
+
+   Start [Image->HeightDim] = 0;  Count [Image->HeightDim] = Image->Height;
+   Start [Image->WidthDim] = 0;   Count [Image->WidthDim] = Image->Width;
+   Start [Image->FrameDim] = 0;   Count [Image->FrameDim] = Image->Frames;
+   if (Image->SliceDim != -1)
+   {
+      Start [Image->SliceDim] = Slice;
+      Count [Image->SliceDim] = 1;
+   }
+
+   if (miicv_get (Image->ICV, Start, Count, PET) == MI_ERROR)
+   {
+      sprintf (ErrMsg, "!! BOMB !! error code %d (%s) set by miicv_get",
+               ncerr, NCErrMsg (ncerr, errno));
+      return (ERR_IN_MINC);
+   }
+   return (ERR_NONE);
+}
+
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : OpenOutput
+@INPUT      : Mname - the filename argument (may be '')
+              ImageSize - number of pixels each image must have
+@OUTPUT     : Image - set up for writing, if there is a file
+              Opened - TRUE if a file was given and opened; FALSE if not
+@RETURNS    : ERR_NONE if all went well (including if there's no file)
+              ERR_ARGS if the filename is bad or the file doesn't match
+                 the study (and sets ErrMsg)
+              ERR_IN_MINC, or whatever OpenImage returns, if the file
+                 can't be opened for writing (and sets ErrMsg)
+@DESCRIPTION: Opens one of the optional output files.  Any cached
+              (read-only) copy of it is closed first, so that later
+              reads see what we write.  On error the file is left
+              closed; it is up to the caller to close any others it
+              has open before bailing out.
+@METHOD     :
+@GLOBALS    : ErrMsg, NaN
+@CALLS      : ParseStringArg, CacheFlush, OpenImage
+@CREATED    : 2026/10/16
+@MODIFIED   : 2026/10/16: returns an error code rather than aborting
+---------------------------------------------------------------------------- */
+int OpenOutput (const mxArray *Mname, long ImageSize, ImageInfoRec *Image,
+                Boolean *Opened)
+{
+   char    *Filename;
+   int      Result;
+
+   *Opened = FALSE;
+   if (mxIsEmpty (Mname))
+   {
+      return (ERR_NONE);
+   }
+   if (ParseStringArg (Mname, &Filename) == NULL)
+   {
+      sprintf (ErrMsg, "Error in output filename");
+      return (ERR_ARGS);
+   }
+
+   CacheFlush (Filename);
+   Result = OpenImage (Filename, Image, NC_WRITE, NaN);
+   if (Result != ERR_NONE)
+   {
+      return (Result);
+   }
+
+   if ((Image->MaxID == MI_ERROR) || (Image->MinID == MI_ERROR))
+   {
+      CloseImage (Image);
+      sprintf (ErrMsg, "Missing image-max or image-min variable in file %s",
+               Filename);
+      return (ERR_IN_MINC);
+   }
+   if (Image->ImageSize != ImageSize)
+   {
+      CloseImage (Image);
+      sprintf (ErrMsg, "Images in %s must have %ld pixels (they have %ld)",
+               Filename, ImageSize, Image->ImageSize);
+      return (ERR_ARGS);
+   }
+   *Opened = TRUE;
+   return (ERR_NONE);
+}
+
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : WriteSlice
+@INPUT      : Image - output file, opened by OpenOutput
+              Slice - zero-based slice number
+              Values - the image to write
+@OUTPUT     :
+@RETURNS    : ERR_NONE if all went well
+              ERR_OUT_MINC if miicv_put failed (and sets ErrMsg)
+              ERR_ARGS if the slice is not in the file
+@DESCRIPTION: Writes one image (into the first frame, if the file has
+              a time dimension).  The same as WriteImages in
+              miputimages.c, for a single image.
+@METHOD     :
+@GLOBALS    : ErrMsg
+@CALLS      : PutMaxMin, MINC library
+@CREATED    : 2026/10/16
+@MODIFIED   :
+---------------------------------------------------------------------------- */
+int WriteSlice (ImageInfoRec *Image, long Slice, double *Values)
+{
+   long     Start [MAX_NC_DIMS], Count [MAX_NC_DIMS];
+   Boolean  DoSlices, DoFrames;
+
+   DoSlices = (Image->SliceDim != -1);
+   DoFrames = (Image->FrameDim != -1);
+
+   if (Slice >= max (Image->Slices, 1))
+   {
+      sprintf (ErrMsg, "Bad slice number: %ld (output file has %ld)",
+               Slice, Image->Slices);
+      return (ERR_ARGS);
+   }
+
+   Start [Image->HeightDim] = 0;  Count [Image->HeightDim] = Image->Height;
+   Start [Image->WidthDim] = 0;   Count [Image->WidthDim] = Image->Width;
+   if (DoSlices)
+   {
+      Start [Image->SliceDim] = Slice;
+      Count [Image->SliceDim] = 1;
+   }
+   if (DoFrames)
+   {
+      Start [Image->FrameDim] = 0;
+      Count [Image->FrameDim] = 1;
+   }
+
+   PutMaxMin (Image, Values, Slice, 0, DoSlices, DoFrames);
+
+   if (miicv_put (Image->ICV, Start, Count, Values) == MI_ERROR)
+   {
+      sprintf (ErrMsg, "INTERNAL BUG: Fail on miicv_put: Error code %d",
+               ncerr);
+      return (ERR_OUT_MINC);
+   }
+   return (ERR_NONE);
+}
+
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : BuildTable
+@INPUT      : NumSamples - number of elements in Ca and Ts
+              Ca, Ts - the blood curve (already corrected, if need be)
+              TableSize - number of elements in K2
+              K2 - k2_lookup
+              NumFrames - number of frames
+              FrameTimes, FrameLengths, MidFTimes - frame timing
+              Weights - the NUM_WEIGHTS weighting functions
+              Delta - the delay of Ca (just kept in the table)
+              progress - whether to print progress messages
+@OUTPUT     : Table - filled in (its vectors must already be allocated)
+@RETURNS    : FALSE if the rR table isn't monotonic (so k2 can't be
+              looked up in it); TRUE otherwise
+@DESCRIPTION: Does the part of rcbf2.m's slice loop that only depends
+              on the blood curve: findintconvo, the weighted integrals
+              of the blood activity, and the sorted rR table.
+@METHOD     : rR is sorted with an insertion sort, which (like MATLAB's
+              sort) is stable and puts NaN's last; rR is usually nearly
+              sorted already, so this is quick.
+@GLOBALS    :
+@CALLS      : IntConvoTables, IntFrames, TrapCoeffs, Monotonic
+@CREATED    : 2026/10/16
+@MODIFIED   :
+---------------------------------------------------------------------------- */
+Boolean BuildTable (int NumSamples, double Ca[], double Ts[],
+                    int TableSize, double K2[],
+                    int NumFrames, double FrameTimes[],
+                    double FrameLengths[], double MidFTimes[],
+                    double *Weights[], double Delta, Boolean progress,
+                    RateTable *Table)
+{
+   double  *CaMft;              /* blood activity integrated over frames */
+   double  *SelTimes, *SelCa, *SelWeights, *Coeffs;
+   double  *Ca1, *Ca2, *Ca3;
+   double  *c1, *c2, *c3;
+   double  r, k;
+   int     NumSelected;
+   int     i, j, w;
+
+   Table->Delta = Delta;
+
+   if (progress)
+      mexPrintf ("Generating k2/rR lookup table\n");
+
+   IntConvoTables (NumSamples, Ca, Ts, TableSize, K2,
+                   NumFrames, MidFTimes, FrameLengths,
+                   NUM_WEIGHTS, Weights, Table->Conv);
+
+   /*
+    * Integrate the blood over every frame, and then (over the frames
+    * it spans) with each weighting function
+    */
+
+   CaMft = (double *) mxCalloc (5 * NumFrames, sizeof (double));
+   SelTimes = CaMft + NumFrames;
+   SelCa = SelTimes + NumFrames;
+   SelWeights = SelCa + NumFrames;
+   Coeffs = SelWeights + NumFrames;
+
+   IntFrames (NumSamples, Ts, Ca, NumFrames, FrameTimes, FrameLengths,
+              CaMft);
+
+   for (j = 0, NumSelected = 0; j < NumFrames; j++)
+   {
+      if (CaMft [j] == CaMft [j])
+      {
+         SelTimes [NumSelected] = MidFTimes [j];
+         SelCa [NumSelected] = CaMft [j];
+         NumSelected++;
+      }
+   }
+   if (NumSelected != NumFrames)
+   {
+      mexPrintf ("Warning: blood data does not span frames.\n");
+   }
+
+   for (w = 0; w < NUM_WEIGHTS; w++)
+   {
+      for (j = 0, i = 0; j < NumFrames; j++)
+      {
+         if (CaMft [j] == CaMft [j])
+            SelWeights [i++] = Weights [w][j];
+      }
+      TrapCoeffs (NumSelected, SelTimes, SelWeights, Coeffs);
+
+      Table->CaInt [w] = 0;
+      for (j = 0; j < NumSelected; j++)
+      {
+         Table->CaInt [w] += Coeffs [j] * SelCa [j];
+      }
+   }
+   mxFree (CaMft);
+
+   /*
+    * rR (the right-hand side of Eq. 10) for every k2, sorted
+    */
+
+   Ca1 = &Table->CaInt [0];  Ca2 = &Table->CaInt [1];  Ca3 = &Table->CaInt [2];
+   c1 = Table->Conv [0];     c2 = Table->Conv [1];     c3 = Table->Conv [2];
+
+   for (i = 0; i < TableSize; i++)
+   {
+      r = ((*Ca3 * c1 [i]) - (*Ca1 * c3 [i])) /
+          ((*Ca3 * c2 [i]) - (*Ca2 * c3 [i]));
+      k = K2 [i];
+
+      for (j = i; j > 0; j--)
+      {
+         if ((r != r) || !((Table->rR [j-1] != Table->rR [j-1]) ||
+                           (Table->rR [j-1] > r)))
+            break;
+         Table->rR [j] = Table->rR [j-1];
+         Table->k2Sorted [j] = Table->k2Sorted [j-1];
+      }
+      Table->rR [j] = r;
+      Table->k2Sorted [j] = k;
+   }
+
+   return (Monotonic (Table->rR, TableSize) == 1);
+}
+
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : BlockRates
+@INPUT      : Table - lookup tables for the slice's blood curve
+              TableSize - number of elements in K2
+              K2 - k2_lookup
+              K2Direction - 1 if K2 is increasing, -1 if decreasing
+              Count - number of pixels in the block
+              P1, P2, P3 - the three weighted integrals of the block's
+                           PET data
+              L1, L3 - Count doubles of work space each
+@OUTPUT     : K1, k2, V0 - the parametric images for the block, in final
+                           units
+@RETURNS    : (void)
+@DESCRIPTION: The pixel-by-pixel part of rcbf2.m, for one block of
+              pixels: k2 by looking up rL in the rR table, then K1 and
+              V0 from the integrals for that k2.  Non-finite K1's and
+              V0's are set to zero, and everything is converted to the
+              usual units.
+@METHOD     : Nothing is shared with other blocks but the (read-only)
+              table, so blocks can be done at the same time.
+@GLOBALS    :
+@CALLS      : Lookup1, Lookup2
+@CREATED    : 2026/10/16 (from SliceRates)
+@MODIFIED   :
+---------------------------------------------------------------------------- */
+static void BlockRates (RateTable *Table, int TableSize, double K2[],
+                        int K2Direction, int Count,
+                        double P1[], double P2[], double P3[],
+                        double L1[], double L3[],
+                        double K1[], double k2[], double V0[])
+{
+   double  Ca1, Ca2, Ca3;
+   double  Numer;
+   int     p;
+
+   Ca1 = Table->CaInt [0];
+   Ca2 = Table->CaInt [1];
+   Ca3 = Table->CaInt [2];
+
+   /*
+    * rL (the left-hand side of Eq. 10) goes in K1 for now
+    */
+
+   for (p = 0; p < Count; p++)
+   {
+      K1 [p] = ((Ca3 * P1 [p]) - (Ca1 * P3 [p])) /
+               ((Ca3 * P2 [p]) - (Ca2 * P3 [p]));
+   }
+
+   Lookup1 (Table->rR, Table->k2Sorted, K1, k2, TableSize, Count);
+   if (K2Direction == 1)
+   {
+      Lookup1 (K2, Table->Conv [0], k2, L1, TableSize, Count);
+      Lookup1 (K2, Table->Conv [2], k2, L3, TableSize, Count);
+   }
+   else
+   {
+      Lookup2 (K2, Table->Conv [0], k2, L1, TableSize, Count);
+      Lookup2 (K2, Table->Conv [2], k2, L3, TableSize, Count);
+   }
+
+   for (p = 0; p < Count; p++)
+   {
+      Numer = (Ca3 * P1 [p]) - (Ca1 * P3 [p]);
+      K1 [p] = Numer / ((Ca3 * L1 [p]) - (Ca1 * L3 [p]));
+      V0 [p] = (P1 [p] - (K1 [p] * L1 [p])) / Ca1;
+
+      if ((K1 [p] != K1 [p]) || (fabs (K1 [p]) > DBL_MAX))
+         K1 [p] = 0;
+      if ((V0 [p] != V0 [p]) || (fabs (V0 [p]) > DBL_MAX))
+         V0 [p] = 0;
+
+      K1 [p] *= K1_SCALE;
+      k2 [p] *= K2_SCALE;
+      V0 [p] *= V0_SCALE;
+   }
+}
+
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : SliceRates
+@INPUT      : Table - lookup tables for the slice's blood curve
+              TableSize - number of elements in K2
+              K2 - k2_lookup
+              K2Direction - 1 if K2 is increasing, -1 if decreasing
+              ImageSize - number of pixels
+              PETInt - the three weighted integrals of the slice's PET
+                       data, one after the other
+              Work - 2*ImageSize doubles of work space
+@OUTPUT     : K1, k2, V0 - the parametric images, in final units
+@RETURNS    : (void)
+@DESCRIPTION: Computes the parametric images for a whole slice (see
+              BlockRates).
+@METHOD     : The slice is cut into blocks of RATE_BLOCK pixels, which
+              are shared among threads if built with OpenMP.  Each block
+              uses its own part of Work, so the results are the same
+              however many threads there are.
+@GLOBALS    :
+@CALLS      : BlockRates
+@CREATED    : 2026/10/16
+@MODIFIED   : 2026/10/16: split into blocks, done in parallel
+---------------------------------------------------------------------------- */
+void SliceRates (RateTable *Table, int TableSize, double K2[],
+                 int K2Direction, long ImageSize, double *PETInt,
+                 double *Work, double K1[], double k2[], double V0[])
+{
+   double  *P1, *P2, *P3;
+   double  *L1, *L3;            /* conv_int1 and conv_int3 at each k2 */
+   long    NumBlocks;
+   long    b, First;
+   int     Count;
+
+   P1 = PETInt;
+   P2 = P1 + ImageSize;
+   P3 = P2 + ImageSize;
+   L1 = Work;
+   L3 = Work + ImageSize;
+   NumBlocks = (ImageSize + RATE_BLOCK - 1) / RATE_BLOCK;
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic) private(First, Count)
+#endif
+   for (b = 0; b < NumBlocks; b++)
+   {
+      First = b * RATE_BLOCK;
+      Count = (int) min (RATE_BLOCK, ImageSize - First);
+      BlockRates (Table, TableSize, K2, K2Direction, Count,
+                  P1 + First, P2 + First, P3 + First,
+                  L1 + First, L3 + First,
+                  K1 + First, k2 + First, V0 + First);
+   }
+}
+
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : mexFunction
+@INPUT      : nlhs, nrhs - number of output/input arguments (from MATLAB)
+              prhs - actual input arguments
+@OUTPUT     : plhs - actual output arguments
+@RETURNS    : (void)
+@DESCRIPTION:
+@METHOD     : For each slice: read every frame, integrate with the three
+              weighting functions (TrapCoeffs), mask, find the delay if
+              need be, find (or build) the lookup tables for the
+              resulting blood curve, and compute the parametric images.
+              Outputs that weren't asked for are computed into a single
+              slice's worth of work space.  A slice with nothing in the
+              delay-correction mask (no pixel brighter than the
+              threshold) is not skipped: its K1, k2 and V0 are written
+              as zeros, and its delta as 0.
+@GLOBALS    : NaN, ErrMsg
+@CALLS      : everything above
+@CREATED    : 2026/10/16
+@MODIFIED   : 2026/10/16: empty masks give zeros; K1 file closed if the
+              V0 file can't be opened
+---------------------------------------------------------------------------- */
+void mexFunction(int    nlhs,
+                 mxArray *plhs[],
+                 int    nrhs,
+                 const mxArray *prhs[])
+{
+   char        *Filename;
+   ImageInfoRec Image;
+   ImageInfoRec Out [2];        /* K1 and V0 files */
+   Boolean      DoOut [2];
+   long        *Slices;
+   long         NumSlices, ImageSize;
+   int          NumFrames, NumSamples, TableSize;
+   double      *FrameTimes, *FrameLengths, *MidFTimes;
+   double      *g_even, *ts_even, *K2;
+   int          K2Direction;
+   Boolean      correction, progress;
+   double       tau;
+   double      *Weights [NUM_WEIGHTS];
+   double      *Coeffs [NUM_WEIGHTS];
+   RateTable    Tables [MAX_TABLES];
+   RateTable   *Table;
+   int          NumTables;
+   double      *Ca, *Ts;        /* the (corrected) blood curve */
+   int          NumCa;
+   double       Delta;
+   double      *PET, *PETInt, *A, *Work;
+   double      *K1, *k2, *V0, *Deltas;
+   double      *Results [3];    /* K1, k2, V0 for the current slice */
+   double       Mean;
+   long         MaskCount;
+   Boolean      EmptyMask;
+   int          Result;
+   long         s, p;
+   int          f, i, w;
+
+   ncopts = 0;
+   ErrMsg = (char *) mxCalloc (256, sizeof (char));
+
+   if (HandleCacheCommand (nlhs, plhs, nrhs, prhs))
+   {
+      return;
+   }
+
+   if ((nrhs < MIN_IN_ARGS) || (nrhs > MAX_IN_ARGS))
+   {
+      ErrAbort ("Incorrect number of arguments", TRUE, ERR_ARGS);
+   }
+
+   if (ParseStringArg (MINC_FILENAME, &Filename) == NULL)
+   {
+      ErrAbort ("Error in filename", TRUE, ERR_ARGS);
+   }
+
+   NaN = CreateNaN();
+
+   Result = CacheOpenImage (Filename, &Image, NC_DOUBLE, NaN);
+   if (Result == ERR_NONE)          /* we'll read all of it, if compressed */
+      Result = CacheInflate (Image.CDF, NULL, NULL, NULL);
+   if (Result != ERR_NONE)
+   {
+      ErrAbort (ErrMsg, TRUE, Result);
+   }
+   if (Image.FrameDim == -1)
+   {
+      ErrAbort ("Study is non-dynamic", TRUE, ERR_ARGS);
+   }
+   ImageSize = Image.ImageSize;
+
+   /*
+    * Get the slices, and check that they're all in the file
+    */
+
+   NumSlices = mxGetM (SLICES) * mxGetN (SLICES);
+   Slices = (long *) mxCalloc (max (NumSlices, 1), sizeof (long));
+   if (ParseIntArg (SLICES, NumSlices, Slices) != NumSlices)
+   {
+      ErrAbort ("Slices must be a vector", TRUE, ERR_ARGS);
+   }
+   for (s = 0; s < NumSlices; s++)
+   {
+      if ((Slices [s] < 0) || (Slices [s] >= max (Image.Slices, 1)))
+      {
+         sprintf (ErrMsg, "Bad slice number: %ld (must be < %ld)",
+                  Slices [s], max (Image.Slices, 1));
+         ErrAbort (ErrMsg, TRUE, ERR_ARGS);
+      }
+   }
+
+   /*
+    * Get the frame timing, blood data and options
+    */
+
+   NumFrames = CheckVector (FRAMETIMES, "FrameTimes", (int) Image.Frames);
+   CheckVector (FRAMELENGTHS, "FrameLengths", NumFrames);
+   NumSamples = CheckVector (G_EVEN, "g_even", -1);
+   CheckVector (TS_EVEN, "ts_even", NumSamples);
+   TableSize = CheckVector (K2_LOOKUP, "k2_lookup", -1);
+
+   if (NumSamples < 3)
+   {
+      ErrAbort ("g_even and ts_even must have at least three elements",
+                TRUE, ERR_ARGS);
+   }
+
+   FrameTimes = mxGetPr (FRAMETIMES);
+   FrameLengths = mxGetPr (FRAMELENGTHS);
+   g_even = mxGetPr (G_EVEN);
+   ts_even = mxGetPr (TS_EVEN);
+   K2 = mxGetPr (K2_LOOKUP);
+
+   K2Direction = Monotonic (K2, TableSize);
+   if (K2Direction == 0)
+   {
+      ErrAbort ("k2_lookup must be monotonic", TRUE, ERR_ARGS);
+   }
+
+   correction = (mxGetScalar (CORRECTION) != 0);
+   tau = mxGetScalar (TAU);
+   progress = (mxGetScalar (PROGRESS) != 0);
+
+   /*
+    * The weighting functions, and their integration coefficients
+    */
+
+   MidFTimes = (double *) mxCalloc (NumFrames, sizeof (double));
+   for (f = 0; f < NumFrames; f++)
+   {
+      MidFTimes [f] = FrameTimes [f] + FrameLengths [f] / 2;
+   }
+
+   for (w = 0; w < NUM_WEIGHTS; w++)
+   {
+      Weights [w] = (double *) mxCalloc (NumFrames, sizeof (double));
+      Coeffs [w] = (double *) mxCalloc (NumFrames, sizeof (double));
+   }
+   for (f = 0; f < NumFrames; f++)
+   {
+      Weights [0][f] = 1;
+      Weights [1][f] = MidFTimes [f];
+      Weights [2][f] = sqrt (MidFTimes [f]);
+   }
+   for (w = 0; w < NUM_WEIGHTS; w++)
+   {
+      TrapCoeffs (NumFrames, MidFTimes, Weights [w], Coeffs [w]);
+   }
+
+   /*
+    * Work space, and the outputs (or a slice's worth of space for any
+    * that weren't asked for)
+    */
+
+   Ca = (double *) mxCalloc (NumSamples, sizeof (double));
+   Ts = (double *) mxCalloc (NumSamples, sizeof (double));
+   PET = (double *) mxCalloc (NumFrames * ImageSize, sizeof (double));
+   PETInt = (double *) mxCalloc (NUM_WEIGHTS * ImageSize, sizeof (double));
+   Work = (double *) mxCalloc (2 * ImageSize, sizeof (double));
+   A = (double *) mxCalloc (NumFrames, sizeof (double));
+
+   K1_OUT = mxCreateDoubleMatrix (ImageSize, NumSlices, mxREAL);
+   K1 = mxGetPr (K1_OUT);
+   if (nlhs > 1)
+   {
+      K2_OUT = mxCreateDoubleMatrix (ImageSize, NumSlices, mxREAL);
+      k2 = mxGetPr (K2_OUT);
+   }
+   else
+      k2 = (double *) mxCalloc (ImageSize, sizeof (double));
+   if (nlhs > 2)
+   {
+      V0_OUT = mxCreateDoubleMatrix (ImageSize, NumSlices, mxREAL);
+      V0 = mxGetPr (V0_OUT);
+   }
+   else
+      V0 = (double *) mxCalloc (ImageSize, sizeof (double));
+   if (nlhs > 3)
+   {
+      DELTA_OUT = mxCreateDoubleMatrix (1, NumSlices, mxREAL);
+      Deltas = mxGetPr (DELTA_OUT);
+   }
+   else
+      Deltas = (double *) mxCalloc (max (NumSlices, 1), sizeof (double));
+
+   NumTables = 0;
+
+   /*
+    * Without delay correction the blood curve is the same for every
+    * slice, so there's only the one table
+    */
+
+   if (!correction)
+   {
+      Table = &Tables [0];
+      for (w = 0; w < NUM_WEIGHTS; w++)
+         Table->Conv [w] = (double *) mxCalloc (TableSize, sizeof (double));
+      Table->rR = (double *) mxCalloc (TableSize, sizeof (double));
+      Table->k2Sorted = (double *) mxCalloc (TableSize, sizeof (double));
+      if (!BuildTable (NumSamples, g_even, ts_even, TableSize, K2,
+                       NumFrames, FrameTimes, FrameLengths, MidFTimes,
+                       Weights, 0.0, progress, Table))
+      {
+         ErrAbort ("The k2/rR lookup table is not monotonic", FALSE,
+                   ERR_ARGS);
+      }
+      NumTables = 1;
+   }
+
+   DoOut [0] = DoOut [1] = FALSE;
+   Result = ERR_NONE;
+   if (nrhs > 10)
+      Result = OpenOutput (K1_FILENAME, ImageSize, &Out [0], &DoOut [0]);
+   if ((nrhs > 11) && (Result == ERR_NONE))
+      Result = OpenOutput (V0_FILENAME, ImageSize, &Out [1], &DoOut [1]);
+   if (Result != ERR_NONE)
+   {
+      if (DoOut [0])
+         CloseImage (&Out [0]);
+      ErrAbort (ErrMsg, TRUE, Result);
+   }
+
+   for (s = 0; s < NumSlices; s++)
+   {
+      if (progress)
+         mexPrintf ("Doing slice %ld\n", Slices [s] + 1);
+
+      /*
+       * Read the slice, and integrate it with each weighting function
+       */
+
+      Result = ReadSlice (&Image, Slices [s], PET);
+      if (Result != ERR_NONE)
+         break;
+
+      for (p = 0; p < NUM_WEIGHTS * ImageSize; p++)
+         PETInt [p] = 0;
+      for (f = 0; f < NumFrames; f++)
+      {
+         for (p = 0; p < ImageSize; p++)
+         {
+            PET [f*ImageSize + p] *= PET_SCALE;
+            for (w = 0; w < NUM_WEIGHTS; w++)
+               PETInt [w*ImageSize + p] += Coeffs [w][f] * PET [f*ImageSize + p];
+         }
+      }
+
+      /*
+       * Mask out (roughly) everything outside the head
+       */
+
+      for (p = 0, Mean = 0; p < ImageSize; p++)
+         Mean += PETInt [p];
+      Mean /= ImageSize;
+
+      for (p = 0; p < ImageSize; p++)
+      {
+         if (!(PETInt [p] > Mean))
+         {
+            for (w = 0; w < NUM_WEIGHTS; w++)
+               PETInt [w*ImageSize + p] *= 0;
+         }
+      }
+
+      /*
+       * Delay/dispersion correction: fit to the mean activity of the
+       * grey matter (the brightest pixels)
+       */
+
+      EmptyMask = FALSE;
+      if (correction)
+      {
+         if (progress)
+            mexPrintf ("Performing delay/dispersion correction\n");
+
+         for (p = 0, Mean = 0; p < ImageSize; p++)
+            Mean += PETInt [p];
+         Mean *= MASK_THRESHOLD / ImageSize;
+
+         for (f = 0; f < NumFrames; f++)
+            A [f] = 0;
+         for (p = 0, MaskCount = 0; p < ImageSize; p++)
+         {
+            if (PETInt [p] > Mean)
+            {
+               for (f = 0; f < NumFrames; f++)
+                  A [f] += PET [f*ImageSize + p];
+               MaskCount++;
+            }
+         }
+
+         /*
+          * An empty mask (eg. a slice with no activity in it) leaves
+          * nothing to fit; the slice is written as zeros below
+          */
+
+         EmptyMask = (MaskCount == 0);
+         if (EmptyMask)
+         {
+            mexPrintf ("Warning: nothing in slice %ld to fit the blood "
+                       "delay to; setting it to zero\n", Slices [s] + 1);
+            Delta = 0;
+            NumCa = 0;
+         }
+         else
+         {
+            for (f = 0; f < NumFrames; f++)
+               A [f] /= MaskCount;
+
+            NumCa = CorrectBlood (NumSamples, g_even, ts_even,
+                                  NumFrames, FrameTimes, FrameLengths,
+                                  A, tau, &Delta, Ca, Ts);
+            if (progress)
+               mexPrintf ("using delta = %.1f\n", Delta);
+         }
+      }
+      else
+      {
+         Delta = 0;
+         NumCa = NumSamples;
+      }
+      Deltas [s] = Delta;
+
+      Results [0] = K1 + s*ImageSize;
+      Results [1] = (nlhs > 1) ? k2 + s*ImageSize : k2;
+      Results [2] = (nlhs > 2) ? V0 + s*ImageSize : V0;
+
+      /*
+       * If the mask was empty, or no delay fitted the data, there's
+       * no blood curve to use
+       */
+
+      if (EmptyMask)
+      {
+         for (p = 0; p < ImageSize; p++)
+         {
+            Results [0][p] = 0;
+            Results [1][p] = 0;
+            Results [2][p] = 0;
+         }
+      }
+      else if (NumCa < 2)
+      {
+         mexPrintf ("Warning: no blood delay fits slice %ld\n",
+                    Slices [s] + 1);
+         for (p = 0; p < ImageSize; p++)
+         {
+            Results [0][p] = 0;
+            Results [1][p] = NaN;
+            Results [2][p] = 0;
+         }
+      }
+      else
+      {
+         /*
+          * Find the lookup tables for this blood curve, building them
+          * if it's new
+          */
+
+         Table = NULL;
+         for (i = 0; i < NumTables; i++)
+         {
+            if (Tables [i].Delta == Delta)
+               Table = &Tables [i];
+         }
+
+         if (Table == NULL)
+         {
+            if (NumTables < MAX_TABLES)
+            {
+               Table = &Tables [NumTables++];
+               for (w = 0; w < NUM_WEIGHTS; w++)
+                  Table->Conv [w] = (double *)
+                     mxCalloc (TableSize, sizeof (double));
+               Table->rR = (double *) mxCalloc (TableSize, sizeof (double));
+               Table->k2Sorted = (double *)
+                  mxCalloc (TableSize, sizeof (double));
+            }
+            else
+            {
+               Table = &Tables [MAX_TABLES-1];
+            }
+
+            if (!BuildTable (NumCa, Ca, Ts, TableSize, K2,
+                             NumFrames, FrameTimes, FrameLengths, MidFTimes,
+                             Weights, Delta, progress, Table))
+            {
+               sprintf (ErrMsg, "The k2/rR lookup table for slice %ld is not monotonic",
+                        Slices [s] + 1);
+               Result = ERR_ARGS;
+               break;
+            }
+         }
+
+         if (progress)
+            mexPrintf ("Calculating k2, K1 and V0 images\n");
+
+         SliceRates (Table, TableSize, K2, K2Direction, ImageSize, PETInt,
+                     Work, Results [0], Results [1], Results [2]);
+      }
+
+      /*
+       * Write the slice to the output files, if any
+       */
+
+      if (DoOut [0])
+         Result = WriteSlice (&Out [0], Slices [s], Results [0]);
+      if (DoOut [1] && (Result == ERR_NONE))
+         Result = WriteSlice (&Out [1], Slices [s], Results [2]);
+      if (Result != ERR_NONE)
+         break;
+
+   }     /* for s */
+
+   for (i = 0; i < 2; i++)
+   {
+      if (DoOut [i])
+      {
+         if (Result == ERR_NONE)
+            miattputstr (Out [i].CDF, Out [i].ID, MIcomplete, MI_TRUE);
+         CloseImage (&Out [i]);
+      }
+   }
+
+   if (Result != ERR_NONE)
+   {
+      ErrAbort (ErrMsg, FALSE, Result);
+   }
+
+}     /* mexFunction */
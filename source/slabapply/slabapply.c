@@ -0,0 +1,322 @@
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : slabapply (CMEX)
+@INPUT      : filename - the study (MINC)
+              fname - name of the MATLAB function to apply
+              slices - zero-based slice numbers ([] for all)
+              frames - zero-based frame numbers, which must be
+                       consecutive ([] for all)
+              rows - number of image rows in each slab
+              P1, P2, ... - (optional) passed on to fname
+@OUTPUT     : R1, R2, ... - one column per slice: for each pixel, the
+                       corresponding output of fname
+@RETURNS    :
+@DESCRIPTION: Streams a study through a MATLAB function a slab at a
+              time, so that pixel-by-pixel analyses can be run on
+              studies whose slices (for all frames) won't fit in memory.
+              A slab is a few rows of one slice, for all of the given
+              frames; fname is called as
+
+                 [R1, R2, ...] = feval (fname, slab, P1, P2, ...)
+
+              with slab a matrix with one row per pixel and one column
+              per frame (like the output of getimages).  Each output must
+              be a vector with one element per pixel of the slab, and is
+              put in place in the corresponding whole-study result.
+@METHOD     : Slabs are read by the library's slab reader
+              (OpenSlabReader/ReadNextSlab in mincutil.c), which reads
+              the next slab in the background while fname works on this
+              one, so only two slabs are in memory at once.  fname must
+              therefore not read or write MINC files itself.
+@GLOBALS    : NaN, ErrMsg
+@CALLS      : CacheOpenImage, CacheInflate, OpenSlabReader, ReadNextSlab,
+              CloseSlabReader, mexCallMATLAB
+@CREATED    : 2026/10/16
+@MODIFIED   : 2026/10/16: slabs are read ahead in the background
+@VERSION    : $Id$
+              $Name:  $
+---------------------------------------------------------------------------- */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+#include "mex.h"
+#include "minc.h"
+#include "mierrors.h"
+#include "mexutils.h"         /* N.B. must link in mexutils.o */
+#include "mincutil.h"
+#include "emmaproto.h"
+
+#define PROGNAME "slabapply"
+
+/*
+ * Constants to check for argument number and position
+ */
+
+#define MIN_IN_ARGS        5
+#define MAX_IN_ARGS        32
+
+#define MINC_FILENAME      prhs[0]
+#define FUNCTION_NAME      prhs[1]
+#define SLICES             prhs[2]
+#define FRAMES             prhs[3]
+#define SLAB_ROWS          prhs[4]
+
+double   NaN;                    /* NaN in native C format */
+char    *ErrMsg;                 /* set as close to the occurence of the
+                                    error as possible; displayed by whatever
+                                    code exits */
+
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : ErrAbort
+@INPUT      : msg - character to string to print just before aborting
+              PrintUsage - whether or not to print a usage summary before
+                aborting
+              ExitCode - one of the standard codes from mierrors.h -- NOTE!
+                this parameter is NOT currently used, but I've included it for
+                consistency with other functions named ErrAbort in other
+                programs
+@OUTPUT     : none - function does not return!!!
+@RETURNS    :
+@DESCRIPTION: Optionally prints a usage summary, and calls mexErrMsgTxt with
+              the supplied msg, which ABORTS the mex-file!!!
+@METHOD     :
+@GLOBALS    : requires PROGNAME macro
+@CALLS      : standard mex functions
+@CREATED    : 2026/10/16 (copied from mireadimages.c)
+@MODIFIED   :
+---------------------------------------------------------------------------- */
+void ErrAbort (char msg[], Boolean PrintUsage, int ExitCode)
+{
+   if (PrintUsage)
+   {
+      (void) mexPrintf ("Usage: [R1, R2, ...] = %s (filename, fname, slices, frames, ...\n", PROGNAME);
+      (void) mexPrintf ("          rows [, P1, P2, ...])\n");
+   }
+   (void) mexErrMsgTxt (msg);
+}
+
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : GetRange
+@INPUT      : Mvector - MATLAB vector of zero-based numbers (may be empty)
+              Name - what to call it in error messages
+              Total - how many slices or frames there are
+              Consecutive - whether the numbers must be consecutive
+@OUTPUT     : Cvector - the numbers (all of them, 0..Total-1, if Mvector
+                 is empty); must have room for Total elements
+@RETURNS    : the number of elements in Cvector
+              does not return if the vector is bad
+@DESCRIPTION:
+@METHOD     :
+@GLOBALS    : ErrMsg
+@CALLS      : ParseIntArg, ErrAbort
+@CREATED    : 2026/10/16
+@MODIFIED   :
+---------------------------------------------------------------------------- */
+long GetRange (const mxArray *Mvector, char *Name, long Total,
+               Boolean Consecutive, long Cvector[])
+{
+   long     Num, i;
+
+   if (mxIsEmpty (Mvector))
+   {
+      for (i = 0; i < Total; i++)
+         Cvector [i] = i;
+      return (Total);
+   }
+
+   Num = mxGetM (Mvector) * mxGetN (Mvector);
+   if ((Num > Total) || (ParseIntArg (Mvector, Num, Cvector) != Num))
+   {
+      sprintf (ErrMsg, "%s must be a vector of at most %ld elements",
+               Name, Total);
+      ErrAbort (ErrMsg, TRUE, ERR_ARGS);
+   }
+   for (i = 0; i < Num; i++)
+   {
+      if ((Cvector [i] < 0) || (Cvector [i] >= Total) ||
+          (Consecutive && (i > 0) && (Cvector [i] != Cvector [i-1] + 1)))
+      {
+         sprintf (ErrMsg, "Bad %s (must be %sbetween 0 and %ld)", Name,
+                  Consecutive ? "consecutive and " : "", Total - 1);
+         ErrAbort (ErrMsg, TRUE, ERR_ARGS);
+      }
+   }
+   return (Num);
+}
+
+
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : mexFunction
+@INPUT      : nlhs, nrhs - number of output/input arguments (from MATLAB)
+              prhs - actual input arguments
+@OUTPUT     : plhs - actual output arguments
+@RETURNS    : (void)
+@DESCRIPTION:
+@METHOD     : One slab reader per slice; each slab is copied into a
+              fresh MATLAB matrix for fname, since fname might keep it
+              (and the reader reuses its buffers).
+              While the next slab is being read the reader must be
+              closed before aborting, so errors in fname are trapped
+              (mexSetTrapFlag) rather than aborting straight away.
+@GLOBALS    : NaN, ErrMsg
+@CALLS      : everything above
+@CREATED    : 2026/10/16
+@MODIFIED   : 2026/10/16: close the reader before aborting
+---------------------------------------------------------------------------- */
+void mexFunction(int    nlhs,
+                 mxArray *plhs[],
+                 int    nrhs,
+                 const mxArray *prhs[])
+{
+   char        *Filename, *FunctionName;
+   ImageInfoRec Image;
+   SlabReader   Reader;
+   long        *Slices, *Frames;
+   long         NumSlices, NumFrames, SlabRows, SlabSize, Offset;
+   mxArray     *Args [MAX_IN_ARGS];
+   mxArray     *Results [MAX_IN_ARGS];
+   double      *Src;
+   int          NumArgs;
+   int          Result;
+   long         s, p;
+   int          i;
+
+   ncopts = 0;
+   ErrMsg = (char *) mxCalloc (256, sizeof (char));
+
+   if (HandleCacheCommand (nlhs, plhs, nrhs, prhs))
+   {
+      return;
+   }
+
+   if ((nrhs < MIN_IN_ARGS) || (nrhs > MAX_IN_ARGS))
+   {
+      ErrAbort ("Incorrect number of arguments", TRUE, ERR_ARGS);
+   }
+   if (nlhs > MAX_IN_ARGS)
+   {
+      ErrAbort ("Too many output arguments", TRUE, ERR_ARGS);
+   }
+
+   if (ParseStringArg (MINC_FILENAME, &Filename) == NULL)
+   {
+      ErrAbort ("Error in filename", TRUE, ERR_ARGS);
+   }
+   if (ParseStringArg (FUNCTION_NAME, &FunctionName) == NULL)
+   {
+      ErrAbort ("Error in function name", TRUE, ERR_ARGS);
+   }
+
+   NaN = CreateNaN();
+
+   Result = CacheOpenImage (Filename, &Image, NC_DOUBLE, NaN);
+   if (Result == ERR_NONE)          /* we'll read all of it, if compressed */
+      Result = CacheInflate (Image.CDF, NULL, NULL, NULL);
+   if (Result != ERR_NONE)
+   {
+      ErrAbort (ErrMsg, TRUE, Result);
+   }
+
+   /*
+    * Which slices and frames, and how big a slab
+    */
+
+   Slices = (long *) mxCalloc (max (Image.Slices, 1), sizeof (long));
+   Frames = (long *) mxCalloc (max (Image.Frames, 1), sizeof (long));
+   NumSlices = GetRange (SLICES, "slices", max (Image.Slices, 1), FALSE,
+                         Slices);
+   NumFrames = GetRange (FRAMES, "frames", max (Image.Frames, 1), TRUE,
+                         Frames);
+   if (NumFrames == 0)
+   {
+      ErrAbort ("No frames given", TRUE, ERR_ARGS);
+   }
+
+   SlabRows = (long) mxGetScalar (SLAB_ROWS);
+   if ((SlabRows <= 0) || (SlabRows > Image.Height))
+   {
+      SlabRows = Image.Height;
+   }
+
+   /*
+    * The arguments to fname: the slab, then anything extra we were given
+    */
+
+   NumArgs = nrhs - MIN_IN_ARGS + 1;
+   for (i = 1; i < NumArgs; i++)
+   {
+      Args [i] = (mxArray *) prhs [MIN_IN_ARGS + i - 1];
+   }
+
+   for (i = 0; i < nlhs; i++)
+   {
+      plhs [i] = mxCreateDoubleMatrix (Image.ImageSize, NumSlices, mxREAL);
+   }
+
+   mexSetTrapFlag (1);
+
+   for (s = 0; s < NumSlices; s++)
+   {
+      Result = OpenSlabReader (&Image, Slices [s], 1, Frames [0], NumFrames,
+                               SlabRows, NULL, &Reader);
+      if (Result != ERR_NONE)
+      {
+         ErrAbort (ErrMsg, TRUE, Result);
+      }
+
+      while (TRUE)
+      {
+         Result = ReadNextSlab (&Reader);
+         if (Result != ERR_NONE)
+         {
+            CloseSlabReader (&Reader);
+            ErrAbort (ErrMsg, FALSE, Result);
+         }
+         if (Reader.Rows == 0)
+            break;
+
+         SlabSize = Reader.Rows * Image.Width;
+         Args [0] = mxCreateDoubleMatrix (SlabSize, NumFrames, mxREAL);
+         memcpy (mxGetPr (Args [0]), Reader.Buffer,
+                 SlabSize * NumFrames * sizeof (double));
+
+         if (mexCallMATLAB (nlhs, Results, NumArgs, Args, FunctionName) != 0)
+         {
+            CloseSlabReader (&Reader);
+            sprintf (ErrMsg, "Error calling %s", FunctionName);
+            ErrAbort (ErrMsg, FALSE, ERR_OTHER);
+         }
+         mxDestroyArray (Args [0]);
+
+         /*
+          * Put each result in place for this slab's pixels
+          */
+
+         Offset = s * Image.ImageSize + Reader.Row * Image.Width;
+         for (i = 0; i < nlhs; i++)
+         {
+            if (!mxIsDouble (Results [i]) || mxIsComplex (Results [i]) ||
+                (mxGetM (Results [i]) * mxGetN (Results [i]) != SlabSize))
+            {
+               sprintf (ErrMsg, "Output %d of %s must be a real vector with "
+                        "one element per pixel of the slab (%ld)",
+                        i+1, FunctionName, SlabSize);
+               CloseSlabReader (&Reader);
+               ErrAbort (ErrMsg, FALSE, ERR_ARGS);
+            }
+            Src = mxGetPr (Results [i]);
+            for (p = 0; p < SlabSize; p++)
+               mxGetPr (plhs [i]) [Offset + p] = Src [p];
+            mxDestroyArray (Results [i]);
+         }
+      }
+
+      CloseSlabReader (&Reader);
+   }
+}